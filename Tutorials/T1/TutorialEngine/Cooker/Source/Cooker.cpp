@@ -0,0 +1,49 @@
+#include "Core/CoreMinimal.h"
+#include "Core/JobSystem.h"
+#include "Core/Asset/AssetCooker.h"
+
+/*
+* cooks ./Content into ./Cooked, run from the Binaries directory
+* usage : Cooker [-force] [-fast] [-threads=N] [-cellsize=N]
+* -fast compresses base color textures with alpha to bc3 instead of bc7
+* -cellsize sets the edge of the world partition cells, in scene units
+*/
+int main(int argc, char** argv)
+{
+	bool bForce{ false };
+	bool bFast{ false };
+	uint32_t NumThreads{ 0 };
+	float CellSize{ ks::FAssetCooker::DefaultPartitionCellSize };
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string Arg{ argv[i] };
+		if (Arg == "-force")
+		{
+			bForce = true;
+		}
+		else if (Arg == "-fast")
+		{
+			bFast = true;
+		}
+		else if (Arg.find("-threads=") == 0)
+		{
+			NumThreads = std::atoi(Arg.substr(std::string("-threads=").length()).c_str());
+		}
+		else if (Arg.find("-cellsize=") == 0)
+		{
+			const float Value{ static_cast<float>(std::atof(Arg.substr(std::string("-cellsize=").length()).c_str())) };
+			CellSize = Value > 0.f ? Value : CellSize;
+		}
+	}
+
+	std::unique_ptr<ks::FJobSystem> JobSystem{ ks::FJobSystem::Create() };
+	JobSystem->Init(NumThreads);
+	const uint32_t NumCookThreads{ JobSystem->GetNumWorkers() + 1 };
+	ks::FAssetCooker Cooker(*JobSystem, bForce, bFast, CellSize);
+	const ks::FAssetCooker::FCookStats Stats{ Cooker.CookAll() };
+	JobSystem->Shutdown();
+
+	std::cout << std::format("{} scenes, {} cooked, {} up to date, {} failed, {:.2f} s on {} threads\n",
+		Stats.NumScenes, Stats.NumCooked, Stats.NumSkipped, Stats.NumFailed, Stats.Seconds, NumCookThreads);
+	return Stats.NumFailed == 0 ? 0 : 1;
+}
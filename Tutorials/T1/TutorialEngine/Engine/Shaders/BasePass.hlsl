@@ -4,13 +4,13 @@
 Pixel VS(Vertex InVert)
 {
 	Pixel Out;
+	FPrimitiveData Primitive = GPrimitives[InVert.PrimitiveIndex];
 	// trans pos from local to homogeneous clip space.
-	Out.PosW = mul(float4(InVert.PosL, 1.0f), World);
+	Out.PosW = mul(float4(InVert.PosL, 1.0f), Primitive.World);
 	Out.PosH = mul(Out.PosW, ViewProj);
 	// trans normal from local to world
-	Out.NormW = mul(InVert.NormL, (float3x3)WorldInvTrans);
-	
-    Out.ShadowPosH = mul(Out.PosW, LightProjTex);
+	Out.NormW = mul(InVert.NormL, (float3x3)Primitive.WorldInvTrans);
+	Out.BaseColorFactor = Primitive.BaseColorFactor;
 
 	return Out;
 }
@@ -20,16 +20,24 @@ float4 PS(Pixel InPix) : SV_Target
 	// normalize
 	float3 NormW = normalize(InPix.NormW);
 	float NdotL = max(dot(NormW, D_LightDirAndIns.xyz), 0.0f);
-	float3 OutColor = BaseColorFactor.xyz * (NdotL * D_LightDirAndIns.w + 0.05f);
+	float3 OutColor = InPix.BaseColorFactor.xyz * (NdotL * D_LightDirAndIns.w + 0.05f);
 
 	float3 ToEye = normalize(EyePosW - InPix.PosW.xyz);
 	float3 H = normalize(ToEye + D_LightDirAndIns.xyz);
 	float HdotN = max(dot(H, NormW), 0.0f);
 	OutColor += 0.65f * pow(HdotN, 32);
 	
-    float ShadowFactor = CalcShadowFactor(InPix.ShadowPosH);
+    float ShadowFactor = CalcShadowFactor(InPix.PosW.xyz, dot(InPix.PosW, ViewDepthRow));
     OutColor *= ShadowFactor;
 
+	// the point and spot lights binned to the cluster of the pixel
+	uint2 LightRange = GClusterLightRanges[GetClusterIndex(InPix.PosH.xy, InPix.PosW.xyz)];
+	for (uint i = 0; i < LightRange.y; ++i)
+	{
+		FLocalLight Light = GLocalLights[GClusterLightIndices[LightRange.x + i]];
+		OutColor += InPix.BaseColorFactor.xyz * CalcLocalLight(Light, InPix.PosW.xyz, NormW);
+	}
+
 	return float4(OutColor, 1.0f);
 }
 
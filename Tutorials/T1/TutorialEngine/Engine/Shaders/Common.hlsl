@@ -5,7 +5,8 @@ Texture2D GSceneColorMap : register(t1);
 SamplerComparisonState GSamplerShadow : register(s0);
 SamplerState GSamplerLinearClamp : register(s1);
 
-cbuffer PrimitiveConstBuffer : register(b0)
+// the primitive constants, see FPrimitiveConstBufferParameter, packed without padding
+struct FPrimitiveData
 {
 	float4x4 World;
 	float4x4 WorldInvTrans;
@@ -13,27 +14,57 @@ cbuffer PrimitiveConstBuffer : register(b0)
 	float4 RoughnessMetallicFactor;
 };
 
+StructuredBuffer<FPrimitiveData> GPrimitives : register(t2);
+
+// point and spot lights, see FLocalLightData
+struct FLocalLight
+{
+	float3 Position;
+	float InvRange;
+	float3 Color;
+	float SpotScale;
+	float3 Direction;
+	float SpotOffset;
+};
+
+StructuredBuffer<FLocalLight> GLocalLights : register(t3);
+// offset into GClusterLightIndices and count per cluster
+StructuredBuffer<uint2> GClusterLightRanges : register(t4);
+StructuredBuffer<uint> GClusterLightIndices : register(t5);
+
 cbuffer PassConstBuffer : register(b1)
 {
 	float4x4 ViewProj;
     float4x4 LightProj;
-    float4x4 LightProjTex;
+    // world to the shadow atlas of each cascade
+    float4x4 LightProjTex[4];
 	float4 D_LightDirAndIns;
 	float3 EyePosW;
+	float Pad;
+	// light clusters of the view
+	float4 ViewDepthRow;
+	float4 ClusterRect;
+	float4 ClusterDepth;
+	uint4 ClusterGrid;
+	// far view depth of each cascade and their number in x
+	float4 CascadeSplits;
+	uint4 ShadowCascades;
 };
 
 struct Vertex
 {
 	float3 PosL : POSITION;
 	float3 NormL : NORMAL;
+	// per instance, index into GPrimitives
+	uint PrimitiveIndex : PRIMITIVEINDEX;
 };
 
 struct Pixel
 {
 	float4 PosH : SV_POSITION;
 	float4 PosW : POSITION0;
-    float4 ShadowPosH : POSITION1;
 	float3 NormW : NORMAL;
+	nointerpolation float4 BaseColorFactor : COLOR0;
 };
 
 struct PixelShadowPass
@@ -41,24 +72,63 @@ struct PixelShadowPass
     float4 PosH : SV_POSITION;
 };
 
-float CalcShadowFactor(float4 ShadowPosH)
+// the first cascade whose split is beyond the view depth, the pixels past the last one are lit
+float CalcShadowFactor(float3 PosW, float ViewDepth)
 {
+    uint NumCascades = ShadowCascades.x;
+    uint Cascade = 0;
+    [loop]
+    while (Cascade < NumCascades && ViewDepth > CascadeSplits[Cascade])
+    {
+        ++Cascade;
+    }
+    if (Cascade >= NumCascades)
+    {
+        return 1.0f;
+    }
+    float4 ShadowPosH = mul(float4(PosW, 1.0f), LightProjTex[Cascade]);
     float DepthToLight = ShadowPosH.z;
     uint Width, Height, NumMips;
     GShadowMap.GetDimensions(0, Width, Height, NumMips);
     float dx = 1.0f / (float)Width;
+    float dy = 1.0f / (float)Height;
+    // the taps stay inside the tile of the cascade
+    float TileMin = (float)Cascade / NumCascades + 0.5f * dx;
+    float TileMax = (float)(Cascade + 1) / NumCascades - 0.5f * dx;
     const float2 Offsets[9] =
     {
-        float2(-dx, -dx), float2(0.0f, -dx), float2(dx, -dx),
+        float2(-dx, -dy), float2(0.0f, -dy), float2(dx, -dy),
         float2(-dx, 0.0f), float2(0.0f, 0.0f), float2(dx, 0.0f),
-        float2(-dx, dx), float2(0.0f, dx), float2(dx, dx)
+        float2(-dx, dy), float2(0.0f, dy), float2(dx, dy)
     };
     float ShadowFactor = 0.0f;
     [unroll]
     for (int i = 0; i < 9; ++i)
     {
+        float2 UV = ShadowPosH.xy + Offsets[i];
+        UV.x = clamp(UV.x, TileMin, TileMax);
         ShadowFactor += GShadowMap.SampleCmpLevelZero(
-            GSamplerShadow, ShadowPosH.xy + Offsets[i], DepthToLight).r;
+            GSamplerShadow, UV, DepthToLight).r;
     }
     return ShadowFactor/9.0f;
-}
\ No newline at end of file
+}
+
+// index into GClusterLightRanges of the pixel
+uint GetClusterIndex(float2 PixelPos, float3 PosW)
+{
+    uint2 Tile = min(uint2((PixelPos - ClusterRect.xy) * ClusterRect.zw), ClusterGrid.xy - 1);
+    float ViewDepth = max(dot(float4(PosW, 1.0f), ViewDepthRow), 1e-4f);
+    uint Slice = (uint)clamp(log(ViewDepth) * ClusterDepth.x + ClusterDepth.y, 0.0f, ClusterGrid.z - 1.0f);
+    return (Slice * ClusterGrid.y + Tile.y) * ClusterGrid.x + Tile.x;
+}
+
+// diffuse light of a point or spot light, inverse square falloff windowed to zero at the range
+float3 CalcLocalLight(FLocalLight Light, float3 PosW, float3 NormW)
+{
+    float3 ToLight = Light.Position - PosW;
+    float DistSq = max(dot(ToLight, ToLight), 1e-4f);
+    ToLight *= rsqrt(DistSq);
+    float Window = saturate(1.0f - pow(DistSq * Light.InvRange * Light.InvRange, 2.0f));
+    float Spot = saturate(dot(ToLight, Light.Direction) * Light.SpotScale + Light.SpotOffset);
+    return Light.Color * (max(dot(NormW, ToLight), 0.0f) * Window * Window * Spot * Spot / DistSq);
+}
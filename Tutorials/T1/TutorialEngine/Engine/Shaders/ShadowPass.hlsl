@@ -5,7 +5,7 @@ PixelShadowPass VS(Vertex InVert)
 {
 	PixelShadowPass Out;
 	// trans to world
-	float4 PosW = mul(float4(InVert.PosL, 1.0f), World);
+	float4 PosW = mul(float4(InVert.PosL, 1.0f), GPrimitives[InVert.PrimitiveIndex].World);
 	// trans to light space and project to clip space
 	Out.PosH = mul(PosW, LightProj);
 
@@ -45,6 +45,35 @@ namespace ks
 			{
 				ResY = std::atoi(TmpStr.substr(std::string("-ResY=").length()).c_str());
 			}
+			else if (TmpStr == "-hotreload")
+			{
+				bHotReload = true;
+			}
+			else if (TmpStr == "-partition")
+			{
+				bWorldPartition = true;
+			}
+			else if (TmpStr.find("-views") == 0)
+			{
+				NumViews = std::max(std::atoi(TmpStr.substr(std::string("-views=").length()).c_str()), 1);
+			}
+			else if (TmpStr.find("-cascades") == 0)
+			{
+				NumShadowCascades = std::max(std::atoi(TmpStr.substr(std::string("-cascades=").length()).c_str()), 1);
+			}
+			else if (TmpStr.find("-shadowres") == 0)
+			{
+				ShadowMapSize = std::max(std::atoi(TmpStr.substr(std::string("-shadowres=").length()).c_str()), 256);
+			}
+			else if (TmpStr == "-nullrhi")
+			{
+				bNullRHI = true;
+			}
+			else if (TmpStr.find("-stats") == 0)
+			{
+				// -stats alone samples once a second at 60 fps
+				StatsInterval = TmpStr.size() > std::string("-stats=").length() ? std::max(std::atoi(TmpStr.substr(std::string("-stats=").length()).c_str()), 1) : 60;
+			}
 		}
 		// ...
 	}
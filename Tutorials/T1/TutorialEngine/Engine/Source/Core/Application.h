@@ -8,7 +8,7 @@ namespace ks
 	{
 		friend FEngine;
 	public:
-		IApp() : Engine(nullptr), WinX(0), WinY(0), ResX(800), ResY(600){}
+		IApp() : Engine(nullptr), WinX(0), WinY(0), ResX(800), ResY(600), bHotReload(false), bWorldPartition(false), NumViews(1), NumShadowCascades(4), ShadowMapSize(2048), bNullRHI(false), StatsInterval(0){}
 		virtual ~IApp();
 		void PreInit();
 		virtual void Init();
@@ -28,6 +28,19 @@ namespace ks
 		// window settings
 		uint32_t WinX, WinY;
 		uint32_t ResX, ResY;
+		// watch the content directory and reimport modified assets
+		bool bHotReload;
+		// stream the cooked world partition of the map around the camera instead of loading it whole
+		bool bWorldPartition;
+		// split screen, the window is cut into a grid of views cycling through the scene cameras
+		uint32_t NumViews;
+		// shadow cascades and the size of each
+		uint32_t NumShadowCascades;
+		uint32_t ShadowMapSize;
+		// render without a gpu, the commands are checked and dropped
+		bool bNullRHI;
+		// frames between the visibility stats in the log, 0 never
+		uint32_t StatsInterval;
 	};
 
 	extern KS_API IApp* GApp;
@@ -0,0 +1,301 @@
+#include "engine_pch.h"
+#include "Core/Asset/AssetCooker.h"
+#include "Core/Asset/Assets.h"
+#include "Core/Asset/CookedData.h"
+#include "Core/Asset/MeshAsset.h"
+#include "Core/Asset/MaterialData.h"
+#include "Core/Asset/PartitionData.h"
+#include "Core/Asset/SceneSnapshot.h"
+#include "Core/Asset/TextureImporter.h"
+#include "Core/JobSystem.h"
+
+namespace ks
+{
+	namespace
+	{
+		/* a parsed scene with its buffers loaded, alive while the graph executes */
+		struct FSourceScene
+		{
+			std::string Path;
+			gltf::FScene Scene;
+			// hash of the gltf file and all its buffers
+			uint64 SourceHash{ 0 };
+			std::vector<std::string> MeshKeys;
+			// parsed and loaded, a broken scene is left out of the graph
+			bool bValid{ false };
+		};
+
+		/* place every mesh node of the default scene in the cell of its world box center */
+		void BuildPartition(const gltf::FScene& Scene, float CellSize, FWorldPartitionData& PartitionData)
+		{
+			PartitionData.CellSize = CellSize;
+			std::map<std::pair<int32, int32>, uint32> CellIds;
+			// parents are resolved before their children
+			std::vector<std::pair<int32, glm::mat4>> Stack;
+			for (int32 NodeId : Scene.scenes.at(Scene.scene).nodes)
+			{
+				Stack.push_back({ NodeId, glm::mat4(1.f) });
+			}
+			while (!Stack.empty())
+			{
+				const auto [NodeId, ParentTrans] = Stack.back();
+				Stack.pop_back();
+				const gltf::FNodeInfo& Node{ Scene.nodes.at(NodeId) };
+				glm::mat4 LocalTrans{ glm::mat4_cast(Node.GetRotation()) * glm::scale(glm::mat4(1.f), Node.GetScale()) };
+				LocalTrans[3] = glm::vec4(Node.GetTranslation(), 1.f);
+				const glm::mat4 WorldTrans{ ParentTrans * LocalTrans };
+				for (int32 ChildId : Node.children)
+				{
+					Stack.push_back({ ChildId, WorldTrans });
+				}
+				if (!Node.IsMeshNode())
+				{
+					continue;
+				}
+				// the position bounds, as imported by gltf::LoadMeshData
+				const gltf::FMesh& Mesh{ Scene.meshes.at(Node.mesh) };
+				const gltf::FAccessor& Positions{ Scene.accessors.at(Mesh.primitives.at(0).attributes.at("POSITION")) };
+				const FBounds::FBox LocalBox{
+					glm::vec3(Positions.min[0], Positions.min[1], Positions.min[2]),
+					glm::vec3(Positions.max[0], Positions.max[1], Positions.max[2]) };
+				FBounds::FBox WorldBox;
+				util::TransformBoxes(1, &WorldTrans, &LocalBox, &WorldBox);
+				const glm::vec3 Center{ WorldBox.Center() };
+				const glm::ivec2 Coord{ glm::floor(glm::vec2(Center.x, Center.z) / CellSize) };
+				auto [It, bInserted] = CellIds.try_emplace({ Coord.x, Coord.y }, static_cast<uint32>(PartitionData.Cells.size()));
+				if (bInserted)
+				{
+					PartitionData.Cells.emplace_back();
+					PartitionData.Cells.back().Coord = Coord;
+					PartitionData.Cells.back().Box = WorldBox;
+				}
+				FPartitionCell& Cell{ PartitionData.Cells.at(It->second) };
+				Cell.Box += WorldBox;
+				Cell.Instances.push_back(FPartitionInstance{ NodeId, static_cast<uint32>(Node.mesh) });
+			}
+		}
+
+		struct FAtomicStats
+		{
+			std::atomic<uint32> NumCooked{ 0 };
+			std::atomic<uint32> NumSkipped{ 0 };
+			std::atomic<uint32> NumFailed{ 0 };
+		};
+	}
+
+	FAssetCooker::FAssetCooker(FJobSystem& InJobSystem, bool bInForce, bool bInFastTextures, float InPartitionCellSize)
+		:JobSystem(InJobSystem)
+		,bForce(bInForce)
+		,bFastTextures(bInFastTextures)
+		,PartitionCellSize(InPartitionCellSize)
+	{
+		assert(PartitionCellSize > 0.f);
+	}
+
+	FAssetCooker::FCookStats FAssetCooker::CookAll()
+	{
+		const std::string ContentDir{ util::GetContentPath("") };
+		std::vector<std::string> ScenePaths;
+		std::error_code Error;
+		for (const auto& Entry : std::filesystem::recursive_directory_iterator(ContentDir, Error))
+		{
+			if (Entry.is_regular_file(Error) && Entry.path().extension() == ".gltf")
+			{
+				ScenePaths.push_back("/" + std::filesystem::relative(Entry.path(), ContentDir, Error).generic_string());
+			}
+		}
+		return Cook(ScenePaths);
+	}
+
+	FAssetCooker::FCookStats FAssetCooker::Cook(const std::vector<std::string>& ScenePaths)
+	{
+		const auto StartTime{ std::chrono::steady_clock::now() };
+
+		// parse the scenes and load their buffers, one scene per job
+		FAtomicStats Stats;
+		std::vector<FSourceScene> SourceScenes(ScenePaths.size());
+		JobSystem.ParallelFor(static_cast<uint32>(ScenePaths.size()), [&](uint32 Index) {
+			FSourceScene& Source{ SourceScenes.at(Index) };
+			Source.Path = ScenePaths.at(Index);
+			// one bad file fails its scene only, the others still cook
+			if (!gltf::LoadSceneSource(Source.Path, Source.Scene))
+			{
+				KS_INFOA(("Cook : skip scene " + Source.Path).c_str());
+				++Stats.NumFailed;
+				return;
+			}
+			Source.bValid = true;
+			// the loaders hash the same files to find stale cooked scenes
+			std::vector<std::string> BufferPaths;
+			for (const gltf::FBuffer& Buffer : Source.Scene.buffers)
+			{
+				BufferPaths.push_back(Source.Scene.root + "/" + Buffer.uri);
+			}
+			Source.SourceHash = cooked::HashSceneSource(Source.Path, BufferPaths);
+		});
+
+		// build the dependency graph, meshes, materials and textures shared by scenes are cooked once
+		auto IsUpToDate = [this](const std::string& FilePath, uint32 Magic, uint64 SourceHash) {
+			uint64 CookedHash{ 0 };
+			return !bForce && cooked::ReadSourceHash(FilePath, Magic, CookedHash) && CookedHash == SourceHash;
+		};
+		auto CountResult = [&Stats](const std::string& FilePath, bool bSucceeded) {
+			if (!bSucceeded)
+			{
+				KS_INFOA(("Cook : failed to write " + FilePath).c_str());
+			}
+			++(bSucceeded ? Stats.NumCooked : Stats.NumFailed);
+		};
+
+		FTaskGraph TaskGraph;
+		std::unordered_map<std::string, FTaskGraph::FTaskId> TextureTasks;
+		std::unordered_map<std::string, FTaskGraph::FTaskId> MaterialTasks;
+		std::unordered_map<std::string, FTaskGraph::FTaskId> MeshTasks;
+		for (FSourceScene& Source : SourceScenes)
+		{
+			if (!Source.bValid)
+			{
+				continue;
+			}
+			const gltf::FScene& Scene{ Source.Scene };
+			std::vector<FTaskGraph::FTaskId> SceneDependencies;
+			for (const gltf::FMesh& Mesh : Scene.meshes)
+			{
+				const std::string MeshKey{ gltf::GetAssetKeyName(Scene, Mesh.name) };
+				Source.MeshKeys.push_back(MeshKey);
+				if (MeshTasks.contains(MeshKey))
+				{
+					SceneDependencies.push_back(MeshTasks.at(MeshKey));
+					continue;
+				}
+
+				std::vector<FTaskGraph::FTaskId> MeshDependencies;
+				const int32 MaterialId{ Mesh.primitives.at(0).material };
+				if (MaterialId != -1)
+				{
+					const gltf::FMaterial& Material{ Scene.materials.at(MaterialId) };
+					const std::string MaterialKey{ gltf::GetAssetKeyName(Scene, Material.name) };
+					if (!MaterialTasks.contains(MaterialKey))
+					{
+						std::vector<FTaskGraph::FTaskId> MaterialDependencies;
+						for (uint32 SlotIndex{ 0 }; SlotIndex < NumTextureSlots; ++SlotIndex)
+						{
+							const ETextureSlot Slot{ static_cast<ETextureSlot>(SlotIndex) };
+							const int32 TextureIndex{ gltf::GetMaterialTexture(Material, Slot) };
+							if (TextureIndex == -1)
+							{
+								continue;
+							}
+							const std::string TextureKey{ gltf::GetTextureKeyName(Scene, TextureIndex) };
+							if (!TextureTasks.contains(TextureKey))
+							{
+								TextureTasks[TextureKey] = TaskGraph.AddTask([&, TextureKey, TextureIndex, Slot]() {
+									const std::string FilePath{ cooked::GetTexturePath(TextureKey) };
+									std::vector<uint8> SourceBytes;
+									if (!gltf::LoadTextureSource(Scene, TextureIndex, SourceBytes))
+									{
+										KS_INFOA(("Cook : missing image of " + TextureKey).c_str());
+										++Stats.NumFailed;
+										return;
+									}
+									// the slot and the compression mode pick the format, both are part of the hash
+									uint64 SourceHash{ util::HashBytes(&Slot, sizeof(Slot), cooked::Version) };
+									SourceHash = util::HashBytes(&bFastTextures, sizeof(bFastTextures), SourceHash);
+									SourceHash = util::HashBytes(SourceBytes.data(), SourceBytes.size(), SourceHash);
+									if (IsUpToDate(FilePath, cooked::TextureMagic, SourceHash))
+									{
+										++Stats.NumSkipped;
+										return;
+									}
+									FTextureData TextureData;
+									TextureData.KeyName = TextureKey;
+									if (!texture::ImportTexture(SourceBytes.data(), SourceBytes.size(), Slot, bFastTextures, JobSystem, TextureData))
+									{
+										KS_INFOA(("Cook : failed to decode " + TextureKey).c_str());
+										++Stats.NumFailed;
+										return;
+									}
+									CountResult(FilePath, cooked::WriteTexture(FilePath, TextureData, SourceHash));
+								});
+							}
+							MaterialDependencies.push_back(TextureTasks.at(TextureKey));
+						}
+						MaterialTasks[MaterialKey] = TaskGraph.AddTask([&, MaterialKey]() {
+							const std::string FilePath{ cooked::GetMaterialPath(MaterialKey) };
+							const uint64 SourceHash{ gltf::GetMaterialSourceHash(Material) };
+							if (IsUpToDate(FilePath, cooked::MaterialMagic, SourceHash))
+							{
+								++Stats.NumSkipped;
+								return;
+							}
+							FMaterialData MaterialData;
+							gltf::LoadMaterialData(Scene, Material, MaterialData);
+							CountResult(FilePath, cooked::WriteMaterial(FilePath, MaterialData, SourceHash));
+						}, MaterialDependencies);
+					}
+					MeshDependencies.push_back(MaterialTasks.at(MaterialKey));
+				}
+
+				MeshTasks[MeshKey] = TaskGraph.AddTask([&, MeshKey]() {
+					const std::string FilePath{ cooked::GetMeshPath(MeshKey) };
+					const uint64 SourceHash{ gltf::GetMeshSourceHash(Scene, Mesh) };
+					if (IsUpToDate(FilePath, cooked::MeshMagic, SourceHash))
+					{
+						++Stats.NumSkipped;
+						return;
+					}
+					FMeshData MeshData;
+					gltf::LoadMeshData(Scene, Mesh, MeshData);
+					CountResult(FilePath, cooked::WriteMesh(FilePath, MeshData, SourceHash));
+				}, MeshDependencies);
+				SceneDependencies.push_back(MeshTasks.at(MeshKey));
+			}
+
+			// the scene snapshot is written last, its presence means the meshes are cooked
+			TaskGraph.AddTask([&]() {
+				const std::string FilePath{ cooked::GetScenePath(Source.Path) };
+				if (IsUpToDate(FilePath, cooked::SceneMagic, Source.SourceHash))
+				{
+					++Stats.NumSkipped;
+					return;
+				}
+				FSceneSnapshot Snapshot;
+				gltf::BuildSnapshot(Source.Scene, Snapshot);
+				CountResult(FilePath, cooked::WriteScene(FilePath, Snapshot, Source.SourceHash));
+			}, SceneDependencies);
+
+			// the partition lists the mesh file sizes, cooked after the meshes as well
+			TaskGraph.AddTask([&]() {
+				const std::string FilePath{ cooked::GetPartitionPath(Source.Path) };
+				const uint64 SourceHash{ util::HashBytes(&PartitionCellSize, sizeof(PartitionCellSize), Source.SourceHash) };
+				if (IsUpToDate(FilePath, cooked::PartitionMagic, SourceHash))
+				{
+					++Stats.NumSkipped;
+					return;
+				}
+				FWorldPartitionData PartitionData;
+				BuildPartition(Source.Scene, PartitionCellSize, PartitionData);
+				PartitionData.MeshKeys = Source.MeshKeys;
+				for (const std::string& MeshKey : PartitionData.MeshKeys)
+				{
+					std::error_code Error;
+					const uintmax_t FileSize{ std::filesystem::file_size(cooked::GetMeshPath(MeshKey), Error) };
+					PartitionData.MeshBytes.push_back(Error ? 0 : static_cast<uint64>(FileSize));
+				}
+				CountResult(FilePath, cooked::WritePartition(FilePath, PartitionData, SourceHash));
+			}, SceneDependencies);
+		}
+
+		TaskGraph.Execute(JobSystem);
+
+		FCookStats CookStats;
+		CookStats.NumScenes = static_cast<uint32>(SourceScenes.size());
+		CookStats.NumCooked = Stats.NumCooked;
+		CookStats.NumSkipped = Stats.NumSkipped;
+		CookStats.NumFailed = Stats.NumFailed;
+		CookStats.Seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - StartTime).count();
+		KS_INFOA(std::format("Cook : {} scenes, {} cooked, {} up to date, {} failed, {:.2f} s",
+			CookStats.NumScenes, CookStats.NumCooked, CookStats.NumSkipped, CookStats.NumFailed, CookStats.Seconds).c_str());
+		return CookStats;
+	}
+}
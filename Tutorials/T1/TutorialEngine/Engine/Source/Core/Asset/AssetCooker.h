@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Core/CoreMinimal.h"
+
+namespace ks
+{
+	class FJobSystem;
+
+	/*
+	* offline cooker, imports the gltf scenes under the content directory and writes
+	* the runtime files under the cooked directory, see cooked namespace
+	* the dependency graph is scene -> meshes -> materials -> textures, independent nodes cook in parallel
+	* every scene also gets a world partition, its mesh nodes split into cells of PartitionCellSize
+	* outputs whose source hash is unchanged are skipped
+	*/
+	class KS_API FAssetCooker
+	{
+	public:
+		struct FCookStats
+		{
+			uint32 NumScenes{ 0 };
+			uint32 NumCooked{ 0 };
+			uint32 NumSkipped{ 0 };
+			uint32 NumFailed{ 0 };
+			float Seconds{ 0.f };
+		};
+
+		static constexpr float DefaultPartitionCellSize{ 64.f };
+
+		FAssetCooker(FJobSystem& InJobSystem, bool bInForce = false, bool bInFastTextures = false,
+			float InPartitionCellSize = DefaultPartitionCellSize);
+		// cook every .gltf file under the content directory
+		FCookStats CookAll();
+		// cook the scenes at the content paths, e.g. "/Map/Map.gltf"
+		FCookStats Cook(const std::vector<std::string>& ScenePaths);
+	private:
+		FJobSystem& JobSystem;
+		// ignore the source hashes and cook everything
+		bool bForce;
+		// bc3 instead of bc7 for base color textures with alpha
+		bool bFastTextures;
+		// edge of the world partition cells on the xz plane
+		float PartitionCellSize;
+	};
+}
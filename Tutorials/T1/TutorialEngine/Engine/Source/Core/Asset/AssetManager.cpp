@@ -2,7 +2,10 @@
 #include "Core/Asset/AssetManager.h"
 #include "Core/Asset/MeshAsset.h"
 #include "Core/Asset/MaterialAsset.h"
+#include "Core/Asset/TextureAsset.h"
 #include "Core/Asset/Assets.h"
+#include "Core/Asset/ContentWatcher.h"
+#include "RHI/RHI.h"
 
 namespace ks
 {
@@ -13,6 +16,13 @@ namespace ks
 		return GAssetManager = new FAssetManager;
 	}
 
+	FAssetManager::FAssetManager() = default;
+
+	FAssetManager::~FAssetManager()
+	{
+		KS_INFO(TEXT("~FAssetManager"));
+	}
+
 	void FAssetManager::Init()
 	{
 		KS_INFO(TEXT("FAssetManager::Init"));
@@ -25,10 +35,56 @@ namespace ks
 		{
 			KS_INFOA(std::format("{}", asset.second.use_count()).c_str());
 		}*/
+		ContentWatcher.reset();
 		Assets.clear();
 	}
 
-	std::shared_ptr<FSceneAsset> FAssetManager::CreateSceneAsset(const std::string& InGLTFPath)
+	void FAssetManager::EnableHotReload()
+	{
+		KS_INFO(TEXT("FAssetManager::EnableHotReload"));
+		ContentWatcher = std::make_unique<FContentWatcher>(util::GetContentPath(""));
+	}
+
+	bool FAssetManager::ReimportChangedAssets(std::vector<std::shared_ptr<FStaticMeshAsset>>& OutMeshAssets,
+		std::filesystem::file_time_type& OutFirstWriteTime)
+	{
+		assert(ContentWatcher);
+		std::vector<FContentWatcher::FChangedFile> ChangedFiles;
+		ContentWatcher->Poll(ChangedFiles);
+		if (ChangedFiles.empty())
+		{
+			return false;
+		}
+		OutFirstWriteTime = std::filesystem::file_time_type::max();
+		// a scene is re-imported once even if both its gltf and bin files changed
+		std::set<FSceneAsset*> ChangedScenes;
+		for (const auto& ChangedFile : ChangedFiles)
+		{
+			for (auto& [Path, Asset] : Assets)
+			{
+				FSceneAsset* SceneAsset = dynamic_cast<FSceneAsset*>(Asset.get());
+				if (SceneAsset && SceneAsset->IsSourceFile(ChangedFile.Path))
+				{
+					ChangedScenes.insert(SceneAsset);
+					OutFirstWriteTime = std::min(OutFirstWriteTime, ChangedFile.WriteTime);
+				}
+			}
+		}
+		// the frames in flight still draw with the render data about to be replaced
+		if (!ChangedScenes.empty())
+		{
+			GRHI->FlushRenderingCommands();
+		}
+		for (FSceneAsset* SceneAsset : ChangedScenes)
+		{
+			KS_INFOA(("HotReload : " + SceneAsset->GetPath()).c_str());
+			auto MeshAssets = SceneAsset->Reimport();
+			OutMeshAssets.insert(OutMeshAssets.end(), MeshAssets.begin(), MeshAssets.end());
+		}
+		return !OutMeshAssets.empty();
+	}
+
+	std::shared_ptr<FSceneAsset> FAssetManager::CreateSceneAsset(const std::string& InGLTFPath, bool bLoadMeshes)
 	{
 		KS_INFO(TEXT("FAssetManager::Load GLTF Scene"));
 
@@ -38,7 +94,7 @@ namespace ks
 		}
 		assert(InGLTFPath.ends_with(".gltf"));
 		assert(Assets.find(InGLTFPath) == Assets.end());
-		std::shared_ptr<FSceneAsset> SceneAsset = std::make_shared<FSceneAsset>(InGLTFPath);
+		std::shared_ptr<FSceneAsset> SceneAsset = std::make_shared<FSceneAsset>(InGLTFPath, bLoadMeshes);
 		Assets.insert({ InGLTFPath, SceneAsset });
 		return SceneAsset;
 	}
@@ -50,6 +106,13 @@ namespace ks
 		return Asset;
 	}
 
+	std::shared_ptr<ks::FStaticMeshAsset> FAssetManager::CreateStaticMeshAsset(FMeshData&& MeshData)
+	{
+		std::shared_ptr<FStaticMeshAsset> Asset = std::make_shared<FStaticMeshAsset>(std::move(MeshData));
+		Assets.insert({ Asset->GetPath(), Asset });
+		return Asset;
+	}
+
 	std::shared_ptr<ks::FMaterialAsset> FAssetManager::CreateMaterialAsset(const FMaterialData& MaterialData)
 	{
 		std::shared_ptr<FMaterialAsset> Asset = std::make_shared<FMaterialAsset>(MaterialData);
@@ -57,6 +120,14 @@ namespace ks
 		return Asset;
 	}
 
+	std::shared_ptr<ks::FTextureAsset> FAssetManager::CreateTextureAsset(const std::string& KeyName)
+	{
+		std::shared_ptr<FTextureAsset> Asset = std::make_shared<FTextureAsset>(KeyName);
+		Assets.insert({ Asset->GetPath(), Asset });
+		Asset->PostLoad();
+		return Asset;
+	}
+
 	FAssetManager::SharedAssetPtr FAssetManager::GetAsset(const std::string& Path)
 	{
 		if (Assets.contains(Path))
@@ -65,4 +136,9 @@ namespace ks
 		}
 		return nullptr;
 	}
+
+	void FAssetManager::UnloadAsset(const std::string& Path)
+	{
+		Assets.erase(Path);
+	}
 }
\ No newline at end of file
@@ -8,6 +8,8 @@ namespace ks
 	class FSceneAsset;
 	class FStaticMeshAsset;
 	class FMaterialAsset;
+	class FTextureAsset;
+	class FContentWatcher;
 
 	class FAssetManager
 	{
@@ -15,22 +17,34 @@ namespace ks
 		using SharedAssetPtr = std::shared_ptr<IAsset>;
 
 		static FAssetManager* Create();
-		~FAssetManager() {
-			KS_INFO(TEXT("~FAssetManager"));
-		}
+		FAssetManager();
+		~FAssetManager();
 		void Init();
 		void Shutdown();
-		// Create scene asset from gltf file
-		std::shared_ptr<FSceneAsset> CreateSceneAsset(const std::string& GLTFScenePath);
+		// watch the content directory and re-import changed assets
+		void EnableHotReload();
+		bool IsHotReloadEnabled() const { return ContentWatcher != nullptr; }
+		// re-import the meshes changed on disk, returns false if nothing changed
+		bool ReimportChangedAssets(std::vector<std::shared_ptr<FStaticMeshAsset>>& OutMeshAssets,
+			std::filesystem::file_time_type& OutFirstWriteTime);
+		// Create scene asset from gltf file, a streamed scene leaves its meshes to the world partition
+		std::shared_ptr<FSceneAsset> CreateSceneAsset(const std::string& GLTFScenePath, bool bLoadMeshes = true);
 		// Create static mesh asset
 		std::shared_ptr<FStaticMeshAsset> CreateStaticMeshAsset(const FMeshData& MeshData);
+		std::shared_ptr<FStaticMeshAsset> CreateStaticMeshAsset(FMeshData&& MeshData);
 		// Create material asset
 		std::shared_ptr<FMaterialAsset> CreateMaterialAsset(const FMaterialData& MaterialData);
+		// Create texture asset from its cooked file
+		std::shared_ptr<FTextureAsset> CreateTextureAsset(const std::string& KeyName);
 		// Get asset shared ptr form path
 		SharedAssetPtr GetAsset(const std::string& Path);
+		// drop the manager's reference, the asset is released with its last user
+		void UnloadAsset(const std::string& Path);
 
 	private:
 		std::unordered_map<std::string, SharedAssetPtr> Assets;
+		// hot reload
+		std::unique_ptr<FContentWatcher> ContentWatcher;
 		//using FSizeType = std::unordered_map<std::string, SharedAssetPtr>::size_type;
 	};
 
@@ -3,6 +3,8 @@
 #include "Core/Asset/MeshAsset.h"
 #include "Core/Asset/MaterialData.h"
 #include "Core/Asset/AssetManager.h"
+#include "Core/Asset/CookedData.h"
+#include "Core/Asset/SceneSnapshot.h"
 #include "Core/Scene.h"
 
 namespace ks {
@@ -22,18 +24,12 @@ namespace ks {
 		namespace {
 			/* load bin file to the RawData */
 			int LoadBuffer(const FScene& Scene, FBuffer& Buffer);
-			/* load all bin files to RawData */
-			void LoadBuffers(FScene& Scene);
-			/* load mesh data form buffer */
-			void LoadMeshData(const FScene& Scene, const FMesh& Mesh, FMeshData& MeshData);
+			/* every buffer view inside its loaded buffer and every mesh accessor on a view, the importer reads them unchecked */
+			bool ValidateBufferViews(const FScene& Scene);
 			/* get accessor */
 			const FAccessor& GetAccessor(const FScene& Scene, const int32 AccessorIndex);
 			/* get elem type enum by the type name */
 			EELEM_TYPE GetElemType(const std::string& TypeName);
-			/* key name used by asset manager */
-			std::string GetAssetKeyName(const FScene& Scene, const std::string& MeshName) {
-				return Scene.root + "/" + MeshName;
-			}
 			/* set node parent id */
 			void SetNodeParent(FScene& Scene) {
 				int32 node_id = 0;
@@ -46,22 +42,6 @@ namespace ks {
 				}
 			}
 
-
-			struct FBufferLoadingHelper
-			{
-				FScene& Scene;
-				FBufferLoadingHelper(FScene& _Scene):Scene(_Scene) {
-					LoadBuffers(Scene);
-				}
-
-				~FBufferLoadingHelper() {
-					auto& Buffers{Scene.buffers};
-					std::for_each(Buffers.begin(), Buffers.end(), [](FBuffer& Buffer) {
-						Buffer.RawData.clear();
-					});
-				}
-			};
-
 			ECameraType GetCameraType(const std::string& type)
 			{
 				ECameraType Type = ECameraType::INVALID;
@@ -104,6 +84,139 @@ namespace ks {
 				CopyRawData(Scene, Accessor, AttributeData.Data);
 			}
 		}
+
+		std::string GetAssetKeyName(const FScene& Scene, const std::string& Name)
+		{
+			return Scene.root + "/" + Name;
+		}
+
+		void ParseScene(const std::string& Path, FScene& Scene)
+		{
+			// open file stream
+			std::string FilePath = util::GetContentPath(Path);
+			std::ifstream InStream(FilePath);
+			assert(InStream.is_open());
+
+			// load gltf data
+			json GLTFLevelJson;
+			InStream >> GLTFLevelJson;
+			Scene = GLTFLevelJson.get<FScene>();
+			// scenes without textures leave these out
+			if (GLTFLevelJson.contains("images"))
+			{
+				GLTFLevelJson.at("images").get_to(Scene.images);
+			}
+			if (GLTFLevelJson.contains("samplers"))
+			{
+				GLTFLevelJson.at("samplers").get_to(Scene.samplers);
+			}
+			if (GLTFLevelJson.contains("textures"))
+			{
+				GLTFLevelJson.at("textures").get_to(Scene.textures);
+			}
+			Scene.root = FString::GetRootPath(Path);
+			SetNodeParent(Scene);
+		}
+
+		FBufferLoadingHelper::FBufferLoadingHelper(FScene& _Scene)
+			:Scene(_Scene)
+		{
+			LoadBuffers(Scene);
+		}
+
+		FBufferLoadingHelper::~FBufferLoadingHelper()
+		{
+			auto& Buffers{Scene.buffers};
+			std::for_each(Buffers.begin(), Buffers.end(), [](FBuffer& Buffer) {
+				Buffer.RawData.clear();
+			});
+		}
+
+		uint64 GetMeshSourceHash(const FScene& Scene, const FMesh& Mesh)
+		{
+			const gltf::FMesh::FPrimitive& Primitive = Mesh.primitives.at(0);
+			uint64 Hash{ util::HashBytes(Mesh.name.data(), Mesh.name.size()) };
+			auto HashAccessor = [&Scene, &Hash](int32 AccessorIndex) {
+				const FAccessor& Accessor{ GetAccessor(Scene, AccessorIndex) };
+				const FBufferView& BufferView{ Scene.bufferViews.at(Accessor.bufferView) };
+				const FBuffer& Buffer{ Scene.buffers.at(BufferView.buffer) };
+				Hash = util::HashBytes(Buffer.RawData.data() + BufferView.byteOffset, BufferView.byteLength, Hash);
+			};
+			HashAccessor(Primitive.indices);
+			for (const auto& [Name, AccessorIndex] : Primitive.attributes)
+			{
+				HashAccessor(AccessorIndex);
+			}
+			if (Primitive.material != -1)
+			{
+				const FMaterial& Material{ Scene.materials.at(Primitive.material) };
+				Hash = util::HashBytes(&Material.pbrMetallicRoughness, sizeof(Material.pbrMetallicRoughness), Hash);
+			}
+			return Hash;
+		}
+
+		uint64 GetMaterialSourceHash(const FMaterial& Material)
+		{
+			uint64 Hash{ util::HashBytes(Material.name.data(), Material.name.size()) };
+			Hash = util::HashBytes(&Material.normalTexture, sizeof(Material.normalTexture), Hash);
+			return util::HashBytes(&Material.pbrMetallicRoughness, sizeof(Material.pbrMetallicRoughness), Hash);
+		}
+
+		int32 GetMaterialTexture(const FMaterial& Material, ETextureSlot Slot)
+		{
+			switch (Slot)
+			{
+			case ETextureSlot::BaseColor:
+				return Material.pbrMetallicRoughness.baseColorTexture.index;
+			case ETextureSlot::MetallicRoughness:
+				return Material.pbrMetallicRoughness.metallicRoughnessTexture.index;
+			case ETextureSlot::Normal:
+				return Material.normalTexture.index;
+			default:
+				assert(false);
+				return -1;
+			}
+		}
+
+		std::string GetTextureKeyName(const FScene& Scene, int32 TextureIndex)
+		{
+			const int32 ImageIndex{ Scene.textures.at(TextureIndex).source };
+			const FImage& Image{ Scene.images.at(ImageIndex) };
+			if (!Image.name.empty())
+			{
+				return GetAssetKeyName(Scene, Image.name);
+			}
+			if (!Image.uri.empty())
+			{
+				return GetAssetKeyName(Scene, std::filesystem::path(Image.uri).stem().generic_string());
+			}
+			return GetAssetKeyName(Scene, "Image" + std::to_string(ImageIndex));
+		}
+
+		bool LoadTextureSource(const FScene& Scene, int32 TextureIndex, std::vector<uint8>& OutBytes)
+		{
+			const FImage& Image{ Scene.images.at(Scene.textures.at(TextureIndex).source) };
+			if (Image.bufferView != -1)
+			{
+				const FBufferView& BufferView{ Scene.bufferViews.at(Image.bufferView) };
+				const FBuffer& Buffer{ Scene.buffers.at(BufferView.buffer) };
+				if (Buffer.RawData.size() < static_cast<size_t>(BufferView.byteOffset) + BufferView.byteLength)
+				{
+					return false;
+				}
+				const uint8* Begin{ Buffer.RawData.data() + BufferView.byteOffset };
+				OutBytes.assign(Begin, Begin + BufferView.byteLength);
+				return true;
+			}
+			// embedded data uris are not supported
+			if (Image.uri.empty() || Image.uri.rfind("data:", 0) == 0)
+			{
+				return false;
+			}
+			std::ifstream InStream(util::GetContentPath(Scene.root + "/" + Image.uri), std::ios::in | std::ios::binary);
+			OutBytes.assign(std::istreambuf_iterator<char>(InStream), std::istreambuf_iterator<char>());
+			return !OutBytes.empty();
+		}
 	}
 
 	IAsset::~IAsset()
@@ -118,30 +231,120 @@ namespace ks {
 		});*/
 	}
 
-	FSceneAsset::FSceneAsset(const std::string& GLTFPath)
+	FSceneAsset::FSceneAsset(const std::string& GLTFPath, bool bInLoadMeshes)
 		:IAsset(GLTFPath)
+		,Snapshot(std::make_unique<FSceneSnapshot>())
+		,bLoadMeshes(bInLoadMeshes)
 	{
 		LoadGLTF();
 	}
 
+	FSceneAsset::~FSceneAsset() = default;
+
 	void FSceneAsset::LoadGLTF()
 	{
-		// open file stream
-		std::string FilePath = util::GetContentPath(Path);
-		std::ifstream InStream(FilePath);
-		assert(InStream.is_open());
-
-		// load gltf data
-		json GLTFLevelJson;
-		InStream >> GLTFLevelJson;
-		GltfScene = GLTFLevelJson.get<gltf::FScene>();
-		GltfScene.root = FString::GetRootPath(Path);
-		gltf::SetNodeParent(GltfScene);
+		// prefer the output of the asset cooker, the snapshot skips the json parse and the node import
+		// a source edited since the last cook is imported again, the cooked meshes of the scene are as old as the scene
+		uint64 CookedHash{ 0 };
+		if (cooked::MapScene(cooked::GetScenePath(Path), *Snapshot, CookedHash))
+		{
+			if (CookedHash == cooked::HashSceneSource(Path, Snapshot->BufferPaths) && (!bLoadMeshes || LoadCookedAssets()))
+			{
+				bCooked = true;
+				return;
+			}
+			KS_INFOA(("Cooked scene is out of date : " + Path).c_str());
+		}
+		gltf::ParseScene(Path, GltfScene);
+		gltf::BuildSnapshot(GltfScene, *Snapshot);
 
 		// load contained assets
+		if (bLoadMeshes)
+		{
+			LoadContainedAssets();
+		}
+	}
+
+	void FSceneAsset::LoadMeshes()
+	{
+		assert(!bCooked && !bLoadMeshes);
+		bLoadMeshes = true;
 		LoadContainedAssets();
 	}
 
+	bool FSceneAsset::IsSourceFile(const std::string& ContentPath) const
+	{
+		return ContentPath == Path ||
+			std::find(Snapshot->BufferPaths.begin(), Snapshot->BufferPaths.end(), ContentPath) != Snapshot->BufferPaths.end();
+	}
+
+	std::vector<std::shared_ptr<FStaticMeshAsset>> FSceneAsset::Reimport()
+	{
+		// the exporter may still be writing the files, a failed import keeps the current meshes and snapshot
+		// and the write that completes the files notifies again
+		gltf::FScene NewScene;
+		if (!gltf::LoadSceneSource(Path, NewScene))
+		{
+			KS_INFOA(("Reimport : keep the current meshes of " + Path).c_str());
+			return {};
+		}
+
+		// import every changed mesh before any is replaced, the scene changes whole or not at all
+		struct FChangedMesh
+		{
+			std::shared_ptr<FStaticMeshAsset> Asset;
+			FMeshData MeshData;
+			uint64 SourceHash{ 0 };
+		};
+		std::vector<FChangedMesh> ChangedMeshes;
+		FSceneSnapshot NewSnapshot;
+		try
+		{
+			for (const gltf::FMesh& Mesh : NewScene.meshes)
+			{
+				const std::string KeyName{ gltf::GetAssetKeyName(NewScene, Mesh.name) };
+				auto StaticMeshAsset = std::dynamic_pointer_cast<FStaticMeshAsset>(GAssetManager->GetAsset(KeyName));
+				if (!StaticMeshAsset)
+				{
+					// new meshes need new scene nodes, which is a scene reload, a streamed scene misses its unloaded meshes
+					if (bLoadMeshes)
+					{
+						KS_INFOA(("Reimport : skip new mesh " + KeyName).c_str());
+					}
+					continue;
+				}
+				const uint64 SourceHash{ gltf::GetMeshSourceHash(NewScene, Mesh) };
+				if (SourceHash == StaticMeshAsset->GetSourceHash())
+				{
+					continue;
+				}
+				ChangedMeshes.push_back(FChangedMesh{ StaticMeshAsset, {}, SourceHash });
+				gltf::LoadMeshData(NewScene, Mesh, ChangedMeshes.back().MeshData);
+			}
+			gltf::BuildSnapshot(NewScene, NewSnapshot);
+		}
+		catch (const std::exception& Exception)
+		{
+			KS_INFOA(("Reimport : keep the current meshes of " + Path + ", " + Exception.what()).c_str());
+			return {};
+		}
+
+		std::vector<std::shared_ptr<FStaticMeshAsset>> ChangedAssets;
+		for (FChangedMesh& ChangedMesh : ChangedMeshes)
+		{
+			ChangedMesh.Asset->Reimport(std::move(ChangedMesh.MeshData), ChangedMesh.SourceHash);
+			ChangedAssets.push_back(std::move(ChangedMesh.Asset));
+		}
+		*Snapshot = std::move(NewSnapshot);
+		// the buffers are only needed for the import
+		for (gltf::FBuffer& Buffer : NewScene.buffers)
+		{
+			Buffer.RawData.clear();
+		}
+		GltfScene = std::move(NewScene);
+		return ChangedAssets;
+	}
+
 	void FSceneAsset::LoadContainedAssets()
 	{
 		// load buffers
@@ -153,103 +356,142 @@ namespace ks {
 			FMeshData MeshData;
 			gltf::LoadMeshData(GltfScene, Mesh, MeshData);
 			std::shared_ptr<FStaticMeshAsset> StaticMeshAsset = GAssetManager->CreateStaticMeshAsset(MeshData);
+			StaticMeshAsset->SetSourceHash(gltf::GetMeshSourceHash(GltfScene, Mesh));
 			RefAssets.push_back(StaticMeshAsset);
 			StaticMeshAsset->PostLoad();
 		});
-
-		int32 a = 0;
 	}
 
-	void FSceneAsset::GetSceneNodeInfo(int32 NodeIndex, FSceneNodeInfo& NodeInfo) const
+	bool FSceneAsset::LoadCookedAssets()
 	{
-		const gltf::FNodeInfo& GLTF_NodeInfo = GltfScene.nodes.at(NodeIndex);
-
-		NodeInfo.id = NodeIndex;
-		NodeInfo.Name = GLTF_NodeInfo.GetName();
-		NodeInfo.Translate = GLTF_NodeInfo.GetTranslation();
-		NodeInfo.Rotation = GLTF_NodeInfo.GetRotation();
-		NodeInfo.Scale = GLTF_NodeInfo.GetScale();
-		NodeInfo.ChildrenIds = GLTF_NodeInfo.children;
-
-		if (GLTF_NodeInfo.mesh != -1)
-		{
-			const gltf::FMesh& GLTF_Mesh = GltfScene.meshes.at(GLTF_NodeInfo.mesh);
-			NodeInfo.MeshAssetKeyName = gltf::GetAssetKeyName(GltfScene, GLTF_Mesh.name);
-		}
-
-		if (GLTF_NodeInfo.camera != -1)
+		const std::vector<std::string>& MeshKeys{ Snapshot->MeshKeys };
+		// read all files first, fall back to the gltf import if any of them is missing
+		std::vector<FMeshData> MeshDatas(MeshKeys.size());
+		std::vector<uint64> SourceHashes(MeshKeys.size());
+		for (size_t i{ 0 }; i < MeshKeys.size(); ++i)
 		{
-			const gltf::FCamera GLTF_Camera = GltfScene.cameras.at(GLTF_NodeInfo.camera);
-			NodeInfo.Camera.Type = gltf::GetCameraType(GLTF_Camera.type);
-			const auto& Type{ NodeInfo.Camera.Type };
-			switch (Type)
-			{
-			case ECameraType::PERSPECTIVE:
-				NodeInfo.Camera.CameraData = {
-					GLTF_Camera.perspective.yfov,
-					GLTF_Camera.perspective.zfar,
-					GLTF_Camera.perspective.znear
-				};
-				break;
-			case ECameraType::ORTHOGRAPHIC:
-				NodeInfo.Camera.CameraData = {
-						GLTF_Camera.orthographic.xmag,
-						GLTF_Camera.orthographic.ymag,
-						GLTF_Camera.orthographic.zfar,
-						GLTF_Camera.orthographic.znear
-				};
-				break;
+			FMeshData& MeshData{ MeshDatas.at(i) };
+			if (!cooked::ReadMesh(cooked::GetMeshPath(MeshKeys.at(i)), MeshData, SourceHashes.at(i)))
+			{
+				return false;
+			}
+			const std::string& MaterialKey{ MeshData.MaterialData.KeyName };
+			if (!MaterialKey.empty() && !cooked::ReadMaterial(cooked::GetMaterialPath(MaterialKey), MeshData.MaterialData))
+			{
+				return false;
 			}
 		}
-
-		if (GLTF_NodeInfo.light != -1)
+		KS_INFOA(("Load cooked : " + Path).c_str());
+		for (size_t i{ 0 }; i < MeshKeys.size(); ++i)
 		{
-			const gltf::FKHRLightsPunctual::FLight& GLTF_Light{ GltfScene.extensions.KHR_lights_punctual.lights.at(GLTF_NodeInfo.light) };
-			NodeInfo.Light.Intensity = GLTF_Light.intensity;
-			NodeInfo.Light.Type = util::GetLightType(GLTF_Light.type);
+			std::shared_ptr<FStaticMeshAsset> StaticMeshAsset = GAssetManager->CreateStaticMeshAsset(std::move(MeshDatas.at(i)));
+			StaticMeshAsset->SetSourceHash(SourceHashes.at(i));
+			RefAssets.push_back(StaticMeshAsset);
+			StaticMeshAsset->PostLoad();
 		}
+		return true;
 	}
 
-	std::vector<ks::FSceneNodeInfo> FSceneAsset::GetSceneNodeInfos() const
+	namespace gltf
 	{
-		std::vector<FSceneNodeInfo> SceneNodeInfos;
-
-		const gltf::FSceneInfo& SceneInfo{ GltfScene.scenes.at(GltfScene.scene) };
-		std::deque<int32> NodeIds(SceneInfo.nodes.begin(), SceneInfo.nodes.end());
-		while (!NodeIds.empty())
+		void BuildSnapshot(const FScene& Scene, FSceneSnapshot& Snapshot)
 		{
-			int32& NodeId{ NodeIds.front() };
-
-			FSceneNodeInfo SceneNodeInfo;
-			GetSceneNodeInfo(NodeId, SceneNodeInfo);
-			SceneNodeInfos.push_back(SceneNodeInfo);
+			Snapshot = FSceneSnapshot{};
+			Snapshot.NumAssetNodes = static_cast<uint32>(Scene.nodes.size());
+			for (const FMesh& Mesh : Scene.meshes)
+			{
+				Snapshot.MeshKeys.push_back(GetAssetKeyName(Scene, Mesh.name));
+			}
+			for (const FBuffer& Buffer : Scene.buffers)
+			{
+				Snapshot.BufferPaths.push_back(Scene.root + "/" + Buffer.uri);
+			}
 
-			for (auto& ChildId : SceneNodeInfo.ChildrenIds)
+			// breadth first from the roots of the default scene, the queue holds the node id and its parent index
+			const FSceneInfo& SceneInfo{ Scene.scenes.at(Scene.scene) };
+			std::deque<std::pair<int32, int32>> Queue;
+			for (int32 NodeId : SceneInfo.nodes)
 			{
-				NodeIds.push_back(ChildId);
+				Queue.push_back({ NodeId, -1 });
 			}
-			NodeIds.pop_front();
-		}
+			Snapshot.Nodes.reserve(Scene.nodes.size());
+			while (!Queue.empty())
+			{
+				const auto [NodeId, Parent] = Queue.front();
+				Queue.pop_front();
+				const FNodeInfo& GLTF_NodeInfo{ Scene.nodes.at(NodeId) };
+				const int32 NodeIndex{ static_cast<int32>(Snapshot.Nodes.size()) };
+				for (int32 ChildId : GLTF_NodeInfo.children)
+				{
+					Queue.push_back({ ChildId, NodeIndex });
+				}
+
+				FSnapshotNode& Node{ Snapshot.Nodes.emplace_back() };
+				Node.Parent = Parent;
+				Node.AssetId = NodeId;
+				Node.NameOffset = static_cast<uint32>(Snapshot.Names.size());
+				Node.NameSize = static_cast<uint32>(GLTF_NodeInfo.GetName().size());
+				Snapshot.Names += GLTF_NodeInfo.GetName();
+				Node.Translate = GLTF_NodeInfo.GetTranslation();
+				Node.Rotation = GLTF_NodeInfo.GetRotation();
+				Node.Scale = GLTF_NodeInfo.GetScale();
+				Node.Mesh = GLTF_NodeInfo.mesh;
+
+				if (GLTF_NodeInfo.camera != -1)
+				{
+					const FCamera& GLTF_Camera{ Scene.cameras.at(GLTF_NodeInfo.camera) };
+					FCameraInfo& Camera{ Snapshot.Cameras.emplace_back() };
+					Camera.Type = GetCameraType(GLTF_Camera.type);
+					switch (Camera.Type)
+					{
+					case ECameraType::PERSPECTIVE:
+						Camera.CameraData = {
+							GLTF_Camera.perspective.yfov,
+							GLTF_Camera.perspective.zfar,
+							GLTF_Camera.perspective.znear
+						};
+						break;
+					case ECameraType::ORTHOGRAPHIC:
+						Camera.CameraData = {
+								GLTF_Camera.orthographic.xmag,
+								GLTF_Camera.orthographic.ymag,
+								GLTF_Camera.orthographic.zfar,
+								GLTF_Camera.orthographic.znear
+						};
+						break;
+					}
+					Node.Camera = static_cast<int32>(Snapshot.Cameras.size() - 1);
+				}
 
-		return SceneNodeInfos;
+				if (GLTF_NodeInfo.light != -1)
+				{
+					const FKHRLightsPunctual::FLight& GLTF_Light{ Scene.extensions.KHR_lights_punctual.lights.at(GLTF_NodeInfo.light) };
+					FLightInfo& Light{ Snapshot.Lights.emplace_back() };
+					Light.Intensity = GLTF_Light.intensity;
+					Light.Type = util::GetLightType(GLTF_Light.type);
+					Light.Color = glm::vec3(GLTF_Light.color[0], GLTF_Light.color[1], GLTF_Light.color[2]);
+					Light.Range = GLTF_Light.range;
+					Light.InnerConeAngle = GLTF_Light.spot.innerConeAngle;
+					Light.OuterConeAngle = GLTF_Light.spot.outerConeAngle;
+					Node.Light = static_cast<int32>(Snapshot.Lights.size() - 1);
+				}
+			}
+		}
 	}
 
 	namespace gltf
 	{
 		namespace
 		{
-			void LoadBuffers(FScene& Scene)
-			{
-				std::for_each(Scene.buffers.begin(), Scene.buffers.end(), [&Scene](FBuffer& Buffer) {
-					auto error = LoadBuffer(Scene, Buffer);
-					assert(!error);
-				});
-			}
-
 			int LoadBuffer(const FScene& Scene, FBuffer& Buffer)
 			{
 				std::string FilePath = util::GetContentPath(Scene.root + "/" + Buffer.uri);
-				assert(Buffer.byteLength == std::filesystem::file_size(FilePath));
+				// a missing or truncated file, as an exporter leaves it mid write
+				std::error_code Error;
+				if (std::filesystem::file_size(FilePath, Error) != Buffer.byteLength || Error)
+				{
+					return -1;
+				}
 
 				std::ifstream BufferFileStream{ FilePath, std::ios::in | std::ios::binary };
 				if (BufferFileStream.is_open())
@@ -266,103 +508,35 @@ namespace ks {
 				return -1;
 			}
 
-			void LoadMeshData(const FScene& Scene, const FMesh& Mesh, FMeshData& MeshData)
+			bool ValidateBufferViews(const FScene& Scene)
 			{
-				// get key name
-				MeshData.KeyName = GetAssetKeyName(Scene, Mesh.name);
-				KS_INFOA(MeshData.KeyName.c_str());
-
-				const gltf::FMesh::FPrimitive& Primitive = Mesh.primitives.at(0);
-
-				// load index buffer
+				for (const FBufferView& BufferView : Scene.bufferViews)
 				{
-					FRawAttributeData MeshIndexData;
-					MeshIndexData.Name = "indices";
-					gltf::CopyRawDataByAccessor(MeshIndexData, Scene, Primitive.indices);
-					MeshData.IndexData.Count = MeshIndexData.Count;
-					MeshData.IndexData.Stride = static_cast<uint32_t>(MeshIndexData.GetStride());
-					MeshData.IndexData.DataType = MeshIndexData.DataType;
-					MeshData.IndexData.Data = std::move(MeshIndexData.Data);
-					auto& IndexData{MeshData.IndexData};
-					if(IndexData.DataType == EDATA_TYPE::BYTE ||
-					   IndexData.DataType == EDATA_TYPE::UNSIGNED_BYTE)
+					if (BufferView.buffer < 0 || BufferView.buffer >= Scene.buffers.size() || BufferView.byteOffset < 0 || BufferView.byteLength < 0 ||
+						static_cast<size_t>(BufferView.byteOffset) + BufferView.byteLength > Scene.buffers[BufferView.buffer].RawData.size())
 					{
-						auto& IndexRawData{IndexData.Data};
-						IndexData.DataType = EDATA_TYPE::UNSIGNED_SHORT;
-						std::vector<uint16> RawData(IndexRawData.size());
-						for (int32 i{0}; i < IndexRawData.size(); ++i)
-						{
-							RawData.at(i) = static_cast<uint16>(IndexRawData.at(i));
-						}
-						IndexRawData.resize(sizeof(uint16) * RawData.size());
-						memcpy(IndexRawData.data(), RawData.data(), sizeof(uint16) * RawData.size());
+						return false;
 					}
 				}
-				// load position buffer
-				{
-					FRawAttributeData MeshPositionData;
-					MeshPositionData.Name = std::move(std::string("POSITION"));
-					gltf::CopyRawDataByAccessor(MeshPositionData, Scene, Primitive.attributes.at(MeshPositionData.Name));
-					MeshData.PositionData.Count = MeshPositionData.Count;
-					MeshData.PositionData.Stride = static_cast<uint32>(MeshPositionData.GetStride());
-					MeshData.PositionData.DataType = MeshPositionData.DataType;
-					MeshData.PositionData.Data = std::move(MeshPositionData.Data);
-					const auto& Accessor = GetAccessor(Scene, Primitive.attributes.at(MeshPositionData.Name));
-					memcpy(&MeshData.Min.x, Accessor.min.data(), Accessor.min.size() * sizeof(float));
-					memcpy(&MeshData.Max.x, Accessor.max.data(), Accessor.max.size() * sizeof(float));
-				}
-				// load all other vertex attributes
+				auto IsValidAccessor = [&Scene](int32 AccessorIndex) {
+					return AccessorIndex >= 0 && AccessorIndex < Scene.accessors.size() &&
+						Scene.accessors[AccessorIndex].bufferView >= 0 && Scene.accessors[AccessorIndex].bufferView < Scene.bufferViews.size();
+				};
+				for (const FMesh& Mesh : Scene.meshes)
 				{
-					std::vector<std::string> AttributeNames = {"NORMAL", "TEXCOORD_0"};
-					std::vector<FRawAttributeData> AttriDataAry;
-					for (const auto& AttributeName : AttributeNames)
+					if (Mesh.primitives.empty() || !IsValidAccessor(Mesh.primitives[0].indices))
 					{
-						AttriDataAry.push_back(FRawAttributeData());
-						AttriDataAry.back().Name = AttributeName;
-						gltf::CopyRawDataByAccessor(AttriDataAry.back(), Scene, Primitive.attributes.at(AttributeName));
+						return false;
 					}
-					
-					// merge all vertex attributes into a single attribute buffer
-					size_t ByteSize{0};
-					size_t Stride{0};
-					const uint32 ElemCount{ AttriDataAry.begin()->Count };
-					for (const auto& AttriData : AttriDataAry)
+					for (const auto& [Name, AccessorIndex] : Mesh.primitives[0].attributes)
 					{
-						ByteSize += AttriData.Data.size();
-						Stride += util::GetStride(AttriData.ElemType, AttriData.DataType);
-						assert(ElemCount == AttriData.Count);
-					}
-					assert(ElemCount * Stride == ByteSize);
-					std::vector<uint8> Data(ByteSize);
-					uint8* pData{Data.data()};
-					size_t ByteOffset{0};
-					for (const auto& AttriData : AttriDataAry)
-					{
-						size_t AttriStride = util::GetStride(AttriData.ElemType, AttriData.DataType);
-						const uint8* pAttriData{AttriData.Data.data()};
-						for (uint32 i{0}; i < ElemCount; ++i)
+						if (!IsValidAccessor(AccessorIndex))
 						{
-							memcpy(pData + ByteOffset + Stride * i, pAttriData + AttriStride * i, AttriStride);
+							return false;
 						}
-						ByteOffset += AttriStride;
 					}
-
-					MeshData.AttributeData.Count = ElemCount;
-					MeshData.AttributeData.Stride = static_cast<uint32>(Stride);
-					MeshData.AttributeData.DataType = AttriDataAry.begin()->DataType;
-					MeshData.AttributeData.Data = std::move(Data);
-				}
-				// load material data
-				if (Primitive.material != -1)
-				{
-					FMaterialData& MaterialData{MeshData.MaterialData};
-					const int32& MaterialId{Primitive.material};
-					const FMaterial& Material{Scene.materials.at(MaterialId)};
-					MaterialData.KeyName = GetAssetKeyName(Scene, Material.name);
-					memcpy(&MaterialData.BaseColorFactor[0], &Material.pbrMetallicRoughness.baseColorFactor[0], sizeof(float)*_countof(MaterialData.BaseColorFactor));
-					MaterialData.MetallicFactor = Material.pbrMetallicRoughness.metallicFactor;
-					MaterialData.RoughnessFactor = Material.pbrMetallicRoughness.roughnessFactor;
 				}
+				return true;
 			}
 
 			const FAccessor& GetAccessor(const FScene& Scene, const int32 AccessorIndex)
@@ -403,6 +577,154 @@ namespace ks {
 				}
 			}
 		}
+
+		void LoadBuffers(FScene& Scene)
+		{
+			std::for_each(Scene.buffers.begin(), Scene.buffers.end(), [&Scene](FBuffer& Buffer) {
+				auto error = LoadBuffer(Scene, Buffer);
+				assert(!error);
+			});
+		}
+
+		bool LoadSceneSource(const std::string& Path, FScene& Scene)
+		{
+			std::error_code Error;
+			if (!std::filesystem::is_regular_file(util::GetContentPath(Path), Error))
+			{
+				KS_INFOA(("Scene : missing " + Path).c_str());
+				return false;
+			}
+			// the json parser and the typed getters throw on malformed content
+			try
+			{
+				ParseScene(Path, Scene);
+			}
+			catch (const std::exception& Exception)
+			{
+				KS_INFOA(("Scene : failed to parse " + Path + ", " + Exception.what()).c_str());
+				return false;
+			}
+			for (FBuffer& Buffer : Scene.buffers)
+			{
+				if (LoadBuffer(Scene, Buffer) != 0)
+				{
+					KS_INFOA(("Scene : failed to load " + Scene.root + "/" + Buffer.uri).c_str());
+					return false;
+				}
+			}
+			if (!ValidateBufferViews(Scene))
+			{
+				KS_INFOA(("Scene : buffer views out of range in " + Path).c_str());
+				return false;
+			}
+			return true;
+		}
+
+		void LoadMeshData(const FScene& Scene, const FMesh& Mesh, FMeshData& MeshData)
+		{
+			// get key name
+			MeshData.KeyName = GetAssetKeyName(Scene, Mesh.name);
+			KS_INFOA(MeshData.KeyName.c_str());
+
+			const gltf::FMesh::FPrimitive& Primitive = Mesh.primitives.at(0);
+
+			// load index buffer
+			{
+				FRawAttributeData MeshIndexData;
+				MeshIndexData.Name = "indices";
+				gltf::CopyRawDataByAccessor(MeshIndexData, Scene, Primitive.indices);
+				MeshData.IndexData.Count = MeshIndexData.Count;
+				MeshData.IndexData.Stride = static_cast<uint32_t>(MeshIndexData.GetStride());
+				MeshData.IndexData.DataType = MeshIndexData.DataType;
+				MeshData.IndexData.Data = std::move(MeshIndexData.Data);
+				auto& IndexData{MeshData.IndexData};
+				if(IndexData.DataType == EDATA_TYPE::BYTE ||
+				   IndexData.DataType == EDATA_TYPE::UNSIGNED_BYTE)
+				{
+					auto& IndexRawData{IndexData.Data};
+					IndexData.DataType = EDATA_TYPE::UNSIGNED_SHORT;
+					std::vector<uint16> RawData(IndexRawData.size());
+					for (int32 i{0}; i < IndexRawData.size(); ++i)
+					{
+						RawData.at(i) = static_cast<uint16>(IndexRawData.at(i));
+					}
+					IndexRawData.resize(sizeof(uint16) * RawData.size());
+					memcpy(IndexRawData.data(), RawData.data(), sizeof(uint16) * RawData.size());
+				}
+			}
+			// load position buffer
+			{
+				FRawAttributeData MeshPositionData;
+				MeshPositionData.Name = std::move(std::string("POSITION"));
+				gltf::CopyRawDataByAccessor(MeshPositionData, Scene, Primitive.attributes.at(MeshPositionData.Name));
+				MeshData.PositionData.Count = MeshPositionData.Count;
+				MeshData.PositionData.Stride = static_cast<uint32>(MeshPositionData.GetStride());
+				MeshData.PositionData.DataType = MeshPositionData.DataType;
+				MeshData.PositionData.Data = std::move(MeshPositionData.Data);
+				const auto& Accessor = GetAccessor(Scene, Primitive.attributes.at(MeshPositionData.Name));
+				memcpy(&MeshData.Min.x, Accessor.min.data(), Accessor.min.size() * sizeof(float));
+				memcpy(&MeshData.Max.x, Accessor.max.data(), Accessor.max.size() * sizeof(float));
+			}
+			// load all other vertex attributes
+			{
+				std::vector<std::string> AttributeNames = {"NORMAL", "TEXCOORD_0"};
+				std::vector<FRawAttributeData> AttriDataAry;
+				for (const auto& AttributeName : AttributeNames)
+				{
+					AttriDataAry.push_back(FRawAttributeData());
+					AttriDataAry.back().Name = AttributeName;
+					gltf::CopyRawDataByAccessor(AttriDataAry.back(), Scene, Primitive.attributes.at(AttributeName));
+				}
+				
+				// merge all vertex attributes into a single attribute buffer
+				size_t ByteSize{0};
+				size_t Stride{0};
+				const uint32 ElemCount{ AttriDataAry.begin()->Count };
+				for (const auto& AttriData : AttriDataAry)
+				{
+					ByteSize += AttriData.Data.size();
+					Stride += util::GetStride(AttriData.ElemType, AttriData.DataType);
+					assert(ElemCount == AttriData.Count);
+				}
+				assert(ElemCount * Stride == ByteSize);
+				std::vector<uint8> Data(ByteSize);
+				uint8* pData{Data.data()};
+				size_t ByteOffset{0};
+				for (const auto& AttriData : AttriDataAry)
+				{
+					size_t AttriStride = util::GetStride(AttriData.ElemType, AttriData.DataType);
+					const uint8* pAttriData{AttriData.Data.data()};
+					for (uint32 i{0}; i < ElemCount; ++i)
+					{
+						memcpy(pData + ByteOffset + Stride * i, pAttriData + AttriStride * i, AttriStride);
+					}
+					ByteOffset += AttriStride;
+				}
+
+				MeshData.AttributeData.Count = ElemCount;
+				MeshData.AttributeData.Stride = static_cast<uint32>(Stride);
+				MeshData.AttributeData.DataType = AttriDataAry.begin()->DataType;
+				MeshData.AttributeData.Data = std::move(Data);
+			}
+			// load material data
+			if (Primitive.material != -1)
+			{
+				LoadMaterialData(Scene, Scene.materials.at(Primitive.material), MeshData.MaterialData);
+			}
+		}
+
+		void LoadMaterialData(const FScene& Scene, const FMaterial& Material, FMaterialData& MaterialData)
+		{
+			MaterialData.KeyName = GetAssetKeyName(Scene, Material.name);
+			memcpy(&MaterialData.BaseColorFactor[0], &Material.pbrMetallicRoughness.baseColorFactor[0], sizeof(float)*_countof(MaterialData.BaseColorFactor));
+			MaterialData.MetallicFactor = Material.pbrMetallicRoughness.metallicFactor;
+			MaterialData.RoughnessFactor = Material.pbrMetallicRoughness.roughnessFactor;
+			for (size_t Slot{ 0 }; Slot < NumTextureSlots; ++Slot)
+			{
+				const int32 TextureIndex{ GetMaterialTexture(Material, static_cast<ETextureSlot>(Slot)) };
+				MaterialData.TextureKeys.at(Slot) = TextureIndex != -1 ? GetTextureKeyName(Scene, TextureIndex) : "";
+			}
+		}
 	}
 
 }
\ No newline at end of file
@@ -5,9 +5,11 @@
 
 namespace ks
 {
-	struct FSceneNodeInfo;
+	struct FSceneSnapshot;
 	struct FMeshData;
+	struct FMaterialData;
 	class FStaticMeshAsset;
+	enum class ETextureSlot : uint8;
 	
 
 	/* see LoadGLTF */
@@ -295,10 +297,32 @@ namespace gltf
 	{
 		struct FLight
 		{
+			struct FSpot
+			{
+				float innerConeAngle{ 0.f };
+				float outerConeAngle{ glm::quarter_pi<float>() };
+			};
 			std::string name;
 			std::string type;
-			float intensity{0.f};
-			NLOHMANN_DEFINE_TYPE_INTRUSIVE(FLight, name, type, intensity)
+			float intensity{ 1.f };
+			std::array<float, 3> color{ 1.f, 1.f, 1.f };
+			// 0 when the light is unbounded
+			float range{ 0.f };
+			FSpot spot{};
+			friend void to_json(json&, const FLight&) { assert(false); }
+			friend void from_json(const json& j, FLight& Light) {
+				Light.name = j.value("name", std::string{});
+				j.at("type").get_to(Light.type);
+				Light.intensity = j.value("intensity", 1.f);
+				Light.color = j.value("color", Light.color);
+				Light.range = j.value("range", 0.f);
+				if (j.contains("spot"))
+				{
+					const json& Spot{ j.at("spot") };
+					Light.spot.innerConeAngle = Spot.value("innerConeAngle", Light.spot.innerConeAngle);
+					Light.spot.outerConeAngle = Spot.value("outerConeAngle", Light.spot.outerConeAngle);
+				}
+			}
 		};
 		std::vector<FLight> lights;
 		NLOHMANN_DEFINE_TYPE_INTRUSIVE(FKHRLightsPunctual, lights)
@@ -316,6 +340,21 @@ namespace gltf
 		}
 	};
 
+	/* material reference to textures[index] */
+	struct FTextureInfo
+	{
+		int32 index{ -1 };
+		int32 texCoord{ 0 };
+		friend void to_json(json&, const FTextureInfo&) { assert(false); }
+		friend void from_json(const json& j, FTextureInfo& TextureInfo) {
+			j.at("index").get_to(TextureInfo.index);
+			if (j.contains("texCoord"))
+			{
+				j.at("texCoord").get_to(TextureInfo.texCoord);
+			}
+		}
+	};
+
 	struct FMaterial
 	{
 		std::string name;
@@ -324,10 +363,110 @@ namespace gltf
 			float baseColorFactor[4]{0.f};
 			float metallicFactor{0.f};
 			float roughnessFactor{0.f};
-			NLOHMANN_DEFINE_TYPE_INTRUSIVE(FPBRMetallicRoughness, baseColorFactor, metallicFactor, roughnessFactor)
+			FTextureInfo baseColorTexture;
+			FTextureInfo metallicRoughnessTexture;
+			friend void to_json(json&, const FPBRMetallicRoughness&) { assert(false); }
+			friend void from_json(const json& j, FPBRMetallicRoughness& PBR) {
+				j.at("baseColorFactor").get_to(PBR.baseColorFactor);
+				j.at("metallicFactor").get_to(PBR.metallicFactor);
+				j.at("roughnessFactor").get_to(PBR.roughnessFactor);
+				if (j.contains("baseColorTexture"))
+				{
+					j.at("baseColorTexture").get_to(PBR.baseColorTexture);
+				}
+				if (j.contains("metallicRoughnessTexture"))
+				{
+					j.at("metallicRoughnessTexture").get_to(PBR.metallicRoughnessTexture);
+				}
+			}
 		};
 		FPBRMetallicRoughness pbrMetallicRoughness;
-		NLOHMANN_DEFINE_TYPE_INTRUSIVE(FMaterial, name, pbrMetallicRoughness)
+		FTextureInfo normalTexture;
+		friend void to_json(json&, const FMaterial&) { assert(false); }
+		friend void from_json(const json& j, FMaterial& Material) {
+			j.at("name").get_to(Material.name);
+			j.at("pbrMetallicRoughness").get_to(Material.pbrMetallicRoughness);
+			if (j.contains("normalTexture"))
+			{
+				j.at("normalTexture").get_to(Material.normalTexture);
+			}
+		}
+	};
+
+	/* either uri or bufferView is set */
+	struct FImage
+	{
+		std::string name;
+		std::string uri;
+		std::string mimeType;
+		int32 bufferView{ -1 };
+		friend void to_json(json&, const FImage&) { assert(false); }
+		friend void from_json(const json& j, FImage& Image) {
+			if (j.contains("name"))
+			{
+				j.at("name").get_to(Image.name);
+			}
+			if (j.contains("uri"))
+			{
+				j.at("uri").get_to(Image.uri);
+			}
+			if (j.contains("mimeType"))
+			{
+				j.at("mimeType").get_to(Image.mimeType);
+			}
+			if (j.contains("bufferView"))
+			{
+				j.at("bufferView").get_to(Image.bufferView);
+			}
+		}
+	};
+
+	/*
+	* filters : 9728 NEAREST, 9729 LINEAR, 9984 - 9987 mipmap variants
+	* wraps : 33071 CLAMP_TO_EDGE, 33648 MIRRORED_REPEAT, 10497 REPEAT
+	*/
+	struct FSampler
+	{
+		int32 magFilter{ -1 };
+		int32 minFilter{ -1 };
+		int32 wrapS{ 10497 };
+		int32 wrapT{ 10497 };
+		friend void to_json(json&, const FSampler&) { assert(false); }
+		friend void from_json(const json& j, FSampler& Sampler) {
+			if (j.contains("magFilter"))
+			{
+				j.at("magFilter").get_to(Sampler.magFilter);
+			}
+			if (j.contains("minFilter"))
+			{
+				j.at("minFilter").get_to(Sampler.minFilter);
+			}
+			if (j.contains("wrapS"))
+			{
+				j.at("wrapS").get_to(Sampler.wrapS);
+			}
+			if (j.contains("wrapT"))
+			{
+				j.at("wrapT").get_to(Sampler.wrapT);
+			}
+		}
+	};
+
+	struct FTexture
+	{
+		int32 sampler{ -1 };
+		int32 source{ -1 };
+		friend void to_json(json&, const FTexture&) { assert(false); }
+		friend void from_json(const json& j, FTexture& Texture) {
+			if (j.contains("sampler"))
+			{
+				j.at("sampler").get_to(Texture.sampler);
+			}
+			if (j.contains("source"))
+			{
+				j.at("source").get_to(Texture.source);
+			}
+		}
 	};
 
 	struct FScene
@@ -342,6 +481,10 @@ namespace gltf
 		std::vector<FBuffer> buffers;
 		std::vector<FCamera> cameras;
 		std::vector<FMaterial> materials;
+		// optional, read by ParseScene
+		std::vector<FImage> images;
+		std::vector<FSampler> samplers;
+		std::vector<FTexture> textures;
 		FExtension extensions;
 
 		NLOHMANN_DEFINE_TYPE_INTRUSIVE(FScene, scene, scenes, nodes, meshes,
@@ -374,6 +517,42 @@ namespace gltf
 #endif
 		}
 	};
+
+	/* import functions, shared by FSceneAsset and FAssetCooker */
+
+	/* parse the gltf file at the content path */
+	void ParseScene(const std::string& Path, FScene& Scene);
+	/* load all bin files to RawData */
+	void LoadBuffers(FScene& Scene);
+	/*
+	* ParseScene and LoadBuffers for files that may be missing, malformed or still being written,
+	* logs the failure and returns false instead of asserting or throwing
+	*/
+	bool LoadSceneSource(const std::string& Path, FScene& Scene);
+	/* load mesh data form buffer, buffers must be loaded */
+	void LoadMeshData(const FScene& Scene, const FMesh& Mesh, FMeshData& MeshData);
+	void LoadMaterialData(const FScene& Scene, const FMaterial& Material, FMaterialData& MaterialData);
+	/* hash the buffer bytes and material factors a mesh is imported from */
+	uint64 GetMeshSourceHash(const FScene& Scene, const FMesh& Mesh);
+	uint64 GetMaterialSourceHash(const FMaterial& Material);
+	/* textures index of a material slot, -1 if the slot has no texture */
+	int32 GetMaterialTexture(const FMaterial& Material, ETextureSlot Slot);
+	/* key of the texture asset, named after the image */
+	std::string GetTextureKeyName(const FScene& Scene, int32 TextureIndex);
+	/* encoded bytes of the texture image, buffers must be loaded for images in buffer views */
+	bool LoadTextureSource(const FScene& Scene, int32 TextureIndex, std::vector<uint8>& OutBytes);
+	/* key name used by asset manager */
+	std::string GetAssetKeyName(const FScene& Scene, const std::string& Name);
+	/* flatten the node hierarchy of the default scene, see FSceneSnapshot */
+	void BuildSnapshot(const FScene& Scene, FSceneSnapshot& Snapshot);
+
+	/* load buffers in scope, release them on exit */
+	struct FBufferLoadingHelper
+	{
+		FScene& Scene;
+		FBufferLoadingHelper(FScene& _Scene);
+		~FBufferLoadingHelper();
+	};
 } // ~gltf
 
 
@@ -393,24 +572,31 @@ namespace gltf
 	class FSceneAsset : public IAsset
 	{
 	public:
-		FSceneAsset(const std::string& GLTFPath);
-		virtual ~FSceneAsset() {}
-		int32 GetNumNodes() const {
-			return static_cast<int32>(GltfScene.nodes.size());
-		}
-		void GetSceneNodeInfo(int32 NodeIndex, FSceneNodeInfo& NodeInfo) const;
-		std::vector<FSceneNodeInfo> GetSceneNodeInfos() const;
+		FSceneAsset(const std::string& GLTFPath, bool bInLoadMeshes = true);
+		virtual ~FSceneAsset();
+		/* the nodes to create the scene from */
+		const FSceneSnapshot& GetSnapshot() const { return *Snapshot; }
+		/* true if the snapshot and the meshes were read from the cooked files */
+		bool IsCooked() const { return bCooked; }
+		/* load the meshes of a scene imported from the gltf without them, a partitioned world whose cook is out of date */
+		void LoadMeshes();
+		/* true if the content file is the gltf file or one of its buffers */
+		bool IsSourceFile(const std::string& ContentPath) const;
+		/* reload the gltf file, re-import meshes whose source bytes changed and return them */
+		std::vector<std::shared_ptr<FStaticMeshAsset>> Reimport();
 	private:
 		/* loading point */
 		void LoadGLTF();
 		/* load all contained assets */
 		void LoadContainedAssets();
+		/* load the meshes written by FAssetCooker, false if any of them is not cooked */
+		bool LoadCookedAssets();
 
-		/* mesh infos */
-		const std::string& GetMeshName(int32 MeshIndex) const {
-			return GltfScene.meshes.at(MeshIndex).name;
-		}
-
+		// parsed when the scene is not cooked or is re-imported
 		gltf::FScene GltfScene;
+		std::unique_ptr<FSceneSnapshot> Snapshot;
+		// false for a partitioned world, FWorldPartition loads the meshes
+		bool bLoadMeshes{ true };
+		bool bCooked{ false };
 	};
 }
\ No newline at end of file
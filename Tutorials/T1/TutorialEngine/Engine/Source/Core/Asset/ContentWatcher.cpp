@@ -0,0 +1,79 @@
+#include "engine_pch.h"
+#include "Core/Asset/ContentWatcher.h"
+
+namespace ks
+{
+	FContentWatcher::FContentWatcher(const std::string& InRootDir)
+		:RootDir(InRootDir)
+	{
+		// record the initial state, nothing is reported for it
+		Scan();
+		PendingFiles.clear();
+#ifdef WINDOWS_PLATFORM
+		ChangeHandle = FindFirstChangeNotificationA(RootDir.c_str(), TRUE,
+			FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE);
+		assert(ChangeHandle != INVALID_HANDLE_VALUE);
+#else
+		LastScanTime = std::chrono::steady_clock::now();
+#endif
+	}
+
+	FContentWatcher::~FContentWatcher()
+	{
+#ifdef WINDOWS_PLATFORM
+		if (ChangeHandle != INVALID_HANDLE_VALUE)
+		{
+			FindCloseChangeNotification(ChangeHandle);
+		}
+#endif
+	}
+
+	void FContentWatcher::Poll(std::vector<FChangedFile>& OutChangedFiles)
+	{
+		const auto Now{ std::chrono::steady_clock::now() };
+#ifdef WINDOWS_PLATFORM
+		// the os signals the handle when anything under the root changed
+		if (ChangeHandle != INVALID_HANDLE_VALUE && WaitForSingleObject(ChangeHandle, 0) == WAIT_OBJECT_0)
+		{
+			Scan();
+			FindNextChangeNotification(ChangeHandle);
+		}
+#else
+		if (Now - LastScanTime > ScanInterval)
+		{
+			Scan();
+			LastScanTime = Now;
+		}
+#endif
+		if (PendingFiles.empty() || Now - LastChangeTime < DebounceTime)
+		{
+			return;
+		}
+		for (auto& [Path, WriteTime] : PendingFiles)
+		{
+			OutChangedFiles.push_back({ Path, WriteTime });
+		}
+		PendingFiles.clear();
+	}
+
+	void FContentWatcher::Scan()
+	{
+		std::error_code Error;
+		for (const auto& Entry : std::filesystem::recursive_directory_iterator(RootDir, Error))
+		{
+			if (!Entry.is_regular_file(Error))
+			{
+				continue;
+			}
+			const FFileTime WriteTime{ Entry.last_write_time(Error) };
+			std::string Path{ "/" + std::filesystem::relative(Entry.path(), RootDir, Error).generic_string() };
+			auto It = FileTimes.find(Path);
+			if (It == FileTimes.end() || It->second != WriteTime)
+			{
+				FileTimes[Path] = WriteTime;
+				PendingFiles[Path] = WriteTime;
+				LastChangeTime = std::chrono::steady_clock::now();
+			}
+		}
+	}
+}
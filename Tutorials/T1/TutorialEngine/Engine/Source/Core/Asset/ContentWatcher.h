@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Core/CoreMinimal.h"
+
+namespace ks
+{
+	/*
+	* watch the content directory for modified files
+	* changes are reported only after the files stop changing for DebounceTime,
+	* so half written files from an exporter are not picked up
+	*/
+	class FContentWatcher
+	{
+	public:
+		using FFileTime = std::filesystem::file_time_type;
+		struct FChangedFile
+		{
+			// content relative path, e.g. "/Map/Map.bin"
+			std::string Path;
+			// last write time, used to measure the edit-to-screen latency
+			FFileTime WriteTime;
+		};
+
+		FContentWatcher(const std::string& InRootDir);
+		~FContentWatcher();
+		// non-blocking, returns the files changed since the last call
+		void Poll(std::vector<FChangedFile>& OutChangedFiles);
+	private:
+		void Scan();
+		std::string RootDir;
+		std::unordered_map<std::string, FFileTime> FileTimes;
+		std::unordered_map<std::string, FFileTime> PendingFiles;
+		std::chrono::steady_clock::time_point LastChangeTime;
+		static constexpr std::chrono::milliseconds DebounceTime{ 150 };
+#ifdef WINDOWS_PLATFORM
+		HANDLE ChangeHandle{ INVALID_HANDLE_VALUE };
+#else
+		std::chrono::steady_clock::time_point LastScanTime;
+		static constexpr std::chrono::milliseconds ScanInterval{ 250 };
+#endif
+	};
+}
@@ -0,0 +1,413 @@
+#include "engine_pch.h"
+#include "Core/Asset/CookedData.h"
+#include "Core/Asset/MeshAsset.h"
+#include "Core/Asset/MaterialData.h"
+#include "Core/Asset/TextureData.h"
+#include "Core/Asset/PartitionData.h"
+#include "Core/Asset/SceneSnapshot.h"
+#include "Core/MappedFile.h"
+
+namespace ks::cooked
+{
+	namespace
+	{
+		/* writes to a temporary file, renamed on Commit so readers never see half written files */
+		struct FFileWriter
+		{
+			std::string FilePath;
+			std::ofstream OutStream;
+			FFileWriter(const std::string& InFilePath, uint32 Magic, uint64 SourceHash)
+				:FilePath(InFilePath)
+			{
+				std::error_code Error;
+				std::filesystem::create_directories(std::filesystem::path(FilePath).parent_path(), Error);
+				OutStream.open(FilePath + ".tmp", std::ios::out | std::ios::binary | std::ios::trunc);
+				Write(FHeader{ Magic, Version, SourceHash });
+			}
+			template<typename T>
+			void Write(const T& Value) {
+				static_assert(std::is_trivially_copyable_v<T>);
+				OutStream.write(reinterpret_cast<const char*>(&Value), sizeof(T));
+			}
+			void Write(const std::string& Value) {
+				Write(static_cast<uint32>(Value.size()));
+				OutStream.write(Value.data(), Value.size());
+			}
+			void Write(const std::vector<uint8>& Value) {
+				Write(static_cast<uint32>(Value.size()));
+				OutStream.write(reinterpret_cast<const char*>(Value.data()), Value.size());
+			}
+			template<typename T>
+			void WriteArray(const std::vector<T>& Values) {
+				static_assert(std::is_trivially_copyable_v<T>);
+				Write(static_cast<uint32>(Values.size()));
+				OutStream.write(reinterpret_cast<const char*>(Values.data()), Values.size() * sizeof(T));
+			}
+			void Write(const FMeshAttributeData& Value) {
+				Write(Value.Count);
+				Write(Value.Stride);
+				Write(Value.DataType);
+				Write(Value.Data);
+			}
+			void Align(uint64 Alignment) {
+				const uint64 Position{ static_cast<uint64>(OutStream.tellp()) };
+				const uint64 Padding{ (Alignment - Position % Alignment) % Alignment };
+				for (uint64 i{ 0 }; i < Padding; ++i)
+				{
+					OutStream.put(0);
+				}
+			}
+			bool Commit() {
+				OutStream.close();
+				if (OutStream.fail())
+				{
+					return false;
+				}
+				std::error_code Error;
+				std::filesystem::rename(FilePath + ".tmp", FilePath, Error);
+				return !Error;
+			}
+		};
+
+		struct FFileReader
+		{
+			std::ifstream InStream;
+			FHeader Header;
+			FFileReader(const std::string& FilePath, uint32 Magic)
+				:InStream(FilePath, std::ios::in | std::ios::binary)
+			{
+				Read(Header);
+				if (Header.Magic != Magic || Header.Version != Version)
+				{
+					InStream.setstate(std::ios::failbit);
+				}
+			}
+			bool IsValid() const { return !InStream.fail(); }
+			template<typename T>
+			void Read(T& Value) {
+				static_assert(std::is_trivially_copyable_v<T>);
+				InStream.read(reinterpret_cast<char*>(&Value), sizeof(T));
+			}
+			void Read(std::string& Value) {
+				uint32 Size{ 0 };
+				Read(Size);
+				Value.resize(IsValid() ? Size : 0);
+				InStream.read(Value.data(), Value.size());
+			}
+			void Read(std::vector<uint8>& Value) {
+				uint32 Size{ 0 };
+				Read(Size);
+				Value.resize(IsValid() ? Size : 0);
+				InStream.read(reinterpret_cast<char*>(Value.data()), Value.size());
+			}
+			void Read(FMeshAttributeData& Value) {
+				Read(Value.Count);
+				Read(Value.Stride);
+				Read(Value.DataType);
+				Read(Value.Data);
+			}
+		};
+
+		/* reads from a mapped file without copying the bulk data */
+		struct FMemoryReader
+		{
+			const uint8* Data;
+			size_t Size;
+			size_t Position{ 0 };
+			bool bValid{ true };
+			template<typename T>
+			void Read(T& Value) {
+				static_assert(std::is_trivially_copyable_v<T>);
+				bValid = bValid && Position + sizeof(T) <= Size;
+				if (bValid)
+				{
+					memcpy(&Value, Data + Position, sizeof(T));
+					Position += sizeof(T);
+				}
+			}
+			void Read(std::string& Value) {
+				uint32 Length{ 0 };
+				Read(Length);
+				bValid = bValid && Position + Length <= Size;
+				if (bValid)
+				{
+					Value.assign(reinterpret_cast<const char*>(Data + Position), Length);
+					Position += Length;
+				}
+			}
+			template<typename T>
+			void ReadArray(std::vector<T>& Values) {
+				static_assert(std::is_trivially_copyable_v<T>);
+				uint32 Count{ 0 };
+				Read(Count);
+				bValid = bValid && Position + uint64(Count) * sizeof(T) <= Size;
+				Values.resize(bValid ? Count : 0);
+				if (bValid)
+				{
+					memcpy(Values.data(), Data + Position, Values.size() * sizeof(T));
+					Position += Values.size() * sizeof(T);
+				}
+			}
+			void Align(uint64 Alignment) {
+				Position = (Position + Alignment - 1) / Alignment * Alignment;
+				bValid = bValid && Position <= Size;
+			}
+		};
+	}
+
+	uint64 HashSceneSource(const std::string& ScenePath, const std::vector<std::string>& BufferPaths)
+	{
+		uint64 Hash{ Version };
+		FMappedFile File;
+		// a missing or empty file hashes as no bytes
+		if (File.Open(util::GetContentPath(ScenePath)))
+		{
+			Hash = util::HashBytes(File.GetData(), File.GetSize(), Hash);
+		}
+		for (const std::string& BufferPath : BufferPaths)
+		{
+			if (File.Open(util::GetContentPath(BufferPath)))
+			{
+				Hash = util::HashBytes(File.GetData(), File.GetSize(), Hash);
+			}
+		}
+		return Hash;
+	}
+
+	bool ReadSourceHash(const std::string& FilePath, uint32 Magic, uint64& OutSourceHash)
+	{
+		FFileReader Reader(FilePath, Magic);
+		OutSourceHash = Reader.Header.SourceHash;
+		return Reader.IsValid();
+	}
+
+	bool WriteMesh(const std::string& FilePath, const FMeshData& MeshData, uint64 SourceHash)
+	{
+		FFileWriter Writer(FilePath, MeshMagic, SourceHash);
+		Writer.Write(MeshData.KeyName);
+		Writer.Write(MeshData.IndexData);
+		Writer.Write(MeshData.PositionData);
+		Writer.Write(MeshData.AttributeData);
+		Writer.Write(MeshData.MaterialData.KeyName);
+		Writer.Write(MeshData.Min);
+		Writer.Write(MeshData.Max);
+		return Writer.Commit();
+	}
+
+	bool ReadMesh(const std::string& FilePath, FMeshData& MeshData, uint64& OutSourceHash)
+	{
+		FFileReader Reader(FilePath, MeshMagic);
+		Reader.Read(MeshData.KeyName);
+		Reader.Read(MeshData.IndexData);
+		Reader.Read(MeshData.PositionData);
+		Reader.Read(MeshData.AttributeData);
+		Reader.Read(MeshData.MaterialData.KeyName);
+		Reader.Read(MeshData.Min);
+		Reader.Read(MeshData.Max);
+		OutSourceHash = Reader.Header.SourceHash;
+		return Reader.IsValid();
+	}
+
+	bool WriteMaterial(const std::string& FilePath, const FMaterialData& MaterialData, uint64 SourceHash)
+	{
+		FFileWriter Writer(FilePath, MaterialMagic, SourceHash);
+		Writer.Write(MaterialData.KeyName);
+		Writer.Write(MaterialData.BaseColorFactor);
+		Writer.Write(MaterialData.MetallicFactor);
+		Writer.Write(MaterialData.RoughnessFactor);
+		for (const auto& TextureKey : MaterialData.TextureKeys)
+		{
+			Writer.Write(TextureKey);
+		}
+		return Writer.Commit();
+	}
+
+	bool ReadMaterial(const std::string& FilePath, FMaterialData& MaterialData)
+	{
+		FFileReader Reader(FilePath, MaterialMagic);
+		Reader.Read(MaterialData.KeyName);
+		Reader.Read(MaterialData.BaseColorFactor);
+		Reader.Read(MaterialData.MetallicFactor);
+		Reader.Read(MaterialData.RoughnessFactor);
+		for (auto& TextureKey : MaterialData.TextureKeys)
+		{
+			Reader.Read(TextureKey);
+		}
+		return Reader.IsValid();
+	}
+
+	bool WriteTexture(const std::string& FilePath, const FTextureData& TextureData, uint64 SourceHash)
+	{
+		FFileWriter Writer(FilePath, TextureMagic, SourceHash);
+		Writer.Write(TextureData.KeyName);
+		Writer.Write(TextureData.Format);
+		Writer.Write(TextureData.Width);
+		Writer.Write(TextureData.Height);
+		Writer.Write(static_cast<uint32>(TextureData.Mips.size()));
+		for (const FTextureMip& Mip : TextureData.Mips)
+		{
+			Writer.Write(Mip);
+		}
+		Writer.Align(TextureDataAlignment);
+		Writer.OutStream.write(reinterpret_cast<const char*>(TextureData.Data.data()), TextureData.Data.size());
+		return Writer.Commit();
+	}
+
+	bool MapTexture(const std::string& FilePath, FMappedFile& File, FTextureData& TextureData, const uint8*& OutMipData)
+	{
+		if (!File.Open(FilePath))
+		{
+			return false;
+		}
+		FMemoryReader Reader{ File.GetData(), File.GetSize() };
+		FHeader Header;
+		Reader.Read(Header);
+		if (!Reader.bValid || Header.Magic != TextureMagic || Header.Version != Version)
+		{
+			return false;
+		}
+		uint32 NumMips{ 0 };
+		Reader.Read(TextureData.KeyName);
+		Reader.Read(TextureData.Format);
+		Reader.Read(TextureData.Width);
+		Reader.Read(TextureData.Height);
+		Reader.Read(NumMips);
+		TextureData.Mips.resize(Reader.bValid ? NumMips : 0);
+		for (FTextureMip& Mip : TextureData.Mips)
+		{
+			Reader.Read(Mip);
+		}
+		Reader.Align(TextureDataAlignment);
+		if (!Reader.bValid || TextureData.Mips.empty() ||
+			TextureData.Mips.back().Offset + TextureData.Mips.back().Size > File.GetSize() - Reader.Position)
+		{
+			return false;
+		}
+		OutMipData = File.GetData() + Reader.Position;
+		return true;
+	}
+
+	bool WriteScene(const std::string& FilePath, const FSceneSnapshot& Snapshot, uint64 SourceHash)
+	{
+		FFileWriter Writer(FilePath, SceneMagic, SourceHash);
+		Writer.Write(Snapshot.NumAssetNodes);
+		Writer.WriteArray(Snapshot.Nodes);
+		Writer.WriteArray(Snapshot.Cameras);
+		Writer.WriteArray(Snapshot.Lights);
+		Writer.Write(Snapshot.Names);
+		for (const std::vector<std::string>* Strings : { &Snapshot.MeshKeys, &Snapshot.BufferPaths })
+		{
+			Writer.Write(static_cast<uint32>(Strings->size()));
+			for (const std::string& String : *Strings)
+			{
+				Writer.Write(String);
+			}
+		}
+		return Writer.Commit();
+	}
+
+	bool MapScene(const std::string& FilePath, FSceneSnapshot& Snapshot, uint64& OutSourceHash)
+	{
+		FMappedFile File;
+		if (!File.Open(FilePath))
+		{
+			return false;
+		}
+		FMemoryReader Reader{ File.GetData(), File.GetSize() };
+		FHeader Header;
+		Reader.Read(Header);
+		if (!Reader.bValid || Header.Magic != SceneMagic || Header.Version != Version)
+		{
+			return false;
+		}
+		OutSourceHash = Header.SourceHash;
+		Reader.Read(Snapshot.NumAssetNodes);
+		Reader.ReadArray(Snapshot.Nodes);
+		Reader.ReadArray(Snapshot.Cameras);
+		Reader.ReadArray(Snapshot.Lights);
+		Reader.Read(Snapshot.Names);
+		for (std::vector<std::string>* Strings : { &Snapshot.MeshKeys, &Snapshot.BufferPaths })
+		{
+			uint32 NumStrings{ 0 };
+			Reader.Read(NumStrings);
+			Strings->resize(Reader.bValid ? NumStrings : 0);
+			for (std::string& String : *Strings)
+			{
+				Reader.Read(String);
+			}
+		}
+		// check the indices once, FScene follows them without checks
+		const int32 NumNodes{ static_cast<int32>(Snapshot.Nodes.size()) };
+		for (int32 i = 0; i < NumNodes && Reader.bValid; ++i)
+		{
+			const FSnapshotNode& Node{ Snapshot.Nodes[i] };
+			Reader.bValid = Node.Parent < i && Node.AssetId >= 0 && static_cast<uint32>(Node.AssetId) < Snapshot.NumAssetNodes &&
+				uint64(Node.NameOffset) + Node.NameSize <= Snapshot.Names.size() &&
+				Node.Mesh < static_cast<int32>(Snapshot.MeshKeys.size()) &&
+				Node.Camera < static_cast<int32>(Snapshot.Cameras.size()) &&
+				Node.Light < static_cast<int32>(Snapshot.Lights.size());
+		}
+		return Reader.bValid;
+	}
+
+	bool WritePartition(const std::string& FilePath, const FWorldPartitionData& PartitionData, uint64 SourceHash)
+	{
+		FFileWriter Writer(FilePath, PartitionMagic, SourceHash);
+		Writer.Write(PartitionData.CellSize);
+		Writer.Write(static_cast<uint32>(PartitionData.MeshKeys.size()));
+		for (size_t i{ 0 }; i < PartitionData.MeshKeys.size(); ++i)
+		{
+			Writer.Write(PartitionData.MeshKeys.at(i));
+			Writer.Write(PartitionData.MeshBytes.at(i));
+		}
+		Writer.Write(static_cast<uint32>(PartitionData.Cells.size()));
+		for (const FPartitionCell& Cell : PartitionData.Cells)
+		{
+			Writer.Write(Cell.Coord);
+			Writer.Write(Cell.Box);
+			Writer.Write(static_cast<uint32>(Cell.Instances.size()));
+			for (const FPartitionInstance& Instance : Cell.Instances)
+			{
+				Writer.Write(Instance);
+			}
+		}
+		return Writer.Commit();
+	}
+
+	bool ReadPartition(const std::string& FilePath, FWorldPartitionData& PartitionData, uint64& OutSourceHash)
+	{
+		FFileReader Reader(FilePath, PartitionMagic);
+		OutSourceHash = Reader.Header.SourceHash;
+		uint32 NumMeshes{ 0 };
+		Reader.Read(PartitionData.CellSize);
+		Reader.Read(NumMeshes);
+		PartitionData.MeshKeys.resize(Reader.IsValid() ? NumMeshes : 0);
+		PartitionData.MeshBytes.resize(PartitionData.MeshKeys.size());
+		for (size_t i{ 0 }; i < PartitionData.MeshKeys.size(); ++i)
+		{
+			Reader.Read(PartitionData.MeshKeys.at(i));
+			Reader.Read(PartitionData.MeshBytes.at(i));
+		}
+		uint32 NumCells{ 0 };
+		Reader.Read(NumCells);
+		PartitionData.Cells.resize(Reader.IsValid() ? NumCells : 0);
+		for (FPartitionCell& Cell : PartitionData.Cells)
+		{
+			uint32 NumInstances{ 0 };
+			Reader.Read(Cell.Coord);
+			Reader.Read(Cell.Box);
+			Reader.Read(NumInstances);
+			Cell.Instances.resize(Reader.IsValid() ? NumInstances : 0);
+			for (FPartitionInstance& Instance : Cell.Instances)
+			{
+				Reader.Read(Instance);
+			}
+		}
+		// instances of meshes the partition does not list would index out of MeshKeys
+		return Reader.IsValid() && std::all_of(PartitionData.Cells.begin(), PartitionData.Cells.end(), [&](const FPartitionCell& Cell) {
+			return std::all_of(Cell.Instances.begin(), Cell.Instances.end(), [&](const FPartitionInstance& Instance) {
+				return Instance.MeshIndex < NumMeshes;
+			});
+		});
+	}
+}
\ No newline at end of file
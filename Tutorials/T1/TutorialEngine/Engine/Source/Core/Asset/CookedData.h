@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Core/CoreMinimal.h"
+
+namespace ks
+{
+	struct FMeshData;
+	struct FMaterialData;
+	struct FTextureData;
+	struct FWorldPartitionData;
+	struct FSceneSnapshot;
+	class FMappedFile;
+
+	/*
+	* binary files written by FAssetCooker, placed under util::GetCookedPath
+	* every file starts with FHeader, SourceHash is the hash of the source bytes
+	* the file is cooked from and is used to skip up to date outputs
+	*/
+namespace cooked
+{
+	constexpr uint32 MeshMagic{ 0x4853454D };		// "MESH"
+	constexpr uint32 MaterialMagic{ 0x4C54414D };	// "MATL"
+	constexpr uint32 SceneMagic{ 0x454E4353 };		// "SCNE"
+	constexpr uint32 TextureMagic{ 0x52584554 };	// "TEXR"
+	constexpr uint32 PartitionMagic{ 0x54524150 };	// "PART"
+	// bump when a format changes, older files are re-cooked
+	constexpr uint32 Version{ 4 };
+	// alignment of the texture mip data in the file
+	constexpr uint64 TextureDataAlignment{ 16 };
+
+	struct FHeader
+	{
+		uint32 Magic{ 0 };
+		uint32 Version{ 0 };
+		uint64 SourceHash{ 0 };
+	};
+
+	inline std::string GetMeshPath(const std::string& KeyName) {
+		return util::GetCookedPath(KeyName + ".ksmesh");
+	}
+	inline std::string GetMaterialPath(const std::string& KeyName) {
+		return util::GetCookedPath(KeyName + ".ksmat");
+	}
+	inline std::string GetTexturePath(const std::string& KeyName) {
+		return util::GetCookedPath(KeyName + ".kstex");
+	}
+	inline std::string GetScenePath(const std::string& ScenePath) {
+		return util::GetCookedPath(std::filesystem::path(ScenePath).replace_extension(".ksscene").generic_string());
+	}
+	inline std::string GetPartitionPath(const std::string& ScenePath) {
+		return util::GetCookedPath(std::filesystem::path(ScenePath).replace_extension(".kspartition").generic_string());
+	}
+
+	/*
+	* the source hash of a scene, hash of the gltf file and its buffers, all content paths
+	* the loaders compare it to the hash of the cooked scene and import the gltf if they differ
+	*/
+	uint64 HashSceneSource(const std::string& ScenePath, const std::vector<std::string>& BufferPaths);
+
+	/* read the header only, false if the file is missing or has another magic or version */
+	bool ReadSourceHash(const std::string& FilePath, uint32 Magic, uint64& OutSourceHash);
+
+	/* the material data is stored in its own file, the mesh keeps the material key */
+	bool WriteMesh(const std::string& FilePath, const FMeshData& MeshData, uint64 SourceHash);
+	bool ReadMesh(const std::string& FilePath, FMeshData& MeshData, uint64& OutSourceHash);
+
+	bool WriteMaterial(const std::string& FilePath, const FMaterialData& MaterialData, uint64 SourceHash);
+	bool ReadMaterial(const std::string& FilePath, FMaterialData& MaterialData);
+
+	/*
+	* header, mip table, then the mip data of all mips at TextureDataAlignment
+	* MapTexture maps the file instead of reading it, TextureData.Data is left empty and
+	* OutMipData points at the mip data inside File, Mips offsets are relative to it
+	*/
+	bool WriteTexture(const std::string& FilePath, const FTextureData& TextureData, uint64 SourceHash);
+	bool MapTexture(const std::string& FilePath, FMappedFile& File, FTextureData& TextureData, const uint8*& OutMipData);
+
+	/*
+	* the cooked scene is the snapshot of its nodes with the mesh keys they reference, written after the meshes
+	* the node, camera and light arrays are stored as they are in memory, MapScene copies them out of the mapped file
+	*/
+	bool WriteScene(const std::string& FilePath, const FSceneSnapshot& Snapshot, uint64 SourceHash);
+	bool MapScene(const std::string& FilePath, FSceneSnapshot& Snapshot, uint64& OutSourceHash);
+
+	/* the mesh nodes of a scene grouped in cells, see FWorldPartitionData */
+	bool WritePartition(const std::string& FilePath, const FWorldPartitionData& PartitionData, uint64 SourceHash);
+	bool ReadPartition(const std::string& FilePath, FWorldPartitionData& PartitionData, uint64& OutSourceHash);
+}
+}
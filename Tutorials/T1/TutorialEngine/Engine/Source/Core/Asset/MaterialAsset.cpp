@@ -1,6 +1,8 @@
 #include "engine_pch.h"
 #include "MaterialAsset.h"
 #include "MaterialData.h"
+#include "Core/Asset/AssetManager.h"
+#include "Core/Asset/TextureAsset.h"
 
 namespace ks
 {
@@ -9,14 +11,42 @@ namespace ks
 		:IAsset(_MaterialData.KeyName)
 		,MaterialData(_MaterialData)
 	{
-
+		LoadTextures();
 	}
 
 	FMaterialAsset::FMaterialAsset(FMaterialData&& TmpMaterialData)
 		:IAsset(TmpMaterialData.KeyName)
 		,MaterialData(std::move(TmpMaterialData))
 	{
+		LoadTextures();
+	}
+
+	void FMaterialAsset::SetMaterialData(const FMaterialData& InMaterialData)
+	{
+		MaterialData = InMaterialData;
+		RefAssets.clear();
+		LoadTextures();
+	}
 
+	void FMaterialAsset::LoadTextures()
+	{
+		// textures are shared between materials by key
+		for (size_t Slot{ 0 }; Slot < NumTextureSlots; ++Slot)
+		{
+			const std::string& TextureKey{ MaterialData.TextureKeys.at(Slot) };
+			Textures.at(Slot) = nullptr;
+			if (TextureKey.empty())
+			{
+				continue;
+			}
+			std::shared_ptr<FTextureAsset> TextureAsset{ std::dynamic_pointer_cast<FTextureAsset>(GAssetManager->GetAsset(TextureKey)) };
+			if (!TextureAsset)
+			{
+				TextureAsset = GAssetManager->CreateTextureAsset(TextureKey);
+			}
+			Textures.at(Slot) = TextureAsset.get();
+			RefAssets.push_back(TextureAsset);
+		}
 	}
 
 }
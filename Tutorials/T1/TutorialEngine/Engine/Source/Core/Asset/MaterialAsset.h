@@ -4,6 +4,8 @@
 
 namespace ks
 {
+	class FTextureAsset;
+
 	class FMaterialAsset : public IAsset
 	{
 	public:
@@ -11,8 +13,13 @@ namespace ks
 		FMaterialAsset(FMaterialData&& TmpMaterialData);
 		virtual ~FMaterialAsset(){}
 		const FMaterialData& GetMaterialData() const { return MaterialData; }
+		void SetMaterialData(const FMaterialData& InMaterialData);
+		// null if the slot has no texture
+		FTextureAsset* GetTexture(ETextureSlot Slot) const { return Textures.at(static_cast<size_t>(Slot)); }
 	private:
+		void LoadTextures();
 		FMaterialData MaterialData;
+		std::array<FTextureAsset*, NumTextureSlots> Textures{};
 	};
 }
 
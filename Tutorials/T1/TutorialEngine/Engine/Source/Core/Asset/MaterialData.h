@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Core/Asset/TextureData.h"
+
 namespace ks
 {
 	struct FMaterialData
@@ -8,6 +10,8 @@ namespace ks
 		float BaseColorFactor[4]{0.f};
 		float MetallicFactor{0.f};
 		float RoughnessFactor{0.f};
+		// texture asset key per slot, empty if the slot has no texture
+		std::array<std::string, NumTextureSlots> TextureKeys;
 
 		FMaterialData() = default;
 
@@ -20,6 +24,7 @@ namespace ks
 			memcpy(&BaseColorFactor[0], &Other.BaseColorFactor[0], sizeof(float)*_countof(BaseColorFactor));
 			MetallicFactor = Other.MetallicFactor;
 			RoughnessFactor = Other.RoughnessFactor;
+			TextureKeys = Other.TextureKeys;
 			return *this;
 		}
 
@@ -28,6 +33,10 @@ namespace ks
 		}
 		FMaterialData& operator=(FMaterialData&& Tmp) noexcept {
 			KeyName = std::move(Tmp.KeyName);
+			memcpy(&BaseColorFactor[0], &Tmp.BaseColorFactor[0], sizeof(float)*_countof(BaseColorFactor));
+			MetallicFactor = Tmp.MetallicFactor;
+			RoughnessFactor = Tmp.RoughnessFactor;
+			TextureKeys = std::move(Tmp.TextureKeys);
 			return *this;
 		}
 	};
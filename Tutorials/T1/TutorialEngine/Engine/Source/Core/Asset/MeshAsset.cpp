@@ -24,6 +24,19 @@ namespace ks
 		InitRenderData();
 	}
 
+	void FStaticMeshAsset::Reimport(FMeshData&& NewMeshData, uint64 NewSourceHash)
+	{
+		assert(NewMeshData.KeyName == MeshData.KeyName);
+		// render data references MeshData, release it first
+		RenderData.reset();
+		MeshData = std::move(NewMeshData);
+		SourceHash = NewSourceHash;
+		RefAssets.clear();
+		CreateMaterialAssetInter();
+		MaterialAsset->SetMaterialData(MeshData.MaterialData);
+		InitRenderData();
+	}
+
 	void FStaticMeshAsset::InitRenderData()
 	{
 		RenderData.reset(new FMeshRenderData(MeshData));
@@ -95,14 +95,20 @@ namespace ks {
 		FStaticMeshAsset(FMeshData&& _MeshData);
 		virtual ~FStaticMeshAsset() {}
 		virtual void PostLoad() override;
+		// replace the mesh data and rebuild the render data, see FSceneAsset::Reimport
+		void Reimport(FMeshData&& NewMeshData, uint64 NewSourceHash);
 		FMeshRenderData* GetRenderData() { return RenderData.get(); }
 		class FMaterialAsset* GetMaterialAsset() { return MaterialAsset; }
 		const FMeshData& GetMeshData() { return MeshData; }
+		uint64 GetSourceHash() const { return SourceHash; }
+		void SetSourceHash(uint64 InSourceHash) { SourceHash = InSourceHash; }
 	private:
 		void InitRenderData();
 		void CreateMaterialAssetInter();
 		// raw data
 		FMeshData MeshData;
+		// hash of the source bytes the mesh data is imported from
+		uint64 SourceHash{0};
 		// rendering, render data
 		std::unique_ptr<FMeshRenderData> RenderData;
 		// material
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Core/CoreMinimal.h"
+#include "Core/Bounds.h"
+
+namespace ks
+{
+	/* a mesh node of the scene, placed in the cell of its world box center */
+	struct FPartitionInstance
+	{
+		// gltf node id, see FScene::GetAssetNode
+		int32 NodeId{ -1 };
+		// index into FWorldPartitionData::MeshKeys
+		uint32 MeshIndex{ 0 };
+	};
+
+	struct FPartitionCell
+	{
+		// cell on the xz plane, the cell covers [Coord, Coord + 1) * CellSize
+		glm::ivec2 Coord{ 0 };
+		// world box of the instances, may reach out of the cell
+		FBounds::FBox Box;
+		std::vector<FPartitionInstance> Instances;
+	};
+
+	/*
+	* the mesh nodes of a scene split into square cells on the xz plane, written by FAssetCooker
+	* next to the cooked scene and streamed around the camera by FWorldPartition
+	* the nodes themselves stay in the scene, a cell only brings the meshes and their components
+	*/
+	struct FWorldPartitionData
+	{
+		float CellSize{ 0.f };
+		// the meshes of the scene in gltf order and the size of their cooked files
+		std::vector<std::string> MeshKeys;
+		std::vector<uint64> MeshBytes;
+		std::vector<FPartitionCell> Cells;
+	};
+}
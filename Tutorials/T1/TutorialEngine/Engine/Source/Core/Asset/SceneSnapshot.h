@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Core/CoreMinimal.h"
+#include "Core/Scene.h"
+
+namespace ks
+{
+	/* a scene node as FScene creates it, all references are indices */
+	struct FSnapshotNode
+	{
+		// index of the parent in FSceneSnapshot::Nodes, -1 for a root
+		int32 Parent{ -1 };
+		// gltf node id
+		int32 AssetId{ -1 };
+		// range of FSceneSnapshot::Names
+		uint32 NameOffset{ 0 };
+		uint32 NameSize{ 0 };
+		glm::vec3 Translate{ 0.f };
+		glm::quat Rotation{ 1.f, 0.f, 0.f, 0.f };
+		glm::vec3 Scale{ 1.f };
+		// indices into MeshKeys, Cameras and Lights, -1 if the node has none
+		int32 Mesh{ -1 };
+		int32 Camera{ -1 };
+		int32 Light{ -1 };
+	};
+
+	/*
+	* the imported node hierarchy of a scene in flat arrays, breadth first so a parent precedes its children
+	* built from the gltf scene or mapped from the cooked scene file, FScene creates its nodes from it in one sweep
+	*/
+	struct FSceneSnapshot
+	{
+		std::vector<FSnapshotNode> Nodes;
+		std::vector<FCameraInfo> Cameras;
+		std::vector<FLightInfo> Lights;
+		// the meshes in gltf order, the key names of their assets
+		std::vector<std::string> MeshKeys;
+		// content paths of the buffers, for hot reload
+		std::vector<std::string> BufferPaths;
+		// the node names back to back
+		std::string Names;
+		// number of gltf nodes, AssetId is below it
+		uint32 NumAssetNodes{ 0 };
+
+		std::string_view GetName(const FSnapshotNode& Node) const {
+			return std::string_view(Names).substr(Node.NameOffset, Node.NameSize);
+		}
+	};
+}
@@ -0,0 +1,41 @@
+#include "engine_pch.h"
+#include "Core/Asset/TextureAsset.h"
+#include "Core/Asset/TextureData.h"
+#include "Core/Asset/CookedData.h"
+#include "Core/MappedFile.h"
+#include "RHI/RHI.h"
+
+namespace ks
+{
+	FTextureAsset::FTextureAsset(const std::string& KeyName)
+		:IAsset(KeyName)
+	{
+	}
+
+	FTextureAsset::~FTextureAsset() = default;
+
+	void FTextureAsset::PostLoad()
+	{
+		FMappedFile File;
+		FTextureData TextureData;
+		const uint8* MipData{ nullptr };
+		if (!cooked::MapTexture(cooked::GetTexturePath(Path), File, TextureData, MipData))
+		{
+			KS_INFOA(("Texture is not cooked : " + Path).c_str());
+			return;
+		}
+
+		// the mips are uploaded straight from the mapped file
+		std::vector<FTextureMipData> Mips;
+		for (const FTextureMip& Mip : TextureData.Mips)
+		{
+			Mips.push_back({ MipData + Mip.Offset, Mip.RowPitch, static_cast<uint32_t>(Mip.Size) });
+		}
+		FTexture2DDesc Desc;
+		Desc.Width = TextureData.Width;
+		Desc.Height = TextureData.Height;
+		Desc.Format = TextureData.Format;
+		Desc.NumMips = static_cast<uint32_t>(Mips.size());
+		RHITexture.reset(GRHI->CreateTexture2D(Desc, Mips.data()));
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "Core/Asset/Assets.h"
+
+namespace ks
+{
+	class IRHITexture2D;
+
+	/*
+	* gpu texture created from the .kstex file written by FAssetCooker
+	* textures are not imported at runtime, an uncooked texture has no rhi texture
+	*/
+	class FTextureAsset : public IAsset
+	{
+	public:
+		FTextureAsset(const std::string& KeyName);
+		virtual ~FTextureAsset();
+		virtual void PostLoad() override;
+		IRHITexture2D* GetRHITexture() const { return RHITexture.get(); }
+	private:
+		std::unique_ptr<IRHITexture2D> RHITexture;
+	};
+}
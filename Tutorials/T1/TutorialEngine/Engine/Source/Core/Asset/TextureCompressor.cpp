@@ -0,0 +1,347 @@
+#include "engine_pch.h"
+#include "Core/Asset/TextureCompressor.h"
+
+namespace ks::texture
+{
+	namespace
+	{
+		constexpr uint32 NumBlockTexels{ 16 };
+
+		/* endpoints at the extremes of the principal axis of the texels, in [0, 255] */
+		template<uint32 NumChannels>
+		void FitPrincipalAxis(const uint8* Texels, float* OutMin, float* OutMax)
+		{
+			float Mean[NumChannels]{};
+			for (uint32 i{ 0 }; i < NumBlockTexels; ++i)
+			{
+				for (uint32 c{ 0 }; c < NumChannels; ++c)
+				{
+					Mean[c] += Texels[i * 4 + c];
+				}
+			}
+			for (uint32 c{ 0 }; c < NumChannels; ++c)
+			{
+				Mean[c] /= NumBlockTexels;
+			}
+
+			float Covariance[NumChannels][NumChannels]{};
+			for (uint32 i{ 0 }; i < NumBlockTexels; ++i)
+			{
+				for (uint32 a{ 0 }; a < NumChannels; ++a)
+				{
+					for (uint32 b{ 0 }; b < NumChannels; ++b)
+					{
+						Covariance[a][b] += (Texels[i * 4 + a] - Mean[a]) * (Texels[i * 4 + b] - Mean[b]);
+					}
+				}
+			}
+
+			// power iteration, started from the column with the largest variance
+			uint32 MaxColumn{ 0 };
+			for (uint32 c{ 1 }; c < NumChannels; ++c)
+			{
+				MaxColumn = Covariance[c][c] > Covariance[MaxColumn][MaxColumn] ? c : MaxColumn;
+			}
+			if (Covariance[MaxColumn][MaxColumn] <= 0.f)
+			{
+				// solid block
+				std::copy(Mean, Mean + NumChannels, OutMin);
+				std::copy(Mean, Mean + NumChannels, OutMax);
+				return;
+			}
+			float Axis[NumChannels];
+			for (uint32 c{ 0 }; c < NumChannels; ++c)
+			{
+				Axis[c] = Covariance[c][MaxColumn];
+			}
+			for (uint32 Iteration{ 0 }; Iteration < 8; ++Iteration)
+			{
+				float NewAxis[NumChannels]{};
+				float MaxComponent{ 0.f };
+				for (uint32 a{ 0 }; a < NumChannels; ++a)
+				{
+					for (uint32 b{ 0 }; b < NumChannels; ++b)
+					{
+						NewAxis[a] += Covariance[a][b] * Axis[b];
+					}
+					MaxComponent = std::max(MaxComponent, std::abs(NewAxis[a]));
+				}
+				if (MaxComponent <= 0.f)
+				{
+					break;
+				}
+				for (uint32 c{ 0 }; c < NumChannels; ++c)
+				{
+					Axis[c] = NewAxis[c] / MaxComponent;
+				}
+			}
+			float Length{ 0.f };
+			for (uint32 c{ 0 }; c < NumChannels; ++c)
+			{
+				Length += Axis[c] * Axis[c];
+			}
+			Length = std::sqrt(Length);
+			for (uint32 c{ 0 }; c < NumChannels; ++c)
+			{
+				Axis[c] /= Length;
+			}
+
+			float MinT{ std::numeric_limits<float>::max() };
+			float MaxT{ std::numeric_limits<float>::lowest() };
+			for (uint32 i{ 0 }; i < NumBlockTexels; ++i)
+			{
+				float T{ 0.f };
+				for (uint32 c{ 0 }; c < NumChannels; ++c)
+				{
+					T += (Texels[i * 4 + c] - Mean[c]) * Axis[c];
+				}
+				MinT = std::min(MinT, T);
+				MaxT = std::max(MaxT, T);
+			}
+			for (uint32 c{ 0 }; c < NumChannels; ++c)
+			{
+				OutMin[c] = std::clamp(Mean[c] + MinT * Axis[c], 0.f, 255.f);
+				OutMax[c] = std::clamp(Mean[c] + MaxT * Axis[c], 0.f, 255.f);
+			}
+		}
+
+		template<uint32 NumChannels>
+		uint32 FindNearest(const uint8* Texel, const int32 (*Palette)[4], uint32 NumEntries)
+		{
+			uint32 Best{ 0 };
+			int32 BestDistance{ std::numeric_limits<int32>::max() };
+			for (uint32 i{ 0 }; i < NumEntries; ++i)
+			{
+				int32 Distance{ 0 };
+				for (uint32 c{ 0 }; c < NumChannels; ++c)
+				{
+					const int32 Delta{ Texel[c] - Palette[i][c] };
+					Distance += Delta * Delta;
+				}
+				if (Distance < BestDistance)
+				{
+					Best = i;
+					BestDistance = Distance;
+				}
+			}
+			return Best;
+		}
+
+		uint16 ToRGB565(const float* Color)
+		{
+			const uint32 R{ static_cast<uint32>(Color[0] * 31.f / 255.f + 0.5f) };
+			const uint32 G{ static_cast<uint32>(Color[1] * 63.f / 255.f + 0.5f) };
+			const uint32 B{ static_cast<uint32>(Color[2] * 31.f / 255.f + 0.5f) };
+			return static_cast<uint16>((R << 11) | (G << 5) | B);
+		}
+
+		void FromRGB565(uint16 Color, int32* OutColor)
+		{
+			const int32 R{ (Color >> 11) & 31 };
+			const int32 G{ (Color >> 5) & 63 };
+			const int32 B{ Color & 31 };
+			OutColor[0] = (R << 3) | (R >> 2);
+			OutColor[1] = (G << 2) | (G >> 4);
+			OutColor[2] = (B << 3) | (B >> 2);
+			OutColor[3] = 255;
+		}
+
+		/* bc1 color block, always in 4 color mode so it is also valid inside bc3 */
+		void CompressColorBlock(const uint8* Texels, uint8* OutBlock)
+		{
+			float Min[3], Max[3];
+			FitPrincipalAxis<3>(Texels, Min, Max);
+			uint16 Color0{ ToRGB565(Max) };
+			uint16 Color1{ ToRGB565(Min) };
+			if (Color0 < Color1)
+			{
+				std::swap(Color0, Color1);
+			}
+
+			uint32 Indices{ 0 };
+			if (Color0 != Color1)
+			{
+				int32 Palette[4][4];
+				FromRGB565(Color0, Palette[0]);
+				FromRGB565(Color1, Palette[1]);
+				for (uint32 c{ 0 }; c < 3; ++c)
+				{
+					Palette[2][c] = (2 * Palette[0][c] + Palette[1][c]) / 3;
+					Palette[3][c] = (Palette[0][c] + 2 * Palette[1][c]) / 3;
+				}
+				for (uint32 i{ 0 }; i < NumBlockTexels; ++i)
+				{
+					Indices |= FindNearest<3>(Texels + i * 4, Palette, 4) << (2 * i);
+				}
+			}
+			memcpy(OutBlock, &Color0, sizeof(Color0));
+			memcpy(OutBlock + 2, &Color1, sizeof(Color1));
+			memcpy(OutBlock + 4, &Indices, sizeof(Indices));
+		}
+
+		/* bc4 block of one channel, always in 8 value mode */
+		void CompressChannelBlock(const uint8* Texels, uint32 Channel, uint8* OutBlock)
+		{
+			uint8 Min{ 255 };
+			uint8 Max{ 0 };
+			for (uint32 i{ 0 }; i < NumBlockTexels; ++i)
+			{
+				Min = std::min(Min, Texels[i * 4 + Channel]);
+				Max = std::max(Max, Texels[i * 4 + Channel]);
+			}
+			OutBlock[0] = Max;
+			OutBlock[1] = Min;
+
+			uint64 Indices{ 0 };
+			if (Max > Min)
+			{
+				int32 Palette[8][4];
+				Palette[0][0] = Max;
+				Palette[1][0] = Min;
+				for (int32 i{ 1 }; i < 7; ++i)
+				{
+					Palette[i + 1][0] = ((7 - i) * Max + i * Min) / 7;
+				}
+				for (uint32 i{ 0 }; i < NumBlockTexels; ++i)
+				{
+					Indices |= static_cast<uint64>(FindNearest<1>(Texels + i * 4 + Channel, Palette, 8)) << (3 * i);
+				}
+			}
+			for (uint32 Byte{ 0 }; Byte < 6; ++Byte)
+			{
+				OutBlock[2 + Byte] = static_cast<uint8>(Indices >> (8 * Byte));
+			}
+		}
+
+		/* writes bit fields from the lsb of the block upwards */
+		struct FBitWriter
+		{
+			uint8* Block;
+			uint32 Position{ 0 };
+			void Write(uint32 Value, uint32 NumBits)
+			{
+				for (uint32 Bit{ 0 }; Bit < NumBits; ++Bit, ++Position)
+				{
+					Block[Position >> 3] |= static_cast<uint8>(((Value >> Bit) & 1) << (Position & 7));
+				}
+			}
+		};
+	}
+
+	void CompressBC1Block(const uint8* Texels, uint8* OutBlock)
+	{
+		CompressColorBlock(Texels, OutBlock);
+	}
+
+	void CompressBC3Block(const uint8* Texels, uint8* OutBlock)
+	{
+		CompressChannelBlock(Texels, 3, OutBlock);
+		CompressColorBlock(Texels, OutBlock + 8);
+	}
+
+	void CompressBC5Block(const uint8* Texels, uint8* OutBlock)
+	{
+		CompressChannelBlock(Texels, 0, OutBlock);
+		CompressChannelBlock(Texels, 1, OutBlock + 8);
+	}
+
+	void CompressBC7Block(const uint8* Texels, uint8* OutBlock)
+	{
+		float Endpoints[2][4];
+		FitPrincipalAxis<4>(Texels, Endpoints[0], Endpoints[1]);
+
+		// 7 bit endpoints, each endpoint shares one extra lsb (p-bit) between its channels
+		uint32 Quantized[2][4];
+		uint32 PBits[2];
+		for (uint32 e{ 0 }; e < 2; ++e)
+		{
+			float BestError{ std::numeric_limits<float>::max() };
+			for (uint32 PBit{ 0 }; PBit < 2; ++PBit)
+			{
+				uint32 Candidate[4];
+				float Error{ 0.f };
+				for (uint32 c{ 0 }; c < 4; ++c)
+				{
+					Candidate[c] = static_cast<uint32>(std::clamp((Endpoints[e][c] - PBit) * 0.5f + 0.5f, 0.f, 127.f));
+					const float Delta{ static_cast<float>((Candidate[c] << 1) | PBit) - Endpoints[e][c] };
+					Error += Delta * Delta;
+				}
+				if (Error < BestError)
+				{
+					BestError = Error;
+					std::copy(Candidate, Candidate + 4, Quantized[e]);
+					PBits[e] = PBit;
+				}
+			}
+		}
+
+		static const int32 Weights[16]{ 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+		int32 Palette[16][4];
+		for (uint32 c{ 0 }; c < 4; ++c)
+		{
+			const int32 E0{ static_cast<int32>((Quantized[0][c] << 1) | PBits[0]) };
+			const int32 E1{ static_cast<int32>((Quantized[1][c] << 1) | PBits[1]) };
+			for (uint32 i{ 0 }; i < 16; ++i)
+			{
+				Palette[i][c] = ((64 - Weights[i]) * E0 + Weights[i] * E1 + 32) >> 6;
+			}
+		}
+		uint32 Indices[NumBlockTexels];
+		for (uint32 i{ 0 }; i < NumBlockTexels; ++i)
+		{
+			Indices[i] = FindNearest<4>(Texels + i * 4, Palette, 16);
+		}
+		// the msb of the first index is not stored, swap the endpoints to make it zero
+		if (Indices[0] & 8)
+		{
+			std::swap(Quantized[0], Quantized[1]);
+			std::swap(PBits[0], PBits[1]);
+			for (uint32& Index : Indices)
+			{
+				Index = 15 - Index;
+			}
+		}
+
+		memset(OutBlock, 0, 16);
+		FBitWriter Writer{ OutBlock };
+		Writer.Write(1 << 6, 7);
+		for (uint32 c{ 0 }; c < 4; ++c)
+		{
+			Writer.Write(Quantized[0][c], 7);
+			Writer.Write(Quantized[1][c], 7);
+		}
+		Writer.Write(PBits[0], 1);
+		Writer.Write(PBits[1], 1);
+		Writer.Write(Indices[0], 3);
+		for (uint32 i{ 1 }; i < NumBlockTexels; ++i)
+		{
+			Writer.Write(Indices[i], 4);
+		}
+		assert(Writer.Position == 128);
+	}
+
+	void CompressBlock(EELEM_FORMAT Format, const uint8* Texels, uint8* OutBlock)
+	{
+		switch (Format)
+		{
+		case EELEM_FORMAT::BC1_UNORM:
+		case EELEM_FORMAT::BC1_UNORM_SRGB:
+			CompressBC1Block(Texels, OutBlock);
+			break;
+		case EELEM_FORMAT::BC3_UNORM:
+		case EELEM_FORMAT::BC3_UNORM_SRGB:
+			CompressBC3Block(Texels, OutBlock);
+			break;
+		case EELEM_FORMAT::BC5_UNORM:
+			CompressBC5Block(Texels, OutBlock);
+			break;
+		case EELEM_FORMAT::BC7_UNORM:
+		case EELEM_FORMAT::BC7_UNORM_SRGB:
+			CompressBC7Block(Texels, OutBlock);
+			break;
+		default:
+			assert(false);
+			break;
+		}
+	}
+}
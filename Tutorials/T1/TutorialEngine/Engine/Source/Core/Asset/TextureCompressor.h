@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Core/CoreMinimal.h"
+
+namespace ks
+{
+	/*
+	* cpu block compression, every function encodes one 4x4 block
+	* Texels are 16 rgba8 texels in row major order
+	*/
+namespace texture
+{
+	// 8 bytes, opaque rgb
+	void CompressBC1Block(const uint8* Texels, uint8* OutBlock);
+	// 16 bytes, bc4 alpha followed by bc1 rgb
+	void CompressBC3Block(const uint8* Texels, uint8* OutBlock);
+	// 16 bytes, bc4 red followed by bc4 green
+	void CompressBC5Block(const uint8* Texels, uint8* OutBlock);
+	// 16 bytes, rgba, mode 6 only : one subset, 7 bit endpoints with p-bits, 4 bit indices
+	void CompressBC7Block(const uint8* Texels, uint8* OutBlock);
+
+	/* dispatch on the block compressed format */
+	void CompressBlock(EELEM_FORMAT Format, const uint8* Texels, uint8* OutBlock);
+}
+}
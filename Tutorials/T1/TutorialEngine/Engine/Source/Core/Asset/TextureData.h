@@ -0,0 +1,39 @@
+#pragma once
+
+namespace ks
+{
+	/* material texture slots, the slot decides the compressed format and the mip filter */
+	enum class ETextureSlot : uint8
+	{
+		BaseColor,
+		// g : roughness, b : metallic
+		MetallicRoughness,
+		// tangent space xy, z is reconstructed
+		Normal,
+		NUM,
+	};
+	constexpr size_t NumTextureSlots{ static_cast<size_t>(ETextureSlot::NUM) };
+
+	struct FTextureMip
+	{
+		uint32 Width{ 0 };
+		uint32 Height{ 0 };
+		// bytes of one row of 4x4 blocks
+		uint32 RowPitch{ 0 };
+		uint32 NumRows{ 0 };
+		// location in FTextureData::Data
+		uint64 Offset{ 0 };
+		uint64 Size{ 0 };
+	};
+
+	/* block compressed mip chain, mip 0 first */
+	struct FTextureData
+	{
+		std::string KeyName;
+		EELEM_FORMAT Format{ EELEM_FORMAT::UNKNOWN };
+		uint32 Width{ 0 };
+		uint32 Height{ 0 };
+		std::vector<FTextureMip> Mips;
+		std::vector<uint8> Data;
+	};
+}
@@ -0,0 +1,317 @@
+#include "engine_pch.h"
+#include "Core/Asset/TextureImporter.h"
+#include "Core/Asset/TextureCompressor.h"
+#include "Core/JobSystem.h"
+
+#include <emmintrin.h>
+#ifdef WINDOWS_PLATFORM
+#include <wincodec.h>
+#include <wrl/client.h>
+#pragma comment(lib, "windowscodecs.lib")
+#endif
+
+namespace ks::texture
+{
+	namespace
+	{
+		/* mips are filtered on float texels, 4 floats per texel */
+		using FFloatTexels = std::vector<float>;
+
+		// mip offsets in FTextureData::Data
+		constexpr uint64 MipAlignment{ 16 };
+
+		float SRGBToLinear(float Value)
+		{
+			return Value <= 0.04045f ? Value / 12.92f : std::pow((Value + 0.055f) / 1.055f, 2.4f);
+		}
+
+		float LinearToSRGB(float Value)
+		{
+			return Value <= 0.0031308f ? Value * 12.92f : 1.055f * std::pow(Value, 1.f / 2.4f) - 0.055f;
+		}
+
+		struct FGammaTables
+		{
+			// indexed by the srgb byte
+			float ToLinear[256];
+			// indexed by the linear value scaled to [0, NumToSRGB - 1]
+			static constexpr uint32 NumToSRGB{ 4096 };
+			uint8 ToSRGB[NumToSRGB];
+
+			FGammaTables()
+			{
+				for (uint32 i{ 0 }; i < 256; ++i)
+				{
+					ToLinear[i] = SRGBToLinear(i / 255.f);
+				}
+				for (uint32 i{ 0 }; i < NumToSRGB; ++i)
+				{
+					ToSRGB[i] = static_cast<uint8>(LinearToSRGB(i / float(NumToSRGB - 1)) * 255.f + 0.5f);
+				}
+			}
+		};
+
+		const FGammaTables& GetGammaTables()
+		{
+			static const FGammaTables GammaTables;
+			return GammaTables;
+		}
+
+		/* base color is srgb encoded, normals are unpacked to [-1, 1], everything else is linear */
+		void DecodeTexels(const FRawImage& Image, ETextureSlot Slot, FFloatTexels& OutTexels)
+		{
+			const FGammaTables& GammaTables{ GetGammaTables() };
+			OutTexels.resize(Image.Texels.size());
+			for (size_t i{ 0 }; i < Image.Texels.size(); ++i)
+			{
+				const uint8 Value{ Image.Texels[i] };
+				switch (Slot)
+				{
+				case ETextureSlot::BaseColor:
+					OutTexels[i] = (i & 3) == 3 ? Value / 255.f : GammaTables.ToLinear[Value];
+					break;
+				case ETextureSlot::Normal:
+					OutTexels[i] = Value / 127.5f - 1.f;
+					break;
+				default:
+					OutTexels[i] = Value / 255.f;
+					break;
+				}
+			}
+		}
+
+		void EncodeTexels(const FFloatTexels& Texels, uint32 Width, uint32 Height, ETextureSlot Slot, FRawImage& OutImage)
+		{
+			const FGammaTables& GammaTables{ GetGammaTables() };
+			const bool bSRGB{ Slot == ETextureSlot::BaseColor };
+			const float SRGBScale{ FGammaTables::NumToSRGB - 1.f };
+			// value * Scale + Bias, truncated, is the rounded byte or the gamma table index
+			const __m128 Scale{ bSRGB ? _mm_setr_ps(SRGBScale, SRGBScale, SRGBScale, 255.f)
+				: Slot == ETextureSlot::Normal ? _mm_set1_ps(127.5f) : _mm_set1_ps(255.f) };
+			const __m128 Bias{ Slot == ETextureSlot::Normal ? _mm_set1_ps(128.f) : _mm_set1_ps(0.5f) };
+			const __m128 Max{ bSRGB ? _mm_setr_ps(SRGBScale, SRGBScale, SRGBScale, 255.f) : _mm_set1_ps(255.f) };
+			const __m128 Zero{ _mm_setzero_ps() };
+
+			OutImage.Width = Width;
+			OutImage.Height = Height;
+			OutImage.Texels.resize(static_cast<size_t>(Width) * Height * 4);
+			alignas(16) int32 Values[4];
+			for (size_t i{ 0 }; i < OutImage.Texels.size(); i += 4)
+			{
+				__m128 Texel{ _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&Texels[i]), Scale), Bias) };
+				Texel = _mm_min_ps(_mm_max_ps(Texel, Zero), Max);
+				_mm_store_si128(reinterpret_cast<__m128i*>(Values), _mm_cvttps_epi32(Texel));
+				for (uint32 c{ 0 }; c < 4; ++c)
+				{
+					OutImage.Texels[i + c] = bSRGB && c < 3 ? GammaTables.ToSRGB[Values[c]] : static_cast<uint8>(Values[c]);
+				}
+			}
+		}
+
+		/* 2x2 box filter, the last row or column of odd sized mips is clamped */
+		void Downsample(const FFloatTexels& Src, uint32 SrcWidth, uint32 SrcHeight,
+			FFloatTexels& Dest, uint32 DestWidth, uint32 DestHeight)
+		{
+			const __m128 Quarter{ _mm_set1_ps(0.25f) };
+			Dest.resize(static_cast<size_t>(DestWidth) * DestHeight * 4);
+			for (uint32 y{ 0 }; y < DestHeight; ++y)
+			{
+				const float* Row0{ &Src[static_cast<size_t>(std::min(2 * y, SrcHeight - 1)) * SrcWidth * 4] };
+				const float* Row1{ &Src[static_cast<size_t>(std::min(2 * y + 1, SrcHeight - 1)) * SrcWidth * 4] };
+				float* DestRow{ &Dest[static_cast<size_t>(y) * DestWidth * 4] };
+				for (uint32 x{ 0 }; x < DestWidth; ++x)
+				{
+					const uint32 x0{ std::min(2 * x, SrcWidth - 1) * 4 };
+					const uint32 x1{ std::min(2 * x + 1, SrcWidth - 1) * 4 };
+					const __m128 Sum{ _mm_add_ps(
+						_mm_add_ps(_mm_loadu_ps(Row0 + x0), _mm_loadu_ps(Row0 + x1)),
+						_mm_add_ps(_mm_loadu_ps(Row1 + x0), _mm_loadu_ps(Row1 + x1))) };
+					_mm_storeu_ps(DestRow + x * 4, _mm_mul_ps(Sum, Quarter));
+				}
+			}
+		}
+
+		/* averaged normals get shorter, scale them back to unit length */
+		void Renormalize(FFloatTexels& Texels)
+		{
+			for (size_t i{ 0 }; i < Texels.size(); i += 4)
+			{
+				const float Length{ std::sqrt(Texels[i] * Texels[i] + Texels[i + 1] * Texels[i + 1] + Texels[i + 2] * Texels[i + 2]) };
+				if (Length > 1e-6f)
+				{
+					Texels[i] /= Length;
+					Texels[i + 1] /= Length;
+					Texels[i + 2] /= Length;
+				}
+			}
+		}
+	}
+
+	bool DecodeImage(const uint8* Bytes, size_t Size, FRawImage& OutImage)
+	{
+#ifdef WINDOWS_PLATFORM
+		using Microsoft::WRL::ComPtr;
+		// cooker jobs run on worker threads, each needs com initialized
+		const HRESULT InitResult{ CoInitializeEx(nullptr, COINIT_MULTITHREADED) };
+		bool bDecoded{ false };
+		{
+			ComPtr<IWICImagingFactory> Factory;
+			ComPtr<IWICStream> Stream;
+			ComPtr<IWICBitmapDecoder> Decoder;
+			ComPtr<IWICBitmapFrameDecode> Frame;
+			ComPtr<IWICFormatConverter> Converter;
+			UINT Width{ 0 };
+			UINT Height{ 0 };
+			bDecoded = SUCCEEDED(CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&Factory)))
+				&& SUCCEEDED(Factory->CreateStream(&Stream))
+				&& SUCCEEDED(Stream->InitializeFromMemory(const_cast<BYTE*>(Bytes), static_cast<DWORD>(Size)))
+				&& SUCCEEDED(Factory->CreateDecoderFromStream(Stream.Get(), nullptr, WICDecodeMetadataCacheOnDemand, &Decoder))
+				&& SUCCEEDED(Decoder->GetFrame(0, &Frame))
+				&& SUCCEEDED(Factory->CreateFormatConverter(&Converter))
+				&& SUCCEEDED(Converter->Initialize(Frame.Get(), GUID_WICPixelFormat32bppRGBA,
+					WICBitmapDitherTypeNone, nullptr, 0.0, WICBitmapPaletteTypeCustom))
+				&& SUCCEEDED(Converter->GetSize(&Width, &Height));
+			if (bDecoded)
+			{
+				OutImage.Width = Width;
+				OutImage.Height = Height;
+				OutImage.Texels.resize(static_cast<size_t>(Width) * Height * 4);
+				bDecoded = SUCCEEDED(Converter->CopyPixels(nullptr, Width * 4,
+					static_cast<UINT>(OutImage.Texels.size()), OutImage.Texels.data()));
+			}
+		}
+		if (SUCCEEDED(InitResult))
+		{
+			CoUninitialize();
+		}
+		return bDecoded;
+#else
+		// no image codec off windows, the importer skips the texture and the cooked data is used as is
+		return false;
+#endif
+	}
+
+	EELEM_FORMAT GetCompressedFormat(ETextureSlot Slot, const FRawImage& Image, bool bFast)
+	{
+		switch (Slot)
+		{
+		case ETextureSlot::BaseColor:
+		{
+			bool bHasAlpha{ false };
+			for (size_t i{ 3 }; i < Image.Texels.size() && !bHasAlpha; i += 4)
+			{
+				bHasAlpha = Image.Texels[i] != 255;
+			}
+			if (!bHasAlpha)
+			{
+				return EELEM_FORMAT::BC1_UNORM_SRGB;
+			}
+			return bFast ? EELEM_FORMAT::BC3_UNORM_SRGB : EELEM_FORMAT::BC7_UNORM_SRGB;
+		}
+		case ETextureSlot::Normal:
+			return EELEM_FORMAT::BC5_UNORM;
+		default:
+			return EELEM_FORMAT::BC1_UNORM;
+		}
+	}
+
+	void GenerateMips(const FRawImage& Image, ETextureSlot Slot, std::vector<FRawImage>& OutMips)
+	{
+		OutMips.clear();
+		OutMips.push_back(Image);
+
+		FFloatTexels Texels;
+		DecodeTexels(Image, Slot, Texels);
+		uint32 Width{ Image.Width };
+		uint32 Height{ Image.Height };
+		while (Width > 1 || Height > 1)
+		{
+			const uint32 MipWidth{ std::max(Width / 2, 1u) };
+			const uint32 MipHeight{ std::max(Height / 2, 1u) };
+			FFloatTexels MipTexels;
+			Downsample(Texels, Width, Height, MipTexels, MipWidth, MipHeight);
+			if (Slot == ETextureSlot::Normal)
+			{
+				Renormalize(MipTexels);
+			}
+			OutMips.emplace_back();
+			EncodeTexels(MipTexels, MipWidth, MipHeight, Slot, OutMips.back());
+
+			// the next mip is filtered from the float texels, not from the rounded bytes
+			Texels = std::move(MipTexels);
+			Width = MipWidth;
+			Height = MipHeight;
+		}
+	}
+
+	void CompressMips(const std::vector<FRawImage>& Mips, EELEM_FORMAT Format, FJobSystem& JobSystem, FTextureData& OutTextureData)
+	{
+		const uint32 BlockSize{ util::GetBlockFormatSize(Format) };
+		assert(BlockSize && !Mips.empty());
+		OutTextureData.Format = Format;
+		OutTextureData.Width = Mips.front().Width;
+		OutTextureData.Height = Mips.front().Height;
+		OutTextureData.Mips.clear();
+
+		// one job per row of blocks, so small mips do not serialize the large ones
+		struct FBlockRow
+		{
+			uint32 MipIndex;
+			uint32 Row;
+		};
+		std::vector<FBlockRow> BlockRows;
+		uint64 Offset{ 0 };
+		for (uint32 MipIndex{ 0 }; MipIndex < Mips.size(); ++MipIndex)
+		{
+			FTextureMip Mip;
+			Mip.Width = Mips.at(MipIndex).Width;
+			Mip.Height = Mips.at(MipIndex).Height;
+			Mip.RowPitch = (Mip.Width + 3) / 4 * BlockSize;
+			Mip.NumRows = (Mip.Height + 3) / 4;
+			Mip.Offset = Offset;
+			Mip.Size = static_cast<uint64>(Mip.RowPitch) * Mip.NumRows;
+			OutTextureData.Mips.push_back(Mip);
+			Offset = (Offset + Mip.Size + MipAlignment - 1) / MipAlignment * MipAlignment;
+			for (uint32 Row{ 0 }; Row < Mip.NumRows; ++Row)
+			{
+				BlockRows.push_back({ MipIndex, Row });
+			}
+		}
+		OutTextureData.Data.assign(Offset, 0);
+
+		JobSystem.ParallelFor(static_cast<uint32>(BlockRows.size()), [&](uint32 Index) {
+			const FBlockRow& BlockRow{ BlockRows.at(Index) };
+			const FRawImage& Image{ Mips.at(BlockRow.MipIndex) };
+			const FTextureMip& Mip{ OutTextureData.Mips.at(BlockRow.MipIndex) };
+			uint8* Dest{ OutTextureData.Data.data() + Mip.Offset + static_cast<uint64>(BlockRow.Row) * Mip.RowPitch };
+			uint8 Texels[16 * 4];
+			for (uint32 BlockX{ 0 }; BlockX < Mip.RowPitch / BlockSize; ++BlockX)
+			{
+				// blocks crossing the edge repeat the last texel
+				for (uint32 y{ 0 }; y < 4; ++y)
+				{
+					const uint32 SrcY{ std::min(BlockRow.Row * 4 + y, Image.Height - 1) };
+					for (uint32 x{ 0 }; x < 4; ++x)
+					{
+						const uint32 SrcX{ std::min(BlockX * 4 + x, Image.Width - 1) };
+						memcpy(Texels + (y * 4 + x) * 4, &Image.Texels[(static_cast<size_t>(SrcY) * Image.Width + SrcX) * 4], 4);
+					}
+				}
+				CompressBlock(Format, Texels, Dest + BlockX * BlockSize);
+			}
+		});
+	}
+
+	bool ImportTexture(const uint8* Bytes, size_t Size, ETextureSlot Slot, bool bFast, FJobSystem& JobSystem, FTextureData& OutTextureData)
+	{
+		FRawImage Image;
+		if (!DecodeImage(Bytes, Size, Image) || !Image.Width || !Image.Height)
+		{
+			return false;
+		}
+		std::vector<FRawImage> Mips;
+		GenerateMips(Image, Slot, Mips);
+		CompressMips(Mips, GetCompressedFormat(Slot, Image, bFast), JobSystem, OutTextureData);
+		return true;
+	}
+}
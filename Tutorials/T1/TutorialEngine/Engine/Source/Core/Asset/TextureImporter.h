@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Core/CoreMinimal.h"
+#include "Core/Asset/TextureData.h"
+
+namespace ks
+{
+	class FJobSystem;
+
+	/*
+	* offline texture import used by FAssetCooker
+	* decode -> mip chain -> block compression, the result is written with cooked::WriteTexture
+	*/
+namespace texture
+{
+	/* rgba8 texels, rows are tightly packed */
+	struct FRawImage
+	{
+		uint32 Width{ 0 };
+		uint32 Height{ 0 };
+		std::vector<uint8> Texels;
+	};
+
+	/* decode png, jpeg, bmp, ... from the encoded file bytes */
+	bool DecodeImage(const uint8* Bytes, size_t Size, FRawImage& OutImage);
+	/* base color keeps alpha only if the image has any, bFast picks bc3 over bc7 for it */
+	EELEM_FORMAT GetCompressedFormat(ETextureSlot Slot, const FRawImage& Image, bool bFast);
+	/* full mip chain down to 1x1, mip 0 is a copy of Image */
+	void GenerateMips(const FRawImage& Image, ETextureSlot Slot, std::vector<FRawImage>& OutMips);
+	/* block compress the mips, block rows are spread over the job system */
+	void CompressMips(const std::vector<FRawImage>& Mips, EELEM_FORMAT Format, FJobSystem& JobSystem, FTextureData& OutTextureData);
+	/* all of the above, false if the image can not be decoded */
+	bool ImportTexture(const uint8* Bytes, size_t Size, ETextureSlot Slot, bool bFast, FJobSystem& JobSystem, FTextureData& OutTextureData);
+}
+}
@@ -0,0 +1,43 @@
+#include "engine_pch.h"
+#include "Core/Bounds.h"
+
+#include <emmintrin.h>
+
+namespace ks::util
+{
+	void TransformBoxes(uint32 Count, const glm::mat4* Trans, const FBounds::FBox* LocalBoxes, FBounds::FBox* OutBoxes)
+	{
+		const __m128 Half{ _mm_set1_ps(0.5f) };
+		const __m128 AbsMask{ _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF)) };
+		for (uint32 i = 0; i < Count; ++i)
+		{
+			// glm matrices are column major, one column per register
+			const float* M{ &Trans[i][0][0] };
+			const __m128 Col0{ _mm_loadu_ps(M) };
+			const __m128 Col1{ _mm_loadu_ps(M + 4) };
+			const __m128 Col2{ _mm_loadu_ps(M + 8) };
+			const __m128 Col3{ _mm_loadu_ps(M + 12) };
+
+			const FBounds::FBox& Box{ LocalBoxes[i] };
+			const __m128 Min{ _mm_setr_ps(Box.Min.x, Box.Min.y, Box.Min.z, 0.f) };
+			const __m128 Max{ _mm_setr_ps(Box.Max.x, Box.Max.y, Box.Max.z, 0.f) };
+			const __m128 Center{ _mm_mul_ps(_mm_add_ps(Min, Max), Half) };
+			const __m128 Extent{ _mm_mul_ps(_mm_sub_ps(Max, Min), Half) };
+
+			__m128 WorldCenter{ Col3 };
+			WorldCenter = _mm_add_ps(WorldCenter, _mm_mul_ps(Col0, _mm_shuffle_ps(Center, Center, _MM_SHUFFLE(0, 0, 0, 0))));
+			WorldCenter = _mm_add_ps(WorldCenter, _mm_mul_ps(Col1, _mm_shuffle_ps(Center, Center, _MM_SHUFFLE(1, 1, 1, 1))));
+			WorldCenter = _mm_add_ps(WorldCenter, _mm_mul_ps(Col2, _mm_shuffle_ps(Center, Center, _MM_SHUFFLE(2, 2, 2, 2))));
+			__m128 WorldExtent{ _mm_mul_ps(_mm_and_ps(Col0, AbsMask), _mm_shuffle_ps(Extent, Extent, _MM_SHUFFLE(0, 0, 0, 0))) };
+			WorldExtent = _mm_add_ps(WorldExtent, _mm_mul_ps(_mm_and_ps(Col1, AbsMask), _mm_shuffle_ps(Extent, Extent, _MM_SHUFFLE(1, 1, 1, 1))));
+			WorldExtent = _mm_add_ps(WorldExtent, _mm_mul_ps(_mm_and_ps(Col2, AbsMask), _mm_shuffle_ps(Extent, Extent, _MM_SHUFFLE(2, 2, 2, 2))));
+
+			alignas(16) float WorldMin[4];
+			alignas(16) float WorldMax[4];
+			_mm_store_ps(WorldMin, _mm_sub_ps(WorldCenter, WorldExtent));
+			_mm_store_ps(WorldMax, _mm_add_ps(WorldCenter, WorldExtent));
+			OutBoxes[i].Min = glm::vec3(WorldMin[0], WorldMin[1], WorldMin[2]);
+			OutBoxes[i].Max = glm::vec3(WorldMax[0], WorldMax[1], WorldMax[2]);
+		}
+	}
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Core/CoreMinimal.h"
 #include "Core/Math.h"
 
 namespace ks
@@ -11,8 +12,8 @@ namespace ks
 			Box.Min = Min;
 			Box.Max = Max;
 			Sphere.Center = Center();
-			const glm::vec3 Extents = Extent();
-			Sphere.Radius = glm::max(Extents.x, Extents.y, Extents.z) / 2.f;
+			// half the diagonal, the sphere must enclose the box corners
+			Sphere.Radius = glm::length(Extent()) / 2.f;
 		}
 		inline glm::vec3 Extent() const {
 			return Box.Extent();
@@ -53,4 +54,13 @@ namespace ks
 		FBox Box;
 		FSphere Sphere;
 	};
+
+namespace util
+{
+	/*
+	* exact world space boxes of Count local boxes, Arvo's method on SSE
+	* center' = M * center, extent' = abs(M3x3) * extent
+	*/
+	void TransformBoxes(uint32 Count, const glm::mat4* Trans, const FBounds::FBox* LocalBoxes, FBounds::FBox* OutBoxes);
+}
 }
\ No newline at end of file
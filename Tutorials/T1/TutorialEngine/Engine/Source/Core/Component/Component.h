@@ -1,18 +1,18 @@
 #pragma once
 
+#include "Core/SceneGraph.h"
+
 namespace ks
 {
-	struct FSceneNode;
-
 	class IComponent
 	{
 	public:
 		IComponent() = delete;
-		IComponent(FSceneNode* _Owner):Owner(_Owner){}
+		IComponent(FSceneNodeHandle _Owner):Owner(_Owner){}
 		virtual ~IComponent(){}
-		FSceneNode* GetOwner() { return Owner; }
-		const FSceneNode* GetOwner() const { return Owner; }
+		FSceneNodeHandle GetOwner() const { return Owner; }
 	protected:
-		FSceneNode* Owner{nullptr};
+		// the owner node in the scene graph
+		FSceneNodeHandle Owner;
 	};
 }
\ No newline at end of file
@@ -1,15 +1,20 @@
 #include "engine_pch.h"
 #include "Core/Component/LightComponent.h"
-#include "Core/Scene.h"
 
 namespace ks
 {
-	const glm::vec3 FLightComponent::GetDirection() const
+	const glm::vec3 FLightComponent::GetDirection(const glm::mat4& WorldTrans) const
 	{
-		glm::mat4 WorldTrans = Owner->GetWorldTrans();
 		return glm::normalize(glm::vec3{WorldTrans[2]});
 	}
 
+	float FLightComponent::GetRange() const
+	{
+		// an unbounded light ends where the inverse square falloff drops below the cutoff
+		constexpr float IntensityCutoff{ 0.01f };
+		return LightInfo.Range > 0.f ? LightInfo.Range : std::sqrt(std::max(LightInfo.Intensity, 0.f) / IntensityCutoff);
+	}
+
 	/*const glm::mat4 FLightComponent::WorldToLightMatrix() const
 	{
 		glm::mat4 Direction = GetDirection();
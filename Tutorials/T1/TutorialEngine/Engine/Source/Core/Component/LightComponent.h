@@ -17,15 +17,25 @@ namespace ks
 	{
 		ELightType Type{ ELightType::INVALID };
 		float Intensity{ 0 };
+		glm::vec3 Color{ 1.f };
+		// distance where a point or spot light ends, 0 for the distance its intensity falls below the cutoff
+		float Range{ 0.f };
+		// spot cone half angles in radians
+		float InnerConeAngle{ 0.f };
+		float OuterConeAngle{ glm::quarter_pi<float>() };
 	};
 
 	class FLightComponent : public IComponent
 	{
 	public:
-		FLightComponent(const FLightInfo& _LightInfo, FSceneNode* _Owner) :IComponent(_Owner),LightInfo(_LightInfo) {}
+		FLightComponent(const FLightInfo& _LightInfo, FSceneNodeHandle _Owner) :IComponent(_Owner),LightInfo(_LightInfo) {}
 		float GetIntensity() const { return LightInfo.Intensity; }
 		ELightType GetType() const { return LightInfo.Type; }
-		const glm::vec3 GetDirection() const;
+		const FLightInfo& GetLightInfo() const { return LightInfo; }
+		// the light points along the z axis of its owner
+		const glm::vec3 GetDirection(const glm::mat4& WorldTrans) const;
+		// distance a point or spot light reaches
+		float GetRange() const;
 	private:
 		FLightInfo LightInfo;
 	};
@@ -37,6 +47,14 @@ namespace util
 		{
 			return ELightType::DIRECTIONAL;
 		}
+		if (LightTypeName == "point")
+		{
+			return ELightType::POINT;
+		}
+		if (LightTypeName == "spot")
+		{
+			return ELightType::SPOT;
+		}
 		return ELightType::INVALID;
 	}
 }
@@ -7,20 +7,48 @@
 namespace ks
 {
 	class FStaticMeshAsset;
+
+	enum class EMobility : uint8
+	{
+		// indexed by the BVHs, rarely moves
+		STATIC,
+		// indexed by the loose grids, moves every frame
+		MOVABLE,
+	};
 	
 	class FStaticMeshComponent : public IComponent
 	{
 	public:
-		FStaticMeshComponent(FSceneNode* _Owner, std::shared_ptr<FStaticMeshAsset> StaticMeshAsset);
+		FStaticMeshComponent(FSceneNodeHandle _Owner, std::shared_ptr<FStaticMeshAsset> StaticMeshAsset);
 		virtual ~FStaticMeshComponent() = default;
 		void SetStaticMesh(std::shared_ptr<FStaticMeshAsset> InAsset);
 		FStaticMeshAsset* GetStaticMesh() { return StaticMeshAsset.get(); }
 		const glm::mat4& GetWorldTrans() const { return WorldTrans; }
 		const FBounds& GetBounds() const { return Bounds; }
-		void UpdateWorldTrans();
+		// bounds of the mesh in its own space
+		const FBounds::FBox& GetLocalBox() const { return LocalBox; }
+		// copy the world matrix of the owner, resolved by the scene graph, the bounds are set separately
+		void SetWorldTrans(const glm::mat4& InWorldTrans) { WorldTrans = InWorldTrans; }
+		// world box computed by util::TransformBoxes, batched over the moved components
+		void SetWorldBox(const FBounds::FBox& WorldBox) { Bounds = FBounds(WorldBox.Min, WorldBox.Max); }
+		// re-read the local box from the mesh and transform it
 		void UpdateBounds();
+		// rendering, index of the render primitive created for this component
+		int32 GetPrimitiveIndex() const { return PrimitiveIndex; }
+		void SetPrimitiveIndex(int32 Index) { PrimitiveIndex = Index; }
+		// picks the spatial index of the component, applied by the next update of its primitive
+		EMobility GetMobility() const { return Mobility; }
+		void SetMobility(EMobility InMobility) { Mobility = InMobility; }
+		bool IsMovable() const { return Mobility == EMobility::MOVABLE; }
+		// FScene frame of the last move, a movable component still for long enough turns static again
+		uint64 GetLastMoveFrame() const { return LastMoveFrame; }
+		void SetLastMoveFrame(uint64 Frame) { LastMoveFrame = Frame; }
 	protected:
+		int32 PrimitiveIndex{ -1 };
+		EMobility Mobility{ EMobility::STATIC };
+		uint64 LastMoveFrame{ 0 };
 		FBounds Bounds;
+		FBounds::FBox LocalBox;
 		glm::mat4 WorldTrans{ 1.f };
 		std::shared_ptr<FStaticMeshAsset> StaticMeshAsset{nullptr};
 		void Init();
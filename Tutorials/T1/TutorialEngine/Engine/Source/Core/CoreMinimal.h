@@ -14,11 +14,20 @@
 #include <unordered_map>
 #include <vector>
 #include <array>
+#include <chrono>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <thread>
 #include <set>
 #include <queue>
 #include <deque>
 #include <limits>
+#include <numeric>
 #include <format>
+#include <bit>
 
 #include "Core/Platform.h"
 #include "Core/Math.h"
@@ -59,11 +68,21 @@ namespace ks
 		R8_UINT,
 		R16_INT,
 		R16_UINT,
+		R32_UINT,
 		D24_UNORM_S8_UINT,
 		R8G8B8A8_UNORM,
 		R32G32B32_FLOAT,
 		R32G32B32A32_FLOAT,
 		R16G16B16A16_FLOAT,
+		R8G8B8A8_UNORM_SRGB,
+		// block compressed, 4x4 texel blocks
+		BC1_UNORM,
+		BC1_UNORM_SRGB,
+		BC3_UNORM,
+		BC3_UNORM_SRGB,
+		BC5_UNORM,
+		BC7_UNORM,
+		BC7_UNORM_SRGB,
 	};
 
 	using FColor = float[4];
@@ -82,9 +101,18 @@ namespace util
 
 	uint32_t GetElemFormatSize(EELEM_FORMAT ElemFormat);
 
+	/* bytes per 4x4 block of a block compressed format, 0 for other formats */
+	uint32_t GetBlockFormatSize(EELEM_FORMAT ElemFormat);
+
 	std::string GetContentPath(const std::string& Path);
 
 	std::string GetShaderPath(const std::string& Path);
+
+	/* output of the asset cooker, mirrors the content directory */
+	std::string GetCookedPath(const std::string& Path);
+
+	/* FNV-1a hash of a byte range, chain calls by passing the previous hash as Seed */
+	uint64 HashBytes(const void* Data, size_t Size, uint64 Seed = 14695981039346656037ull);
 }
 
 	class KS_API FString
@@ -99,7 +127,27 @@ namespace util
 			WideCharToMultiByte(CP_UTF8, 0, &wstr[0], (int)wstr.size(), &strTo[0], size_needed, NULL, NULL);
 			return strTo;
 #else
-#error NOT IMPLEMENTED!
+			// wchar_t holds a whole code point off windows, encode it as utf-8
+			std::string strTo;
+			strTo.reserve(wstr.size());
+			for (const wchar_t wc : wstr)
+			{
+				const uint32_t c{ static_cast<uint32_t>(wc) };
+				if (c < 0x80)
+				{
+					strTo += static_cast<char>(c);
+					continue;
+				}
+				// the lead byte marks the number of trailing bytes
+				constexpr uint32_t LeadBits[]{ 0x00, 0xC0, 0xE0, 0xF0 };
+				const uint32_t NumTrail{ c < 0x800 ? 1u : c < 0x10000 ? 2u : 3u };
+				strTo += static_cast<char>(LeadBits[NumTrail] | (c >> (6 * NumTrail)));
+				for (uint32_t i = NumTrail; i > 0; --i)
+				{
+					strTo += static_cast<char>(0x80 | ((c >> (6 * (i - 1))) & 0x3F));
+				}
+			}
+			return strTo;
 #endif
 		}
 
@@ -112,7 +160,21 @@ namespace util
 			MultiByteToWideChar(CP_UTF8, 0, &str[0], (int)str.size(), &wstrTo[0], size_needed);
 			return wstrTo;
 #else
-#error NOT IMPLEMENTED!
+			// decode utf-8 to one wchar_t per code point, a truncated sequence keeps the bits it has
+			std::wstring wstrTo;
+			wstrTo.reserve(str.size());
+			for (size_t i = 0; i < str.size();)
+			{
+				const uint8_t Lead{ static_cast<uint8_t>(str[i++]) };
+				const uint32_t NumTrail{ Lead < 0xC0 ? 0u : Lead < 0xE0 ? 1u : Lead < 0xF0 ? 2u : 3u };
+				uint32_t c{ NumTrail == 0 ? Lead : Lead & (0x3Fu >> NumTrail) };
+				for (uint32_t j = 0; j < NumTrail && i < str.size(); ++j)
+				{
+					c = (c << 6) | (static_cast<uint8_t>(str[i++]) & 0x3F);
+				}
+				wstrTo += static_cast<wchar_t>(c);
+			}
+			return wstrTo;
 #endif
 		}
 
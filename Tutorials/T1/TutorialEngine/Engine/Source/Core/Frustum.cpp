@@ -0,0 +1,88 @@
+#include "engine_pch.h"
+#include "Core/Frustum.h"
+
+#include <emmintrin.h>
+
+namespace ks
+{
+	FFrustum::FFrustum(const glm::mat4& ViewProj)
+	{
+		// glm is column major, Row(i) is the i-th row of the matrix
+		auto Row = [&ViewProj](int32 i) {
+			return glm::vec4(ViewProj[0][i], ViewProj[1][i], ViewProj[2][i], ViewProj[3][i]);
+		};
+		Planes[LEFT] = Row(3) + Row(0);
+		Planes[RIGHT] = Row(3) - Row(0);
+		Planes[BOTTOM] = Row(3) + Row(1);
+		Planes[TOP] = Row(3) - Row(1);
+		Planes[ZNEAR] = Row(2);
+		Planes[ZFAR] = Row(3) - Row(2);
+		for (glm::vec4& Plane : Planes)
+		{
+			Plane /= glm::length(glm::vec3(Plane));
+		}
+	}
+
+	bool FFrustum::Intersects(const FBounds::FBox& Box) const
+	{
+		const glm::vec3 Center{ (Box.Min + Box.Max) * 0.5f };
+		const glm::vec3 Extent{ (Box.Max - Box.Min) * 0.5f };
+		for (const glm::vec4& Plane : Planes)
+		{
+			const glm::vec3 Normal{ Plane };
+			if (glm::dot(Normal, Center) + Plane.w < -glm::dot(glm::abs(Normal), Extent))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+namespace util
+{
+	uint32 CullBoxes(const FFrustum& Frustum, uint32 Count, const FBounds::FBox* Boxes, uint8* OutVisible)
+	{
+		uint32 NumVisible{ 0 };
+		const __m128 Half{ _mm_set1_ps(0.5f) };
+		uint32 i{ 0 };
+		for (; i + 4 <= Count; i += 4)
+		{
+			// transpose 4 boxes to center and extent per axis
+			__m128 Center[3];
+			__m128 Extent[3];
+			for (int32 Axis = 0; Axis < 3; ++Axis)
+			{
+				const __m128 Min{ _mm_setr_ps(Boxes[i].Min[Axis], Boxes[i + 1].Min[Axis], Boxes[i + 2].Min[Axis], Boxes[i + 3].Min[Axis]) };
+				const __m128 Max{ _mm_setr_ps(Boxes[i].Max[Axis], Boxes[i + 1].Max[Axis], Boxes[i + 2].Max[Axis], Boxes[i + 3].Max[Axis]) };
+				Center[Axis] = _mm_mul_ps(_mm_add_ps(Min, Max), Half);
+				Extent[Axis] = _mm_mul_ps(_mm_sub_ps(Max, Min), Half);
+			}
+			__m128 Outside{ _mm_setzero_ps() };
+			for (const glm::vec4& Plane : Frustum.Planes)
+			{
+				// distance of the center against the projected radius of the box
+				__m128 Distance{ _mm_set1_ps(Plane.w) };
+				__m128 Radius{ _mm_setzero_ps() };
+				for (int32 Axis = 0; Axis < 3; ++Axis)
+				{
+					Distance = _mm_add_ps(Distance, _mm_mul_ps(Center[Axis], _mm_set1_ps(Plane[Axis])));
+					Radius = _mm_add_ps(Radius, _mm_mul_ps(Extent[Axis], _mm_set1_ps(std::abs(Plane[Axis]))));
+				}
+				Outside = _mm_or_ps(Outside, _mm_cmplt_ps(_mm_add_ps(Distance, Radius), _mm_setzero_ps()));
+			}
+			const int32 OutsideMask{ _mm_movemask_ps(Outside) };
+			for (uint32 j = 0; j < 4; ++j)
+			{
+				OutVisible[i + j] = (OutsideMask >> j) & 1 ? 0 : 1;
+				NumVisible += OutVisible[i + j];
+			}
+		}
+		for (; i < Count; ++i)
+		{
+			OutVisible[i] = Frustum.Intersects(Boxes[i]) ? 1 : 0;
+			NumVisible += OutVisible[i];
+		}
+		return NumVisible;
+	}
+}
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Core/CoreMinimal.h"
+#include "Core/Bounds.h"
+
+namespace ks
+{
+	/*
+	* six planes extracted from a view projection matrix (Gribb/Hartmann), depth in [0, 1]
+	* the normals point inside, a point p is inside a plane if dot(xyz, p) + w >= 0
+	*/
+	struct FFrustum
+	{
+		// ZNEAR and ZFAR as windows.h defines NEAR and FAR
+		enum EPlane { LEFT, RIGHT, BOTTOM, TOP, ZNEAR, ZFAR, NUM };
+		glm::vec4 Planes[NUM]{};
+
+		FFrustum() = default;
+		explicit FFrustum(const glm::mat4& ViewProj);
+		// false only if the box is fully outside one plane, conservative near the corners
+		bool Intersects(const FBounds::FBox& Box) const;
+	};
+
+namespace util
+{
+	/*
+	* frustum test of Count boxes, 4 boxes per SSE iteration
+	* OutVisible[i] is 1 if box i intersects the frustum, returns the number of visible boxes
+	*/
+	uint32 CullBoxes(const FFrustum& Frustum, uint32 Count, const FBounds::FBox* Boxes, uint8* OutVisible);
+}
+}
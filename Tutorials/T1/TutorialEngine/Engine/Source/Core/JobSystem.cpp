@@ -0,0 +1,212 @@
+#include "engine_pch.h"
+#include "Core/JobSystem.h"
+
+namespace ks
+{
+	FJobSystem* GJobSystem = nullptr;
+
+	FJobSystem* FJobSystem::Create()
+	{
+		return GJobSystem = new FJobSystem;
+	}
+
+	FJobSystem::~FJobSystem()
+	{
+		KS_INFO(TEXT("~FJobSystem"));
+		assert(Workers.empty());
+	}
+
+	void FJobSystem::Init(uint32 NumThreads)
+	{
+		KS_INFO(TEXT("FJobSystem::Init"));
+		if (NumThreads == 0)
+		{
+			NumThreads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+		}
+		bStop = false;
+		for (uint32 i{ 0 }; i < NumThreads; ++i)
+		{
+			Workers.emplace_back(&FJobSystem::WorkerLoop, this);
+		}
+	}
+
+	void FJobSystem::Shutdown()
+	{
+		KS_INFO(TEXT("\tFJobSystem::Shutdown"));
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			bStop = true;
+		}
+		Condition.notify_all();
+		for (auto& Worker : Workers)
+		{
+			Worker.join();
+		}
+		Workers.clear();
+		// jobs submitted after the last wait are run here
+		while (RunPendingJob()) {}
+	}
+
+	void FJobSystem::Submit(FJob Job)
+	{
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			Jobs.push_back(std::move(Job));
+		}
+		Condition.notify_one();
+	}
+
+	bool FJobSystem::RunPendingJob()
+	{
+		FJob Job;
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			if (Jobs.empty())
+			{
+				return false;
+			}
+			Job = std::move(Jobs.front());
+			Jobs.pop_front();
+		}
+		Job();
+		return true;
+	}
+
+	void FJobSystem::WorkerLoop()
+	{
+		while (true)
+		{
+			FJob Job;
+			{
+				std::unique_lock<std::mutex> Lock(Mutex);
+				Condition.wait(Lock, [this]() { return bStop || !Jobs.empty(); });
+				if (Jobs.empty())
+				{
+					return;
+				}
+				Job = std::move(Jobs.front());
+				Jobs.pop_front();
+			}
+			Job();
+		}
+	}
+
+	void FJobSystem::ParallelFor(uint32 Count, const std::function<void(uint32)>& Func, uint32 BatchSize)
+	{
+		assert(BatchSize > 0);
+		const uint32 NumBatches{ (Count + BatchSize - 1) / BatchSize };
+		if (NumBatches <= 1 || Workers.empty())
+		{
+			for (uint32 i{ 0 }; i < Count; ++i)
+			{
+				Func(i);
+			}
+			return;
+		}
+
+		// shared with the helper jobs, a helper may start after this call returned
+		struct FParallelForState
+		{
+			const std::function<void(uint32)>* Func;
+			uint32 Count, BatchSize, NumBatches;
+			std::atomic<uint32> NextBatch{ 0 };
+			std::atomic<uint32> NumDone{ 0 };
+			void RunBatches() {
+				uint32 Batch;
+				while ((Batch = NextBatch.fetch_add(1)) < NumBatches)
+				{
+					const uint32 Begin{ Batch * BatchSize };
+					const uint32 End{ std::min(Begin + BatchSize, Count) };
+					for (uint32 i{ Begin }; i < End; ++i)
+					{
+						(*Func)(i);
+					}
+					NumDone.fetch_add(1, std::memory_order_release);
+				}
+			}
+		};
+		auto State = std::make_shared<FParallelForState>();
+		State->Func = &Func;
+		State->Count = Count;
+		State->BatchSize = BatchSize;
+		State->NumBatches = NumBatches;
+
+		const uint32 NumHelpers{ std::min(GetNumWorkers(), NumBatches - 1) };
+		for (uint32 i{ 0 }; i < NumHelpers; ++i)
+		{
+			Submit([State]() { State->RunBatches(); });
+		}
+		State->RunBatches();
+		while (State->NumDone.load(std::memory_order_acquire) < NumBatches)
+		{
+			if (!RunPendingJob())
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	FTaskGraph::FTaskId FTaskGraph::AddTask(std::function<void()> Func, const std::vector<FTaskId>& Dependencies)
+	{
+		const FTaskId TaskId{ static_cast<FTaskId>(Tasks.size()) };
+		auto Task = std::make_unique<FTask>();
+		Task->Func = std::move(Func);
+		Task->NumDependencies = static_cast<uint32>(Dependencies.size());
+		for (FTaskId Dependency : Dependencies)
+		{
+			assert(Dependency < TaskId);
+			Tasks.at(Dependency)->Dependents.push_back(TaskId);
+		}
+		Tasks.push_back(std::move(Task));
+		return TaskId;
+	}
+
+	void FTaskGraph::Execute(FJobSystem& JobSystem)
+	{
+		for (auto& Task : Tasks)
+		{
+			Task->NumPending.store(Task->NumDependencies);
+		}
+
+		// shared with the jobs, the job of the last task still returns from RunTask after Execute saw it done
+		struct FExecuteState
+		{
+			FTaskGraph* Graph;
+			FJobSystem* JobSystem;
+			std::atomic<uint32> NumRemaining{ 0 };
+			// runs the task, then schedules the dependents it unblocked
+			static void RunTask(const std::shared_ptr<FExecuteState>& State, FTaskId TaskId) {
+				FTask& Task{ *State->Graph->Tasks.at(TaskId) };
+				Task.Func();
+				for (FTaskId Dependent : Task.Dependents)
+				{
+					if (State->Graph->Tasks.at(Dependent)->NumPending.fetch_sub(1) == 1)
+					{
+						State->JobSystem->Submit([State, Dependent]() { RunTask(State, Dependent); });
+					}
+				}
+				// the last access, the graph may be gone once the count reaches zero
+				State->NumRemaining.fetch_sub(1, std::memory_order_release);
+			}
+		};
+		auto State = std::make_shared<FExecuteState>();
+		State->Graph = this;
+		State->JobSystem = &JobSystem;
+		State->NumRemaining.store(GetNumTasks());
+
+		for (FTaskId TaskId{ 0 }; TaskId < GetNumTasks(); ++TaskId)
+		{
+			if (Tasks.at(TaskId)->NumDependencies == 0)
+			{
+				JobSystem.Submit([State, TaskId]() { FExecuteState::RunTask(State, TaskId); });
+			}
+		}
+		while (State->NumRemaining.load(std::memory_order_acquire) > 0)
+		{
+			if (!JobSystem.RunPendingJob())
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Core/CoreMinimal.h"
+
+namespace ks
+{
+	/*
+	* fixed pool of worker threads consuming a shared job queue
+	* threads waiting on jobs (ParallelFor, FTaskGraph::Execute) run queued jobs
+	* themselves, so nested waits do not dead lock
+	*/
+	class KS_API FJobSystem
+	{
+	public:
+		using FJob = std::function<void()>;
+
+		static FJobSystem* Create();
+		~FJobSystem();
+		// NumThreads == 0 uses one worker per core, minus the calling thread
+		void Init(uint32 NumThreads = 0);
+		void Shutdown();
+		uint32 GetNumWorkers() const { return static_cast<uint32>(Workers.size()); }
+		void Submit(FJob Job);
+		// run Func(Index) for Index in [0, Count), returns after all indices are done
+		void ParallelFor(uint32 Count, const std::function<void(uint32)>& Func, uint32 BatchSize = 1);
+		// run one queued job on the calling thread, returns false if the queue is empty
+		bool RunPendingJob();
+	private:
+		void WorkerLoop();
+		std::vector<std::thread> Workers;
+		std::deque<FJob> Jobs;
+		std::mutex Mutex;
+		std::condition_variable Condition;
+		bool bStop{ false };
+	};
+
+	extern KS_API FJobSystem* GJobSystem;
+
+	/*
+	* dependency graph of tasks, tasks without pending dependencies run in parallel
+	*/
+	class KS_API FTaskGraph
+	{
+	public:
+		using FTaskId = uint32;
+		// dependencies must be added before the task
+		FTaskId AddTask(std::function<void()> Func, const std::vector<FTaskId>& Dependencies = {});
+		uint32 GetNumTasks() const { return static_cast<uint32>(Tasks.size()); }
+		// run all tasks on the job system, returns after all tasks are done
+		void Execute(FJobSystem& JobSystem);
+	private:
+		struct FTask
+		{
+			std::function<void()> Func;
+			std::vector<FTaskId> Dependents;
+			uint32 NumDependencies{ 0 };
+			std::atomic<uint32> NumPending{ 0 };
+		};
+		std::vector<std::unique_ptr<FTask>> Tasks;
+	};
+}
@@ -0,0 +1,177 @@
+#include "engine_pch.h"
+#include "Core/LooseGrid.h"
+
+namespace ks
+{
+	namespace
+	{
+		// 19 bits per axis, the level in the top bits
+		constexpr int32 CoordBits{ 19 };
+		constexpr int32 MaxCoord{ (1 << (CoordBits - 1)) - 1 };
+		constexpr int32 MinCoord{ -(1 << (CoordBits - 1)) };
+		// relative to the cell size, rounding may push a fitting object this far out of its loose box
+		constexpr float LooseTolerance{ 1e-3f };
+	}
+
+	uint32 FLooseGrid::GetLevel(const FBox& Box) const
+	{
+		const glm::vec3 Extent{ Box.Extent() };
+		const float MaxExtent{ std::max(std::max(Extent.x, Extent.y), Extent.z) };
+		uint32 Level{ 0 };
+		float LevelCellSize{ CellSize };
+		while (LevelCellSize < MaxExtent && Level + 1 < NumLevels)
+		{
+			LevelCellSize *= 2.f;
+			++Level;
+		}
+		return Level;
+	}
+
+	glm::ivec3 FLooseGrid::GetCellCoord(uint32 Level, const glm::vec3& Position) const
+	{
+		const float LevelCellSize{ CellSize * static_cast<float>(1u << Level) };
+		const glm::vec3 Coord{ glm::floor(Position / LevelCellSize) };
+		return glm::ivec3(glm::clamp(Coord, glm::vec3(static_cast<float>(MinCoord)), glm::vec3(static_cast<float>(MaxCoord))));
+	}
+
+	void FLooseGrid::GetCellRange(uint32 Level, const FBox& Box, glm::ivec3& OutMin, glm::ivec3& OutMax) const
+	{
+		// a cell holds the centers inside it, its objects reach at most half a cell out
+		const float HalfCellSize{ CellSize * static_cast<float>(1u << Level) * (0.5f + LooseTolerance) };
+		OutMin = GetCellCoord(Level, Box.Min - HalfCellSize);
+		OutMax = GetCellCoord(Level, Box.Max + HalfCellSize);
+	}
+
+	uint64 FLooseGrid::MakeKey(uint32 Level, const glm::ivec3& Coord)
+	{
+		constexpr uint64 Mask{ (uint64(1) << CoordBits) - 1 };
+		return (uint64(Level) << (3 * CoordBits)) |
+			((uint64(Coord.z) & Mask) << (2 * CoordBits)) |
+			((uint64(Coord.y) & Mask) << CoordBits) |
+			(uint64(Coord.x) & Mask);
+	}
+
+	FLooseGrid::FBox FLooseGrid::GetLooseBox(uint64 Key) const
+	{
+		const uint32 Level{ static_cast<uint32>(Key >> (3 * CoordBits)) };
+		// sign extend the coordinates
+		auto GetCoord = [Key](int32 Axis) {
+			const int32 Coord{ static_cast<int32>((Key >> (Axis * CoordBits)) & ((uint64(1) << CoordBits) - 1)) };
+			return (Coord << (32 - CoordBits)) >> (32 - CoordBits);
+		};
+		const glm::vec3 Coord{ static_cast<float>(GetCoord(0)), static_cast<float>(GetCoord(1)), static_cast<float>(GetCoord(2)) };
+		const float LevelCellSize{ CellSize * static_cast<float>(1u << Level) };
+		return FBox{ (Coord - 0.5f) * LevelCellSize, (Coord + 1.5f) * LevelCellSize };
+	}
+
+	bool FLooseGrid::IsOversized(uint64 Key, const FBox& Box) const
+	{
+		// larger than the top level cells or clamped at the grid border, allowing for rounding
+		const FBox LooseBox{ GetLooseBox(Key) };
+		const float Tolerance{ LooseBox.Extent().x * 0.5f * LooseTolerance };
+		return glm::any(glm::lessThan(Box.Min, LooseBox.Min - Tolerance)) || glm::any(glm::greaterThan(Box.Max, LooseBox.Max + Tolerance));
+	}
+
+	uint64 FLooseGrid::GetKey(const FBox& Box) const
+	{
+		const uint32 Level{ GetLevel(Box) };
+		return MakeKey(Level, GetCellCoord(Level, Box.Center()));
+	}
+
+	void FLooseGrid::Insert(uint32 Id, const FBox& Box)
+	{
+		if (Id >= Items.size())
+		{
+			Items.resize(Id + 1);
+		}
+		assert(Items[Id].Cell == InvalidIndex);
+		Items[Id].Box = Box;
+		AddToCell(Id, GetKey(Box));
+		++NumItems;
+	}
+
+	void FLooseGrid::Update(uint32 Id, const FBox& Box)
+	{
+		assert(Contains(Id));
+		FItem& Item{ Items[Id] };
+		Item.Box = Box;
+		const uint64 Key{ GetKey(Box) };
+		if (Key == Item.Key && !Item.bOversized && !IsOversized(Key, Box))
+		{
+			return;
+		}
+		RemoveFromCell(Id);
+		AddToCell(Id, Key);
+	}
+
+	void FLooseGrid::Remove(uint32 Id)
+	{
+		assert(Contains(Id));
+		RemoveFromCell(Id);
+		--NumItems;
+	}
+
+	void FLooseGrid::Clear()
+	{
+		Items.clear();
+		Cells.clear();
+		FreeCells.clear();
+		CellLookup.clear();
+		std::fill(std::begin(LevelCounts), std::end(LevelCounts), 0);
+		NumItems = 0;
+		NumOversized = 0;
+	}
+
+	void FLooseGrid::AddToCell(uint32 Id, uint64 Key)
+	{
+		const uint32 Level{ static_cast<uint32>(Key >> (3 * CoordBits)) };
+		auto [It, bInserted] = CellLookup.try_emplace(Key, InvalidIndex);
+		if (bInserted)
+		{
+			if (FreeCells.empty())
+			{
+				It->second = static_cast<uint32>(Cells.size());
+				Cells.emplace_back();
+			}
+			else
+			{
+				It->second = FreeCells.back();
+				FreeCells.pop_back();
+			}
+			FCell& NewCell{ Cells[It->second] };
+			NewCell.Key = Key;
+			NewCell.LooseBox = GetLooseBox(Key);
+		}
+		FCell& Cell{ Cells[It->second] };
+		FItem& Item{ Items[Id] };
+		Item.Key = Key;
+		Item.Cell = It->second;
+		Item.Slot = static_cast<uint32>(Cell.Items.size());
+		Cell.Items.push_back(Id);
+		++LevelCounts[Level];
+		// an oversized object grows the loose box of its cell until the cell empties
+		Item.bOversized = IsOversized(Key, Item.Box);
+		Cell.LooseBox += Item.Box;
+		NumOversized += Item.bOversized ? 1 : 0;
+	}
+
+	void FLooseGrid::RemoveFromCell(uint32 Id)
+	{
+		FItem& Item{ Items[Id] };
+		FCell& Cell{ Cells[Item.Cell] };
+		// swap with the last object of the cell
+		const uint32 LastId{ Cell.Items.back() };
+		Cell.Items[Item.Slot] = LastId;
+		Items[LastId].Slot = Item.Slot;
+		Cell.Items.pop_back();
+		--LevelCounts[Item.Key >> (3 * CoordBits)];
+		NumOversized -= Item.bOversized ? 1 : 0;
+		if (Cell.Items.empty())
+		{
+			CellLookup.erase(Cell.Key);
+			FreeCells.push_back(Item.Cell);
+		}
+		Item.Cell = InvalidIndex;
+		Item.bOversized = false;
+	}
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "Core/CoreMinimal.h"
+#include "Core/Bounds.h"
+
+namespace ks
+{
+	/*
+	* loose hashed grid for objects that move every frame, ids are dense indices chosen by the owner
+	* an object lives in the cell of its center on the level whose cell size fits its extent,
+	* a cell is tested with its loose box, the cell grown by half its size, which holds all its objects
+	* moving an object is a hash lookup and two swaps, nothing is rebuilt
+	*/
+	class FLooseGrid
+	{
+	public:
+		using FBox = FBounds::FBox;
+		static constexpr uint32 NumLevels{ 16 };
+
+		explicit FLooseGrid(float InCellSize = 1.f) : CellSize(InCellSize) {}
+		void Insert(uint32 Id, const FBox& Box);
+		// move the object, only touches the cells if it left its cell
+		void Update(uint32 Id, const FBox& Box);
+		void Remove(uint32 Id);
+		void Clear();
+		bool Contains(uint32 Id) const { return Id < Items.size() && Items[Id].Cell != InvalidIndex; }
+		uint32 GetNumItems() const { return NumItems; }
+		uint32 GetNumCells() const { return static_cast<uint32>(CellLookup.size()); }
+		const FBox& GetBox(uint32 Id) const { return Items[Id].Box; }
+
+		/*
+		* visits the occupied cells, NodeTest(const FBox&) returns false to skip a cell
+		* Visit(Id) is called for the objects of the accepted cells, their boxes still need a test
+		*/
+		template<typename NodeTestType, typename VisitType>
+		void Traverse(NodeTestType&& NodeTest, VisitType&& Visit) const {
+			for (const FCell& Cell : Cells)
+			{
+				if (Cell.Items.empty() || !NodeTest(Cell.LooseBox))
+				{
+					continue;
+				}
+				for (uint32 Id : Cell.Items)
+				{
+					Visit(Id);
+				}
+			}
+		}
+		// objects whose cell overlaps Box, the cells in range are looked up when there are fewer of them than occupied cells
+		template<typename VisitType>
+		void QueryOverlap(const FBox& Box, VisitType&& Visit) const {
+			auto Overlaps = [&Box](const FBox& CellBox) {
+				return glm::all(glm::lessThanEqual(CellBox.Min, Box.Max)) && glm::all(glm::lessThanEqual(Box.Min, CellBox.Max));
+			};
+			uint64 NumRangeCells{ 0 };
+			for (uint32 Level = 0; Level < NumLevels && NumRangeCells <= CellLookup.size(); ++Level)
+			{
+				if (LevelCounts[Level] == 0)
+				{
+					continue;
+				}
+				glm::ivec3 Min, Max;
+				GetCellRange(Level, Box, Min, Max);
+				const glm::ivec3 Range{ Max - Min + 1 };
+				NumRangeCells += uint64(Range.x) * Range.y * Range.z;
+			}
+			// oversized objects stick out of the loose boxes, only the full sweep sees their cells' grown boxes
+			if (NumRangeCells > CellLookup.size() || NumOversized > 0)
+			{
+				Traverse(Overlaps, Visit);
+				return;
+			}
+			for (uint32 Level = 0; Level < NumLevels; ++Level)
+			{
+				if (LevelCounts[Level] == 0)
+				{
+					continue;
+				}
+				glm::ivec3 Min, Max;
+				GetCellRange(Level, Box, Min, Max);
+				for (int32 z = Min.z; z <= Max.z; ++z)
+				{
+					for (int32 y = Min.y; y <= Max.y; ++y)
+					{
+						for (int32 x = Min.x; x <= Max.x; ++x)
+						{
+							auto It = CellLookup.find(MakeKey(Level, glm::ivec3(x, y, z)));
+							if (It == CellLookup.end())
+							{
+								continue;
+							}
+							for (uint32 Id : Cells[It->second].Items)
+							{
+								Visit(Id);
+							}
+						}
+					}
+				}
+			}
+		}
+	private:
+		static constexpr uint32 InvalidIndex{ 0xFFFFFFFF };
+		struct FCell
+		{
+			uint64 Key{ 0 };
+			FBox LooseBox;
+			std::vector<uint32> Items;
+		};
+		struct FItem
+		{
+			FBox Box;
+			uint64 Key{ 0 };
+			uint32 Cell{ InvalidIndex };
+			// position in FCell::Items
+			uint32 Slot{ 0 };
+			// larger than the cells of the top level
+			bool bOversized{ false };
+		};
+		uint32 GetLevel(const FBox& Box) const;
+		glm::ivec3 GetCellCoord(uint32 Level, const glm::vec3& Position) const;
+		// cells on Level whose loose box can overlap Box
+		void GetCellRange(uint32 Level, const FBox& Box, glm::ivec3& OutMin, glm::ivec3& OutMax) const;
+		static uint64 MakeKey(uint32 Level, const glm::ivec3& Coord);
+		uint64 GetKey(const FBox& Box) const;
+		// the cell grown by half its size on every side
+		FBox GetLooseBox(uint64 Key) const;
+		bool IsOversized(uint64 Key, const FBox& Box) const;
+		void AddToCell(uint32 Id, uint64 Key);
+		void RemoveFromCell(uint32 Id);
+
+		float CellSize{ 1.f };
+		std::vector<FItem> Items;
+		std::vector<FCell> Cells;
+		std::vector<uint32> FreeCells;
+		std::unordered_map<uint64, uint32> CellLookup;
+		uint32 LevelCounts[NumLevels]{};
+		uint32 NumItems{ 0 };
+		uint32 NumOversized{ 0 };
+	};
+}
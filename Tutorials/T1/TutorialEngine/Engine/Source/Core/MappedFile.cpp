@@ -0,0 +1,67 @@
+#include "engine_pch.h"
+#include "Core/MappedFile.h"
+
+namespace ks
+{
+	FMappedFile::~FMappedFile()
+	{
+		Close();
+	}
+
+	bool FMappedFile::Open(const std::string& FilePath)
+	{
+		Close();
+#ifdef WINDOWS_PLATFORM
+		FileHandle = CreateFileA(FilePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		LARGE_INTEGER FileSize{};
+		if (FileHandle == INVALID_HANDLE_VALUE || !GetFileSizeEx(FileHandle, &FileSize) || FileSize.QuadPart == 0)
+		{
+			Close();
+			return false;
+		}
+		MappingHandle = CreateFileMappingA(FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!MappingHandle)
+		{
+			Close();
+			return false;
+		}
+		Data = static_cast<const uint8*>(MapViewOfFile(MappingHandle, FILE_MAP_READ, 0, 0, 0));
+		Size = Data ? static_cast<size_t>(FileSize.QuadPart) : 0;
+#else
+		std::ifstream InStream(FilePath, std::ios::in | std::ios::binary);
+		Bytes.assign(std::istreambuf_iterator<char>(InStream), std::istreambuf_iterator<char>());
+		Data = Bytes.empty() ? nullptr : Bytes.data();
+		Size = Bytes.size();
+#endif
+		if (!Data)
+		{
+			Close();
+		}
+		return IsOpen();
+	}
+
+	void FMappedFile::Close()
+	{
+#ifdef WINDOWS_PLATFORM
+		if (Data)
+		{
+			UnmapViewOfFile(Data);
+		}
+		if (MappingHandle)
+		{
+			CloseHandle(MappingHandle);
+			MappingHandle = nullptr;
+		}
+		if (FileHandle != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(FileHandle);
+			FileHandle = INVALID_HANDLE_VALUE;
+		}
+#else
+		Bytes.clear();
+#endif
+		Data = nullptr;
+		Size = 0;
+	}
+}
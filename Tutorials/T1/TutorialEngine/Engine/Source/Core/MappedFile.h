@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Core/CoreMinimal.h"
+
+namespace ks
+{
+	/*
+	* read only view of a whole file, pages are loaded by the os on first access
+	* the view is valid until Close or destruction
+	*/
+	class KS_API FMappedFile
+	{
+	public:
+		FMappedFile() = default;
+		~FMappedFile();
+		FMappedFile(const FMappedFile&) = delete;
+		FMappedFile& operator=(const FMappedFile&) = delete;
+		// false if the file is missing or empty
+		bool Open(const std::string& FilePath);
+		void Close();
+		bool IsOpen() const { return Data != nullptr; }
+		const uint8* GetData() const { return Data; }
+		size_t GetSize() const { return Size; }
+	private:
+		const uint8* Data{ nullptr };
+		size_t Size{ 0 };
+#ifdef WINDOWS_PLATFORM
+		HANDLE FileHandle{ INVALID_HANDLE_VALUE };
+		HANDLE MappingHandle{ nullptr };
+#else
+		std::vector<uint8> Bytes;
+#endif
+	};
+}
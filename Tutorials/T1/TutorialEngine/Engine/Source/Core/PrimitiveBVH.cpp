@@ -0,0 +1,371 @@
+#include "engine_pch.h"
+#include "Core/PrimitiveBVH.h"
+
+namespace ks
+{
+	namespace
+	{
+		constexpr uint32 NumBins{ 16 };
+		// leaves with more primitives are split even if the SAH does not gain
+		constexpr uint32 MaxLeafSize{ 8 };
+		// bounded by the traversal stack
+		constexpr uint32 MaxDepth{ 48 };
+		// cost of visiting a node relative to testing a primitive
+		constexpr float TraversalCost{ 1.f };
+		// rebuild once the refitted tree is this much worse than the built one
+		constexpr float MaxCostRatio{ 1.5f };
+
+		FBounds::FBox EmptyBox()
+		{
+			return FBounds::FBox{ glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest()) };
+		}
+
+		float SurfaceArea(const FBounds::FBox& Box)
+		{
+			const glm::vec3 Extent{ glm::max(Box.Extent(), glm::vec3(0.f)) };
+			return 2.f * (Extent.x * Extent.y + Extent.y * Extent.z + Extent.z * Extent.x);
+		}
+	}
+
+	void FPrimitiveBVH::Build(const std::vector<FBox>& Boxes)
+	{
+		std::vector<uint32> Subset(Boxes.size());
+		std::iota(Subset.begin(), Subset.end(), 0);
+		Build(Boxes, Subset);
+	}
+
+	void FPrimitiveBVH::Build(const std::vector<FBox>& Boxes, const std::vector<uint32>& Subset)
+	{
+		NumPrims = static_cast<uint32>(Subset.size());
+		Nodes.clear();
+		DirtyLeaves.clear();
+		NumRefittedPrims = 0;
+		PrimIndices = Subset;
+		PrimLeaves.assign(Boxes.size(), InvalidNode);
+		if (NumPrims == 0)
+		{
+			Parents.clear();
+			return;
+		}
+		// indexed by primitive index, only the subset is filled
+		std::vector<glm::vec3> Centers(Boxes.size());
+		for (uint32 PrimIndex : Subset)
+		{
+			Centers[PrimIndex] = Boxes[PrimIndex].Center();
+		}
+		Nodes.reserve(2 * NumPrims);
+		Nodes.push_back(FNode{ FBox{}, 0, NumPrims });
+		Subdivide(0, Boxes, Centers, 0);
+
+		// children are stored after their parent
+		Parents.assign(Nodes.size(), InvalidNode);
+		for (uint32 i = 0; i < Nodes.size(); ++i)
+		{
+			const FNode& Node{ Nodes[i] };
+			if (Node.IsLeaf())
+			{
+				for (uint32 j = 0; j < Node.Count; ++j)
+				{
+					PrimLeaves[PrimIndices[Node.LeftFirst + j]] = i;
+				}
+				continue;
+			}
+			Parents[Node.LeftFirst] = i;
+			Parents[Node.LeftFirst + 1] = i;
+		}
+		BuildCost = ComputeCost();
+	}
+
+	void FPrimitiveBVH::Subdivide(uint32 NodeIndex, const std::vector<FBox>& Boxes, const std::vector<glm::vec3>& Centers, uint32 Depth)
+	{
+		const uint32 First{ Nodes[NodeIndex].LeftFirst };
+		const uint32 Count{ Nodes[NodeIndex].Count };
+		FBox NodeBox{ EmptyBox() };
+		FBox CenterBox{ EmptyBox() };
+		for (uint32 i = First; i < First + Count; ++i)
+		{
+			NodeBox += Boxes[PrimIndices[i]];
+			CenterBox.Min = glm::min(CenterBox.Min, Centers[PrimIndices[i]]);
+			CenterBox.Max = glm::max(CenterBox.Max, Centers[PrimIndices[i]]);
+		}
+		Nodes[NodeIndex].Box = NodeBox;
+		if (Count <= 1 || Depth >= MaxDepth)
+		{
+			return;
+		}
+
+		// binned SAH over the centers, the best plane of the three axes
+		const glm::vec3 CenterExtent{ CenterBox.Extent() };
+		float BestCost{ std::numeric_limits<float>::max() };
+		int32 BestAxis{ -1 };
+		uint32 BestSplit{ 0 };
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			if (CenterExtent[Axis] <= 0.f)
+			{
+				continue;
+			}
+			FBox BinBoxes[NumBins];
+			uint32 BinCounts[NumBins]{};
+			std::fill(std::begin(BinBoxes), std::end(BinBoxes), EmptyBox());
+			const float Scale{ NumBins / CenterExtent[Axis] };
+			for (uint32 i = First; i < First + Count; ++i)
+			{
+				const uint32 Bin{ std::min(NumBins - 1, static_cast<uint32>((Centers[PrimIndices[i]][Axis] - CenterBox.Min[Axis]) * Scale)) };
+				BinBoxes[Bin] += Boxes[PrimIndices[i]];
+				++BinCounts[Bin];
+			}
+			// sweep from the right to get the area and count right of every plane
+			float RightAreas[NumBins - 1];
+			uint32 RightCounts[NumBins - 1];
+			FBox RightBox{ EmptyBox() };
+			uint32 RightCount{ 0 };
+			for (uint32 Split = NumBins - 1; Split > 0; --Split)
+			{
+				RightBox += BinBoxes[Split];
+				RightCount += BinCounts[Split];
+				RightAreas[Split - 1] = SurfaceArea(RightBox);
+				RightCounts[Split - 1] = RightCount;
+			}
+			FBox LeftBox{ EmptyBox() };
+			uint32 LeftCount{ 0 };
+			for (uint32 Split = 1; Split < NumBins; ++Split)
+			{
+				LeftBox += BinBoxes[Split - 1];
+				LeftCount += BinCounts[Split - 1];
+				if (LeftCount == 0 || RightCounts[Split - 1] == 0)
+				{
+					continue;
+				}
+				const float Cost{ SurfaceArea(LeftBox) * LeftCount + RightAreas[Split - 1] * RightCounts[Split - 1] };
+				if (Cost < BestCost)
+				{
+					BestCost = Cost;
+					BestAxis = Axis;
+					BestSplit = Split;
+				}
+			}
+		}
+
+		const float NodeArea{ SurfaceArea(NodeBox) };
+		const float SplitCost{ NodeArea > 0.f ? TraversalCost + BestCost / NodeArea : std::numeric_limits<float>::max() };
+		uint32 Mid{ First };
+		if (BestAxis != -1 && (SplitCost < Count || Count > MaxLeafSize))
+		{
+			const float Scale{ NumBins / CenterExtent[BestAxis] };
+			auto MidIt = std::partition(PrimIndices.begin() + First, PrimIndices.begin() + First + Count, [&](uint32 PrimIndex) {
+				return std::min(NumBins - 1, static_cast<uint32>((Centers[PrimIndex][BestAxis] - CenterBox.Min[BestAxis]) * Scale)) < BestSplit;
+			});
+			Mid = static_cast<uint32>(MidIt - PrimIndices.begin());
+		}
+		else if (Count > MaxLeafSize)
+		{
+			// coincident centers, split the list in half
+			Mid = First + Count / 2;
+		}
+		if (Mid == First || Mid == First + Count)
+		{
+			return;
+		}
+
+		const uint32 Left{ static_cast<uint32>(Nodes.size()) };
+		Nodes.push_back(FNode{ FBox{}, First, Mid - First });
+		Nodes.push_back(FNode{ FBox{}, Mid, First + Count - Mid });
+		Nodes[NodeIndex].LeftFirst = Left;
+		Nodes[NodeIndex].Count = 0;
+		Subdivide(Left, Boxes, Centers, Depth + 1);
+		Subdivide(Left + 1, Boxes, Centers, Depth + 1);
+	}
+
+	void FPrimitiveBVH::MarkDirty(uint32 PrimIndex)
+	{
+		if (Contains(PrimIndex))
+		{
+			DirtyLeaves.push_back(PrimLeaves[PrimIndex]);
+		}
+	}
+
+	bool FPrimitiveBVH::Insert(uint32 PrimIndex, const std::vector<FBox>& Boxes)
+	{
+		assert(!Contains(PrimIndex) && PrimIndex < Boxes.size());
+		if (Nodes.empty())
+		{
+			return false;
+		}
+		// down the child whose surface grows least
+		const FBox& Box{ Boxes[PrimIndex] };
+		uint32 NodeIndex{ 0 };
+		while (!Nodes[NodeIndex].IsLeaf())
+		{
+			const uint32 Left{ Nodes[NodeIndex].LeftFirst };
+			const float LeftGrowth{ SurfaceArea(Nodes[Left].Box + Box) - SurfaceArea(Nodes[Left].Box) };
+			const float RightGrowth{ SurfaceArea(Nodes[Left + 1].Box + Box) - SurfaceArea(Nodes[Left + 1].Box) };
+			NodeIndex = LeftGrowth <= RightGrowth ? Left : Left + 1;
+		}
+		FNode& Leaf{ Nodes[NodeIndex] };
+		if (Leaf.Count == 1 && PrimIndices[Leaf.LeftFirst] == InvalidPrim)
+		{
+			PrimIndices[Leaf.LeftFirst] = PrimIndex;
+		}
+		else
+		{
+			// the leaf range grows at the end of the array, the unused ranges go with the next build
+			if (Leaf.LeftFirst + Leaf.Count != PrimIndices.size())
+			{
+				const uint32 First{ static_cast<uint32>(PrimIndices.size()) };
+				PrimIndices.insert(PrimIndices.end(), PrimIndices.begin() + Leaf.LeftFirst, PrimIndices.begin() + Leaf.LeftFirst + Leaf.Count);
+				Leaf.LeftFirst = First;
+			}
+			PrimIndices.push_back(PrimIndex);
+			++Leaf.Count;
+		}
+		if (PrimLeaves.size() <= PrimIndex)
+		{
+			PrimLeaves.resize(PrimIndex + 1, InvalidNode);
+		}
+		PrimLeaves[PrimIndex] = NodeIndex;
+		++NumPrims;
+		for (uint32 Node = NodeIndex; Node != InvalidNode; Node = Parents[Node])
+		{
+			Nodes[Node].Box += Box;
+		}
+		// counted as a refit, the cost check sees the leaves grow
+		DirtyLeaves.push_back(NodeIndex);
+		return true;
+	}
+
+	void FPrimitiveBVH::Remove(uint32 PrimIndex)
+	{
+		assert(Contains(PrimIndex));
+		const uint32 LeafIndex{ PrimLeaves[PrimIndex] };
+		FNode& Leaf{ Nodes[LeafIndex] };
+		const uint32 Entry{ FindLeafEntry(PrimIndex) };
+		// a leaf keeps one entry, Count 0 is an inner node
+		if (Leaf.Count > 1)
+		{
+			PrimIndices[Entry] = PrimIndices[Leaf.LeftFirst + Leaf.Count - 1];
+			--Leaf.Count;
+		}
+		else
+		{
+			PrimIndices[Entry] = InvalidPrim;
+		}
+		PrimLeaves[PrimIndex] = InvalidNode;
+		TrimPrimLeaves();
+		--NumPrims;
+		DirtyLeaves.push_back(LeafIndex);
+	}
+
+	void FPrimitiveBVH::Reindex(uint32 From, uint32 To)
+	{
+		assert(Contains(From) && !Contains(To));
+		PrimIndices[FindLeafEntry(From)] = To;
+		if (PrimLeaves.size() <= To)
+		{
+			PrimLeaves.resize(To + 1, InvalidNode);
+		}
+		PrimLeaves[To] = PrimLeaves[From];
+		PrimLeaves[From] = InvalidNode;
+		TrimPrimLeaves();
+	}
+
+	uint32 FPrimitiveBVH::FindLeafEntry(uint32 PrimIndex) const
+	{
+		const FNode& Leaf{ Nodes[PrimLeaves[PrimIndex]] };
+		const auto Begin{ PrimIndices.begin() + Leaf.LeftFirst };
+		const auto It{ std::find(Begin, Begin + Leaf.Count, PrimIndex) };
+		assert(It != Begin + Leaf.Count);
+		return static_cast<uint32>(It - PrimIndices.begin());
+	}
+
+	void FPrimitiveBVH::TrimPrimLeaves()
+	{
+		while (!PrimLeaves.empty() && PrimLeaves.back() == InvalidNode)
+		{
+			PrimLeaves.pop_back();
+		}
+	}
+
+	void FPrimitiveBVH::UpdateNodeBox(uint32 NodeIndex, const std::vector<FBox>& Boxes)
+	{
+		FNode& Node{ Nodes[NodeIndex] };
+		if (Node.IsLeaf())
+		{
+			FBox Box{ EmptyBox() };
+			for (uint32 i = 0; i < Node.Count; ++i)
+			{
+				const uint32 PrimIndex{ PrimIndices[Node.LeftFirst + i] };
+				if (PrimIndex != InvalidPrim)
+				{
+					Box += Boxes[PrimIndex];
+				}
+			}
+			Node.Box = Box;
+			return;
+		}
+		Node.Box = Nodes[Node.LeftFirst].Box + Nodes[Node.LeftFirst + 1].Box;
+	}
+
+	bool FPrimitiveBVH::Refit(const std::vector<FBox>& Boxes)
+	{
+		assert(Boxes.size() >= PrimLeaves.size());
+		if (DirtyLeaves.empty())
+		{
+			return true;
+		}
+		// many moved primitives, one bottom up sweep is cheaper than walking the paths
+		if (DirtyLeaves.size() * 8 > NumPrims)
+		{
+			DirtyLeaves.clear();
+			for (uint32 i = static_cast<uint32>(Nodes.size()); i-- > 0;)
+			{
+				UpdateNodeBox(i, Boxes);
+			}
+			return !IsDegraded();
+		}
+		// walk up from the leaves, stop once a box is unchanged
+		for (uint32 LeafIndex : DirtyLeaves)
+		{
+			for (uint32 NodeIndex = LeafIndex; NodeIndex != InvalidNode; NodeIndex = Parents[NodeIndex])
+			{
+				const FBox OldBox{ Nodes[NodeIndex].Box };
+				UpdateNodeBox(NodeIndex, Boxes);
+				const FBox& NewBox{ Nodes[NodeIndex].Box };
+				if (OldBox.Min == NewBox.Min && OldBox.Max == NewBox.Max)
+				{
+					break;
+				}
+			}
+		}
+		// the paths do not track the cost, check it once as many primitives as the tree holds were refitted
+		NumRefittedPrims += static_cast<uint32>(DirtyLeaves.size());
+		DirtyLeaves.clear();
+		if (NumRefittedPrims < NumPrims)
+		{
+			return true;
+		}
+		NumRefittedPrims = 0;
+		return !IsDegraded();
+	}
+
+	bool FPrimitiveBVH::IsDegraded() const
+	{
+		// the leaf ranges left behind by the inserts count too, past as many as the tree holds a build compacts them
+		return ComputeCost() > BuildCost * MaxCostRatio || PrimIndices.size() > 2 * static_cast<size_t>(NumPrims) + MaxLeafSize;
+	}
+
+	float FPrimitiveBVH::ComputeCost() const
+	{
+		if (Nodes.empty())
+		{
+			return 0.f;
+		}
+		float Cost{ 0.f };
+		for (const FNode& Node : Nodes)
+		{
+			Cost += SurfaceArea(Node.Box) * (Node.IsLeaf() ? static_cast<float>(Node.Count) : TraversalCost);
+		}
+		const float RootArea{ SurfaceArea(Nodes[0].Box) };
+		return RootArea > 0.f ? Cost / RootArea : 0.f;
+	}
+}
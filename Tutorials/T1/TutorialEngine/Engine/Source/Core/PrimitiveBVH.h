@@ -0,0 +1,120 @@
+#pragma once
+
+#include "Core/CoreMinimal.h"
+#include "Core/Bounds.h"
+
+namespace ks
+{
+	/*
+	* bounding volume hierarchy over a set of boxes, indexed by their position in the box array
+	* indexes the render primitives and the mesh components of the scene query
+	* built top down with a binned SAH, moved primitives are refitted bottom up and
+	* the tree is rebuilt once refitting has degraded its SAH cost too much
+	* streamed primitives are inserted into the leaf they grow least and removed from their leaf,
+	* both are refitted like moves so a cell load costs its own primitives rather than a build
+	*/
+	class FPrimitiveBVH
+	{
+	public:
+		using FBox = FBounds::FBox;
+		// a removed entry of a leaf that had no other primitive, skipped by the traversal
+		static constexpr uint32 InvalidPrim{ 0xFFFFFFFF };
+		struct FNode
+		{
+			FBox Box;
+			// leaf, first index into PrimIndices, otherwise index of the left child, the right child follows it
+			uint32 LeftFirst{ 0 };
+			// number of primitives of a leaf, 0 for an inner node
+			uint32 Count{ 0 };
+			bool IsLeaf() const { return Count > 0; }
+		};
+
+		void Build(const std::vector<FBox>& Boxes);
+		// only the primitives in Subset, the others are never visited
+		void Build(const std::vector<FBox>& Boxes, const std::vector<uint32>& Subset);
+		// the primitive box changed, applied by the next Refit
+		void MarkDirty(uint32 PrimIndex);
+		bool NeedsRefit() const { return !DirtyLeaves.empty(); }
+		// refit the dirty paths, or the whole tree if many primitives moved, returns false if a rebuild is advised
+		// Boxes are all the primitives, the subset of the build included
+		bool Refit(const std::vector<FBox>& Boxes);
+		// add a primitive not in the tree, its box is Boxes[PrimIndex], false if the tree is empty and needs a build
+		bool Insert(uint32 PrimIndex, const std::vector<FBox>& Boxes);
+		// drop a primitive of the tree, the leaf boxes shrink on the next Refit
+		void Remove(uint32 PrimIndex);
+		// the primitive at From moved to the free index To, for the swap removal of the owner arrays
+		void Reindex(uint32 From, uint32 To);
+		bool Contains(uint32 PrimIndex) const { return PrimIndex < PrimLeaves.size() && PrimLeaves[PrimIndex] != InvalidNode; }
+		bool IsEmpty() const { return Nodes.empty(); }
+		uint32 GetNumPrimitives() const { return NumPrims; }
+
+		/*
+		* depth first traversal, NodeTest(const FBox&) returns false to skip a subtree
+		* Visit(PrimIndex) is called for the primitives of the accepted leaves
+		*/
+		template<typename NodeTestType, typename VisitType>
+		void Traverse(NodeTestType&& NodeTest, VisitType&& Visit) const {
+			if (Nodes.empty())
+			{
+				return;
+			}
+			uint32 Stack[64];
+			uint32 StackSize{ 0 };
+			Stack[StackSize++] = 0;
+			while (StackSize > 0)
+			{
+				const FNode& Node{ Nodes[Stack[--StackSize]] };
+				if (!NodeTest(Node.Box))
+				{
+					continue;
+				}
+				if (Node.IsLeaf())
+				{
+					for (uint32 i = 0; i < Node.Count; ++i)
+					{
+						const uint32 PrimIndex{ PrimIndices[Node.LeftFirst + i] };
+						if (PrimIndex != InvalidPrim)
+						{
+							Visit(PrimIndex);
+						}
+					}
+					continue;
+				}
+				assert(StackSize + 2 <= _countof(Stack));
+				Stack[StackSize++] = Node.LeftFirst + 1;
+				Stack[StackSize++] = Node.LeftFirst;
+			}
+		}
+		// primitives whose node boxes overlap Box, the primitive boxes still need a test
+		template<typename VisitType>
+		void QueryOverlap(const FBox& Box, VisitType&& Visit) const {
+			Traverse([&Box](const FBox& NodeBox) {
+				return glm::all(glm::lessThanEqual(NodeBox.Min, Box.Max)) && glm::all(glm::lessThanEqual(Box.Min, NodeBox.Max));
+			}, Visit);
+		}
+	private:
+		void Subdivide(uint32 NodeIndex, const std::vector<FBox>& Boxes, const std::vector<glm::vec3>& Centers, uint32 Depth);
+		void UpdateNodeBox(uint32 NodeIndex, const std::vector<FBox>& Boxes);
+		// SAH cost of the tree over the root area
+		float ComputeCost() const;
+		// the refits and inserts made the tree worse than a build would
+		bool IsDegraded() const;
+		// position of the primitive in PrimIndices, within its leaf
+		uint32 FindLeafEntry(uint32 PrimIndex) const;
+		// drop the trailing primitives that are not in the tree
+		void TrimPrimLeaves();
+
+		static constexpr uint32 InvalidNode{ 0xFFFFFFFF };
+		std::vector<FNode> Nodes;
+		// the leaf ranges, an inserted primitive moves its leaf to the end and leaves the old range unused
+		std::vector<uint32> PrimIndices;
+		uint32 NumPrims{ 0 };
+		// for the incremental refit
+		std::vector<uint32> Parents;
+		std::vector<uint32> PrimLeaves;
+		std::vector<uint32> DirtyLeaves;
+		float BuildCost{ 0.f };
+		// path refits since the last cost check
+		uint32 NumRefittedPrims{ 0 };
+	};
+}
@@ -0,0 +1,108 @@
+#include "engine_pch.h"
+#include "Core/RadixSort.h"
+#include "Core/JobSystem.h"
+
+namespace ks
+{
+	namespace
+	{
+		constexpr uint32 NumDigits{ 256 };
+		constexpr uint32 NumPasses{ sizeof(uint64) };
+		// keys per chunk, smaller arrays sort on the calling thread
+		constexpr uint32 ChunkSize{ 4096 };
+	}
+
+namespace util
+{
+	void RadixSort(std::vector<uint64>& Keys, std::vector<uint32>& Values, FRadixSortScratch& Scratch, FJobSystem* JobSystem)
+	{
+		assert(Keys.size() == Values.size());
+		const uint32 Count{ static_cast<uint32>(Keys.size()) };
+		if (Count < 2)
+		{
+			return;
+		}
+		const uint32 NumChunks{ (Count + ChunkSize - 1) / ChunkSize };
+		auto ForEachChunk = [&](const std::function<void(uint32)>& Func) {
+			if (JobSystem && NumChunks > 1)
+			{
+				JobSystem->ParallelFor(NumChunks, Func);
+			}
+			else
+			{
+				for (uint32 Chunk = 0; Chunk < NumChunks; ++Chunk)
+				{
+					Func(Chunk);
+				}
+			}
+		};
+
+		// the differing bits of the keys, a pass whose byte never differs keeps the order
+		uint64 DifferentBits{ 0 };
+		for (uint32 i = 1; i < Count; ++i)
+		{
+			DifferentBits |= Keys[i] ^ Keys[0];
+		}
+
+		Scratch.Keys.resize(Count);
+		Scratch.Values.resize(Count);
+		Scratch.Histograms.resize(NumChunks * NumDigits);
+		std::vector<uint64>* SourceKeys{ &Keys };
+		std::vector<uint32>* SourceValues{ &Values };
+		std::vector<uint64>* DestKeys{ &Scratch.Keys };
+		std::vector<uint32>* DestValues{ &Scratch.Values };
+		for (uint32 Pass = 0; Pass < NumPasses; ++Pass)
+		{
+			const uint32 Shift{ Pass * 8 };
+			if (((DifferentBits >> Shift) & 0xff) == 0)
+			{
+				continue;
+			}
+			const uint64* InKeys{ SourceKeys->data() };
+			const uint32* InValues{ SourceValues->data() };
+			uint64* OutKeys{ DestKeys->data() };
+			uint32* OutValues{ DestValues->data() };
+			uint32* Histograms{ Scratch.Histograms.data() };
+
+			ForEachChunk([&](uint32 Chunk) {
+				uint32* Histogram{ Histograms + Chunk * NumDigits };
+				std::fill(Histogram, Histogram + NumDigits, 0u);
+				const uint32 End{ std::min(Count, (Chunk + 1) * ChunkSize) };
+				for (uint32 i = Chunk * ChunkSize; i < End; ++i)
+				{
+					++Histogram[(InKeys[i] >> Shift) & 0xff];
+				}
+			});
+			// digit major offsets, the chunks of a digit follow each other so the sort stays stable
+			uint32 Offset{ 0 };
+			for (uint32 Digit = 0; Digit < NumDigits; ++Digit)
+			{
+				for (uint32 Chunk = 0; Chunk < NumChunks; ++Chunk)
+				{
+					const uint32 DigitCount{ Histograms[Chunk * NumDigits + Digit] };
+					Histograms[Chunk * NumDigits + Digit] = Offset;
+					Offset += DigitCount;
+				}
+			}
+			ForEachChunk([&](uint32 Chunk) {
+				uint32* ChunkOffsets{ Histograms + Chunk * NumDigits };
+				const uint32 End{ std::min(Count, (Chunk + 1) * ChunkSize) };
+				for (uint32 i = Chunk * ChunkSize; i < End; ++i)
+				{
+					const uint32 Dest{ ChunkOffsets[(InKeys[i] >> Shift) & 0xff]++ };
+					OutKeys[Dest] = InKeys[i];
+					OutValues[Dest] = InValues[i];
+				}
+			});
+			std::swap(SourceKeys, DestKeys);
+			std::swap(SourceValues, DestValues);
+		}
+		// an odd number of passes left the result in the scratch
+		if (SourceKeys != &Keys)
+		{
+			Keys.swap(Scratch.Keys);
+			Values.swap(Scratch.Values);
+		}
+	}
+}
+}
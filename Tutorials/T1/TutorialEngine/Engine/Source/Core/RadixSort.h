@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Core/CoreMinimal.h"
+
+namespace ks
+{
+	class FJobSystem;
+
+	/* temporaries of util::RadixSort, kept by the caller so the sorts of every frame reuse them */
+	struct FRadixSortScratch
+	{
+		std::vector<uint64> Keys;
+		std::vector<uint32> Values;
+		// a histogram of 256 digits per chunk
+		std::vector<uint32> Histograms;
+	};
+
+namespace util
+{
+	/*
+	* stable least significant digit radix sort of the keys and the values they carry, 8 bits per pass
+	* the passes whose digit is the same for every key are skipped, so the unused high bits cost one count
+	* large arrays count and scatter in chunks on JobSystem if not null
+	*/
+	void RadixSort(std::vector<uint64>& Keys, std::vector<uint32>& Values, FRadixSortScratch& Scratch, FJobSystem* JobSystem);
+}
+}
@@ -1,117 +1,328 @@
 #include "engine_pch.h"
 #include "Core/Scene.h"
 #include "Core/Asset/Assets.h"
+#include "Core/Asset/SceneSnapshot.h"
 #include "Core/Asset/MeshAsset.h"
 #include "Core/Asset/AssetManager.h"
 #include "Render/Render.h"
-#include "Core/Application.h"
 #include "Core/Component/MeshComponent.h"
+#include "Core/JobSystem.h"
 
 namespace ks
 {
 	FScene::FScene(std::shared_ptr<FSceneAsset> _SceneAsset)
 		: SceneAsset(_SceneAsset)
-		, Camera(nullptr)
 		, RenderScene(nullptr)
 	{
-		// create scene nodes
-		std::map<int32, FSceneNode*> SceneNodeMap;
-		std::vector<FSceneNodeInfo> SceneNodeInfos = SceneAsset->GetSceneNodeInfos();
-		for (auto& SceneNodeInfo : SceneNodeInfos)
+		// the snapshot is breadth first, a parent is added before its children
+		const FSceneSnapshot& Snapshot{ SceneAsset->GetSnapshot() };
+		// meshes the scene asset did not load are streamed in later, see AddMeshComponents
+		std::vector<std::shared_ptr<FStaticMeshAsset>> MeshAssets;
+		MeshAssets.reserve(Snapshot.MeshKeys.size());
+		for (const std::string& MeshKey : Snapshot.MeshKeys)
 		{
-			SceneNodes.push_back(std::make_unique<FSceneNode>(SceneNodeInfo));
-			auto& SceneNode{SceneNodes.back()};
+			MeshAssets.push_back(std::dynamic_pointer_cast<FStaticMeshAsset>(GAssetManager->GetAsset(MeshKey)));
+		}
+		const size_t NumMeshes{ static_cast<size_t>(std::count_if(Snapshot.Nodes.begin(), Snapshot.Nodes.end(),
+			[&](const FSnapshotNode& Node) { return Node.Mesh != -1 && MeshAssets[Node.Mesh]; })) };
+		SceneGraph.Reserve(static_cast<uint32>(Snapshot.Nodes.size()));
+		MeshComponents.reserve(NumMeshes);
+
+		// create scene nodes and their components
+		std::vector<FSceneNodeHandle> Nodes(Snapshot.Nodes.size());
+		AssetNodes.resize(Snapshot.NumAssetNodes);
+		for (size_t i = 0; i < Snapshot.Nodes.size(); ++i)
+		{
+			const FSnapshotNode& NodeInfo{ Snapshot.Nodes[i] };
+			const FSceneNodeHandle Parent{ NodeInfo.Parent != -1 ? Nodes[NodeInfo.Parent] : FSceneNodeHandle{} };
+			const FSceneNodeHandle Node{ SceneGraph.AddNode(Parent, std::string(Snapshot.GetName(NodeInfo)),
+				NodeInfo.Translate, NodeInfo.Rotation, NodeInfo.Scale) };
+			Nodes[i] = Node;
+			AssetNodes[NodeInfo.AssetId] = Node;
+
+			if (NodeInfo.Mesh != -1 && MeshAssets[NodeInfo.Mesh])
+			{
+				MeshComponents.emplace_back(Node, MeshAssets[NodeInfo.Mesh]);
+			}
 			// get camera node
-			if (SceneNode->CameraComponent)
+			if (NodeInfo.Camera != -1)
 			{
-				Camera = SceneNode.get();
+				CameraIndex = static_cast<int32>(CameraComponents.size());
+				CameraComponents.emplace_back(Snapshot.Cameras[NodeInfo.Camera], Node);
 			}
-			// get directional light node
-			else if (SceneNode->LightComponent)
+			// get light nodes, the last directional light is the sun
+			else if (NodeInfo.Light != -1)
 			{
-				auto& LightComponent{SceneNode->LightComponent};
-				ELightType LightType{LightComponent->GetType()};
-				switch (LightType)
+				const FLightInfo& LightInfo{ Snapshot.Lights[NodeInfo.Light] };
+				switch (LightInfo.Type)
 				{
 				case ELightType::DIRECTIONAL:
-					DirectionalLight = SceneNode.get();
+					DirectionalLightIndex = static_cast<int32>(LightComponents.size());
 					break;
-				default:
-					assert(false);
+				case ELightType::POINT:
+				case ELightType::SPOT:
 					break;
+				default:
+					KS_INFOA(("Scene : skipped light of unknown type on " + std::string(Snapshot.GetName(NodeInfo))).c_str());
+					continue;
 				}
+				LightComponents.emplace_back(LightInfo, Node);
 			}
-			// insert to map
-			SceneNodeMap.insert({SceneNodeInfo.id, SceneNode.get()});
 		}
-		// setup parent and children links
-		for (auto& SceneNodeInfo : SceneNodeInfos)
+
+		// resolve the world matrices, every node is dirty after creation
+		SceneGraph.Update(GJobSystem);
+		std::vector<uint8> Moved;
+		UpdateMeshComponents(Moved);
+
+		// update scene bounds
+		UpdateSceneBounds();
+		SceneQuery.Build(MeshComponents);
+		
+		// rendering, create render scene
+		RenderScene = FRenderer::CreateRenderScene(this);
+
+		// rendering, add mesh components to render scene
+		for (auto& MeshComponent : MeshComponents)
+		{
+			RenderScene->AddPrimitive(&MeshComponent);
+		}
+	}
+
+	void FScene::Update()
+	{
+		++FrameNumber;
+		std::vector<uint32> ChangedIndices;
+		if (SceneGraph.Update(GJobSystem) != 0)
 		{
-			FSceneNode*& pParent = SceneNodeMap.at(SceneNodeInfo.id);
-			for (auto& ChildId : SceneNodeInfo.ChildrenIds)
+			std::vector<uint8> Moved;
+			UpdateMeshComponents(Moved);
+
+			const uint32 NumMeshComponents{ static_cast<uint32>(MeshComponents.size()) };
+			for (uint32 i = 0; i < NumMeshComponents; ++i)
 			{
-				FSceneNode*& pChild = SceneNodeMap.at(ChildId);
-				pParent->AddChild(pChild);
+				if (!Moved[i])
+				{
+					continue;
+				}
+				// a component that moves after loading leaves the BVHs for the loose grids
+				FStaticMeshComponent& MeshComponent{ MeshComponents[i] };
+				if (!MeshComponent.IsMovable())
+				{
+					MeshComponent.SetMobility(EMobility::MOVABLE);
+					MovableComponents.push_back(i);
+				}
+				MeshComponent.SetLastMoveFrame(FrameNumber);
+				if (RenderScene)
+				{
+					RenderScene->UpdatePrimitive(&MeshComponent);
+				}
+				ChangedIndices.push_back(i);
+			}
+			if (!ChangedIndices.empty())
+			{
+				UpdateSceneBounds();
 			}
 		}
-		// update scene bounds
+		DemoteStillComponents(ChangedIndices);
+		SceneQuery.UpdateComponents(MeshComponents, ChangedIndices);
+	}
+
+	void FScene::DemoteStillComponents(std::vector<uint32>& OutChanged)
+	{
+		// a scripted nudge makes a component movable, this many frames without a move make it static again
+		constexpr uint64 MobilityDemoteFrames{ 120 };
+		for (size_t i = MovableComponents.size(); i-- > 0;)
 		{
-			auto& Box{ SceneBounds.Box };
-			Box.Min = glm::vec3(std::numeric_limits<float>::max());
-			Box.Max = glm::vec3(std::numeric_limits<float>::min());
-			for (auto& SceneNode : SceneNodes)
+			const uint32 Index{ MovableComponents[i] };
+			FStaticMeshComponent& MeshComponent{ MeshComponents[Index] };
+			if (FrameNumber - MeshComponent.GetLastMoveFrame() < MobilityDemoteFrames)
+			{
+				continue;
+			}
+			MeshComponent.SetMobility(EMobility::STATIC);
+			if (RenderScene)
+			{
+				RenderScene->UpdatePrimitive(&MeshComponent);
+			}
+			OutChanged.push_back(Index);
+			MovableComponents[i] = MovableComponents.back();
+			MovableComponents.pop_back();
+		}
+	}
+
+	void FScene::UpdateMeshComponents(std::vector<uint8>& OutMoved)
+	{
+		constexpr uint32 BatchSize{ 64 };
+		const uint32 NumMeshComponents{ static_cast<uint32>(MeshComponents.size()) };
+		const uint32 NumBatches{ (NumMeshComponents + BatchSize - 1) / BatchSize };
+		OutMoved.assign(NumMeshComponents, 0);
+		// gather the moved components of a batch and transform their boxes in one call
+		auto UpdateBatch = [&](uint32 Batch) {
+			glm::mat4 Trans[BatchSize];
+			FBounds::FBox LocalBoxes[BatchSize];
+			FBounds::FBox WorldBoxes[BatchSize];
+			uint32 Indices[BatchSize];
+			uint32 NumMoved{ 0 };
+			const uint32 End{ std::min((Batch + 1) * BatchSize, NumMeshComponents) };
+			for (uint32 i = Batch * BatchSize; i < End; ++i)
 			{
-				if (SceneNode->StaticMeshComponent)
+				FStaticMeshComponent& MeshComponent{ MeshComponents[i] };
+				const FSceneNodeHandle Owner{ MeshComponent.GetOwner() };
+				if (!SceneGraph.IsValid(Owner) || !SceneGraph.HasMoved(Owner))
 				{
-					auto& Bounds{SceneNode->StaticMeshComponent->GetBounds()};
-					Box += Bounds.Box;
+					continue;
 				}
+				MeshComponent.SetWorldTrans(SceneGraph.GetWorldTrans(Owner));
+				Trans[NumMoved] = MeshComponent.GetWorldTrans();
+				LocalBoxes[NumMoved] = MeshComponent.GetLocalBox();
+				Indices[NumMoved++] = i;
+				OutMoved[i] = 1;
+			}
+			util::TransformBoxes(NumMoved, Trans, LocalBoxes, WorldBoxes);
+			for (uint32 i = 0; i < NumMoved; ++i)
+			{
+				MeshComponents[Indices[i]].SetWorldBox(WorldBoxes[i]);
 			}
-			// update sphere bounds
-			SceneBounds = FBounds(Box.Min, Box.Max);
+		};
+		if (GJobSystem)
+		{
+			GJobSystem->ParallelFor(NumBatches, UpdateBatch);
 		}
-		
-		// rendering, create render scene
-		RenderScene = FRenderer::CreateRenderScene(this);
+		else
+		{
+			for (uint32 Batch = 0; Batch < NumBatches; ++Batch)
+			{
+				UpdateBatch(Batch);
+			}
+		}
+	}
 
-		// rendering, add mesh components to render scene
-		for (int32 i = 0; i < SceneNodes.size(); ++i)
+	void FScene::AddMeshComponents(const std::vector<FSceneNodeHandle>& Owners, const std::vector<std::shared_ptr<FStaticMeshAsset>>& MeshAssets)
+	{
+		assert(Owners.size() == MeshAssets.size());
+		if (Owners.empty())
+		{
+			return;
+		}
+		const size_t FirstNew{ MeshComponents.size() };
+		for (size_t i = 0; i < Owners.size(); ++i)
 		{
-			auto& SceneNode = SceneNodes.at(i);
-			FStaticMeshComponent* MeshComponent = SceneNode->GetMeshComponent();
-			if (MeshComponent) { RenderScene->AddPrimitive(MeshComponent); }
+			// the nodes exist since the scene was created, their world matrices are resolved
+			FStaticMeshComponent& MeshComponent{ MeshComponents.emplace_back(Owners[i], MeshAssets[i]) };
+			MeshComponent.SetWorldTrans(SceneGraph.GetWorldTrans(Owners[i]));
+			MeshComponent.UpdateBounds();
 		}
+		for (size_t i = FirstNew; i < MeshComponents.size(); ++i)
+		{
+			RenderScene->AddPrimitive(&MeshComponents[i]);
+		}
+		UpdateSceneBounds();
+		SceneQuery.AddComponents(MeshComponents, static_cast<uint32>(FirstNew));
 	}
 
-	FSceneNode::FSceneNode(const FSceneNodeInfo& NodeInfo)
-		:Name(NodeInfo.Name)
-		,Translate(NodeInfo.Translate)
-		,Rotation(NodeInfo.Rotation)
-		,Scale(NodeInfo.Scale)
+	void FScene::RemoveMeshComponents(const std::vector<FSceneNodeHandle>& Owners)
 	{
-		if (!NodeInfo.MeshAssetKeyName.empty())
+		if (Owners.empty())
 		{
-			std::shared_ptr<IAsset> Asset = GAssetManager->GetAsset(NodeInfo.MeshAssetKeyName);
-			StaticMeshComponent = std::make_unique<FStaticMeshComponent>(this, std::dynamic_pointer_cast<FStaticMeshAsset>(Asset));
+			return;
 		}
-		if (NodeInfo.Camera.Type != ECameraType::INVALID)
+		// the whole handle, a stale handle to a reused slot must not match the new node
+		std::set<std::pair<uint32, uint32>> OwnerHandles;
+		for (const FSceneNodeHandle& Owner : Owners)
 		{
-			CameraComponent = std::make_unique<FCameraComponent>(NodeInfo.Camera);
+			OwnerHandles.insert({ Owner.Index, Owner.Generation });
 		}
-		if (NodeInfo.Light.Type != ELightType::INVALID)
+		// backwards, the component swapped into a hole has been visited already
+		std::vector<uint32> RemovedIndices;
+		for (size_t i = MeshComponents.size(); i-- > 0;)
 		{
-			LightComponent = std::make_unique<FLightComponent>(NodeInfo.Light, this);
+			const FSceneNodeHandle Owner{ MeshComponents[i].GetOwner() };
+			if (!OwnerHandles.contains({ Owner.Index, Owner.Generation }))
+			{
+				continue;
+			}
+			assert(MeshComponents[i].GetPrimitiveIndex() == static_cast<int32>(i));
+			const uint32 Index{ static_cast<uint32>(i) };
+			const uint32 LastIndex{ static_cast<uint32>(MeshComponents.size() - 1) };
+			RenderScene->RemovePrimitive(Index);
+			// the movable list follows the swap, it holds a handful of indices
+			std::erase(MovableComponents, Index);
+			std::replace(MovableComponents.begin(), MovableComponents.end(), LastIndex, Index);
+			if (Index != LastIndex)
+			{
+				MeshComponents[i] = std::move(MeshComponents.back());
+				MeshComponents[i].SetPrimitiveIndex(static_cast<int32>(i));
+			}
+			MeshComponents.pop_back();
+			RemovedIndices.push_back(Index);
+		}
+		UpdateSceneBounds();
+		SceneQuery.RemoveComponents(RemovedIndices);
+	}
+
+	void FScene::UpdateSceneBounds()
+	{
+		// an empty streamed world, keep the bounds finite for the shadow projection
+		if (MeshComponents.empty())
+		{
+			SceneBounds = FBounds(glm::vec3(0.f), glm::vec3(0.f));
+			return;
+		}
+		auto& Box{ SceneBounds.Box };
+		Box.Min = glm::vec3(std::numeric_limits<float>::max());
+		Box.Max = glm::vec3(std::numeric_limits<float>::lowest());
+		for (auto& MeshComponent : MeshComponents)
+		{
+			Box += MeshComponent.GetBounds().Box;
+		}
+		// update sphere bounds
+		SceneBounds = FBounds(Box.Min, Box.Max);
+	}
+
+	void FScene::OnMeshAssetsReimported(const std::vector<std::shared_ptr<FStaticMeshAsset>>& MeshAssets)
+	{
+		std::set<const FStaticMeshAsset*> Reimported;
+		for (auto& MeshAsset : MeshAssets)
+		{
+			Reimported.insert(MeshAsset.get());
+		}
+		std::vector<uint32> ReimportedIndices;
+		for (uint32 i = 0; i < MeshComponents.size(); ++i)
+		{
+			FStaticMeshComponent& MeshComponent{ MeshComponents[i] };
+			if (Reimported.contains(MeshComponent.GetStaticMesh()))
+			{
+				MeshComponent.UpdateBounds();
+				RenderScene->UpdatePrimitive(&MeshComponent);
+				ReimportedIndices.push_back(i);
+			}
+		}
+		UpdateSceneBounds();
+		SceneQuery.UpdateComponents(MeshComponents, ReimportedIndices);
+	}
+
+	const FCameraComponent* FScene::GetCameraComponent(FSceneNodeHandle Camera) const
+	{
+		// a handful of cameras, a linear search is enough
+		for (const FCameraComponent& CameraComponent : CameraComponents)
+		{
+			if (CameraComponent.GetOwner() == Camera)
+			{
+				return &CameraComponent;
+			}
 		}
+		return nullptr;
 	}
 
-	glm::mat4 FCameraComponent::GetProjectionTrans() const
+	glm::mat4 FCameraComponent::GetProjectionTrans(float Aspect) const
 	{
 		switch (CameraInfo.Type)
 		{
 		case ECameraType::PERSPECTIVE:
 			return glm::perspective(
 				glm::degrees(CameraInfo.CameraData.PersCamera.YFov), 
-				GApp->GetWindowAspect(), 
+				Aspect, 
 				CameraInfo.CameraData.PersCamera.ZNear,
 				CameraInfo.CameraData.PersCamera.ZFar);
 			break;
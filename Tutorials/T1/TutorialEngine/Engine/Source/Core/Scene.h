@@ -4,6 +4,8 @@
 #include "Component/LightComponent.h"
 #include "Component/MeshComponent.h"
 #include "Core/Bounds.h"
+#include "Core/SceneGraph.h"
+#include "Core/SceneQuery.h"
 
 namespace ks
 {
@@ -11,6 +13,7 @@ namespace ks
 	class FCameraComponent;
 	class FRenderScene;
 	class FStaticMeshComponent;
+	class FStaticMeshAsset;
 
 	enum class ECameraType : unsigned short
 	{
@@ -45,108 +48,101 @@ namespace ks
 		FCameraData CameraData{};
 	};
 
-	struct FSceneNodeInfo
-	{
-		int32 id;
-		std::vector<int32> ChildrenIds;
-		std::string Name;
-		glm::vec3 Translate;
-		glm::quat Rotation;
-		glm::vec3 Scale;
-		std::string MeshAssetKeyName;
-		FCameraInfo Camera;
-		FLightInfo Light;
-	};
-
-	struct FSceneNode
-	{
-		FSceneNode() = delete;
-		FSceneNode(const FSceneNodeInfo& NodeInfo);
-		FStaticMeshComponent* GetMeshComponent() {
-			return StaticMeshComponent.get();
-		}
-		void AddChild(FSceneNode* Child) {
-			assert(Child && !Child->Parent);
-			Child->Parent = this;
-			Children.push_back(Child);
-		}
-		glm::mat4 GetWorldTrans() const {
-			glm::mat4 ParentWorldTrans = Parent
-				? Parent->GetWorldTrans()
-				: glm::mat4{1.0f};
-			return ParentWorldTrans * GetLocalTrans();
-		}
-		glm::mat4 GetLocalTrans() const {
-			glm::mat4 LocalTrans{1.0f};
-			LocalTrans = glm::scale(LocalTrans, Scale);
-			LocalTrans = glm::mat4_cast(Rotation) * LocalTrans;
-			LocalTrans[3] = glm::vec4(Translate, 1.0f);
-			/*
-			When using glm::translate( X, vec3 ), you are multiplying
-            X * glm::translate( Identity, vec3 )
-			This means translate first, then X
-			so if we want scale first, then rot, then trans, we need the following
-			glm::mat4 lt = glm::translate(glm::mat4{ 1.0f }, Translate);
-			lt = lt * glm::mat4_cast(Rotation);
-			lt = glm::scale(lt, Scale);
-			*/
-			return LocalTrans;
-		}
-		std::string Name;
-		// transform
-		glm::vec3 Translate;
-		glm::quat Rotation;
-		glm::vec3 Scale;
-		// mesh component
-		std::unique_ptr<FStaticMeshComponent> StaticMeshComponent;
-		// camera component
-		std::unique_ptr<FCameraComponent> CameraComponent;
-		// light component
-		std::unique_ptr<FLightComponent> LightComponent;
-		// tree info
-		FSceneNode* Parent{ nullptr };
-		std::vector<FSceneNode*> Children;
-	};
-
-	class FCameraComponent
+	class FCameraComponent : public IComponent
 	{
 	public:
 		FCameraComponent() = delete;
-		FCameraComponent(const FCameraInfo& _CameraInfo) : CameraInfo(_CameraInfo) {}
-		glm::mat4 GetProjectionTrans() const;
+		FCameraComponent(const FCameraInfo& _CameraInfo, FSceneNodeHandle _Owner) : IComponent(_Owner), CameraInfo(_CameraInfo) {}
+		// Aspect is width over height of the view rectangle
+		glm::mat4 GetProjectionTrans(float Aspect) const;
+		const FCameraInfo& GetCameraInfo() const { return CameraInfo; }
 	private:
 		FCameraInfo CameraInfo;
 	};
 
+	/*
+	* nodes live in FSceneGraph, components are stored densely per type and refer to
+	* their node by handle, update and render extraction sweep the arrays linearly
+	*/
 	class FScene
 	{
 	public:
 		FScene() = default;
 		FScene(std::shared_ptr<FSceneAsset> SceneAsset);
 		FRenderScene* GetRenderScene() { return RenderScene; }
-		void Update(){}
-		FSceneNode* GetCamera() { return Camera; }
-		glm::mat4 GetViewTrans() {
-			glm::mat4 Eye2World{ Camera->GetWorldTrans() };
+		// resolve the transforms, moved meshes refresh their bounds and primitives
+		void Update();
+		FSceneGraph& GetSceneGraph() { return SceneGraph; }
+		const FSceneGraph& GetSceneGraph() const { return SceneGraph; }
+		FSceneNodeHandle GetCamera() const {
+			return CameraIndex == -1 ? FSceneNodeHandle{} : CameraComponents.at(CameraIndex).GetOwner();
+		}
+		// every camera of the scene, GetCamera is the main one, the others feed the extra views of the render scene
+		uint32 GetNumCameras() const { return static_cast<uint32>(CameraComponents.size()); }
+		FSceneNodeHandle GetCamera(uint32 Index) const { return CameraComponents.at(Index).GetOwner(); }
+		glm::mat4 GetViewTrans(FSceneNodeHandle Camera) const {
+			glm::mat4 Eye2World{ SceneGraph.GetWorldTrans(Camera) };
 			glm::mat4 World2Eye{ glm::affineInverse(Eye2World) };
 			return World2Eye;
 		}
-		glm::mat4 GetProjectionTrans() {
-			return Camera->CameraComponent->GetProjectionTrans();
+		// camera component on the node, null if it has none
+		const FCameraComponent* GetCameraComponent(FSceneNodeHandle Camera) const;
+		glm::mat4 GetProjectionTrans(FSceneNodeHandle Camera, float Aspect) const {
+			return GetCameraComponent(Camera)->GetProjectionTrans(Aspect);
 		}
 		void GetDirectionalLight(glm::vec3& Direction, float& Intensity) {
-			Direction = DirectionalLight ? DirectionalLight->LightComponent->GetDirection() : glm::vec3(0, 1, 0);
-			Intensity = DirectionalLight ? DirectionalLight->LightComponent->GetIntensity() : 0.f;
+			const FLightComponent* Light{ GetDirectionalLightComponent() };
+			Direction = Light ? Light->GetDirection(SceneGraph.GetWorldTrans(Light->GetOwner())) : glm::vec3(0, 1, 0);
+			Intensity = Light ? Light->GetIntensity() : 0.f;
+		}
+		FSceneNodeHandle GetLightNode() const {
+			return DirectionalLightIndex == -1 ? FSceneNodeHandle{} : LightComponents.at(DirectionalLightIndex).GetOwner();
+		}
+		const FLightComponent* GetDirectionalLightComponent() const {
+			return DirectionalLightIndex == -1 ? nullptr : &LightComponents.at(DirectionalLightIndex);
+		}
+		// every light, the point and spot lights are clustered per view by the render scene
+		const std::vector<FLightComponent>& GetLightComponents() const { return LightComponents; }
+		std::vector<FStaticMeshComponent>& GetMeshComponents() { return MeshComponents; }
+		// node created for the gltf node id, invalid if the node is not part of the scene
+		FSceneNodeHandle GetAssetNode(int32 NodeId) const {
+			return NodeId >= 0 && NodeId < static_cast<int32>(AssetNodes.size()) ? AssetNodes[NodeId] : FSceneNodeHandle{};
 		}
-		FSceneNode* GetLightNode() { return DirectionalLight; }
+		/*
+		* streaming, components of meshes loaded after the scene are appended to the existing nodes
+		* removal swaps the last component into the hole, the primitives follow the same order
+		* the spatial indices insert and remove only the components of the call and refit
+		*/
+		void AddMeshComponents(const std::vector<FSceneNodeHandle>& Owners, const std::vector<std::shared_ptr<FStaticMeshAsset>>& MeshAssets);
+		void RemoveMeshComponents(const std::vector<FSceneNodeHandle>& Owners);
 		const FBounds& GetSceneBounds() const { return SceneBounds; }
+		// ray casts, overlaps and nearest queries over the mesh components, safe from any thread
+		const FSceneQuery& GetSceneQuery() const { return SceneQuery; }
+		// hot reload, refresh the components and primitives using the re-imported meshes
+		void OnMeshAssetsReimported(const std::vector<std::shared_ptr<FStaticMeshAsset>>& MeshAssets);
 	private:
-		FSceneNode* Camera{nullptr};
-		FSceneNode* DirectionalLight{nullptr};
+		void UpdateSceneBounds();
+		// world matrices and bounds of the components whose owner moved, OutMoved flags them
+		void UpdateMeshComponents(std::vector<uint8>& OutMoved);
+		// the movable components that have not moved for MobilityDemoteFrames go back to the BVHs and the shadow cache
+		void DemoteStillComponents(std::vector<uint32>& OutChanged);
 		// ref the scene asset
 		std::shared_ptr<FSceneAsset> SceneAsset;
-		// contain all the scene nodes
-		std::vector<std::unique_ptr<FSceneNode>> SceneNodes;
+		// transform hierarchy of all the scene nodes
+		FSceneGraph SceneGraph;
+		// components, dense per type
+		std::vector<FStaticMeshComponent> MeshComponents;
+		std::vector<FCameraComponent> CameraComponents;
+		std::vector<FLightComponent> LightComponents;
+		// scene node of every gltf node id
+		std::vector<FSceneNodeHandle> AssetNodes;
+		int32 CameraIndex{ -1 };
+		int32 DirectionalLightIndex{ -1 };
+		// indices of the movable components
+		std::vector<uint32> MovableComponents;
+		uint64 FrameNumber{ 0 };
+		// spatial index for the gameplay queries
+		FSceneQuery SceneQuery;
 		// rendering
 		FRenderScene* RenderScene{nullptr};
 		// scene bounds
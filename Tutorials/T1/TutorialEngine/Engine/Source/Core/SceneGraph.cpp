@@ -0,0 +1,268 @@
+#include "engine_pch.h"
+#include "Core/SceneGraph.h"
+#include "Core/JobSystem.h"
+
+namespace ks
+{
+	namespace
+	{
+		glm::mat4 ComposeLocalTrans(const glm::vec3& Translate, const glm::quat& Rotation, const glm::vec3& Scale)
+		{
+			glm::mat4 Trans{1.0f};
+			Trans = glm::scale(Trans, Scale);
+			Trans = glm::mat4_cast(Rotation) * Trans;
+			Trans[3] = glm::vec4(Translate, 1.0f);
+			/*
+			When using glm::translate( X, vec3 ), you are multiplying
+			X * glm::translate( Identity, vec3 )
+			This means translate first, then X
+			so if we want scale first, then rot, then trans, we need the following
+			glm::mat4 lt = glm::translate(glm::mat4{ 1.0f }, Translate);
+			lt = lt * glm::mat4_cast(Rotation);
+			lt = glm::scale(lt, Scale);
+			*/
+			return Trans;
+		}
+
+		constexpr uint32 InvalidIndex{ 0xFFFFFFFF };
+		// nodes per job, smaller levels are resolved on the calling thread
+		constexpr uint32 UpdateBatchSize{ 2048 };
+
+		// moves the kept values to their new dense index
+		template<typename T>
+		void Permute(std::vector<T>& Values, const std::vector<uint32>& NewIndices, uint32 NumKept)
+		{
+			std::vector<T> Sorted(NumKept);
+			for (size_t i = 0; i < Values.size(); ++i)
+			{
+				if (NewIndices[i] != InvalidIndex)
+				{
+					Sorted[NewIndices[i]] = std::move(Values[i]);
+				}
+			}
+			Values.swap(Sorted);
+		}
+	}
+
+	void FSceneGraph::Reserve(uint32 NumNodes)
+	{
+		Slots.reserve(NumNodes);
+		DenseToSlot.reserve(NumNodes);
+		Parents.reserve(NumNodes);
+		Depths.reserve(NumNodes);
+		Translates.reserve(NumNodes);
+		Rotations.reserve(NumNodes);
+		Scales.reserve(NumNodes);
+		LocalTrans.reserve(NumNodes);
+		WorldTrans.reserve(NumNodes);
+		Flags.reserve(NumNodes);
+		Names.reserve(NumNodes);
+	}
+
+	FSceneNodeHandle FSceneGraph::AddNode(FSceneNodeHandle Parent, const std::string& Name,
+		const glm::vec3& Translate, const glm::quat& Rotation, const glm::vec3& Scale)
+	{
+		uint32 SlotIndex{ 0 };
+		if (FreeSlots.empty())
+		{
+			SlotIndex = static_cast<uint32>(Slots.size());
+			Slots.emplace_back();
+		}
+		else
+		{
+			SlotIndex = FreeSlots.back();
+			FreeSlots.pop_back();
+		}
+		const uint32 Dense{ GetNumNodes() };
+		Slots[SlotIndex].Dense = Dense;
+
+		// appending keeps the parent before the child, only the depth order is lost
+		const int32 ParentDense{ Parent.IsValid() ? static_cast<int32>(GetDenseIndex(Parent)) : -1 };
+		assert(ParentDense == -1 || !(Flags[ParentDense] & REMOVED));
+		const uint32 Depth{ ParentDense == -1 ? 0 : Depths[ParentDense] + 1 };
+		bLayoutDirty = bLayoutDirty || Depth + 2 < LevelOffsets.size();
+		DenseToSlot.push_back(SlotIndex);
+		Parents.push_back(ParentDense);
+		Depths.push_back(Depth);
+		Translates.push_back(Translate);
+		Rotations.push_back(Rotation);
+		Scales.push_back(Scale);
+		LocalTrans.emplace_back(1.f);
+		WorldTrans.emplace_back(1.f);
+		Flags.push_back(LOCAL_DIRTY | WORLD_DIRTY);
+		Names.push_back(Name);
+		if (!bLayoutDirty)
+		{
+			// appended to the deepest level or opened a new one
+			if (Depth + 1 == LevelOffsets.size())
+			{
+				LevelOffsets.push_back(Dense + 1);
+			}
+			else
+			{
+				LevelOffsets.back() = Dense + 1;
+			}
+		}
+		return FSceneNodeHandle{ SlotIndex, Slots[SlotIndex].Generation };
+	}
+
+	void FSceneGraph::RemoveNode(FSceneNodeHandle Handle)
+	{
+		const uint32 Dense{ GetDenseIndex(Handle) };
+		Flags[Dense] |= REMOVED;
+		// the handle is stale from now on, the subtree is dropped by RebuildLayout
+		FSlot& Slot{ Slots[Handle.Index] };
+		Slot.Dense = InvalidDense;
+		++Slot.Generation;
+		FreeSlots.push_back(Handle.Index);
+		bLayoutDirty = true;
+	}
+
+	void FSceneGraph::SetTranslate(FSceneNodeHandle Handle, const glm::vec3& Translate)
+	{
+		const uint32 Dense{ GetDenseIndex(Handle) };
+		Translates[Dense] = Translate;
+		Flags[Dense] |= LOCAL_DIRTY | WORLD_DIRTY;
+	}
+
+	void FSceneGraph::SetRotation(FSceneNodeHandle Handle, const glm::quat& Rotation)
+	{
+		const uint32 Dense{ GetDenseIndex(Handle) };
+		Rotations[Dense] = Rotation;
+		Flags[Dense] |= LOCAL_DIRTY | WORLD_DIRTY;
+	}
+
+	void FSceneGraph::SetScale(FSceneNodeHandle Handle, const glm::vec3& Scale)
+	{
+		const uint32 Dense{ GetDenseIndex(Handle) };
+		Scales[Dense] = Scale;
+		Flags[Dense] |= LOCAL_DIRTY | WORLD_DIRTY;
+	}
+
+	uint32 FSceneGraph::Update(FJobSystem* JobSystem)
+	{
+		if (bLayoutDirty)
+		{
+			RebuildLayout();
+		}
+		// a level only reads the world matrices and flags of the previous one
+		uint32 NumMoved{ 0 };
+		for (size_t Level = 0; Level + 1 < LevelOffsets.size(); ++Level)
+		{
+			const uint32 Begin{ LevelOffsets[Level] };
+			const uint32 End{ LevelOffsets[Level + 1] };
+			const uint32 NumBatches{ (End - Begin + UpdateBatchSize - 1) / UpdateBatchSize };
+			if (!JobSystem || NumBatches <= 1)
+			{
+				NumMoved += UpdateRange(Begin, End);
+				continue;
+			}
+			std::atomic<uint32> NumLevelMoved{ 0 };
+			JobSystem->ParallelFor(NumBatches, [&](uint32 Batch) {
+				const uint32 BatchBegin{ Begin + Batch * UpdateBatchSize };
+				NumLevelMoved += UpdateRange(BatchBegin, std::min(BatchBegin + UpdateBatchSize, End));
+			});
+			NumMoved += NumLevelMoved;
+		}
+		return NumMoved;
+	}
+
+	uint32 FSceneGraph::UpdateRange(uint32 Begin, uint32 End)
+	{
+		uint32 NumMoved{ 0 };
+		for (uint32 i = Begin; i < End; ++i)
+		{
+			const uint8 NodeFlags{ Flags[i] };
+			if (NodeFlags & LOCAL_DIRTY)
+			{
+				LocalTrans[i] = ComposeLocalTrans(Translates[i], Rotations[i], Scales[i]);
+			}
+			const int32 Parent{ Parents[i] };
+			if ((NodeFlags & WORLD_DIRTY) || (Parent != -1 && (Flags[Parent] & MOVED)))
+			{
+				WorldTrans[i] = Parent == -1 ? LocalTrans[i] : WorldTrans[Parent] * LocalTrans[i];
+				Flags[i] = MOVED;
+				++NumMoved;
+			}
+			else
+			{
+				Flags[i] = 0;
+			}
+		}
+		return NumMoved;
+	}
+
+	void FSceneGraph::RebuildLayout()
+	{
+		const uint32 NumNodes{ GetNumNodes() };
+		// drop the subtrees of the removed nodes, one sweep as parents precede children
+		uint32 MaxDepth{ 0 };
+		for (uint32 i = 0; i < NumNodes; ++i)
+		{
+			const int32 Parent{ Parents[i] };
+			if (!(Flags[i] & REMOVED) && Parent != -1 && (Flags[Parent] & REMOVED))
+			{
+				Flags[i] |= REMOVED;
+				FSlot& Slot{ Slots[DenseToSlot[i]] };
+				Slot.Dense = InvalidDense;
+				++Slot.Generation;
+				FreeSlots.push_back(DenseToSlot[i]);
+			}
+			if (!(Flags[i] & REMOVED))
+			{
+				MaxDepth = std::max(MaxDepth, Depths[i]);
+			}
+		}
+
+		// counting sort by depth, stable so the order inside a level is kept
+		LevelOffsets.assign(MaxDepth + 2, 0);
+		for (uint32 i = 0; i < NumNodes; ++i)
+		{
+			if (!(Flags[i] & REMOVED))
+			{
+				++LevelOffsets[Depths[i] + 1];
+			}
+		}
+		for (size_t Level = 1; Level < LevelOffsets.size(); ++Level)
+		{
+			LevelOffsets[Level] += LevelOffsets[Level - 1];
+		}
+		const uint32 NumKept{ LevelOffsets.back() };
+		if (NumKept == 0)
+		{
+			LevelOffsets.assign(1, 0);
+		}
+		std::vector<uint32> NextIndices(LevelOffsets.begin(), LevelOffsets.end());
+		std::vector<uint32> NewIndices(NumNodes, InvalidIndex);
+		for (uint32 i = 0; i < NumNodes; ++i)
+		{
+			if (!(Flags[i] & REMOVED))
+			{
+				NewIndices[i] = NextIndices[Depths[i]]++;
+			}
+		}
+
+		for (uint32 i = 0; i < NumNodes; ++i)
+		{
+			if (NewIndices[i] != InvalidIndex && Parents[i] != -1)
+			{
+				Parents[i] = static_cast<int32>(NewIndices[Parents[i]]);
+			}
+		}
+		Permute(DenseToSlot, NewIndices, NumKept);
+		Permute(Parents, NewIndices, NumKept);
+		Permute(Depths, NewIndices, NumKept);
+		Permute(Translates, NewIndices, NumKept);
+		Permute(Rotations, NewIndices, NumKept);
+		Permute(Scales, NewIndices, NumKept);
+		Permute(LocalTrans, NewIndices, NumKept);
+		Permute(WorldTrans, NewIndices, NumKept);
+		Permute(Flags, NewIndices, NumKept);
+		Permute(Names, NewIndices, NumKept);
+		for (uint32 i = 0; i < NumKept; ++i)
+		{
+			Slots[DenseToSlot[i]].Dense = i;
+		}
+		bLayoutDirty = false;
+	}
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "Core/CoreMinimal.h"
+#include "Core/Math.h"
+
+namespace ks
+{
+	class FJobSystem;
+
+	/* generational handle of a scene node, stale once the node is removed */
+	struct FSceneNodeHandle
+	{
+		static constexpr uint32 InvalidIndex{ 0xFFFFFFFF };
+		uint32 Index{ InvalidIndex };
+		uint32 Generation{ 0 };
+		bool IsValid() const { return Index != InvalidIndex; }
+		bool operator==(const FSceneNodeHandle& Other) const = default;
+	};
+
+	/*
+	* transform hierarchy stored as flat arrays (SoA), sorted by depth so a parent
+	* always precedes its children and one linear sweep resolves the world matrices
+	* nodes are addressed by FSceneNodeHandle, the handle maps to a slot that holds the
+	* current dense index, dense indices change when the layout is rebuilt
+	*/
+	class FSceneGraph
+	{
+	public:
+		enum ENodeFlags : uint8
+		{
+			LOCAL_DIRTY = 1 << 0,
+			WORLD_DIRTY = 1 << 1,
+			// the world matrix changed during the last update
+			MOVED = 1 << 2,
+			// dropped with its subtree on the next layout rebuild
+			REMOVED = 1 << 3,
+		};
+
+		void Reserve(uint32 NumNodes);
+		// the parent must be valid or invalid for a root, the node is appended after its parent
+		FSceneNodeHandle AddNode(FSceneNodeHandle Parent, const std::string& Name,
+			const glm::vec3& Translate, const glm::quat& Rotation, const glm::vec3& Scale);
+		// removes the node and its subtree, the handles of the subtree become stale
+		void RemoveNode(FSceneNodeHandle Handle);
+		bool IsValid(FSceneNodeHandle Handle) const {
+			return Handle.Index < Slots.size() && Slots[Handle.Index].Generation == Handle.Generation
+				&& Slots[Handle.Index].Dense != InvalidDense;
+		}
+		/*
+		* rebuild the layout if nodes were added or removed, then resolve the dirty world matrices
+		* level by level, the nodes of a level are split in batches run on JobSystem if not null
+		* returns the number of nodes that moved
+		*/
+		uint32 Update(FJobSystem* JobSystem = nullptr);
+
+		uint32 GetNumNodes() const { return static_cast<uint32>(Parents.size()); }
+		uint32 GetDenseIndex(FSceneNodeHandle Handle) const {
+			assert(IsValid(Handle));
+			return Slots[Handle.Index].Dense;
+		}
+		FSceneNodeHandle GetHandle(uint32 DenseIndex) const {
+			const uint32 SlotIndex{ DenseToSlot[DenseIndex] };
+			return FSceneNodeHandle{ SlotIndex, Slots[SlotIndex].Generation };
+		}
+		FSceneNodeHandle GetParent(FSceneNodeHandle Handle) const {
+			const int32 Parent{ Parents[GetDenseIndex(Handle)] };
+			return Parent == -1 ? FSceneNodeHandle{} : GetHandle(Parent);
+		}
+		const std::string& GetName(FSceneNodeHandle Handle) const { return Names[GetDenseIndex(Handle)]; }
+
+		/*
+		* the cached matrices are refreshed by Update
+		* after a Set* call they keep the previous values until the next update
+		*/
+		const glm::mat4& GetWorldTrans(FSceneNodeHandle Handle) const { return WorldTrans[GetDenseIndex(Handle)]; }
+		const glm::mat4& GetLocalTrans(FSceneNodeHandle Handle) const { return LocalTrans[GetDenseIndex(Handle)]; }
+		const glm::vec3& GetTranslate(FSceneNodeHandle Handle) const { return Translates[GetDenseIndex(Handle)]; }
+		const glm::quat& GetRotation(FSceneNodeHandle Handle) const { return Rotations[GetDenseIndex(Handle)]; }
+		const glm::vec3& GetScale(FSceneNodeHandle Handle) const { return Scales[GetDenseIndex(Handle)]; }
+		void SetTranslate(FSceneNodeHandle Handle, const glm::vec3& Translate);
+		void SetRotation(FSceneNodeHandle Handle, const glm::quat& Rotation);
+		void SetScale(FSceneNodeHandle Handle, const glm::vec3& Scale);
+		bool HasMoved(FSceneNodeHandle Handle) const { return Flags[GetDenseIndex(Handle)] & MOVED; }
+
+		// dense ranges of each depth, level i is [LevelOffsets[i], LevelOffsets[i + 1])
+		const std::vector<uint32>& GetLevelOffsets() const { return LevelOffsets; }
+	private:
+		static constexpr uint32 InvalidDense{ 0xFFFFFFFF };
+		struct FSlot
+		{
+			uint32 Dense{ InvalidDense };
+			uint32 Generation{ 0 };
+		};
+		void RebuildLayout();
+		// resolve the dense range [Begin, End), the parents must be resolved, returns the number of moved nodes
+		uint32 UpdateRange(uint32 Begin, uint32 End);
+
+		// handle slots, freed slots are reused with a new generation
+		std::vector<FSlot> Slots;
+		std::vector<uint32> FreeSlots;
+		// dense arrays, all indexed by the dense index
+		std::vector<uint32> DenseToSlot;
+		std::vector<int32> Parents;
+		std::vector<uint32> Depths;
+		std::vector<glm::vec3> Translates;
+		std::vector<glm::quat> Rotations;
+		std::vector<glm::vec3> Scales;
+		std::vector<glm::mat4> LocalTrans;
+		std::vector<glm::mat4> WorldTrans;
+		std::vector<uint8> Flags;
+		std::vector<std::string> Names;
+		std::vector<uint32> LevelOffsets{ 0 };
+		// set by AddNode and RemoveNode, the depth order is restored on the next update
+		bool bLayoutDirty{ false };
+	};
+}
@@ -0,0 +1,422 @@
+#include "engine_pch.h"
+#include "Core/SceneQuery.h"
+#include "Core/Asset/MeshAsset.h"
+#include "Core/Component/MeshComponent.h"
+#include "Core/JobSystem.h"
+
+namespace ks
+{
+	namespace
+	{
+		// queries per job of the batch entry points
+		constexpr uint32 QueryBatchSize{ 64 };
+
+		// entry distance of the ray into the box, false if it misses or enters beyond MaxDistance
+		bool IntersectRayBox(const glm::vec3& Origin, const glm::vec3& InvDirection, const FBounds::FBox& Box, float MaxDistance, float& OutDistance)
+		{
+			const glm::vec3 T0{ (Box.Min - Origin) * InvDirection };
+			const glm::vec3 T1{ (Box.Max - Origin) * InvDirection };
+			const glm::vec3 TMin{ glm::min(T0, T1) };
+			const glm::vec3 TMax{ glm::max(T0, T1) };
+			const float Enter{ std::max(std::max(TMin.x, TMin.y), std::max(TMin.z, 0.f)) };
+			const float Exit{ std::min(std::min(TMax.x, TMax.y), std::min(TMax.z, MaxDistance)) };
+			OutDistance = Enter;
+			return Enter <= Exit;
+		}
+
+		// Moller-Trumbore, both faces
+		bool IntersectRayTriangle(const glm::vec3& Origin, const glm::vec3& Direction, const glm::vec3& V0, const glm::vec3& V1, const glm::vec3& V2, float& OutDistance)
+		{
+			const glm::vec3 Edge1{ V1 - V0 };
+			const glm::vec3 Edge2{ V2 - V0 };
+			const glm::vec3 P{ glm::cross(Direction, Edge2) };
+			const float Det{ glm::dot(Edge1, P) };
+			if (std::abs(Det) < 1e-12f)
+			{
+				return false;
+			}
+			const float InvDet{ 1.f / Det };
+			const glm::vec3 T{ Origin - V0 };
+			const float U{ glm::dot(T, P) * InvDet };
+			if (U < 0.f || U > 1.f)
+			{
+				return false;
+			}
+			const glm::vec3 Q{ glm::cross(T, Edge1) };
+			const float V{ glm::dot(Direction, Q) * InvDet };
+			if (V < 0.f || U + V > 1.f)
+			{
+				return false;
+			}
+			OutDistance = glm::dot(Edge2, Q) * InvDet;
+			return OutDistance >= 0.f;
+		}
+
+		float DistanceSq(const FBounds::FBox& Box, const glm::vec3& Point)
+		{
+			const glm::vec3 Delta{ glm::max(glm::max(Box.Min - Point, Point - Box.Max), glm::vec3(0.f)) };
+			return glm::dot(Delta, Delta);
+		}
+
+		bool Overlaps(const FBounds::FBox& A, const FBounds::FBox& B)
+		{
+			return glm::all(glm::lessThanEqual(A.Min, B.Max)) && glm::all(glm::lessThanEqual(B.Min, A.Max));
+		}
+
+		template<typename FuncType>
+		void RunBatch(uint32 Count, FJobSystem* JobSystem, FuncType&& Func)
+		{
+			if (JobSystem && Count > QueryBatchSize)
+			{
+				JobSystem->ParallelFor(Count, Func, QueryBatchSize);
+				return;
+			}
+			for (uint32 i = 0; i < Count; ++i)
+			{
+				Func(i);
+			}
+		}
+	}
+
+	void FSceneQuery::Build(std::vector<FStaticMeshComponent>& MeshComponents)
+	{
+		std::unique_lock Lock{ Mutex };
+		const uint32 NumComponents{ static_cast<uint32>(MeshComponents.size()) };
+		Boxes.resize(NumComponents);
+		WorldToLocal.resize(NumComponents);
+		Meshes.resize(NumComponents);
+		DynamicGrid.Clear();
+		for (uint32 i = 0; i < NumComponents; ++i)
+		{
+			SetComponent(i, MeshComponents[i]);
+			if (MeshComponents[i].IsMovable())
+			{
+				DynamicGrid.Insert(i, Boxes[i]);
+			}
+		}
+		BuildBVH();
+	}
+
+	void FSceneQuery::BuildBVH()
+	{
+		std::vector<uint32> StaticIndices;
+		StaticIndices.reserve(Boxes.size() - DynamicGrid.GetNumItems());
+		for (uint32 i = 0; i < Boxes.size(); ++i)
+		{
+			if (!DynamicGrid.Contains(i))
+			{
+				StaticIndices.push_back(i);
+			}
+		}
+		BVH.Build(Boxes, StaticIndices);
+	}
+
+	void FSceneQuery::UpdateComponents(std::vector<FStaticMeshComponent>& MeshComponents, const std::vector<uint32>& Indices)
+	{
+		if (Indices.empty())
+		{
+			return;
+		}
+		std::unique_lock Lock{ Mutex };
+		bool bNeedsBuild{ false };
+		for (uint32 Index : Indices)
+		{
+			SetComponent(Index, MeshComponents[Index]);
+			const bool bMovable{ MeshComponents[Index].IsMovable() };
+			if (bMovable && DynamicGrid.Contains(Index))
+			{
+				DynamicGrid.Update(Index, Boxes[Index]);
+			}
+			else if (bMovable)
+			{
+				// the mobility changed, the component moves between the tree and the grid without a build
+				DynamicGrid.Insert(Index, Boxes[Index]);
+				BVH.Remove(Index);
+			}
+			else if (DynamicGrid.Contains(Index))
+			{
+				DynamicGrid.Remove(Index);
+				if (!bNeedsBuild)
+				{
+					// an empty tree, every component was movable, has nothing to insert into
+					bNeedsBuild = !BVH.Insert(Index, Boxes);
+				}
+			}
+			else
+			{
+				BVH.MarkDirty(Index);
+			}
+		}
+		if (bNeedsBuild)
+		{
+			BuildBVH();
+			return;
+		}
+		RefitBVH();
+	}
+
+	void FSceneQuery::AddComponents(std::vector<FStaticMeshComponent>& MeshComponents, uint32 FirstNew)
+	{
+		std::unique_lock Lock{ Mutex };
+		assert(FirstNew == Boxes.size());
+		const uint32 NumComponents{ static_cast<uint32>(MeshComponents.size()) };
+		Boxes.resize(NumComponents);
+		WorldToLocal.resize(NumComponents);
+		Meshes.resize(NumComponents);
+		bool bNeedsBuild{ false };
+		for (uint32 i = FirstNew; i < NumComponents; ++i)
+		{
+			SetComponent(i, MeshComponents[i]);
+			if (MeshComponents[i].IsMovable())
+			{
+				DynamicGrid.Insert(i, Boxes[i]);
+			}
+			else if (!bNeedsBuild)
+			{
+				// the first cell of an empty world has no tree to insert into
+				bNeedsBuild = !BVH.Insert(i, Boxes);
+			}
+		}
+		if (bNeedsBuild)
+		{
+			BuildBVH();
+			return;
+		}
+		RefitBVH();
+	}
+
+	void FSceneQuery::RemoveComponents(const std::vector<uint32>& Indices)
+	{
+		if (Indices.empty())
+		{
+			return;
+		}
+		std::unique_lock Lock{ Mutex };
+		for (uint32 Index : Indices)
+		{
+			const uint32 LastIndex{ static_cast<uint32>(Boxes.size() - 1) };
+			assert(Index <= LastIndex);
+			if (DynamicGrid.Contains(Index))
+			{
+				DynamicGrid.Remove(Index);
+			}
+			else
+			{
+				BVH.Remove(Index);
+			}
+			if (Index != LastIndex)
+			{
+				Boxes[Index] = Boxes[LastIndex];
+				WorldToLocal[Index] = WorldToLocal[LastIndex];
+				Meshes[Index] = Meshes[LastIndex];
+				if (DynamicGrid.Contains(LastIndex))
+				{
+					DynamicGrid.Remove(LastIndex);
+					DynamicGrid.Insert(Index, Boxes[Index]);
+				}
+				else
+				{
+					BVH.Reindex(LastIndex, Index);
+				}
+			}
+			Boxes.pop_back();
+			WorldToLocal.pop_back();
+			Meshes.pop_back();
+		}
+		RefitBVH();
+	}
+
+	void FSceneQuery::RefitBVH()
+	{
+		if (!BVH.Refit(Boxes))
+		{
+			BuildBVH();
+		}
+	}
+
+	void FSceneQuery::SetComponent(uint32 Index, FStaticMeshComponent& MeshComponent)
+	{
+		Boxes[Index] = MeshComponent.GetBounds().Box;
+		WorldToLocal[Index] = glm::affineInverse(MeshComponent.GetWorldTrans());
+		Meshes[Index] = MeshComponent.GetStaticMesh() ? &MeshComponent.GetStaticMesh()->GetMeshData() : nullptr;
+	}
+
+	bool FSceneQuery::RayCast(const FRay& Ray, FRayHit& OutHit, ERayCastMode Mode) const
+	{
+		std::shared_lock Lock{ Mutex };
+		return RayCastLocked(Ray, OutHit, Mode);
+	}
+
+	bool FSceneQuery::RayCastLocked(const FRay& Ray, FRayHit& OutHit, ERayCastMode Mode) const
+	{
+		OutHit = FRayHit{};
+		const glm::vec3 InvDirection{ 1.f / Ray.Direction };
+		float ClosestDistance{ Ray.MaxDistance };
+		// the closest hit so far prunes the nodes entered beyond it
+		auto NodeTest = [&](const FBounds::FBox& NodeBox) {
+			float Distance;
+			return IntersectRayBox(Ray.Origin, InvDirection, NodeBox, ClosestDistance, Distance);
+		};
+		auto Visit = [&](uint32 Index) {
+			float Distance;
+			if (!IntersectRayBox(Ray.Origin, InvDirection, Boxes[Index], ClosestDistance, Distance))
+			{
+				return;
+			}
+			if (Mode == ERayCastMode::TRIANGLES)
+			{
+				Distance = ClosestDistance;
+				if (!RayCastMesh(Index, Ray, Distance))
+				{
+					return;
+				}
+			}
+			ClosestDistance = Distance;
+			OutHit.MeshComponentIndex = static_cast<int32>(Index);
+			OutHit.Distance = Distance;
+		};
+		BVH.Traverse(NodeTest, Visit);
+		DynamicGrid.Traverse(NodeTest, Visit);
+		if (OutHit.IsValid())
+		{
+			OutHit.Position = Ray.Origin + Ray.Direction * OutHit.Distance;
+		}
+		return OutHit.IsValid();
+	}
+
+	bool FSceneQuery::RayCastMesh(uint32 Index, const FRay& Ray, float& InOutDistance) const
+	{
+		const FMeshData* MeshData{ Meshes[Index] };
+		if (!MeshData || MeshData->PositionData.DataType != EDATA_TYPE::FLOAT)
+		{
+			return false;
+		}
+		// an affine transform keeps the ray parameter, the distance needs no conversion
+		const glm::vec3 Origin{ WorldToLocal[Index] * glm::vec4(Ray.Origin, 1.f) };
+		const glm::vec3 Direction{ WorldToLocal[Index] * glm::vec4(Ray.Direction, 0.f) };
+		const FMeshAttributeData& IndexData{ MeshData->IndexData };
+		const FMeshAttributeData& PositionData{ MeshData->PositionData };
+		auto GetPosition = [&](uint32 i) {
+			const uint32 Vertex{ IndexData.DataType == EDATA_TYPE::UNSIGNED_INT ?
+				reinterpret_cast<const uint32*>(IndexData.Data.data())[i] :
+				reinterpret_cast<const uint16*>(IndexData.Data.data())[i] };
+			glm::vec3 Position;
+			memcpy(&Position, PositionData.Data.data() + Vertex * PositionData.Stride, sizeof(glm::vec3));
+			return Position;
+		};
+		bool bHit{ false };
+		for (uint32 i = 0; i + 2 < IndexData.Count; i += 3)
+		{
+			float Distance;
+			if (IntersectRayTriangle(Origin, Direction, GetPosition(i), GetPosition(i + 1), GetPosition(i + 2), Distance) && Distance < InOutDistance)
+			{
+				InOutDistance = Distance;
+				bHit = true;
+			}
+		}
+		return bHit;
+	}
+
+	void FSceneQuery::OverlapBox(const FBounds::FBox& Box, std::vector<uint32>& OutIndices) const
+	{
+		std::shared_lock Lock{ Mutex };
+		OverlapBoxLocked(Box, OutIndices);
+	}
+
+	void FSceneQuery::OverlapBoxLocked(const FBounds::FBox& Box, std::vector<uint32>& OutIndices) const
+	{
+		auto Visit = [&](uint32 Index) {
+			if (Overlaps(Boxes[Index], Box))
+			{
+				OutIndices.push_back(Index);
+			}
+		};
+		BVH.QueryOverlap(Box, Visit);
+		DynamicGrid.QueryOverlap(Box, Visit);
+	}
+
+	void FSceneQuery::OverlapSphere(const FBounds::FSphere& Sphere, std::vector<uint32>& OutIndices) const
+	{
+		std::shared_lock Lock{ Mutex };
+		const float RadiusSq{ Sphere.Radius * Sphere.Radius };
+		auto NodeTest = [&](const FBounds::FBox& NodeBox) {
+			return DistanceSq(NodeBox, Sphere.Center) <= RadiusSq;
+		};
+		auto Visit = [&](uint32 Index) {
+			if (DistanceSq(Boxes[Index], Sphere.Center) <= RadiusSq)
+			{
+				OutIndices.push_back(Index);
+			}
+		};
+		BVH.Traverse(NodeTest, Visit);
+		DynamicGrid.Traverse(NodeTest, Visit);
+	}
+
+	void FSceneQuery::FindNearest(const glm::vec3& Point, uint32 K, std::vector<uint32>& OutIndices) const
+	{
+		std::shared_lock Lock{ Mutex };
+		FindNearestLocked(Point, K, OutIndices);
+	}
+
+	void FSceneQuery::FindNearestLocked(const glm::vec3& Point, uint32 K, std::vector<uint32>& OutIndices) const
+	{
+		OutIndices.clear();
+		if (K == 0)
+		{
+			return;
+		}
+		// max heap of the K best, its top bounds the nodes still worth visiting
+		std::vector<std::pair<float, uint32>> Nearest;
+		Nearest.reserve(K + 1);
+		auto NodeTest = [&](const FBounds::FBox& NodeBox) {
+			return Nearest.size() < K || DistanceSq(NodeBox, Point) < Nearest.front().first;
+		};
+		auto Visit = [&](uint32 Index) {
+			const float Distance{ DistanceSq(Boxes[Index], Point) };
+			if (Nearest.size() == K && Distance >= Nearest.front().first)
+			{
+				return;
+			}
+			Nearest.emplace_back(Distance, Index);
+			std::push_heap(Nearest.begin(), Nearest.end());
+			if (Nearest.size() > K)
+			{
+				std::pop_heap(Nearest.begin(), Nearest.end());
+				Nearest.pop_back();
+			}
+		};
+		BVH.Traverse(NodeTest, Visit);
+		DynamicGrid.Traverse(NodeTest, Visit);
+		std::sort_heap(Nearest.begin(), Nearest.end());
+		for (const auto& [Distance, Index] : Nearest)
+		{
+			OutIndices.push_back(Index);
+		}
+	}
+
+	void FSceneQuery::RayCastBatch(uint32 Count, const FRay* Rays, FRayHit* OutHits, ERayCastMode Mode, FJobSystem* JobSystem) const
+	{
+		// one shared lock for the batch, the jobs run under it
+		std::shared_lock Lock{ Mutex };
+		RunBatch(Count, JobSystem, [&](uint32 i) {
+			RayCastLocked(Rays[i], OutHits[i], Mode);
+		});
+	}
+
+	void FSceneQuery::OverlapBoxBatch(uint32 Count, const FBounds::FBox* QueryBoxes, std::vector<uint32>* OutIndices, FJobSystem* JobSystem) const
+	{
+		std::shared_lock Lock{ Mutex };
+		RunBatch(Count, JobSystem, [&](uint32 i) {
+			OutIndices[i].clear();
+			OverlapBoxLocked(QueryBoxes[i], OutIndices[i]);
+		});
+	}
+
+	void FSceneQuery::FindNearestBatch(uint32 Count, const glm::vec3* Points, uint32 K, std::vector<uint32>* OutIndices, FJobSystem* JobSystem) const
+	{
+		std::shared_lock Lock{ Mutex };
+		RunBatch(Count, JobSystem, [&](uint32 i) {
+			FindNearestLocked(Points[i], K, OutIndices[i]);
+		});
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Core/CoreMinimal.h"
+#include "Core/Bounds.h"
+#include "Core/PrimitiveBVH.h"
+#include "Core/LooseGrid.h"
+
+namespace ks
+{
+	class FJobSystem;
+	class FStaticMeshComponent;
+	struct FMeshData;
+
+	struct FRay
+	{
+		glm::vec3 Origin{ 0.f };
+		// need not be normalized, distances are in units of its length
+		glm::vec3 Direction{ 0.f, 0.f, 1.f };
+		float MaxDistance{ std::numeric_limits<float>::max() };
+	};
+
+	struct FRayHit
+	{
+		// index into FScene::GetMeshComponents, -1 if nothing was hit
+		int32 MeshComponentIndex{ -1 };
+		float Distance{ std::numeric_limits<float>::max() };
+		glm::vec3 Position{ 0.f };
+		bool IsValid() const { return MeshComponentIndex != -1; }
+	};
+
+	enum class ERayCastMode : uint8
+	{
+		// hit the world boxes, cheap and conservative
+		BOUNDS,
+		// hit the mesh triangles inside the boxes
+		TRIANGLES,
+	};
+
+	/*
+	* spatial queries over the mesh components of a scene, backed by a BVH of the static world boxes
+	* and a loose grid of the movable ones
+	* the queries take a shared lock and can run from any number of threads,
+	* FScene updates the index under the exclusive lock when components move
+	* results are indices into FScene::GetMeshComponents
+	*/
+	class FSceneQuery
+	{
+	public:
+		void Build(std::vector<FStaticMeshComponent>& MeshComponents);
+		// refresh the boxes of the given components, move the movable ones in the grid and refit the tree
+		void UpdateComponents(std::vector<FStaticMeshComponent>& MeshComponents, const std::vector<uint32>& Indices);
+		// streaming, index the components from FirstNew on, appended by FScene since the last call
+		void AddComponents(std::vector<FStaticMeshComponent>& MeshComponents, uint32 FirstNew);
+		// streaming, the same swap removals FScene made, in the same order, the last component moves into each index
+		void RemoveComponents(const std::vector<uint32>& Indices);
+
+		// closest hit along the ray, false if nothing was hit
+		bool RayCast(const FRay& Ray, FRayHit& OutHit, ERayCastMode Mode = ERayCastMode::BOUNDS) const;
+		// components whose world box overlaps, appended to OutIndices
+		void OverlapBox(const FBounds::FBox& Box, std::vector<uint32>& OutIndices) const;
+		void OverlapSphere(const FBounds::FSphere& Sphere, std::vector<uint32>& OutIndices) const;
+		// up to K components closest to Point by box distance, nearest first
+		void FindNearest(const glm::vec3& Point, uint32 K, std::vector<uint32>& OutIndices) const;
+
+		// batch entry points, the queries are spread over JobSystem if not null
+		void RayCastBatch(uint32 Count, const FRay* Rays, FRayHit* OutHits, ERayCastMode Mode, FJobSystem* JobSystem) const;
+		void OverlapBoxBatch(uint32 Count, const FBounds::FBox* QueryBoxes, std::vector<uint32>* OutIndices, FJobSystem* JobSystem) const;
+		void FindNearestBatch(uint32 Count, const glm::vec3* Points, uint32 K, std::vector<uint32>* OutIndices, FJobSystem* JobSystem) const;
+	private:
+		void SetComponent(uint32 Index, FStaticMeshComponent& MeshComponent);
+		void BuildBVH();
+		// apply the marked changes to the tree, rebuilt if the refit is not good enough
+		void RefitBVH();
+		// the lock is held by the caller
+		bool RayCastLocked(const FRay& Ray, FRayHit& OutHit, ERayCastMode Mode) const;
+		void OverlapBoxLocked(const FBounds::FBox& Box, std::vector<uint32>& OutIndices) const;
+		void FindNearestLocked(const glm::vec3& Point, uint32 K, std::vector<uint32>& OutIndices) const;
+		// closest triangle hit of the mesh in its local space, the distance is in units of the ray
+		bool RayCastMesh(uint32 Index, const FRay& Ray, float& InOutDistance) const;
+
+		mutable std::shared_mutex Mutex;
+		FPrimitiveBVH BVH;
+		FLooseGrid DynamicGrid;
+		std::vector<FBounds::FBox> Boxes;
+		// for the triangle tests
+		std::vector<glm::mat4> WorldToLocal;
+		std::vector<const FMeshData*> Meshes;
+	};
+}
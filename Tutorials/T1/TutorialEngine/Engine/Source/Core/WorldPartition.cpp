@@ -0,0 +1,280 @@
+#include "engine_pch.h"
+#include "Core/WorldPartition.h"
+#include "Core/Scene.h"
+#include "Core/JobSystem.h"
+#include "Core/Asset/AssetManager.h"
+#include "Core/Asset/CookedData.h"
+#include "RHI/RHI.h"
+
+namespace ks
+{
+	FWorldPartition::FWorldPartition(FJobSystem* InJobSystem, const FStreamingSettings& InSettings)
+		:JobSystem(InJobSystem)
+		,Settings(InSettings)
+	{
+		assert(Settings.UnloadRadius >= Settings.LoadRadius);
+	}
+
+	// the jobs in flight only reference their request
+	FWorldPartition::~FWorldPartition() = default;
+
+	bool FWorldPartition::Load(const std::string& ScenePath)
+	{
+		// the partition is cooked from the scene, it must come from the cook of the cooked scene
+		// FSceneAsset checks that one against the gltf source
+		uint64 SourceHash{ 0 };
+		uint64 SceneHash{ 0 };
+		if (!cooked::ReadPartition(cooked::GetPartitionPath(ScenePath), PartitionData, SourceHash) ||
+			!cooked::ReadSourceHash(cooked::GetScenePath(ScenePath), cooked::SceneMagic, SceneHash) ||
+			SourceHash != util::HashBytes(&PartitionData.CellSize, sizeof(PartitionData.CellSize), SceneHash))
+		{
+			return false;
+		}
+		Meshes.assign(PartitionData.MeshKeys.size(), FMesh{});
+		Cells.assign(PartitionData.Cells.size(), FCell{});
+		for (size_t i = 0; i < Cells.size(); ++i)
+		{
+			std::vector<uint32>& MeshIndices{ Cells[i].MeshIndices };
+			for (const FPartitionInstance& Instance : PartitionData.Cells[i].Instances)
+			{
+				MeshIndices.push_back(Instance.MeshIndex);
+			}
+			std::sort(MeshIndices.begin(), MeshIndices.end());
+			MeshIndices.erase(std::unique(MeshIndices.begin(), MeshIndices.end()), MeshIndices.end());
+		}
+		KS_INFOA(std::format("World partition : {} cells of {} for {} meshes",
+			Cells.size(), PartitionData.CellSize, Meshes.size()).c_str());
+		return true;
+	}
+
+	void FWorldPartition::Update(FScene& Scene)
+	{
+		const FSceneNodeHandle Camera{ Scene.GetCamera() };
+		const glm::vec3 ViewPosition{ Camera.IsValid() ? glm::vec3(Scene.GetSceneGraph().GetWorldTrans(Camera)[3]) : glm::vec3(0.f) };
+		const uint32 NumLoadedBefore{ Stats.NumLoadedCells };
+		uint32 NumUnloaded{ 0 };
+
+		// finish the read cells in request order until the time budget is spent
+		const auto Deadline{ std::chrono::steady_clock::now() +
+			std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float, std::milli>(Settings.TimeBudgetMs)) };
+		while (!Requests.empty() && Requests.front()->bRead.load(std::memory_order_acquire))
+		{
+			FCellRequest& Request{ *Requests.front() };
+			if (!FinishCell(Scene, Request, Deadline))
+			{
+				break;
+			}
+			Cells[Request.Cell].State = ECellState::LOADED;
+			Cells[Request.Cell].Request.reset();
+			++Stats.NumLoadedCells;
+			Requests.pop_front();
+		}
+
+		SortedCells.clear();
+		for (uint32 Cell = 0; Cell < Cells.size(); ++Cell)
+		{
+			SortedCells.push_back({ GetCellDistance(Cell, ViewPosition), Cell });
+		}
+		std::sort(SortedCells.begin(), SortedCells.end());
+
+		// a loading cell finishes first and is unloaded on a later frame
+		std::vector<uint32> ReleasedMeshes;
+		for (const auto& [Distance, Cell] : SortedCells)
+		{
+			if (Distance > Settings.UnloadRadius && Cells[Cell].State == ECellState::LOADED)
+			{
+				UnloadCell(Scene, Cell, ReleasedMeshes);
+				++NumUnloaded;
+			}
+		}
+
+		// request the near cells, nearest first, making room by dropping the loaded cells out of the load radius
+		for (const auto& [Distance, Cell] : SortedCells)
+		{
+			if (Distance > Settings.LoadRadius || Requests.size() >= Settings.MaxPendingCells)
+			{
+				break;
+			}
+			if (Cells[Cell].State != ECellState::UNLOADED)
+			{
+				continue;
+			}
+			uint64 NeededBytes{ 0 };
+			for (uint32 MeshIndex : Cells[Cell].MeshIndices)
+			{
+				const FMesh& Mesh{ Meshes[MeshIndex] };
+				NeededBytes += Mesh.Asset || Mesh.bPending ? 0 : PartitionData.MeshBytes[MeshIndex];
+			}
+			auto IsOverBudget = [&]() {
+				const uint64 UsedBytes{ Stats.ResidentBytes + Stats.PendingBytes };
+				// a cell larger than the budget still loads into an empty world
+				return UsedBytes > 0 && UsedBytes + NeededBytes > Settings.MemoryBudget;
+			};
+			for (auto It = SortedCells.rbegin(); It != SortedCells.rend() && It->first > Settings.LoadRadius && IsOverBudget(); ++It)
+			{
+				if (Cells[It->second].State == ECellState::LOADED)
+				{
+					UnloadCell(Scene, It->second, ReleasedMeshes);
+					++NumUnloaded;
+				}
+			}
+			if (IsOverBudget())
+			{
+				break;
+			}
+			RequestCell(Cell);
+		}
+
+		ReleaseMeshes(ReleasedMeshes);
+		Stats.NumPendingCells = static_cast<uint32>(Requests.size());
+		if (Stats.NumLoadedCells + NumUnloaded != NumLoadedBefore)
+		{
+			KS_INFOA(std::format("World partition : {} cells loaded, {} unloaded, {} resident, {} pending, {:.1f} MB",
+				Stats.NumLoadedCells + NumUnloaded - NumLoadedBefore, NumUnloaded, Stats.NumLoadedCells,
+				Stats.NumPendingCells, Stats.ResidentBytes / float(1 << 20)).c_str());
+		}
+	}
+
+	float FWorldPartition::GetCellDistance(uint32 Cell, const glm::vec3& Position) const
+	{
+		const FBounds::FBox& Box{ PartitionData.Cells[Cell].Box };
+		const glm::vec2 Point{ Position.x, Position.z };
+		const glm::vec2 Outside{ glm::max(glm::max(glm::vec2(Box.Min.x, Box.Min.z) - Point, Point - glm::vec2(Box.Max.x, Box.Max.z)), glm::vec2(0.f)) };
+		return glm::length(Outside);
+	}
+
+	void FWorldPartition::RequestCell(uint32 Cell)
+	{
+		auto Request{ std::make_shared<FCellRequest>() };
+		Request->Cell = Cell;
+		// the resident meshes are pinned now, a mesh read by an earlier request is created before this one finishes
+		for (uint32 MeshIndex : Cells[Cell].MeshIndices)
+		{
+			FMesh& Mesh{ Meshes[MeshIndex] };
+			++Mesh.NumRefs;
+			if (Mesh.Asset || Mesh.bPending)
+			{
+				continue;
+			}
+			Mesh.bPending = true;
+			Stats.PendingBytes += PartitionData.MeshBytes[MeshIndex];
+			Request->MeshIndices.push_back(MeshIndex);
+			Request->MeshPaths.push_back(cooked::GetMeshPath(PartitionData.MeshKeys[MeshIndex]));
+		}
+		const size_t NumReads{ Request->MeshIndices.size() };
+		Request->MeshDatas.resize(NumReads);
+		Request->SourceHashes.resize(NumReads);
+		Request->Succeeded.resize(NumReads);
+		Cells[Cell].State = ECellState::LOADING;
+		Cells[Cell].Request = Request;
+		Requests.push_back(Request);
+
+		auto Read = [Request]() {
+			for (size_t i = 0; i < Request->MeshPaths.size(); ++i)
+			{
+				FMeshData& MeshData{ Request->MeshDatas[i] };
+				const std::string& MaterialKey{ MeshData.MaterialData.KeyName };
+				Request->Succeeded[i] = cooked::ReadMesh(Request->MeshPaths[i], MeshData, Request->SourceHashes[i]) &&
+					(MaterialKey.empty() || cooked::ReadMaterial(cooked::GetMaterialPath(MaterialKey), MeshData.MaterialData));
+			}
+			Request->bRead.store(true, std::memory_order_release);
+		};
+		if (JobSystem && NumReads > 0)
+		{
+			JobSystem->Submit(Read);
+		}
+		else
+		{
+			Read();
+		}
+	}
+
+	bool FWorldPartition::FinishCell(FScene& Scene, FCellRequest& Request, std::chrono::steady_clock::time_point Deadline)
+	{
+		// one mesh at a time, the render data upload is the expensive part
+		for (; Request.NumCreated < Request.MeshIndices.size(); ++Request.NumCreated)
+		{
+			if (std::chrono::steady_clock::now() >= Deadline)
+			{
+				return false;
+			}
+			const uint32 i{ Request.NumCreated };
+			const uint32 MeshIndex{ Request.MeshIndices[i] };
+			FMesh& Mesh{ Meshes[MeshIndex] };
+			Mesh.bPending = false;
+			Stats.PendingBytes -= PartitionData.MeshBytes[MeshIndex];
+			if (!Request.Succeeded[i])
+			{
+				KS_INFOA(("World partition : failed to read " + Request.MeshPaths[i]).c_str());
+				continue;
+			}
+			Mesh.Asset = GAssetManager->CreateStaticMeshAsset(std::move(Request.MeshDatas[i]));
+			Mesh.Asset->SetSourceHash(Request.SourceHashes[i]);
+			Mesh.Asset->PostLoad();
+			Stats.ResidentBytes += PartitionData.MeshBytes[MeshIndex];
+			++Stats.NumResidentMeshes;
+		}
+
+		std::vector<FSceneNodeHandle> Owners;
+		std::vector<std::shared_ptr<FStaticMeshAsset>> MeshAssets;
+		for (const FPartitionInstance& Instance : PartitionData.Cells[Request.Cell].Instances)
+		{
+			const FSceneNodeHandle Owner{ Scene.GetAssetNode(Instance.NodeId) };
+			const std::shared_ptr<FStaticMeshAsset>& MeshAsset{ Meshes[Instance.MeshIndex].Asset };
+			if (Owner.IsValid() && MeshAsset)
+			{
+				Owners.push_back(Owner);
+				MeshAssets.push_back(MeshAsset);
+			}
+		}
+		Scene.AddMeshComponents(Owners, MeshAssets);
+		return true;
+	}
+
+	void FWorldPartition::UnloadCell(FScene& Scene, uint32 Cell, std::vector<uint32>& OutReleasedMeshes)
+	{
+		assert(Cells[Cell].State == ECellState::LOADED);
+		std::vector<FSceneNodeHandle> Owners;
+		for (const FPartitionInstance& Instance : PartitionData.Cells[Cell].Instances)
+		{
+			Owners.push_back(Scene.GetAssetNode(Instance.NodeId));
+		}
+		Scene.RemoveMeshComponents(Owners);
+		// the bytes are freed now so the budget sees them, the assets are released once per frame
+		for (uint32 MeshIndex : Cells[Cell].MeshIndices)
+		{
+			FMesh& Mesh{ Meshes[MeshIndex] };
+			assert(Mesh.NumRefs > 0);
+			if (--Mesh.NumRefs == 0 && Mesh.Asset)
+			{
+				Stats.ResidentBytes -= PartitionData.MeshBytes[MeshIndex];
+				OutReleasedMeshes.push_back(MeshIndex);
+			}
+		}
+		Cells[Cell].State = ECellState::UNLOADED;
+		--Stats.NumLoadedCells;
+	}
+
+	void FWorldPartition::ReleaseMeshes(const std::vector<uint32>& MeshIndices)
+	{
+		if (MeshIndices.empty())
+		{
+			return;
+		}
+		// the frames in flight still draw with the render data about to be released
+		GRHI->FlushRenderingCommands();
+		for (uint32 MeshIndex : MeshIndices)
+		{
+			FMesh& Mesh{ Meshes[MeshIndex] };
+			// requested again by a nearer cell after its unload
+			if (Mesh.NumRefs > 0)
+			{
+				Stats.ResidentBytes += PartitionData.MeshBytes[MeshIndex];
+				continue;
+			}
+			GAssetManager->UnloadAsset(PartitionData.MeshKeys[MeshIndex]);
+			Mesh.Asset.reset();
+			--Stats.NumResidentMeshes;
+		}
+	}
+}
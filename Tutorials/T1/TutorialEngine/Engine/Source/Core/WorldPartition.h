@@ -0,0 +1,107 @@
+#pragma once
+
+#include "Core/CoreMinimal.h"
+#include "Core/Asset/PartitionData.h"
+#include "Core/Asset/MeshAsset.h"
+
+namespace ks
+{
+	class FScene;
+	class FJobSystem;
+
+	struct FStreamingSettings
+	{
+		// cells closer to the camera on the xz plane are loaded, nearest first
+		float LoadRadius{ 150.f };
+		// loaded cells farther than this are unloaded, the gap keeps cells on the edge from thrashing
+		float UnloadRadius{ 200.f };
+		// cooked bytes of the resident and loading meshes
+		uint64 MemoryBudget{ uint64(512) << 20 };
+		// main thread time per frame spent creating the render data of the read meshes
+		float TimeBudgetMs{ 2.f };
+		// cells read at the same time
+		uint32 MaxPendingCells{ 4 };
+	};
+
+	struct FStreamingStats
+	{
+		uint32 NumLoadedCells{ 0 };
+		uint32 NumPendingCells{ 0 };
+		uint32 NumResidentMeshes{ 0 };
+		uint64 ResidentBytes{ 0 };
+		uint64 PendingBytes{ 0 };
+	};
+
+	/*
+	* streams the cells of a world partition cooked by FAssetCooker in and out of the scene around the camera
+	* the cooked meshes of a cell are read by a job, the main thread creates their render data under the
+	* time budget and adds the components to the scene, a mesh is refcounted by the cells that use it
+	* and is released with the last one
+	*/
+	class FWorldPartition
+	{
+	public:
+		FWorldPartition(FJobSystem* InJobSystem, const FStreamingSettings& InSettings = {});
+		~FWorldPartition();
+		// read the cooked partition of the scene, false if the scene was not cooked
+		// the scene asset must still be loaded from the cook, see FSceneAsset::IsCooked
+		bool Load(const std::string& ScenePath);
+		// finish the reads, unload the far cells and request the near ones, before FScene::Update
+		void Update(FScene& Scene);
+		const FStreamingStats& GetStats() const { return Stats; }
+	private:
+		enum class ECellState : uint8
+		{
+			UNLOADED,
+			LOADING,
+			LOADED,
+		};
+		/* the meshes of a cell that were not resident when it was requested, filled by a job */
+		struct FCellRequest
+		{
+			uint32 Cell{ 0 };
+			std::vector<uint32> MeshIndices;
+			std::vector<std::string> MeshPaths;
+			std::vector<FMeshData> MeshDatas;
+			std::vector<uint64> SourceHashes;
+			std::vector<uint8> Succeeded;
+			std::atomic<bool> bRead{ false };
+			// meshes whose render data is created, the rest wait for the next frame's budget
+			uint32 NumCreated{ 0 };
+		};
+		struct FCell
+		{
+			ECellState State{ ECellState::UNLOADED };
+			// distinct meshes of the instances
+			std::vector<uint32> MeshIndices;
+			std::shared_ptr<FCellRequest> Request;
+		};
+		struct FMesh
+		{
+			std::shared_ptr<FStaticMeshAsset> Asset;
+			// loading and loaded cells that use the mesh
+			uint32 NumRefs{ 0 };
+			// being read by a request
+			bool bPending{ false };
+		};
+		// distance on the xz plane from the position to the cell box
+		float GetCellDistance(uint32 Cell, const glm::vec3& Position) const;
+		void RequestCell(uint32 Cell);
+		// create the read meshes and add the components, false if the budget ran out first
+		bool FinishCell(FScene& Scene, FCellRequest& Request, std::chrono::steady_clock::time_point Deadline);
+		// remove the components and release the meshes no other cell uses
+		void UnloadCell(FScene& Scene, uint32 Cell, std::vector<uint32>& OutReleasedMeshes);
+		void ReleaseMeshes(const std::vector<uint32>& MeshIndices);
+
+		FJobSystem* JobSystem{ nullptr };
+		FStreamingSettings Settings;
+		FWorldPartitionData PartitionData;
+		std::vector<FCell> Cells;
+		std::vector<FMesh> Meshes;
+		// requests in the order they were issued, finished in that order
+		std::deque<std::shared_ptr<FCellRequest>> Requests;
+		// scratch, cells by distance
+		std::vector<std::pair<float, uint32>> SortedCells;
+		FStreamingStats Stats;
+	};
+}
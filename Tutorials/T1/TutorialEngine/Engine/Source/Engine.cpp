@@ -1,10 +1,12 @@
 /**/
 #include "engine_pch.h"
 #include "Engine.h"
+#include "Core/JobSystem.h"
 #include "RHI/RHI.h"
 #include "Core/Asset/Assets.h"
 #include "Core/Asset/AssetManager.h"
 #include "Core/Scene.h"
+#include "Core/WorldPartition.h"
 #include "Render/Render.h"
 
 namespace ks
@@ -79,13 +81,24 @@ namespace ks
 		GRHIConfig.ViewPort.Height = WindowSizeY;
 		GRHIConfig.BackBufferFormat = EELEM_FORMAT::R8G8B8A8_UNORM;
 		GRHIConfig.DepthBufferFormat = EELEM_FORMAT::D24_UNORM_S8_UINT;
-		GRHIConfig.ShadowMapSize = 2048;
+		// the cascades side by side must fit the widest texture
+		GRHIConfig.NumShadowCascades = std::min(GApp->NumShadowCascades, MaxShadowCascades);
+		GRHIConfig.ShadowMapSize = std::min(GApp->ShadowMapSize, 16384u / GRHIConfig.NumShadowCascades);
+		GRHIConfig.bNullRHI = GApp->bNullRHI;
+		GRHIConfig.StatsInterval = GApp->StatsInterval;
+
+		JobSystem.reset(FJobSystem::Create());
+		JobSystem->Init();
 
 		RHI.reset(IRHI::Create());
 		RHI->Init(GRHIConfig);
 
 		AssetManager.reset(FAssetManager::Create());
 		AssetManager->Init();
+		if (GApp->bHotReload)
+		{
+			AssetManager->EnableHotReload();
+		}
 
 		Renderer.reset(FRenderer::Create());
 
@@ -94,10 +107,16 @@ namespace ks
 
 		// rendering, set render scene to renderer
 		Renderer->SetScene(Scene->GetRenderScene());
+		SetupViews();
 	}
 
 	void FEngine::Tick()
 	{
+		HotReload();
+		if (WorldPartition)
+		{
+			WorldPartition->Update(*Scene);
+		}
 		Scene->Update();
 		Renderer->Render();
 	}
@@ -107,9 +126,11 @@ namespace ks
 		KS_INFO(TEXT("FEngine::Shutdown\n["));
 		Renderer->Shutdown();
 		KS_INFO(TEXT("\tRelease Scene"));
+		WorldPartition.reset();
 		Scene.reset();
 		AssetManager->Shutdown();
 		RHI->Shutdown();
+		JobSystem->Shutdown();
 		KS_INFO(TEXT("]//!FEngine::Shutdown"));
 	}
 
@@ -117,14 +138,84 @@ namespace ks
 	{
 		std::wstring StartMap{ FString::S2WS(GApp->StartMap) };
 		KS_INFO((TEXT("Loading : ") + StartMap).c_str());
+		const auto StartTime{ std::chrono::steady_clock::now() };
+		// a partitioned world only loads the nodes up front, the meshes stream in around the camera
+		if (GApp->bWorldPartition && !GApp->StartMap.empty())
+		{
+			WorldPartition = std::make_unique<FWorldPartition>(JobSystem.get());
+			if (!WorldPartition->Load(GApp->StartMap))
+			{
+				KS_INFO(TEXT("World partition : map is not cooked, loading it whole"));
+				WorldPartition.reset();
+			}
+		}
 		// create scene asset from gltf file
-		auto SceneAsset = AssetManager->CreateSceneAsset(GApp->StartMap);
+		auto SceneAsset = AssetManager->CreateSceneAsset(GApp->StartMap, !WorldPartition);
+		if (WorldPartition && SceneAsset && !SceneAsset->IsCooked())
+		{
+			// the gltf changed since the cook, the cells would stream the old meshes
+			KS_INFO(TEXT("World partition : map cook is out of date, loading it whole"));
+			WorldPartition.reset();
+			SceneAsset->LoadMeshes();
+		}
 		// create scene from scene asset
 		Scene = std::make_unique<FScene>();
 		if (SceneAsset)
 		{
 			Scene = std::make_unique<FScene>(SceneAsset);
 		}
+		KS_INFOA(std::format("Loaded : {} nodes in {:.2f} ms", Scene->GetSceneGraph().GetNumNodes(),
+			std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - StartTime).count()).c_str());
+	}
+
+	void FEngine::SetupViews()
+	{
+		FRenderScene* RenderScene{ Scene->GetRenderScene() };
+		const uint32 NumViews{ GApp->NumViews };
+		if (!RenderScene || RenderScene->GetNumViews() == 0 || NumViews <= 1)
+		{
+			return;
+		}
+		// a grid as square as the count allows, view 0 keeps the main camera
+		const uint32 NumColumns{ static_cast<uint32>(std::ceil(std::sqrt(static_cast<float>(NumViews)))) };
+		const uint32 NumRows{ (NumViews + NumColumns - 1) / NumColumns };
+		const glm::vec2 Size{ 1.f / NumColumns, 1.f / NumRows };
+		for (uint32 i = 0; i < NumViews; ++i)
+		{
+			FSceneViewDesc Desc{ RenderScene->GetView(0).Desc };
+			Desc.Rect = glm::vec4(glm::vec2(i % NumColumns, i / NumColumns) * Size, Size);
+			if (i == 0)
+			{
+				RenderScene->SetViewDesc(0, Desc);
+				continue;
+			}
+			Desc.Camera = Scene->GetCamera(i % Scene->GetNumCameras());
+			RenderScene->AddView(Desc);
+		}
+		KS_INFOA(std::format("Views : {} in {}x{}", NumViews, NumColumns, NumRows).c_str());
+	}
+
+	void FEngine::HotReload()
+	{
+		if (!AssetManager->IsHotReloadEnabled())
+		{
+			return;
+		}
+		// the asset manager flushes the frames in flight before it swaps render data
+		const auto StartTime{ std::chrono::steady_clock::now() };
+		std::vector<std::shared_ptr<FStaticMeshAsset>> ReimportedMeshes;
+		std::filesystem::file_time_type FirstWriteTime;
+		AssetManager->ReimportChangedAssets(ReimportedMeshes, FirstWriteTime);
+		if (ReimportedMeshes.empty())
+		{
+			return;
+		}
+		Scene->OnMeshAssetsReimported(ReimportedMeshes);
+		using FMilliseconds = std::chrono::duration<float, std::milli>;
+		const float ReimportTime{ FMilliseconds(std::chrono::steady_clock::now() - StartTime).count() };
+		const float SwapLatency{ FMilliseconds(std::filesystem::file_time_type::clock::now() - FirstWriteTime).count() };
+		KS_INFOA(std::format("HotReload: {} meshes, reimport {:.2f} ms, edit to swap {:.2f} ms",
+			ReimportedMeshes.size(), ReimportTime, SwapLatency).c_str());
 	}
 
 namespace util
@@ -173,14 +264,36 @@ namespace util
 		static const std::unordered_map<EELEM_FORMAT, uint32_t> FormatSizeMap = {
 			{EELEM_FORMAT::R16_INT,		2},
 			{EELEM_FORMAT::R16_UINT,	2},
+			{EELEM_FORMAT::R32_UINT,	4},
 			{EELEM_FORMAT::R8_INT,		1},
 			{EELEM_FORMAT::R8_UINT,		1},
 			{EELEM_FORMAT::R32G32B32_FLOAT,		12},
 			{EELEM_FORMAT::R32G32B32A32_FLOAT,	16},
+			{EELEM_FORMAT::R8G8B8A8_UNORM,		4},
+			{EELEM_FORMAT::R8G8B8A8_UNORM_SRGB,	4},
 		};
 		return FormatSizeMap.at(ElemFormat);
 	}
 
+	uint32_t GetBlockFormatSize(EELEM_FORMAT ElemFormat)
+	{
+		switch (ElemFormat)
+		{
+		case EELEM_FORMAT::BC1_UNORM:
+		case EELEM_FORMAT::BC1_UNORM_SRGB:
+			return 8;
+		case EELEM_FORMAT::BC3_UNORM:
+		case EELEM_FORMAT::BC3_UNORM_SRGB:
+		case EELEM_FORMAT::BC5_UNORM:
+		case EELEM_FORMAT::BC7_UNORM:
+		case EELEM_FORMAT::BC7_UNORM_SRGB:
+			return 16;
+		default:
+			break;
+		}
+		return 0;
+	}
+
 	size_t GetDataTypeSize(EDATA_TYPE DataType)
 	{
 		switch (DataType)
@@ -236,6 +349,23 @@ namespace util
 	{
 		return "./Shaders/" + Path;
 	}
+
+	std::string GetCookedPath(const std::string& Path)
+	{
+		return "./Cooked" + Path;
+	}
+
+	uint64 HashBytes(const void* Data, size_t Size, uint64 Seed)
+	{
+		const uint8* Bytes{ static_cast<const uint8*>(Data) };
+		uint64 Hash{ Seed };
+		for (size_t i{ 0 }; i < Size; ++i)
+		{
+			Hash ^= Bytes[i];
+			Hash *= 1099511628211ull;
+		}
+		return Hash;
+	}
 }
 }
 
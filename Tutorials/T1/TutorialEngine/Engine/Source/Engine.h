@@ -4,9 +4,11 @@ namespace ks
 {
 	//class FEngine;
 	class IRHI;
+	class FJobSystem;
 	class FAssetManager;
 	class FScene;
 	class FRenderer;
+	class FWorldPartition;
 
 	extern FEngine* GEngine;
 	extern std::wstring GCmdLineArgs;
@@ -28,10 +30,16 @@ namespace ks
 
 	protected:
 		void LoadScene();
+		void HotReload();
+		// split the window between the views asked on the command line
+		void SetupViews();
 
+		std::unique_ptr<FJobSystem> JobSystem;
 		std::unique_ptr<IRHI> RHI;
 		std::unique_ptr<FAssetManager> AssetManager;
 		std::unique_ptr<FScene> Scene;
+		// streams the scene meshes, null when the map is loaded whole
+		std::unique_ptr<FWorldPartition> WorldPartition;
 		std::unique_ptr<FRenderer> Renderer;
 	};
 }
\ No newline at end of file
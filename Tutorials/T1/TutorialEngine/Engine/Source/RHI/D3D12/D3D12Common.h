@@ -29,6 +29,9 @@ namespace ks::d3d12
 	extern ID3D12Device* GD3D12Device;
 	extern ID3D12GraphicsCommandList* GGfxCmdlist;
 
+	// frames the cpu records ahead of the gpu, per frame resources are buffered this many times
+	constexpr uint32 NumFramesInFlight{ 2 };
+
 	class FDescriptorHandle
 	{
 	public:
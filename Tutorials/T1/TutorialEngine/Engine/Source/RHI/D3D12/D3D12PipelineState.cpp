@@ -58,8 +58,9 @@ namespace
 			InputLayout[i].Format = GetDXGIFormat(InputElemDesc[i].ElemFormat);
 			InputLayout[i].InputSlot = InputElemDesc[i].InputSlot;
 			InputLayout[i].AlignedByteOffset = InputElemDesc[i].Stride;
-			InputLayout[i].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
-			InputLayout[i].InstanceDataStepRate = 0;
+			InputLayout[i].InputSlotClass = InputElemDesc[i].InstanceStepRate > 0 ?
+				D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA : D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
+			InputLayout[i].InstanceDataStepRate = InputElemDesc[i].InstanceStepRate;
 		}
 
 		D3D12_GRAPHICS_PIPELINE_STATE_DESC D3D12Desc;
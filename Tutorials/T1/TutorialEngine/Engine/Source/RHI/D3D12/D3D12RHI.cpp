@@ -13,7 +13,8 @@
 
 namespace ks::d3d12
 {
-	const uint32_t MAX_CBV_NUM = 128;
+	// constant buffer, texture and structured buffer views, an array of constants takes one whatever its count
+	const uint32_t MAX_CBV_NUM = 16384;
 	const uint32_t MAX_RTV_NUM = 8;
 	const uint32_t MAX_DSV_NUM = 8;
 
@@ -28,10 +29,19 @@ namespace ks::d3d12
 			{EELEM_FORMAT::R8_INT,				DXGI_FORMAT::DXGI_FORMAT_R8_SINT},
 			{EELEM_FORMAT::R16_INT,				DXGI_FORMAT::DXGI_FORMAT_R16_SINT},
 			{EELEM_FORMAT::R16_UINT,			DXGI_FORMAT::DXGI_FORMAT_R16_UINT},
+			{EELEM_FORMAT::R32_UINT,			DXGI_FORMAT::DXGI_FORMAT_R32_UINT},
 			{EELEM_FORMAT::D24_UNORM_S8_UINT,	DXGI_FORMAT::DXGI_FORMAT_D24_UNORM_S8_UINT},
 			{EELEM_FORMAT::R8G8B8A8_UNORM,		DXGI_FORMAT::DXGI_FORMAT_R8G8B8A8_UNORM},
 			{EELEM_FORMAT::R32G32B32_FLOAT,		DXGI_FORMAT::DXGI_FORMAT_R32G32B32_FLOAT},
 			{EELEM_FORMAT::R16G16B16A16_FLOAT,	DXGI_FORMAT::DXGI_FORMAT_R16G16B16A16_FLOAT },
+			{EELEM_FORMAT::R8G8B8A8_UNORM_SRGB,	DXGI_FORMAT::DXGI_FORMAT_R8G8B8A8_UNORM_SRGB},
+			{EELEM_FORMAT::BC1_UNORM,			DXGI_FORMAT::DXGI_FORMAT_BC1_UNORM},
+			{EELEM_FORMAT::BC1_UNORM_SRGB,		DXGI_FORMAT::DXGI_FORMAT_BC1_UNORM_SRGB},
+			{EELEM_FORMAT::BC3_UNORM,			DXGI_FORMAT::DXGI_FORMAT_BC3_UNORM},
+			{EELEM_FORMAT::BC3_UNORM_SRGB,		DXGI_FORMAT::DXGI_FORMAT_BC3_UNORM_SRGB},
+			{EELEM_FORMAT::BC5_UNORM,			DXGI_FORMAT::DXGI_FORMAT_BC5_UNORM},
+			{EELEM_FORMAT::BC7_UNORM,			DXGI_FORMAT::DXGI_FORMAT_BC7_UNORM},
+			{EELEM_FORMAT::BC7_UNORM_SRGB,		DXGI_FORMAT::DXGI_FORMAT_BC7_UNORM_SRGB},
 		};
 		return FormatTable.at(ElemFormat);
 	}
@@ -90,6 +100,13 @@ namespace ks::d3d12
 		return Handle;
 	}
 
+	void FDescriptorHeap::Free(const FDescriptorHandle& Handle)
+	{
+		assert(CurrFreeHanle > 0);
+		const uint32 Index{ static_cast<uint32>((Handle.CpuHandle.ptr - CpuStart.ptr) / DescriptorSize) };
+		FreeHandles.at(--CurrFreeHanle) = Index;
+	}
+
 	class FScopedCommandRecorder
 	{
 	public:
@@ -144,7 +161,7 @@ namespace
 	* "CBV(b1)),"
 	*/
 	void CreateGlobalRootSignature(ComPtr<ID3D12RootSignature>& RootSignature) {
-		constexpr int32_t NumRootParameters = 4;
+		constexpr int32_t NumRootParameters = 8;
 		// primitive const buffer parameter
 		CD3DX12_DESCRIPTOR_RANGE cbvTable0;
 		/* table_type table_number register_start_index */
@@ -162,11 +179,20 @@ namespace
 		CD3DX12_DESCRIPTOR_RANGE SceneColorMapSRVTable;
 		SceneColorMapSRVTable.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 1);
 
+		// primitive constants as a structured buffer, indexed per instance
+		CD3DX12_DESCRIPTOR_RANGE PrimitiveSRVTable;
+		PrimitiveSRVTable.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 2);
+
 		CD3DX12_ROOT_PARAMETER slotRootParameter[NumRootParameters];
 		slotRootParameter[0].InitAsDescriptorTable(1, &cbvTable0);
 		slotRootParameter[1].InitAsDescriptorTable(1, &cbvTable1);
 		slotRootParameter[2].InitAsDescriptorTable(1, &ShadowMapSRVTable, D3D12_SHADER_VISIBILITY_PIXEL);
 		slotRootParameter[3].InitAsDescriptorTable(1, &SceneColorMapSRVTable, D3D12_SHADER_VISIBILITY_PIXEL);
+		slotRootParameter[4].InitAsDescriptorTable(1, &PrimitiveSRVTable, D3D12_SHADER_VISIBILITY_VERTEX);
+		// clustered lights, per frame structured buffers bound by address: the lights, the cluster ranges and the light indices
+		slotRootParameter[5].InitAsShaderResourceView(3, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+		slotRootParameter[6].InitAsShaderResourceView(4, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+		slotRootParameter[7].InitAsShaderResourceView(5, 0, D3D12_SHADER_VISIBILITY_PIXEL);
 
 		// static samplers
 		const CD3DX12_STATIC_SAMPLER_DESC SamplerShadow(
@@ -223,6 +249,10 @@ namespace ks::d3d12
 	{
 		FD3D12RenderTarget* CurrentRenderTarget{ nullptr };
 		FD3D12DepthStencilBuffer1* CurrentDepthStencilBuffer{ nullptr };
+		// vertex input bound to the frame command list, consecutive draws of a mesh bind it once
+		// the other vertex and index buffer binds clear them
+		const FD3D12IndexBuffer1* BoundIndexBuffer{ nullptr };
+		const FD3D12DrawCommand* BoundDrawCommand{ nullptr };
 		std::vector<std::unique_ptr<FD3D12RenderTarget>> DefaultRenderTargets;
 		std::unique_ptr<FD3D12DepthStencilBuffer1> DefaultDepthStencilBuffer;
 		ComPtr<ID3D12Resource> D3D12SwapChainBuffers[FD3D12RHI::SwapChainBufferCount];
@@ -233,13 +263,103 @@ namespace ks::d3d12
 		ComPtr<ID3D12RootSignature> GlobalRootSignature{ nullptr };
 		ComPtr<ID3D12Fence> D3D12Fence;
 		ComPtr<ID3D12CommandQueue> D3D12CommandQueue;
+		// one-off uploads and resizes, flushed right away
 		ComPtr<ID3D12CommandAllocator> D3D12CommandAllocator;
+		// frame commands, an allocator is reset once its frame has retired on the gpu
+		ComPtr<ID3D12CommandAllocator> FrameCommandAllocators[NumFramesInFlight];
+		// upload ring of each frame slot, rewound when the slot is reused
+		struct FFrameUpload
+		{
+			ComPtr<ID3D12Resource> Buffer;
+			uint8* MapData{ nullptr };
+			uint64 Size{ 0 };
+			uint64 Offset{ 0 };
+			// outgrown buffers still read by the copies of the frame
+			std::vector<ComPtr<ID3D12Resource>> RetiredBuffers;
+		};
+		FFrameUpload FrameUploads[NumFramesInFlight];
+		// the command lists of the passes allocate from the ring on their threads
+		std::mutex FrameUploadMutex;
 		ComPtr<ID3D12GraphicsCommandList> D3D12GfxCommandList;
 		ComPtr<ID3D12DescriptorHeap> D3D12RTVHeap;
 		ComPtr<ID3D12DescriptorHeap> D3D12DSVHeap;
 		ComPtr<IDXGISwapChain> DXGISwapChain;
 	};
 
+	namespace
+	{
+		void SetD3D12PipelineState(ID3D12GraphicsCommandList* CommandList, IRHIPipelineState* PipelineState)
+		{
+			d3d12::FD3D12PipelineState* D3D12PipelineState = dynamic_cast<d3d12::FD3D12PipelineState*>(PipelineState);
+			assert(D3D12PipelineState);
+			CommandList->SetPipelineState(D3D12PipelineState->PipelineState.Get());
+			CommandList->IASetPrimitiveTopology(D3D12PipelineState->PrimitiveType);
+		}
+
+		void SetD3D12Viewports(ID3D12GraphicsCommandList* CommandList, uint32 Num, const FViewPort* Viewports)
+		{
+			constexpr uint32 NumMaxView{ 4 };
+			assert(Num <= NumMaxView);
+			Num = std::min(Num, NumMaxView);
+			D3D12_VIEWPORT D3D12Viewports[NumMaxView];
+			D3D12_RECT D3D12ScissorRects[NumMaxView];
+			for (uint32 i{ 0 }; i < Num; ++i)
+			{
+				D3D12Viewports[i] = {
+					static_cast<float>(Viewports[i].TopLeftX),
+					static_cast<float>(Viewports[i].TopLeftY),
+					static_cast<float>(Viewports[i].Width),
+					static_cast<float>(Viewports[i].Height),
+					0.f, 1.f };
+				// the scissor rect is left, top, right, bottom
+				D3D12ScissorRects[i] = {
+					static_cast<LONG>(Viewports[i].TopLeftX),
+					static_cast<LONG>(Viewports[i].TopLeftY),
+					static_cast<LONG>(Viewports[i].TopLeftX + Viewports[i].Width),
+					static_cast<LONG>(Viewports[i].TopLeftY + Viewports[i].Height) };
+			}
+			CommandList->RSSetViewports(Num, D3D12Viewports);
+			CommandList->RSSetScissorRects(Num, D3D12ScissorRects);
+		}
+
+		void SetD3D12RenderTargets(ID3D12GraphicsCommandList* CommandList, FD3D12RenderTarget* RenderTarget, FD3D12DepthStencilBuffer1* DepthStencilBuffer)
+		{
+			const D3D12_CPU_DESCRIPTOR_HANDLE* pRTV{ RenderTarget ? &RenderTarget->GetRenderTargetView().CpuHandle : nullptr };
+			const D3D12_CPU_DESCRIPTOR_HANDLE* pDSV{ DepthStencilBuffer ? &DepthStencilBuffer->GetDepthStencilView().CpuHandle : nullptr };
+			CommandList->OMSetRenderTargets(RenderTarget ? 1 : 0, pRTV, RenderTarget != nullptr, pDSV);
+		}
+
+		void SetD3D12StructuredBuffer(ID3D12GraphicsCommandList* CommandList, IRHIConstBufferArray* ConstBufferArray)
+		{
+			FD3D12ConstBufferArray* D3D12ConstBufferArray = dynamic_cast<FD3D12ConstBufferArray*>(ConstBufferArray);
+			assert(D3D12ConstBufferArray);
+			CommandList->SetGraphicsRootDescriptorTable(static_cast<UINT>(ConstBufferArray->GetShaderResourceLocationIndex()),
+				D3D12ConstBufferArray->GetShaderResourceViewHandle().GpuHandle);
+		}
+
+		void SetD3D12Texture2D(ID3D12GraphicsCommandList* CommandList, IRHITexture2D* Texture2D)
+		{
+			FD3D12Texture2D1* D3D12Texture2D = dynamic_cast<FD3D12Texture2D1*>(Texture2D);
+			const FDescriptorHandle& SRV{ D3D12Texture2D->GetViewHandle() };
+			CommandList->SetGraphicsRootDescriptorTable(static_cast<UINT>(Texture2D->GetLocationIndex()), SRV.GpuHandle);
+		}
+
+		// BoundDrawCommand is the command the list drew last, its buffers are still bound
+		void DrawD3D12CommandInstanced(ID3D12GraphicsCommandList* CommandList, const FD3D12DrawCommand*& BoundDrawCommand,
+			const IRHIDrawCommand* _DrawCommand, uint32 NumInstances, uint32 FirstInstance)
+		{
+			// only this rhi creates the commands, no cast check on the draw path
+			const FD3D12DrawCommand* DrawCommand{ static_cast<const FD3D12DrawCommand*>(_DrawCommand) };
+			if (DrawCommand != BoundDrawCommand)
+			{
+				CommandList->IASetVertexBuffers(0, DrawCommand->NumVertexBuffers, DrawCommand->VertexBufferViews);
+				CommandList->IASetIndexBuffer(&DrawCommand->IndexBufferView);
+				BoundDrawCommand = DrawCommand;
+			}
+			CommandList->DrawIndexedInstanced(DrawCommand->IndexCount, NumInstances, 0, 0, FirstInstance);
+		}
+	}
+
 	FD3D12RHI::~FD3D12RHI()
 	{
 		KS_INFO(TEXT("~FD3D12RHI"));
@@ -307,6 +427,12 @@ namespace ks::d3d12
 			KS_D3D12_CALL(D3D12Device->CreateCommandAllocator(
 				D3D12_COMMAND_LIST_TYPE_DIRECT,
 				IID_PPV_ARGS(Context->D3D12CommandAllocator.GetAddressOf())));
+			for (auto& FrameCommandAllocator : Context->FrameCommandAllocators)
+			{
+				KS_D3D12_CALL(D3D12Device->CreateCommandAllocator(
+					D3D12_COMMAND_LIST_TYPE_DIRECT,
+					IID_PPV_ARGS(FrameCommandAllocator.GetAddressOf())));
+			}
 
 			KS_D3D12_CALL(D3D12Device->CreateCommandList(
 				0,
@@ -389,6 +515,8 @@ namespace ks::d3d12
 		KS_INFO(TEXT("\tFD3D12RHI::Shutdown"));
 
 		assert(Context);
+		// the frames in flight still reference the resources
+		FlushRenderingCommands();
 		delete Context;
 		Context = nullptr;
 		
@@ -565,12 +693,18 @@ namespace ks::d3d12
 		KS_D3D12_CALL(Context->D3D12CommandQueue->Signal(D3D12Fence, CurrentFence));
 
 		// Wait until the GPU has completed commands up to this fence point.
-		if (D3D12Fence->GetCompletedValue() < CurrentFence)
+		WaitForFence(CurrentFence);
+	}
+
+	void FD3D12RHI::WaitForFence(UINT64 FenceValue)
+	{
+		auto D3D12Fence{ Context->D3D12Fence.Get() };
+		if (D3D12Fence->GetCompletedValue() < FenceValue)
 		{
 			HANDLE eventHandle = CreateEventEx(nullptr, nullptr, false, EVENT_ALL_ACCESS);
 
-			// Fire event when GPU hits current fence.  
-			KS_D3D12_CALL(D3D12Fence->SetEventOnCompletion(CurrentFence, eventHandle));
+			// Fire event when GPU hits the fence.
+			KS_D3D12_CALL(D3D12Fence->SetEventOnCompletion(FenceValue, eventHandle));
 
 			// Wait until the GPU hits current fence event is fired.
 			WaitForSingleObject(eventHandle, INFINITE);
@@ -580,20 +714,25 @@ namespace ks::d3d12
 
 	void FD3D12RHI::BeginFrame()
 	{
-		auto& D3D12CommandAllocator{ Context->D3D12CommandAllocator };
+		auto& D3D12CommandAllocator{ Context->FrameCommandAllocators[FrameIndex] };
 		auto& D3D12GfxCommandList{ Context->D3D12GfxCommandList };
 		// Reuse the memory associated with command recording.
-		// We can only reset when the associated command lists have finished execution on the GPU.
+		// We can only reset when the associated command lists have finished execution on the GPU,
+		// EndFrame of the previous frame waited for the last submission of this slot.
 		KS_D3D12_CALL(D3D12CommandAllocator->Reset());
+		// the copies out of the upload ring of this slot are done as well
+		auto& FrameUpload{ Context->FrameUploads[FrameIndex] };
+		FrameUpload.Offset = 0;
+		FrameUpload.RetiredBuffers.clear();
+		// the copies of this slot are free too, the lists of the passes then only read the const buffers
+		std::erase_if(StaleConstBuffers, [this](FD3D12ConstBuffer1* ConstBuffer) { return ConstBuffer->RefreshFrame(FrameIndex); });
 
 		// A command list can be reset after it has been added to the command queue via ExecuteCommandList.
 		// Reusing the command list reuses memory.
 		KS_D3D12_CALL(D3D12GfxCommandList->Reset(D3D12CommandAllocator.Get(), nullptr));
-
-		ID3D12DescriptorHeap* Heaps[] = {Context->CBVHeap.GetHeap()};
-		D3D12GfxCommandList->SetDescriptorHeaps(_countof(Heaps), Heaps);
-
-		D3D12GfxCommandList->SetGraphicsRootSignature(Context->GlobalRootSignature.Get());
+		SetCommandListState(D3D12GfxCommandList.Get());
+		Context->BoundIndexBuffer = nullptr;
+		Context->BoundDrawCommand = nullptr;
 
 		// transition back buffers
 		{
@@ -625,10 +764,14 @@ namespace ks::d3d12
 		KS_D3D12_CALL(Context->DXGISwapChain->Present(1, 0));
 
 		CurrentBackBuffer = (CurrentBackBuffer + 1) % SwapChainBufferCount;
-		// Wait until frame commands are complete.  This waiting is inefficient and is
-		// done for simplicity.  Later we will show how to organize our rendering code
-		// so we do not have to wait per frame.
-		FlushRenderingCommands();
+
+		// mark the frame and move on to the next slot without waiting for this one,
+		// only the frame submitted NumFramesInFlight ago has to be done before its allocator and buffers are reused
+		KS_D3D12_CALL(Context->D3D12CommandQueue->Signal(Context->D3D12Fence.Get(), ++CurrentFence));
+		FrameFenceValues[FrameIndex] = CurrentFence;
+		FrameIndex = (FrameIndex + 1) % NumFramesInFlight;
+		++FrameNumber;
+		WaitForFence(FrameFenceValues[FrameIndex]);
 	}
 
 	d3d12::FD3D12Resource* FD3D12RHI::CreateConstBufferResource(size_t Size)
@@ -717,11 +860,7 @@ namespace ks::d3d12
 
 	void FD3D12RHI::SetPipelineState(IRHIPipelineState* PipelineState)
 	{
-		d3d12::FD3D12PipelineState* D3D12PipelineState = dynamic_cast<d3d12::FD3D12PipelineState*>(PipelineState);
-		assert(D3D12PipelineState);
-		ID3D12PipelineState* pPipelineState{D3D12PipelineState->PipelineState.Get()};
-		GGfxCmdlist->SetPipelineState(pPipelineState);
-		GGfxCmdlist->IASetPrimitiveTopology(D3D12PipelineState->PrimitiveType);
+		SetD3D12PipelineState(GGfxCmdlist, PipelineState);
 	}
 
 	IRHIPipelineState* FD3D12RHI::CreatePipelineState(const FRHIPipelineStateDesc& Desc)
@@ -764,6 +903,7 @@ namespace ks::d3d12
 		auto& D3D12GfxCommandList{ Context->D3D12GfxCommandList };
 		const FD3D12VertexBuffer* VertexBuffer{dynamic_cast<const FD3D12VertexBuffer*>(InVertexBuffer)};
 		D3D12GfxCommandList->IASetVertexBuffers(0, 1, &VertexBuffer->GetVertexBufferView());
+		Context->BoundDrawCommand = nullptr;
 	}
 
 	void FD3D12RHI::SetVertexBuffers(const IRHIVertexBuffer** VertexBuffers, int32 Num)
@@ -778,6 +918,7 @@ namespace ks::d3d12
 			const FD3D12VertexBuffer* VertexBuffer{ dynamic_cast<const FD3D12VertexBuffer*>(VertexBuffers[i]) };
 			D3D12GfxCommandList->IASetVertexBuffers(i, 1, &VertexBuffer->GetVertexBufferView());
 		}
+		Context->BoundDrawCommand = nullptr;
 	}
 
 	ks::IRHIVertexBuffer* FD3D12RHI::CreateVertexBuffer(uint32 Stride, uint32 Size, const void* Data)
@@ -809,6 +950,8 @@ namespace ks::d3d12
 		const FD3D12IndexBuffer* IndexBuffer{dynamic_cast<const FD3D12IndexBuffer*>(InIndexBuffer)};
 		const D3D12_INDEX_BUFFER_VIEW IndexBufferView{IndexBuffer->GetIndexBufferView()};
 		D3D12GfxCommandList->IASetIndexBuffer(&IndexBufferView);
+		Context->BoundIndexBuffer = nullptr;
+		Context->BoundDrawCommand = nullptr;
 
 		const UINT IndexCount{IndexBuffer->GetIndexCount()};
 		D3D12GfxCommandList->DrawIndexedInstanced(IndexCount, 1, 0, 0, 0);
@@ -818,14 +961,20 @@ namespace ks::d3d12
 	{
 		uint32_t AllocSize = CalcConstantBufferByteSize(Size);
 		FD3D12ConstBuffer1* ConstBuffer = new FD3D12ConstBuffer1(AllocSize);
-		CreateBuffer1(AllocSize, D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ, ConstBuffer->D3D12Resource);
-		ConstBuffer->D3D12Resource->Map(0, nullptr, &ConstBuffer->MapData);
+		// a copy per frame in flight, each with its own view
+		CreateBuffer1(AllocSize * NumFramesInFlight, D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ, ConstBuffer->D3D12Resource);
+		void* MapData{ nullptr };
+		ConstBuffer->D3D12Resource->Map(0, nullptr, &MapData);
+		ConstBuffer->MapData = static_cast<uint8*>(MapData);
+		for (uint32 i = 0; i < NumFramesInFlight; ++i)
+		{
+			ConstBuffer->ViewHandles[i] = Context->CBVHeap.Allocate();
+			D3D12_CONSTANT_BUFFER_VIEW_DESC desc{};
+			desc.BufferLocation = ConstBuffer->D3D12Resource->GetGPUVirtualAddress() + i * AllocSize;
+			desc.SizeInBytes = AllocSize;
+			GD3D12Device->CreateConstantBufferView(&desc, ConstBuffer->ViewHandles[i].CpuHandle);
+		}
 		ConstBuffer->SetData(Data, Size);
-		ConstBuffer->ViewHandle = Context->CBVHeap.Allocate();
-		D3D12_CONSTANT_BUFFER_VIEW_DESC desc{};
-		desc.BufferLocation = ConstBuffer->D3D12Resource->GetGPUVirtualAddress();
-		desc.SizeInBytes = AllocSize;
-		GD3D12Device->CreateConstantBufferView(&desc, ConstBuffer->ViewHandle.CpuHandle);
 #ifdef KS_DEBUG_BUILD
 		KS_NAME_D3D12_OBJECT(ConstBuffer->D3D12Resource.Get(), TEXT("ConstBuffer"));
 #endif
@@ -846,14 +995,164 @@ namespace ks::d3d12
 		));
 	}
 
-	void FD3D12RHI::SetConstBuffer(IRHIConstBuffer1* ConstBuffer)
+	uint8* FD3D12RHI::AllocateFrameUpload(uint64 Size, ID3D12Resource*& OutResource, uint64& OutOffset)
 	{
+		constexpr uint64 MinUploadSize{ 64 * 1024 };
+		std::lock_guard<std::mutex> Lock(Context->FrameUploadMutex);
+		auto& FrameUpload{ Context->FrameUploads[FrameIndex] };
+		uint64 Offset{ (FrameUpload.Offset + D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1) & ~uint64(D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1) };
+		if (Offset + Size > FrameUpload.Size)
+		{
+			// grow, the copies recorded so far keep the old buffer alive until the frame retires
+			if (FrameUpload.Buffer)
+			{
+				FrameUpload.Buffer->Unmap(0, nullptr);
+				FrameUpload.RetiredBuffers.push_back(FrameUpload.Buffer);
+			}
+			FrameUpload.Size = std::max({ Size, FrameUpload.Size * 2, MinUploadSize });
+			FrameUpload.Buffer.Reset();
+			CreateBuffer1(static_cast<uint32>(FrameUpload.Size), D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ, FrameUpload.Buffer);
+			void* MapData{ nullptr };
+			FrameUpload.Buffer->Map(0, nullptr, &MapData);
+			FrameUpload.MapData = static_cast<uint8*>(MapData);
+#ifdef KS_DEBUG_BUILD
+			KS_NAME_D3D12_OBJECT(FrameUpload.Buffer.Get(), TEXT("FrameUploadBuffer"));
+#endif
+			Offset = 0;
+		}
+		FrameUpload.Offset = Offset + Size;
+		OutResource = FrameUpload.Buffer.Get();
+		OutOffset = Offset;
+		return FrameUpload.MapData + Offset;
+	}
+
+	IRHIConstBufferArray* FD3D12RHI::CreateConstBufferArray(uint32 ElemSize, uint32 Count)
+	{
+		// structured buffer stride, no per element constant buffer views so no 256 byte placement
+		const uint32 AllocElemSize{ (ElemSize + 15) & ~15u };
+		FD3D12ConstBufferArray* ConstBufferArray = new FD3D12ConstBufferArray(ElemSize, Count, AllocElemSize);
+		// default heap, written by copies from the frame upload ring
+		CreateBuffer1(AllocElemSize * Count, D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_COMMON, ConstBufferArray->D3D12Resource);
+		D3D12_SHADER_RESOURCE_VIEW_DESC SRVDesc{};
+		SRVDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+		SRVDesc.Format = DXGI_FORMAT_UNKNOWN;
+		SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+		SRVDesc.Buffer.FirstElement = 0;
+		SRVDesc.Buffer.NumElements = Count;
+		SRVDesc.Buffer.StructureByteStride = AllocElemSize;
+		ConstBufferArray->ShaderResourceViewHandle = Context->CBVHeap.Allocate();
+		GD3D12Device->CreateShaderResourceView(ConstBufferArray->D3D12Resource.Get(), &SRVDesc, ConstBufferArray->ShaderResourceViewHandle.CpuHandle);
+#ifdef KS_DEBUG_BUILD
+		KS_NAME_D3D12_OBJECT(ConstBufferArray->D3D12Resource.Get(), TEXT("ConstBufferArray"));
+#endif
+		return ConstBufferArray;
+	}
+
+	void FD3D12RHI::UpdateConstBufferArray(IRHIConstBufferArray* ConstBufferArray, uint32 NumElems, const uint32* Indices, const void* Data)
+	{
+		FD3D12ConstBufferArray* D3D12ConstBufferArray = dynamic_cast<FD3D12ConstBufferArray*>(ConstBufferArray);
+		assert(D3D12ConstBufferArray);
+		if (NumElems == 0)
+		{
+			return;
+		}
 		auto& D3D12GfxCommandList{ Context->D3D12GfxCommandList };
+		const uint32 ElemSize{ ConstBufferArray->GetElemSize() };
+		const uint32 AllocElemSize{ D3D12ConstBufferArray->GetAllocElemSize() };
+		// pack at the gpu stride, a run of consecutive indices is then one copy
+		ID3D12Resource* UploadResource{ nullptr };
+		uint64 UploadOffset{ 0 };
+		uint8* UploadData{ AllocateFrameUpload(uint64(NumElems) * AllocElemSize, UploadResource, UploadOffset) };
+		for (uint32 i = 0; i < NumElems; ++i)
+		{
+			memcpy(UploadData + uint64(i) * AllocElemSize, static_cast<const uint8*>(Data) + uint64(i) * ElemSize, ElemSize);
+		}
+
+		// buffers decay to common at the end of every submission, so one update per frame starts from common
+		ID3D12Resource* DestResource{ D3D12ConstBufferArray->GetResource() };
+		CD3DX12_RESOURCE_BARRIER ResBarrier = CD3DX12_RESOURCE_BARRIER::Transition(DestResource,
+			D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST);
+		D3D12GfxCommandList->ResourceBarrier(1, &ResBarrier);
+		for (uint32 First = 0; First < NumElems;)
+		{
+			assert(Indices[First] < ConstBufferArray->GetCount());
+			uint32 Last{ First };
+			while (Last + 1 < NumElems && Indices[Last + 1] == Indices[Last] + 1)
+			{
+				++Last;
+			}
+			D3D12GfxCommandList->CopyBufferRegion(DestResource, uint64(Indices[First]) * AllocElemSize,
+				UploadResource, UploadOffset + uint64(First) * AllocElemSize, uint64(Last - First + 1) * AllocElemSize);
+			First = Last + 1;
+		}
+		// read as the structured buffer of the vertex shaders
+		ResBarrier = CD3DX12_RESOURCE_BARRIER::Transition(DestResource,
+			D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		D3D12GfxCommandList->ResourceBarrier(1, &ResBarrier);
+	}
+
+	void FD3D12RHI::SetStructuredBuffer(IRHIConstBufferArray* ConstBufferArray)
+	{
+		SetD3D12StructuredBuffer(GGfxCmdlist, ConstBufferArray);
+	}
+
+	void FD3D12RHI::SetInstanceBuffer(uint32 Slot, uint32 Stride, uint32 NumInstances, const void* Data)
+	{
+		SetInstanceBuffer(GGfxCmdlist, Slot, Stride, NumInstances, Data);
+	}
+
+	void FD3D12RHI::SetInstanceBuffer(ID3D12GraphicsCommandList* CommandList, uint32 Slot, uint32 Stride, uint32 NumInstances, const void* Data)
+	{
+		// the upload heap is read in place, the ring keeps the data until the frame retires
+		const uint32 Size{ Stride * NumInstances };
+		ID3D12Resource* UploadResource{ nullptr };
+		uint64 UploadOffset{ 0 };
+		uint8* UploadData{ AllocateFrameUpload(Size, UploadResource, UploadOffset) };
+		memcpy(UploadData, Data, Size);
+		D3D12_VERTEX_BUFFER_VIEW BufferView;
+		BufferView.BufferLocation = UploadResource->GetGPUVirtualAddress() + UploadOffset;
+		BufferView.SizeInBytes = Size;
+		BufferView.StrideInBytes = Stride;
+		CommandList->IASetVertexBuffers(Slot, 1, &BufferView);
+	}
+
+	FRHIFrameData FD3D12RHI::UploadFrameData(uint32 Stride, uint32 NumElems, const void* Data)
+	{
+		// a root view needs a valid address, an empty buffer still takes one element
+		const uint32 Size{ Stride * NumElems };
+		ID3D12Resource* UploadResource{ nullptr };
+		uint64 UploadOffset{ 0 };
+		uint8* UploadData{ AllocateFrameUpload(std::max(Size, Stride), UploadResource, UploadOffset) };
+		if (Size > 0)
+		{
+			memcpy(UploadData, Data, Size);
+		}
+		return FRHIFrameData{ UploadResource->GetGPUVirtualAddress() + UploadOffset, NumElems };
+	}
+
+	void FD3D12RHI::SetShaderResourceData(uint32 LocationIndex, const FRHIFrameData& FrameData)
+	{
+		SetShaderResourceData(GGfxCmdlist, LocationIndex, FrameData);
+	}
+
+	void FD3D12RHI::SetShaderResourceData(ID3D12GraphicsCommandList* CommandList, uint32 LocationIndex, const FRHIFrameData& FrameData)
+	{
+		assert(FrameData.Address != 0);
+		CommandList->SetGraphicsRootShaderResourceView(LocationIndex, FrameData.Address);
+	}
+
+	void FD3D12RHI::SetConstBuffer(IRHIConstBuffer1* ConstBuffer)
+	{
+		SetConstBuffer(GGfxCmdlist, ConstBuffer);
+	}
+
+	void FD3D12RHI::SetConstBuffer(ID3D12GraphicsCommandList* CommandList, IRHIConstBuffer1* ConstBuffer)
+	{
 		assert(ConstBuffer);
 		FD3D12ConstBuffer1* D3D12ConstBuffer = dynamic_cast<FD3D12ConstBuffer1*>(ConstBuffer);
 		assert(D3D12ConstBuffer);
-		const FDescriptorHandle& ViewHandle = D3D12ConstBuffer->GetViewHandle();
-		D3D12GfxCommandList->SetGraphicsRootDescriptorTable(static_cast<UINT>(ConstBuffer->GetLocationIndex()), ViewHandle.GpuHandle);
+		const FDescriptorHandle& ViewHandle = D3D12ConstBuffer->GetViewHandle(FrameIndex);
+		CommandList->SetGraphicsRootDescriptorTable(static_cast<UINT>(ConstBuffer->GetLocationIndex()), ViewHandle.GpuHandle);
 	}
 
 	ks::IRHIVertexBuffer1* FD3D12RHI::CreateVertexBuffer1(uint32 Stride, uint32 Size, const void* Data)
@@ -912,6 +1211,7 @@ namespace ks::d3d12
 	{
 		const FD3D12VertexBuffer1* VertexBuffer{ dynamic_cast<const FD3D12VertexBuffer1*>(_VertexBuffer) };
 		GGfxCmdlist->IASetVertexBuffers(0, 1, &VertexBuffer->GetVertexBufferView());
+		Context->BoundDrawCommand = nullptr;
 	}
 
 	void FD3D12RHI::SetVertexBuffers1(const IRHIVertexBuffer1** VertexBuffers, int32 Num)
@@ -923,6 +1223,7 @@ namespace ks::d3d12
 				const FD3D12VertexBuffer1* VertexBuffer{ dynamic_cast<const FD3D12VertexBuffer1*>(VertexBuffers[i]) };
 				GGfxCmdlist->IASetVertexBuffers(i, 1, &VertexBuffer->GetVertexBufferView());
 			}
+			Context->BoundDrawCommand = nullptr;
 		}
 	}
 
@@ -949,16 +1250,100 @@ namespace ks::d3d12
 		const FD3D12IndexBuffer1* IndexBuffer{ dynamic_cast<const FD3D12IndexBuffer1*>(_IndexBuffer) };
 		const D3D12_INDEX_BUFFER_VIEW IndexBufferView{ IndexBuffer->GetIndexBufferView() };
 		GGfxCmdlist->IASetIndexBuffer(&IndexBufferView);
+		Context->BoundIndexBuffer = IndexBuffer;
+		Context->BoundDrawCommand = nullptr;
 
 		const UINT IndexCount{ IndexBuffer->GetCount() };
 		GGfxCmdlist->DrawIndexedInstanced(IndexCount, 1, 0, 0, 0);
 	}
 
-	ks::IRHITexture2D* FD3D12RHI::CreateTexture2D(const FTexture2DDesc& Desc)
+	void FD3D12RHI::DrawIndexedPrimitiveInstanced1(const IRHIIndexBuffer1* _IndexBuffer, uint32 NumInstances, uint32 FirstInstance)
+	{
+		const FD3D12IndexBuffer1* IndexBuffer{ dynamic_cast<const FD3D12IndexBuffer1*>(_IndexBuffer) };
+		if (IndexBuffer != Context->BoundIndexBuffer)
+		{
+			const D3D12_INDEX_BUFFER_VIEW IndexBufferView{ IndexBuffer->GetIndexBufferView() };
+			GGfxCmdlist->IASetIndexBuffer(&IndexBufferView);
+			Context->BoundIndexBuffer = IndexBuffer;
+			Context->BoundDrawCommand = nullptr;
+		}
+		GGfxCmdlist->DrawIndexedInstanced(IndexBuffer->GetCount(), NumInstances, 0, 0, FirstInstance);
+	}
+
+	IRHIDrawCommand* FD3D12RHI::CreateDrawCommand(const IRHIVertexBuffer1** VertexBuffers, int32 Num, const IRHIIndexBuffer1* _IndexBuffer)
+	{
+		assert(Num > 0 && Num <= FD3D12DrawCommand::MaxVertexBuffers);
+		FD3D12DrawCommand* DrawCommand = new FD3D12DrawCommand();
+		for (int32 i = 0; i < Num; ++i)
+		{
+			DrawCommand->VertexBufferViews[i] = dynamic_cast<const FD3D12VertexBuffer1*>(VertexBuffers[i])->GetVertexBufferView();
+		}
+		DrawCommand->NumVertexBuffers = Num;
+		const FD3D12IndexBuffer1* IndexBuffer{ dynamic_cast<const FD3D12IndexBuffer1*>(_IndexBuffer) };
+		DrawCommand->IndexBufferView = IndexBuffer->GetIndexBufferView();
+		DrawCommand->IndexCount = IndexBuffer->GetCount();
+		return DrawCommand;
+	}
+
+	void FD3D12RHI::DrawCommandInstanced(const IRHIDrawCommand* DrawCommand, uint32 NumInstances, uint32 FirstInstance)
 	{
-		FD3D12Texture2D* Texture = new FD3D12Texture2D(Desc);
+		if (DrawCommand != Context->BoundDrawCommand)
+		{
+			Context->BoundIndexBuffer = nullptr;
+		}
+		DrawD3D12CommandInstanced(GGfxCmdlist, Context->BoundDrawCommand, DrawCommand, NumInstances, FirstInstance);
+	}
 
+	ks::IRHITexture2D* FD3D12RHI::CreateTexture2D(const FTexture2DDesc& Desc, const FTextureMipData* MipData)
+	{
+		FD3D12Texture2D1* Texture = new FD3D12Texture2D1(Desc);
+		auto& D3D12ResComPtr{ Texture->GetComPtr() };
+		const DXGI_FORMAT Format{ GetDXGIFormat(Desc.Format) };
+		const UINT NumMips{ Desc.NumMips };
 
+		CD3DX12_RESOURCE_DESC ResDesc = CD3DX12_RESOURCE_DESC::Tex2D(Format, Desc.Width, Desc.Height, 1, static_cast<UINT16>(NumMips));
+		CD3DX12_HEAP_PROPERTIES HeapProp(D3D12_HEAP_TYPE_DEFAULT);
+		KS_D3D12_CALL(D3D12Device->CreateCommittedResource(
+			&HeapProp,
+			D3D12_HEAP_FLAG_NONE,
+			&ResDesc,
+			MipData ? D3D12_RESOURCE_STATE_COPY_DEST : D3D12_RESOURCE_STATE_GENERIC_READ,
+			nullptr,
+			IID_PPV_ARGS(&D3D12ResComPtr)
+		));
+
+		if (MipData)
+		{
+			std::vector<D3D12_SUBRESOURCE_DATA> SubresourceData(NumMips);
+			for (UINT i{ 0 }; i < NumMips; ++i)
+			{
+				SubresourceData.at(i) = { MipData[i].Data, MipData[i].RowPitch, MipData[i].SlicePitch };
+			}
+			// one upload buffer for the whole mip chain, laid out with the copyable footprints of the texture
+			ComPtr<ID3D12Resource> UploadBuffer;
+			const UINT64 UploadSize{ GetRequiredIntermediateSize(Texture->GetResource(), 0, NumMips) };
+			CreateBuffer1(static_cast<uint32_t>(UploadSize), D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ, UploadBuffer);
+			{
+				FScopedCommandRecorder ScopedCmdRecorder(
+					GGfxCmdlist, Context->D3D12CommandAllocator.Get(), Context->D3D12CommandQueue.Get());
+				UpdateSubresources(GGfxCmdlist, Texture->GetResource(), UploadBuffer.Get(), 0, 0, NumMips, SubresourceData.data());
+				CD3DX12_RESOURCE_BARRIER ResrcBarrier = CD3DX12_RESOURCE_BARRIER::Transition(Texture->GetResource(),
+					D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ);
+				GGfxCmdlist->ResourceBarrier(1, &ResrcBarrier);
+			}
+		}
+
+		D3D12_SHADER_RESOURCE_VIEW_DESC SRVDesc{};
+		SRVDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+		SRVDesc.Format = Format;
+		SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+		SRVDesc.Texture2D.MostDetailedMip = 0;
+		SRVDesc.Texture2D.MipLevels = NumMips;
+		Texture->SetViewHandle(Context->CBVHeap.Allocate());
+		D3D12Device->CreateShaderResourceView(Texture->GetResource(), &SRVDesc, Texture->GetViewHandle().CpuHandle);
+#ifdef KS_DEBUG_BUILD
+		KS_NAME_D3D12_OBJECT(Texture->GetResource(), TEXT("Texture2D"));
+#endif
 		return Texture;
 	}
 
@@ -1026,22 +1411,7 @@ namespace ks::d3d12
 
 	void FD3D12RHI::SetViewports(uint32_t Num, const FViewPort* Viewports)
 	{
-		assert(Num <= 8);
-		static const uint32_t NumMaxView{4};
-		static D3D12_VIEWPORT D3D12Viewports[NumMaxView];
-		static D3D12_RECT D3D12ScissorRects[NumMaxView];
-		for (uint32_t i{0}; i < Num && i < NumMaxView; ++i)
-		{
-			D3D12Viewports[i] = {0, 0,
-				static_cast<float>(Viewports[i].Width),
-				static_cast<float>(Viewports[i].Height),
-				0.f, 1.f};
-			D3D12ScissorRects[i] = {0, 0,
-				static_cast<LONG>(Viewports[i].Width),
-				static_cast<LONG>(Viewports[i].Height)};
-		}
-		GGfxCmdlist->RSSetViewports(Num, D3D12Viewports);
-		GGfxCmdlist->RSSetScissorRects(Num, D3D12ScissorRects);
+		SetD3D12Viewports(GGfxCmdlist, Num, Viewports);
 	}
 
 	void FD3D12RHI::ClearRenderTarget(const FColor& Color)
@@ -1056,22 +1426,9 @@ namespace ks::d3d12
 	{
 		auto& CurrentRenderTarget{ Context->CurrentRenderTarget };
 		auto& CurrentDepthStencilBuffer{ Context->CurrentDepthStencilBuffer };
-		//if (RenderTarget != CurrentRenderTarget || DepthStencilBuffer != CurrentDepthStencilBuffer)
-		{
-			CurrentRenderTarget = dynamic_cast<FD3D12RenderTarget*>(RenderTarget);
-			int32_t NumRenderTargets = CurrentRenderTarget ? 1 : 0;
-			const D3D12_CPU_DESCRIPTOR_HANDLE* pRTV{nullptr};
-			if (NumRenderTargets)
-			{
-				pRTV = &CurrentRenderTarget->GetRenderTargetView().CpuHandle;
-			}
-			bool bSingleHandle = NumRenderTargets != 0;
-
-			CurrentDepthStencilBuffer = dynamic_cast<FD3D12DepthStencilBuffer1*>(DepthStencilBuffer);
-			const D3D12_CPU_DESCRIPTOR_HANDLE* pDSV = CurrentDepthStencilBuffer ?
-				&CurrentDepthStencilBuffer->GetDepthStencilView().CpuHandle : nullptr;
-			GGfxCmdlist->OMSetRenderTargets(NumRenderTargets, pRTV, bSingleHandle, pDSV);
-		}
+		CurrentRenderTarget = dynamic_cast<FD3D12RenderTarget*>(RenderTarget);
+		CurrentDepthStencilBuffer = dynamic_cast<FD3D12DepthStencilBuffer1*>(DepthStencilBuffer);
+		SetD3D12RenderTargets(GGfxCmdlist, CurrentRenderTarget, CurrentDepthStencilBuffer);
 	}
 
 	IRHIRenderTarget* FD3D12RHI::GetCurrentBackBuffer()
@@ -1139,6 +1496,33 @@ namespace ks::d3d12
 			D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
 	}
 
+	void FD3D12RHI::ClearDepthStencilBuffer(const FViewPort& Rect)
+	{
+		const auto& DSV{ Context->CurrentDepthStencilBuffer->GetDepthStencilView().CpuHandle };
+		const D3D12_RECT ClearRect{
+			static_cast<LONG>(Rect.TopLeftX),
+			static_cast<LONG>(Rect.TopLeftY),
+			static_cast<LONG>(Rect.TopLeftX + Rect.Width),
+			static_cast<LONG>(Rect.TopLeftY + Rect.Height) };
+		GGfxCmdlist->ClearDepthStencilView(DSV,
+			D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 1, &ClearRect);
+	}
+
+	void FD3D12RHI::CopyDepthStencilBuffer(IRHIDepthStencilBuffer* Dest, IRHIDepthStencilBuffer* Source)
+	{
+		// depth stencil resources are copied whole, they rest in generic read between the passes
+		ID3D12Resource* DestResource{ dynamic_cast<FD3D12DepthStencilBuffer1*>(Dest)->GetResource() };
+		ID3D12Resource* SourceResource{ dynamic_cast<FD3D12DepthStencilBuffer1*>(Source)->GetResource() };
+		CD3DX12_RESOURCE_BARRIER ResBarriers[2]{
+			CD3DX12_RESOURCE_BARRIER::Transition(DestResource, D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_COPY_DEST),
+			CD3DX12_RESOURCE_BARRIER::Transition(SourceResource, D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_COPY_SOURCE) };
+		GGfxCmdlist->ResourceBarrier(_countof(ResBarriers), ResBarriers);
+		GGfxCmdlist->CopyResource(DestResource, SourceResource);
+		ResBarriers[0] = CD3DX12_RESOURCE_BARRIER::Transition(DestResource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ);
+		ResBarriers[1] = CD3DX12_RESOURCE_BARRIER::Transition(SourceResource, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_GENERIC_READ);
+		GGfxCmdlist->ResourceBarrier(_countof(ResBarriers), ResBarriers);
+	}
+
 	ks::IRHIDepthStencilBuffer* FD3D12RHI::GetDefaultDepthStencilBuffer()
 	{
 		return Context->DefaultDepthStencilBuffer.get();
@@ -1146,9 +1530,7 @@ namespace ks::d3d12
 
 	void FD3D12RHI::SetTexture2D(IRHITexture2D* Texture2D)
 	{
-		FD3D12Texture2D1* D3D12Texture2D = dynamic_cast<FD3D12Texture2D1*>(Texture2D);
-		const FDescriptorHandle& SRV{D3D12Texture2D->GetViewHandle()};
-		GGfxCmdlist->SetGraphicsRootDescriptorTable(static_cast<UINT>(Texture2D->GetLocationIndex()), SRV.GpuHandle);
+		SetD3D12Texture2D(GGfxCmdlist, Texture2D);
 	}
 
 	IRHIRenderTarget* FD3D12RHI::CreateRenderTarget(const FTexture2DDesc& Desc)
@@ -1202,6 +1584,123 @@ namespace ks::d3d12
 		return RenderTarget;
 	}
 
+	void FD3D12RHI::SetCommandListState(ID3D12GraphicsCommandList* CommandList)
+	{
+		ID3D12DescriptorHeap* Heaps[] = { Context->CBVHeap.GetHeap() };
+		CommandList->SetDescriptorHeaps(_countof(Heaps), Heaps);
+		CommandList->SetGraphicsRootSignature(Context->GlobalRootSignature.Get());
+	}
+
+	IRHICommandList* FD3D12RHI::CreateCommandList()
+	{
+		return new FD3D12CommandList(*this);
+	}
+
+	void FD3D12RHI::ExecuteCommandLists(IRHICommandList* const* CommandLists, uint32 Num)
+	{
+		if (Num == 0)
+		{
+			return;
+		}
+		auto& D3D12GfxCommandList{ Context->D3D12GfxCommandList };
+		// the frame commands recorded so far run first, the barriers and clears of the pass among them
+		KS_D3D12_CALL(D3D12GfxCommandList->Close());
+		std::vector<ID3D12CommandList*> D3D12CommandLists;
+		D3D12CommandLists.reserve(Num + 1);
+		D3D12CommandLists.push_back(D3D12GfxCommandList.Get());
+		for (uint32 i = 0; i < Num; ++i)
+		{
+			const FD3D12CommandList* CommandList{ static_cast<const FD3D12CommandList*>(CommandLists[i]) };
+			assert(!CommandList->IsRecording());
+			D3D12CommandLists.push_back(CommandList->GetD3D12CommandList());
+		}
+		Context->D3D12CommandQueue->ExecuteCommandLists(static_cast<UINT>(D3D12CommandLists.size()), D3D12CommandLists.data());
+
+		// a submitted list records again on the allocator of the frame, the state starts over
+		KS_D3D12_CALL(D3D12GfxCommandList->Reset(Context->FrameCommandAllocators[FrameIndex].Get(), nullptr));
+		SetCommandListState(D3D12GfxCommandList.Get());
+		SetD3D12RenderTargets(D3D12GfxCommandList.Get(), Context->CurrentRenderTarget, Context->CurrentDepthStencilBuffer);
+		Context->BoundIndexBuffer = nullptr;
+		Context->BoundDrawCommand = nullptr;
+	}
+
+	/*****************************************************************************/
+	FD3D12CommandList::FD3D12CommandList(FD3D12RHI& InRHI)
+		:RHI(InRHI)
+	{
+		for (auto& Allocator : Allocators)
+		{
+			KS_D3D12_CALL(RHI.D3D12Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(Allocator.GetAddressOf())));
+		}
+		KS_D3D12_CALL(RHI.D3D12Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, Allocators[0].Get(), nullptr,
+			IID_PPV_ARGS(D3D12CommandList.GetAddressOf())));
+		// closed until the first Begin, as the frame command list
+		D3D12CommandList->Close();
+	}
+
+	void FD3D12CommandList::Begin()
+	{
+		assert(!bRecording);
+		const uint32 FrameIndex{ RHI.FrameIndex };
+		auto& Allocator{ Allocators[FrameIndex] };
+		if (AllocatorFrames[FrameIndex] != RHI.FrameNumber)
+		{
+			KS_D3D12_CALL(Allocator->Reset());
+			AllocatorFrames[FrameIndex] = RHI.FrameNumber;
+		}
+		KS_D3D12_CALL(D3D12CommandList->Reset(Allocator.Get(), nullptr));
+		RHI.SetCommandListState(D3D12CommandList.Get());
+		SetD3D12RenderTargets(D3D12CommandList.Get(), RHI.Context->CurrentRenderTarget, RHI.Context->CurrentDepthStencilBuffer);
+		BoundDrawCommand = nullptr;
+		bRecording = true;
+	}
+
+	void FD3D12CommandList::End()
+	{
+		assert(bRecording);
+		KS_D3D12_CALL(D3D12CommandList->Close());
+		bRecording = false;
+	}
+
+	void FD3D12CommandList::SetPipelineState(IRHIPipelineState* PipelineState)
+	{
+		SetD3D12PipelineState(D3D12CommandList.Get(), PipelineState);
+	}
+
+	void FD3D12CommandList::SetViewports(uint32 Num, const FViewPort* Viewports)
+	{
+		SetD3D12Viewports(D3D12CommandList.Get(), Num, Viewports);
+	}
+
+	void FD3D12CommandList::SetConstBuffer(IRHIConstBuffer1* ConstBuffer)
+	{
+		RHI.SetConstBuffer(D3D12CommandList.Get(), ConstBuffer);
+	}
+
+	void FD3D12CommandList::SetStructuredBuffer(IRHIConstBufferArray* ConstBufferArray)
+	{
+		SetD3D12StructuredBuffer(D3D12CommandList.Get(), ConstBufferArray);
+	}
+
+	void FD3D12CommandList::SetTexture2D(IRHITexture2D* Texture2D)
+	{
+		SetD3D12Texture2D(D3D12CommandList.Get(), Texture2D);
+	}
+
+	void FD3D12CommandList::SetInstanceBuffer(uint32 Slot, uint32 Stride, uint32 NumInstances, const void* Data)
+	{
+		RHI.SetInstanceBuffer(D3D12CommandList.Get(), Slot, Stride, NumInstances, Data);
+	}
+
+	void FD3D12CommandList::SetShaderResourceData(uint32 LocationIndex, const FRHIFrameData& FrameData)
+	{
+		RHI.SetShaderResourceData(D3D12CommandList.Get(), LocationIndex, FrameData);
+	}
+
+	void FD3D12CommandList::DrawCommandInstanced(const IRHIDrawCommand* DrawCommand, uint32 NumInstances, uint32 FirstInstance)
+	{
+		DrawD3D12CommandInstanced(D3D12CommandList.Get(), BoundDrawCommand, DrawCommand, NumInstances, FirstInstance);
+	}
 }
 
 
@@ -19,6 +19,8 @@ namespace ks::d3d12
 		virtual ~FDescriptorHeap() {}
 		void Init(uint32 _Capacity, bool bShaderVisiable);
 		FDescriptorHandle Allocate();
+		// the descriptor must not be referenced by a frame in flight
+		void Free(const FDescriptorHandle& Handle);
 		ID3D12DescriptorHeap* GetHeap() { return Heap.Get(); }
 		D3D12_CPU_DESCRIPTOR_HANDLE GetCpuStart() const { return CpuStart; }
 		D3D12_GPU_DESCRIPTOR_HANDLE GetGpuStart() const { return GpuStart; }
@@ -39,6 +41,7 @@ namespace ks::d3d12
 
 	class FD3D12RHI : public IRHI
 	{
+		friend class FD3D12CommandList;
 	public:
 		// RHI interface
 		virtual ~FD3D12RHI();
@@ -54,6 +57,12 @@ namespace ks::d3d12
 		virtual IRHIPipelineState* CreatePipelineState(const FRHIPipelineStateDesc& Desc) override;
 		virtual void SetShaderConstBuffer(IRHIConstBuffer* ConstBuffer) override;
 		virtual void SetConstBuffer(IRHIConstBuffer1* ConstBuffer) override;
+		virtual IRHIConstBufferArray* CreateConstBufferArray(uint32 ElemSize, uint32 Count) override;
+		virtual void UpdateConstBufferArray(IRHIConstBufferArray* ConstBufferArray, uint32 NumElems, const uint32* Indices, const void* Data) override;
+		virtual void SetStructuredBuffer(IRHIConstBufferArray* ConstBufferArray) override;
+		virtual void SetInstanceBuffer(uint32 Slot, uint32 Stride, uint32 NumInstances, const void* Data) override;
+		virtual FRHIFrameData UploadFrameData(uint32 Stride, uint32 NumElems, const void* Data) override;
+		virtual void SetShaderResourceData(uint32 LocationIndex, const FRHIFrameData& FrameData) override;
 		virtual void SetVertexBuffer(const IRHIVertexBuffer* VertexBuffer) override;
 		virtual void SetVertexBuffer1(const IRHIVertexBuffer1* VertexBuffer) override;
 		virtual void SetVertexBuffers(const IRHIVertexBuffer** VertexBuffers, int32 Num) override;
@@ -64,18 +73,25 @@ namespace ks::d3d12
 		virtual IRHIIndexBuffer1* CreateIndexBuffer1(EELEM_FORMAT ElemFormat, uint32 Count, uint32 Size, const void* Data) override;
 		virtual void DrawIndexedPrimitive(const IRHIIndexBuffer* IndexBuffer) override;
 		virtual void DrawIndexedPrimitive1(const IRHIIndexBuffer1* IndexBuffer) override;
-		virtual IRHITexture2D* CreateTexture2D(const FTexture2DDesc& Desc) override;
+		virtual void DrawIndexedPrimitiveInstanced1(const IRHIIndexBuffer1* IndexBuffer, uint32 NumInstances, uint32 FirstInstance) override;
+		virtual IRHIDrawCommand* CreateDrawCommand(const IRHIVertexBuffer1** VertexBuffers, int32 Num, const IRHIIndexBuffer1* IndexBuffer) override;
+		virtual void DrawCommandInstanced(const IRHIDrawCommand* DrawCommand, uint32 NumInstances, uint32 FirstInstance) override;
+		virtual IRHITexture2D* CreateTexture2D(const FTexture2DDesc& Desc, const FTextureMipData* MipData) override;
 		virtual IRHIDepthStencilBuffer* CreateDepthStencilBuffer(const FTexture2DDesc& Desc) override;
 		virtual void SetViewports(uint32_t Num, const FViewPort* Viewports) override;
 		virtual void ClearRenderTarget(const FColor& Color) override;
 		virtual void SetRenderTarget(IRHIRenderTarget* RenderTarget, IRHIDepthStencilBuffer* DepthBuffer) override;
 		virtual void ClearDepthStencilBuffer() override;
+		virtual void ClearDepthStencilBuffer(const FViewPort& Rect) override;
+		virtual void CopyDepthStencilBuffer(IRHIDepthStencilBuffer* Dest, IRHIDepthStencilBuffer* Source) override;
 		virtual void BeginPass() override;
 		virtual void EndPass() override;
 		virtual IRHIRenderTarget* GetCurrentBackBuffer() override;
 		virtual IRHIDepthStencilBuffer* GetDefaultDepthStencilBuffer() override;
 		virtual void SetTexture2D(IRHITexture2D* Texture2D) override;
 		virtual IRHIRenderTarget* CreateRenderTarget(const FTexture2DDesc& Desc) override;
+		virtual IRHICommandList* CreateCommandList() override;
+		virtual void ExecuteCommandLists(IRHICommandList* const* CommandLists, uint32 Num) override;
 		// static helper functions
 		static d3d12::FD3D12Resource* CreateConstBufferResource(size_t Size);
 		// d3d12 interface
@@ -85,7 +101,22 @@ namespace ks::d3d12
 		DXGI_FORMAT GetDepthbufferFormat() const { return DepthBufferFormat; }
 		ID3D12RootSignature* GetGlobalRootSignature();
 		static const int SwapChainBufferCount = 2;
+		// frame slot of the per frame resources, in [0, NumFramesInFlight)
+		uint32 GetFrameIndex() const { return FrameIndex; }
+		// const buffers with copies older than their data, refreshed by BeginFrame
+		void AddStaleConstBuffer(FD3D12ConstBuffer1* ConstBuffer) { StaleConstBuffers.push_back(ConstBuffer); }
+		void RemoveStaleConstBuffer(FD3D12ConstBuffer1* ConstBuffer) { std::erase(StaleConstBuffers, ConstBuffer); }
 	private:
+		// block until the gpu has passed FenceValue
+		void WaitForFence(UINT64 FenceValue);
+		// Size bytes of the upload buffer of the current frame, valid until the frame retires
+		uint8* AllocateFrameUpload(uint64 Size, ID3D12Resource*& OutResource, uint64& OutOffset);
+		// the binds shared by the frame command list and the command lists of the passes
+		void SetConstBuffer(ID3D12GraphicsCommandList* CommandList, IRHIConstBuffer1* ConstBuffer);
+		void SetInstanceBuffer(ID3D12GraphicsCommandList* CommandList, uint32 Slot, uint32 Stride, uint32 NumInstances, const void* Data);
+		void SetShaderResourceData(ID3D12GraphicsCommandList* CommandList, uint32 LocationIndex, const FRHIFrameData& FrameData);
+		// the heaps, root signature and targets a command list starts with
+		void SetCommandListState(ID3D12GraphicsCommandList* CommandList);
 		IRHIBuffer* CreateBuffer(uint32 Size, const void* Data);
 		void CreateBuffer1(uint32_t Size, D3D12_HEAP_TYPE HeapType, D3D12_RESOURCE_STATES ResStats, ComPtr<ID3D12Resource>& OutResource);
 		int32_t UploadResourceData(ID3D12Resource* DestResource, const void* Data, uint32_t Size);
@@ -101,6 +132,12 @@ namespace ks::d3d12
 
 		UINT64 CurrentFence = 0;
 		int CurrentBackBuffer = 0;
+		// the frame being recorded and the fence signaled by each frame slot at its submission
+		uint32 FrameIndex = 0;
+		UINT64 FrameFenceValues[NumFramesInFlight]{};
+		// frames ended so far plus one, the command lists reset an allocator once per frame
+		uint64 FrameNumber = 1;
+		std::vector<FD3D12ConstBuffer1*> StaleConstBuffers;
 
 		D3D12_VIEWPORT D3D12Viewport;
 		D3D12_RECT ScissorRect;
@@ -113,4 +150,31 @@ namespace ks::d3d12
 		DXGI_FORMAT BackBufferFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
 		DXGI_FORMAT DepthBufferFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
 	};
+
+	/* a list with its own allocator per frame slot, see IRHICommandList */
+	class FD3D12CommandList : public IRHICommandList
+	{
+	public:
+		explicit FD3D12CommandList(FD3D12RHI& InRHI);
+		virtual void Begin() override;
+		virtual void End() override;
+		virtual void SetPipelineState(IRHIPipelineState* PipelineState) override;
+		virtual void SetViewports(uint32 Num, const FViewPort* Viewports) override;
+		virtual void SetConstBuffer(IRHIConstBuffer1* ConstBuffer) override;
+		virtual void SetStructuredBuffer(IRHIConstBufferArray* ConstBufferArray) override;
+		virtual void SetTexture2D(IRHITexture2D* Texture2D) override;
+		virtual void SetInstanceBuffer(uint32 Slot, uint32 Stride, uint32 NumInstances, const void* Data) override;
+		virtual void SetShaderResourceData(uint32 LocationIndex, const FRHIFrameData& FrameData) override;
+		virtual void DrawCommandInstanced(const IRHIDrawCommand* DrawCommand, uint32 NumInstances, uint32 FirstInstance) override;
+		ID3D12GraphicsCommandList* GetD3D12CommandList() const { return D3D12CommandList.Get(); }
+		bool IsRecording() const { return bRecording; }
+	private:
+		FD3D12RHI& RHI;
+		ComPtr<ID3D12GraphicsCommandList> D3D12CommandList;
+		// the allocator of a slot is reset by the first recording of a frame, the slot retired before the frame began
+		ComPtr<ID3D12CommandAllocator> Allocators[NumFramesInFlight];
+		uint64 AllocatorFrames[NumFramesInFlight]{};
+		const FD3D12DrawCommand* BoundDrawCommand{ nullptr };
+		bool bRecording{ false };
+	};
 } // ~ks::d3d12
\ No newline at end of file
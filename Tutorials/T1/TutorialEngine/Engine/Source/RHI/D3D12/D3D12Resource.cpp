@@ -1,5 +1,6 @@
 #include "engine_pch.h"
 #include "D3D12Resource.h"
+#include "D3D12RHI.h"
 
 namespace ks::d3d12
 {
@@ -14,11 +15,48 @@ namespace ks::d3d12
 		{
 			D3D12Resource->Unmap(0, nullptr);
 		}
+		if (bStale)
+		{
+			GD3D12RHI->RemoveStaleConstBuffer(this);
+		}
+	}
+
+	void FD3D12ConstBuffer1::SetData(const void* InData, uint32_t Size)
+	{
+		assert(Size <= AllocSize);
+		Data.assign(static_cast<const uint8*>(InData), static_cast<const uint8*>(InData) + Size);
+		++Version;
+		// the copy of the current frame is not read by the gpu until this frame is submitted
+		const uint32 FrameIndex{ GD3D12RHI->GetFrameIndex() };
+		memcpy(MapData + FrameIndex * AllocSize, InData, Size);
+		FrameVersions[FrameIndex] = Version;
+		if (!bStale)
+		{
+			bStale = true;
+			GD3D12RHI->AddStaleConstBuffer(this);
+		}
+	}
+
+	bool FD3D12ConstBuffer1::RefreshFrame(uint32 FrameIndex)
+	{
+		if (FrameVersions[FrameIndex] != Version)
+		{
+			memcpy(MapData + FrameIndex * AllocSize, Data.data(), Data.size());
+			FrameVersions[FrameIndex] = Version;
+		}
+		bStale = std::any_of(std::begin(FrameVersions), std::end(FrameVersions), [this](uint32 FrameVersion) { return FrameVersion != Version; });
+		return !bStale;
+	}
+
+	const FDescriptorHandle& FD3D12ConstBuffer1::GetViewHandle(uint32 FrameIndex) const
+	{
+		assert(FrameVersions[FrameIndex] == Version);
+		return ViewHandles[FrameIndex];
 	}
 
-	void FD3D12ConstBuffer1::SetData(const void* Data, uint32_t Size)
+	FD3D12ConstBufferArray::~FD3D12ConstBufferArray()
 	{
-		memcpy(MapData, Data, Size);
+		GD3D12RHI->GetCBVHeap().Free(ShaderResourceViewHandle);
 	}
 
 	FD3D12IndexBuffer1::FD3D12IndexBuffer1(EELEM_FORMAT _ElemFormat, uint32 _Count, uint32 _Size)
@@ -113,13 +113,40 @@ namespace ks::d3d12
 	public:
 		FD3D12ConstBuffer1(uint32_t _Size);
 		virtual ~FD3D12ConstBuffer1();
+		// writes the copy of the current frame, the other copies are refreshed by the BeginFrame of their frame
 		virtual void SetData(const void* Data, uint32_t Size) override;
-		const FDescriptorHandle& GetViewHandle() const { return ViewHandle; }
+		// bring the copy of the frame up to date, true once every copy is, on the render thread before any list records
+		bool RefreshFrame(uint32 FrameIndex);
+		// view of the copy of the frame, read only so the command lists of a pass bind it in parallel
+		const FDescriptorHandle& GetViewHandle(uint32 FrameIndex) const;
 		uint32_t GetAllocSize() const { return AllocSize; }
 	private:
-		void* MapData{ nullptr };
+		// one copy per frame in flight, AllocSize apart
+		uint8* MapData{ nullptr };
 		uint32_t AllocSize{ 0 };
-		FDescriptorHandle ViewHandle;
+		FDescriptorHandle ViewHandles[NumFramesInFlight];
+		// latest data and the version each copy holds
+		std::vector<uint8> Data;
+		uint32 Version{ 0 };
+		uint32 FrameVersions[NumFramesInFlight]{};
+		// in the stale list of the rhi
+		bool bStale{ false };
+	};
+
+	class FD3D12ConstBufferArray : public IRHIConstBufferArray, public FD3D12Resource1
+	{
+		friend class FD3D12RHI;
+	public:
+		FD3D12ConstBufferArray(uint32 InElemSize, uint32 InCount, uint32 InAllocElemSize)
+			:IRHIConstBufferArray(InElemSize, InCount), AllocElemSize(InAllocElemSize) {}
+		virtual ~FD3D12ConstBufferArray();
+		// structured buffer view of all the elements
+		const FDescriptorHandle& GetShaderResourceViewHandle() const { return ShaderResourceViewHandle; }
+		// elements are placed this many bytes apart
+		uint32 GetAllocElemSize() const { return AllocElemSize; }
+	private:
+		uint32 AllocElemSize{ 0 };
+		FDescriptorHandle ShaderResourceViewHandle;
 	};
 
 	class FD3D12IndexBuffer1 : public IRHIIndexBuffer1, public FD3D12Resource1
@@ -144,6 +171,18 @@ namespace ks::d3d12
 		D3D12_VERTEX_BUFFER_VIEW BufferView;
 	};
 
+	class FD3D12DrawCommand : public IRHIDrawCommand
+	{
+		friend class FD3D12RHI;
+	public:
+		static constexpr uint32 MaxVertexBuffers{ 2 };
+	private:
+		D3D12_VERTEX_BUFFER_VIEW VertexBufferViews[MaxVertexBuffers]{};
+		uint32 NumVertexBuffers{ 0 };
+		D3D12_INDEX_BUFFER_VIEW IndexBufferView{};
+		uint32 IndexCount{ 0 };
+	};
+
 	class FD3D12Texture2D : public IRHITexture2D, public FD3D12Resource1
 	{
 		friend class FD3D12RHI;
@@ -0,0 +1,415 @@
+#include "engine_pch.h"
+
+#include "RHI/Null/NullRHI.h"
+
+namespace ks::nullrhi
+{
+	namespace
+	{
+		class FNullConstBuffer : public IRHIConstBuffer
+		{
+		public:
+			virtual void UpdateData(const void* pData, uint32 Size) override {}
+		};
+
+		class FNullConstBuffer1 : public IRHIConstBuffer1
+		{
+		public:
+			virtual void SetData(const void* Data, uint32 Size) override {}
+		};
+
+		class FNullConstBufferArray : public IRHIConstBufferArray
+		{
+		public:
+			FNullConstBufferArray(uint32 ElemSize, uint32 Count) :IRHIConstBufferArray(ElemSize, Count) {}
+		};
+
+		class FNullPipelineState : public IRHIPipelineState
+		{
+		public:
+			FNullPipelineState(const FRHIPipelineStateDesc& Desc) :IRHIPipelineState(Desc) {}
+		};
+
+		class FNullVertexBuffer : public IRHIVertexBuffer
+		{
+		public:
+			FNullVertexBuffer(uint32 Stride, uint32 Size) :IRHIVertexBuffer(Stride, Size) {}
+		};
+
+		class FNullVertexBuffer1 : public IRHIVertexBuffer1
+		{
+		public:
+			FNullVertexBuffer1(uint32 Stride, uint32 Size) :IRHIVertexBuffer1(Stride, Size) {}
+		};
+
+		class FNullIndexBuffer : public IRHIIndexBuffer
+		{
+		public:
+			FNullIndexBuffer(EELEM_FORMAT ElemFormat, uint32 Count, uint32 Size) :IRHIIndexBuffer(ElemFormat, Count, Size) {}
+		};
+
+		class FNullIndexBuffer1 : public IRHIIndexBuffer1
+		{
+		public:
+			FNullIndexBuffer1(EELEM_FORMAT ElemFormat, uint32 Count, uint32 Size) :IRHIIndexBuffer1(ElemFormat, Count, Size) {}
+		};
+
+		class FNullDrawCommand : public IRHIDrawCommand
+		{
+		public:
+			explicit FNullDrawCommand(uint32 InIndexCount) :IndexCount(InIndexCount) {}
+			uint32 IndexCount{ 0 };
+		};
+
+		class FNullTexture2D : public IRHITexture2D
+		{
+		public:
+			FNullTexture2D(const FTexture2DDesc& Desc) :IRHITexture2D(Desc) {}
+		};
+
+		class FNullDepthStencilBuffer : public IRHIDepthStencilBuffer
+		{
+		public:
+			FNullDepthStencilBuffer(const FTexture2DDesc& Desc) :IRHIDepthStencilBuffer(Desc), Texture(Desc) {}
+			virtual IRHITexture2D* GetTexture2D() override { return &Texture; }
+		private:
+			FNullTexture2D Texture;
+		};
+
+		class FNullRenderTarget : public IRHIRenderTarget
+		{
+		public:
+			FNullRenderTarget(const FTexture2DDesc& Desc) :IRHIRenderTarget(Desc), Texture(Desc) {}
+			virtual IRHITexture2D* GetTexture2D() override { return &Texture; }
+		private:
+			FNullTexture2D Texture;
+		};
+	}
+
+	void FNullRHI::Init(const FRHIConfig& Config)
+	{
+		KS_INFO(TEXT("FNullRHI::Init"));
+		FTexture2DDesc BackBufferDesc;
+		BackBufferDesc.Width = Config.ViewPort.Width;
+		BackBufferDesc.Height = Config.ViewPort.Height;
+		BackBufferDesc.Format = Config.BackBufferFormat;
+		BackBuffer.reset(CreateRenderTarget(BackBufferDesc));
+		FTexture2DDesc DepthDesc{ BackBufferDesc };
+		DepthDesc.Format = Config.DepthBufferFormat;
+		DefaultDepthStencilBuffer.reset(CreateDepthStencilBuffer(DepthDesc));
+	}
+
+	void FNullRHI::Shutdown()
+	{
+		KS_INFO(TEXT("\tFNullRHI::Shutdown"));
+		assert(!bInFrame);
+		BackBuffer.reset();
+		DefaultDepthStencilBuffer.reset();
+	}
+
+	void FNullRHI::BeginFrame()
+	{
+		assert(!bInFrame);
+		bInFrame = true;
+		FrameStats = FStats{};
+	}
+
+	void FNullRHI::EndFrame()
+	{
+		assert(bInFrame && !bInPass);
+		bInFrame = false;
+		LastFrameStats = FrameStats;
+	}
+
+	IRHIConstBuffer* FNullRHI::CreateConstBuffer(const void* Data, uint32 Size)
+	{
+		return new FNullConstBuffer();
+	}
+
+	IRHIConstBuffer1* FNullRHI::CreateConstBuffer1(const void* Data, uint32 Size)
+	{
+		return new FNullConstBuffer1();
+	}
+
+	void FNullRHI::SetPipelineState(IRHIPipelineState* PipelineState)
+	{
+		assert(bInFrame && PipelineState);
+	}
+
+	IRHIPipelineState* FNullRHI::CreatePipelineState(const FRHIPipelineStateDesc& Desc)
+	{
+		return new FNullPipelineState(Desc);
+	}
+
+	void FNullRHI::SetShaderConstBuffer(IRHIConstBuffer* ConstBuffer)
+	{
+		assert(bInFrame && ConstBuffer);
+	}
+
+	void FNullRHI::SetConstBuffer(IRHIConstBuffer1* ConstBuffer)
+	{
+		assert(bInFrame && ConstBuffer);
+	}
+
+	IRHIConstBufferArray* FNullRHI::CreateConstBufferArray(uint32 ElemSize, uint32 Count)
+	{
+		return new FNullConstBufferArray(ElemSize, Count);
+	}
+
+	void FNullRHI::UpdateConstBufferArray(IRHIConstBufferArray* ConstBufferArray, uint32 NumElems, const uint32* Indices, const void* Data)
+	{
+		assert(bInFrame && ConstBufferArray);
+		for (uint32 i = 0; i < NumElems; ++i)
+		{
+			assert(Indices[i] < ConstBufferArray->GetCount());
+		}
+	}
+
+	void FNullRHI::SetStructuredBuffer(IRHIConstBufferArray* ConstBufferArray)
+	{
+		assert(bInFrame && ConstBufferArray);
+	}
+
+	void FNullRHI::SetInstanceBuffer(uint32 Slot, uint32 Stride, uint32 NumInstances, const void* Data)
+	{
+		assert(bInFrame && (Data || NumInstances == 0));
+	}
+
+	FRHIFrameData FNullRHI::UploadFrameData(uint32 Stride, uint32 NumElems, const void* Data)
+	{
+		assert(bInFrame && (Data || NumElems == 0));
+		return FRHIFrameData{ 0, NumElems };
+	}
+
+	void FNullRHI::SetShaderResourceData(uint32 LocationIndex, const FRHIFrameData& FrameData)
+	{
+		assert(bInFrame);
+	}
+
+	void FNullRHI::SetVertexBuffer(const IRHIVertexBuffer* VertexBuffer)
+	{
+		assert(bInFrame && VertexBuffer);
+	}
+
+	void FNullRHI::SetVertexBuffer1(const IRHIVertexBuffer1* VertexBuffer)
+	{
+		assert(bInFrame && VertexBuffer);
+	}
+
+	void FNullRHI::SetVertexBuffers(const IRHIVertexBuffer** VertexBuffers, int32 Num)
+	{
+		assert(bInFrame);
+	}
+
+	void FNullRHI::SetVertexBuffers1(const IRHIVertexBuffer1** VertexBuffers, int32 Num)
+	{
+		assert(bInFrame);
+	}
+
+	IRHIVertexBuffer* FNullRHI::CreateVertexBuffer(uint32 Stride, uint32 Size, const void* Data)
+	{
+		return new FNullVertexBuffer(Stride, Size);
+	}
+
+	IRHIVertexBuffer1* FNullRHI::CreateVertexBuffer1(uint32 Stride, uint32 Size, const void* Data)
+	{
+		return new FNullVertexBuffer1(Stride, Size);
+	}
+
+	IRHIIndexBuffer* FNullRHI::CreateIndexBuffer(EELEM_FORMAT ElemFormat, uint32 Count, uint32 Size, const void* Data)
+	{
+		return new FNullIndexBuffer(ElemFormat, Count, Size);
+	}
+
+	IRHIIndexBuffer1* FNullRHI::CreateIndexBuffer1(EELEM_FORMAT ElemFormat, uint32 Count, uint32 Size, const void* Data)
+	{
+		return new FNullIndexBuffer1(ElemFormat, Count, Size);
+	}
+
+	void FNullRHI::DrawIndexedPrimitive(const IRHIIndexBuffer* IndexBuffer)
+	{
+		assert(IndexBuffer);
+		CountDraw(1);
+	}
+
+	void FNullRHI::DrawIndexedPrimitive1(const IRHIIndexBuffer1* IndexBuffer)
+	{
+		assert(IndexBuffer);
+		CountDraw(1);
+	}
+
+	void FNullRHI::DrawIndexedPrimitiveInstanced1(const IRHIIndexBuffer1* IndexBuffer, uint32 NumInstances, uint32 FirstInstance)
+	{
+		assert(IndexBuffer);
+		CountDraw(NumInstances);
+	}
+
+	IRHIDrawCommand* FNullRHI::CreateDrawCommand(const IRHIVertexBuffer1** VertexBuffers, int32 Num, const IRHIIndexBuffer1* IndexBuffer)
+	{
+		assert(Num > 0 && IndexBuffer);
+		return new FNullDrawCommand(IndexBuffer->GetCount());
+	}
+
+	void FNullRHI::DrawCommandInstanced(const IRHIDrawCommand* DrawCommand, uint32 NumInstances, uint32 FirstInstance)
+	{
+		assert(DrawCommand);
+		CountDraw(NumInstances);
+	}
+
+	IRHITexture2D* FNullRHI::CreateTexture2D(const FTexture2DDesc& Desc, const FTextureMipData* MipData)
+	{
+		return new FNullTexture2D(Desc);
+	}
+
+	IRHIDepthStencilBuffer* FNullRHI::CreateDepthStencilBuffer(const FTexture2DDesc& Desc)
+	{
+		return new FNullDepthStencilBuffer(Desc);
+	}
+
+	void FNullRHI::SetViewports(uint32_t Num, const FViewPort* Viewports)
+	{
+		assert(bInFrame && Viewports);
+	}
+
+	void FNullRHI::ClearRenderTarget(const FColor& Color)
+	{
+		assert(bInPass);
+	}
+
+	void FNullRHI::SetRenderTarget(IRHIRenderTarget* RenderTarget, IRHIDepthStencilBuffer* DepthBuffer)
+	{
+		assert(bInFrame && !bInPass);
+		CurrentDepthStencilBuffer = DepthBuffer;
+	}
+
+	void FNullRHI::ClearDepthStencilBuffer()
+	{
+		assert(bInPass);
+	}
+
+	void FNullRHI::ClearDepthStencilBuffer(const FViewPort& Rect)
+	{
+		assert(bInPass);
+	}
+
+	void FNullRHI::CopyDepthStencilBuffer(IRHIDepthStencilBuffer* Dest, IRHIDepthStencilBuffer* Source)
+	{
+		assert(bInFrame && !bInPass && Dest && Source && Dest != Source);
+	}
+
+	void FNullRHI::BeginPass()
+	{
+		// as the d3d12 rhi, a pass draws with a depth stencil buffer
+		assert(bInFrame && !bInPass && CurrentDepthStencilBuffer);
+		bInPass = true;
+	}
+
+	void FNullRHI::EndPass()
+	{
+		assert(bInPass);
+		bInPass = false;
+	}
+
+	IRHIRenderTarget* FNullRHI::GetCurrentBackBuffer()
+	{
+		return BackBuffer.get();
+	}
+
+	IRHIDepthStencilBuffer* FNullRHI::GetDefaultDepthStencilBuffer()
+	{
+		return DefaultDepthStencilBuffer.get();
+	}
+
+	void FNullRHI::SetTexture2D(IRHITexture2D* Texture2D)
+	{
+		assert(bInFrame && Texture2D && Texture2D->GetLocationIndex() >= 0);
+	}
+
+	IRHIRenderTarget* FNullRHI::CreateRenderTarget(const FTexture2DDesc& Desc)
+	{
+		return new FNullRenderTarget(Desc);
+	}
+
+	IRHICommandList* FNullRHI::CreateCommandList()
+	{
+		return new FNullCommandList(*this);
+	}
+
+	void FNullRHI::ExecuteCommandLists(IRHICommandList* const* CommandLists, uint32 Num)
+	{
+		assert(bInFrame);
+		for (uint32 i = 0; i < Num; ++i)
+		{
+			const FNullCommandList* CommandList{ static_cast<const FNullCommandList*>(CommandLists[i]) };
+			assert(!CommandList->IsRecording());
+			const FStats& ListStats{ CommandList->GetStats() };
+			FrameStats.NumDraws += ListStats.NumDraws;
+			FrameStats.NumInstances += ListStats.NumInstances;
+			++FrameStats.NumCommandLists;
+		}
+	}
+
+	void FNullRHI::CountDraw(uint32 NumInstances)
+	{
+		assert(bInPass && NumInstances > 0);
+		++FrameStats.NumDraws;
+		FrameStats.NumInstances += NumInstances;
+	}
+
+	/*****************************************************************************/
+	void FNullCommandList::Begin()
+	{
+		// recorded inside the pass whose targets the list inherits
+		assert(RHI.bInPass && !bRecording);
+		bRecording = true;
+		Stats = FNullRHI::FStats{};
+	}
+
+	void FNullCommandList::End()
+	{
+		assert(bRecording);
+		bRecording = false;
+	}
+
+	void FNullCommandList::SetPipelineState(IRHIPipelineState* PipelineState)
+	{
+		assert(bRecording && PipelineState);
+	}
+
+	void FNullCommandList::SetViewports(uint32 Num, const FViewPort* Viewports)
+	{
+		assert(bRecording && Viewports);
+	}
+
+	void FNullCommandList::SetConstBuffer(IRHIConstBuffer1* ConstBuffer)
+	{
+		assert(bRecording && ConstBuffer);
+	}
+
+	void FNullCommandList::SetStructuredBuffer(IRHIConstBufferArray* ConstBufferArray)
+	{
+		assert(bRecording && ConstBufferArray);
+	}
+
+	void FNullCommandList::SetTexture2D(IRHITexture2D* Texture2D)
+	{
+		assert(bRecording && Texture2D && Texture2D->GetLocationIndex() >= 0);
+	}
+
+	void FNullCommandList::SetInstanceBuffer(uint32 Slot, uint32 Stride, uint32 NumInstances, const void* Data)
+	{
+		assert(bRecording && (Data || NumInstances == 0));
+	}
+
+	void FNullCommandList::SetShaderResourceData(uint32 LocationIndex, const FRHIFrameData& FrameData)
+	{
+		assert(bRecording);
+	}
+
+	void FNullCommandList::DrawCommandInstanced(const IRHIDrawCommand* DrawCommand, uint32 NumInstances, uint32 FirstInstance)
+	{
+		assert(bRecording && DrawCommand && NumInstances > 0);
+		++Stats.NumDraws;
+		Stats.NumInstances += NumInstances;
+	}
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "RHI/RHI.h"
+
+namespace ks::nullrhi
+{
+	/*
+	* an rhi without a device, the resources hold their descriptions only and the commands are checked and counted
+	* runs the renderer headless with -nullrhi, the counted draws are read back with GetLastFrameStats
+	* only the rhi and the core containers build off windows, the application, entry point and logging are windows only
+	*/
+	class FNullRHI : public IRHI
+	{
+		friend class FNullCommandList;
+	public:
+		struct FStats
+		{
+			uint32 NumDraws{ 0 };
+			uint32 NumInstances{ 0 };
+			uint32 NumCommandLists{ 0 };
+		};
+		// RHI interface
+		virtual ~FNullRHI() {}
+		virtual void Init(const FRHIConfig& Config) override;
+		virtual void Shutdown() override;
+		virtual void ResizeWindow() override {}
+		virtual void FlushRenderingCommands() override {}
+		virtual void BeginFrame() override;
+		virtual void EndFrame() override;
+		virtual IRHIConstBuffer* CreateConstBuffer(const void* Data, uint32 Size) override;
+		virtual IRHIConstBuffer1* CreateConstBuffer1(const void* Data, uint32 Size) override;
+		virtual void SetPipelineState(IRHIPipelineState* PipelineState) override;
+		virtual IRHIPipelineState* CreatePipelineState(const FRHIPipelineStateDesc& Desc) override;
+		virtual void SetShaderConstBuffer(IRHIConstBuffer* ConstBuffer) override;
+		virtual void SetConstBuffer(IRHIConstBuffer1* ConstBuffer) override;
+		virtual IRHIConstBufferArray* CreateConstBufferArray(uint32 ElemSize, uint32 Count) override;
+		virtual void UpdateConstBufferArray(IRHIConstBufferArray* ConstBufferArray, uint32 NumElems, const uint32* Indices, const void* Data) override;
+		virtual void SetStructuredBuffer(IRHIConstBufferArray* ConstBufferArray) override;
+		virtual void SetInstanceBuffer(uint32 Slot, uint32 Stride, uint32 NumInstances, const void* Data) override;
+		virtual FRHIFrameData UploadFrameData(uint32 Stride, uint32 NumElems, const void* Data) override;
+		virtual void SetShaderResourceData(uint32 LocationIndex, const FRHIFrameData& FrameData) override;
+		virtual void SetVertexBuffer(const IRHIVertexBuffer* VertexBuffer) override;
+		virtual void SetVertexBuffer1(const IRHIVertexBuffer1* VertexBuffer) override;
+		virtual void SetVertexBuffers(const IRHIVertexBuffer** VertexBuffers, int32 Num) override;
+		virtual void SetVertexBuffers1(const IRHIVertexBuffer1** VertexBuffers, int32 Num) override;
+		virtual IRHIVertexBuffer* CreateVertexBuffer(uint32 Stride, uint32 Size, const void* Data) override;
+		virtual IRHIVertexBuffer1* CreateVertexBuffer1(uint32 Stride, uint32 Size, const void* Data) override;
+		virtual IRHIIndexBuffer* CreateIndexBuffer(EELEM_FORMAT ElemFormat, uint32 Count, uint32 Size, const void* Data) override;
+		virtual IRHIIndexBuffer1* CreateIndexBuffer1(EELEM_FORMAT ElemFormat, uint32 Count, uint32 Size, const void* Data) override;
+		virtual void DrawIndexedPrimitive(const IRHIIndexBuffer* IndexBuffer) override;
+		virtual void DrawIndexedPrimitive1(const IRHIIndexBuffer1* IndexBuffer) override;
+		virtual void DrawIndexedPrimitiveInstanced1(const IRHIIndexBuffer1* IndexBuffer, uint32 NumInstances, uint32 FirstInstance) override;
+		virtual IRHIDrawCommand* CreateDrawCommand(const IRHIVertexBuffer1** VertexBuffers, int32 Num, const IRHIIndexBuffer1* IndexBuffer) override;
+		virtual void DrawCommandInstanced(const IRHIDrawCommand* DrawCommand, uint32 NumInstances, uint32 FirstInstance) override;
+		virtual IRHITexture2D* CreateTexture2D(const FTexture2DDesc& Desc, const FTextureMipData* MipData) override;
+		virtual IRHIDepthStencilBuffer* CreateDepthStencilBuffer(const FTexture2DDesc& Desc) override;
+		virtual void SetViewports(uint32_t Num, const FViewPort* Viewports) override;
+		virtual void ClearRenderTarget(const FColor& Color) override;
+		virtual void SetRenderTarget(IRHIRenderTarget* RenderTarget, IRHIDepthStencilBuffer* DepthBuffer) override;
+		virtual void ClearDepthStencilBuffer() override;
+		virtual void ClearDepthStencilBuffer(const FViewPort& Rect) override;
+		virtual void CopyDepthStencilBuffer(IRHIDepthStencilBuffer* Dest, IRHIDepthStencilBuffer* Source) override;
+		virtual void BeginPass() override;
+		virtual void EndPass() override;
+		virtual IRHIRenderTarget* GetCurrentBackBuffer() override;
+		virtual IRHIDepthStencilBuffer* GetDefaultDepthStencilBuffer() override;
+		virtual void SetTexture2D(IRHITexture2D* Texture2D) override;
+		virtual IRHIRenderTarget* CreateRenderTarget(const FTexture2DDesc& Desc) override;
+		virtual IRHICommandList* CreateCommandList() override;
+		virtual void ExecuteCommandLists(IRHICommandList* const* CommandLists, uint32 Num) override;
+		// null interface
+		// the draws of the last ended frame, immediate and from the command lists
+		const FStats& GetLastFrameStats() const { return LastFrameStats; }
+	private:
+		void CountDraw(uint32 NumInstances);
+
+		std::unique_ptr<IRHIRenderTarget> BackBuffer;
+		std::unique_ptr<IRHIDepthStencilBuffer> DefaultDepthStencilBuffer;
+		IRHIDepthStencilBuffer* CurrentDepthStencilBuffer{ nullptr };
+		bool bInFrame{ false };
+		bool bInPass{ false };
+		FStats FrameStats;
+		FStats LastFrameStats;
+	};
+
+	class FNullCommandList : public IRHICommandList
+	{
+	public:
+		explicit FNullCommandList(FNullRHI& InRHI) :RHI(InRHI) {}
+		virtual void Begin() override;
+		virtual void End() override;
+		virtual void SetPipelineState(IRHIPipelineState* PipelineState) override;
+		virtual void SetViewports(uint32 Num, const FViewPort* Viewports) override;
+		virtual void SetConstBuffer(IRHIConstBuffer1* ConstBuffer) override;
+		virtual void SetStructuredBuffer(IRHIConstBufferArray* ConstBufferArray) override;
+		virtual void SetTexture2D(IRHITexture2D* Texture2D) override;
+		virtual void SetInstanceBuffer(uint32 Slot, uint32 Stride, uint32 NumInstances, const void* Data) override;
+		virtual void SetShaderResourceData(uint32 LocationIndex, const FRHIFrameData& FrameData) override;
+		virtual void DrawCommandInstanced(const IRHIDrawCommand* DrawCommand, uint32 NumInstances, uint32 FirstInstance) override;
+		bool IsRecording() const { return bRecording; }
+		// the draws recorded since Begin, added to the frame when submitted
+		const FNullRHI::FStats& GetStats() const { return Stats; }
+	private:
+		FNullRHI& RHI;
+		bool bRecording{ false };
+		FNullRHI::FStats Stats;
+	};
+} // ~ks::nullrhi
@@ -1,6 +1,9 @@
 #include "engine_pch.h"
 
+#ifdef WINDOWS_PLATFORM
 #include "RHI/D3D12/D3D12RHI.h"
+#endif
+#include "RHI/Null/NullRHI.h"
 
 namespace ks
 {
@@ -15,7 +18,14 @@ namespace ks
 	IRHI* IRHI::Create()
 	{
 		KS_INFO(TEXT("IRHI::Create"));
-		GRHI = new d3d12::FD3D12RHI;
+#ifdef WINDOWS_PLATFORM
+		if (!GRHIConfig.bNullRHI)
+		{
+			GRHI = new d3d12::FD3D12RHI;
+			return GRHI;
+		}
+#endif
+		GRHI = new nullrhi::FNullRHI;
 		return GRHI;
 	}
 
@@ -5,6 +5,7 @@
 namespace ks
 {
 	class IRHIPipelineState;
+	class IRHICommandList;
 
 	class IRHI
 	{
@@ -23,6 +24,17 @@ namespace ks
 		virtual IRHIPipelineState* CreatePipelineState(const FRHIPipelineStateDesc& Desc) = 0;
 		virtual void SetShaderConstBuffer(IRHIConstBuffer* ConstBuffer) = 0;
 		virtual void SetConstBuffer(IRHIConstBuffer1* ConstBuffer) = 0;
+		virtual IRHIConstBufferArray* CreateConstBufferArray(uint32 ElemSize, uint32 Count) = 0;
+		// copy NumElems packed elements to the sorted Indices in one upload, recorded in the frame command list
+		virtual void UpdateConstBufferArray(IRHIConstBufferArray* ConstBufferArray, uint32 NumElems, const uint32* Indices, const void* Data) = 0;
+		// all the elements as one structured buffer, the stride is the element size rounded up to 16 bytes
+		virtual void SetStructuredBuffer(IRHIConstBufferArray* ConstBufferArray) = 0;
+		// per instance stream of the following instanced draws, copied for this frame and bound to Slot
+		virtual void SetInstanceBuffer(uint32 Slot, uint32 Stride, uint32 NumInstances, const void* Data) = 0;
+		// structured buffer rebuilt every frame, copied once for this frame on the render thread before the lists bind it
+		virtual FRHIFrameData UploadFrameData(uint32 Stride, uint32 NumElems, const void* Data) = 0;
+		// bind the uploaded data to the root parameter LocationIndex
+		virtual void SetShaderResourceData(uint32 LocationIndex, const FRHIFrameData& FrameData) = 0;
 		virtual void SetVertexBuffer(const IRHIVertexBuffer* VertexBuffer) = 0;
 		virtual void SetVertexBuffer1(const IRHIVertexBuffer1* VertexBuffer) = 0;
 		virtual void SetVertexBuffers(const IRHIVertexBuffer** VertexBuffers, int32 Num) = 0;
@@ -33,18 +45,33 @@ namespace ks
 		virtual IRHIIndexBuffer1* CreateIndexBuffer1(EELEM_FORMAT ElemFormat, uint32 Count, uint32 Size, const void* Data) = 0;
 		virtual void DrawIndexedPrimitive(const IRHIIndexBuffer* IndexBuffer) = 0;
 		virtual void DrawIndexedPrimitive1(const IRHIIndexBuffer1* IndexBuffer) = 0;
-		virtual IRHITexture2D* CreateTexture2D(const FTexture2DDesc& Desc) = 0;
+		// FirstInstance offsets the reads of the instance stream
+		virtual void DrawIndexedPrimitiveInstanced1(const IRHIIndexBuffer1* IndexBuffer, uint32 NumInstances, uint32 FirstInstance) = 0;
+		// the buffers must outlive the command, a draw of the command copies its resolved views only
+		virtual IRHIDrawCommand* CreateDrawCommand(const IRHIVertexBuffer1** VertexBuffers, int32 Num, const IRHIIndexBuffer1* IndexBuffer) = 0;
+		// skips the binds when the previous draw used the same command
+		virtual void DrawCommandInstanced(const IRHIDrawCommand* DrawCommand, uint32 NumInstances, uint32 FirstInstance) = 0;
+		// MipData holds Desc.NumMips entries, null leaves the texture uninitialized
+		virtual IRHITexture2D* CreateTexture2D(const FTexture2DDesc& Desc, const FTextureMipData* MipData) = 0;
 		virtual IRHIDepthStencilBuffer* CreateDepthStencilBuffer(const FTexture2DDesc& Desc) = 0;
 		virtual void SetViewports(uint32_t Num, const FViewPort* Viewports) = 0;
 		virtual void ClearRenderTarget(const FColor& Color) = 0;
 		virtual void SetRenderTarget(IRHIRenderTarget* RenderTarget, IRHIDepthStencilBuffer* DepthBuffer) = 0;
 		virtual void ClearDepthStencilBuffer() = 0;
+		// clear the rectangle of the viewport only, the rest of the depth stencil buffer keeps its content
+		virtual void ClearDepthStencilBuffer(const FViewPort& Rect) = 0;
+		// copy the whole buffer, the two have the same size, both outside a pass
+		virtual void CopyDepthStencilBuffer(IRHIDepthStencilBuffer* Dest, IRHIDepthStencilBuffer* Source) = 0;
 		virtual void BeginPass() = 0;
 		virtual void EndPass() = 0;
 		virtual IRHIRenderTarget* GetCurrentBackBuffer() = 0;
 		virtual IRHIDepthStencilBuffer* GetDefaultDepthStencilBuffer() = 0;
 		virtual void SetTexture2D(IRHITexture2D* Texture2D) = 0;
 		virtual IRHIRenderTarget* CreateRenderTarget(const FTexture2DDesc& Desc) = 0;
+		virtual IRHICommandList* CreateCommandList() = 0;
+		// submit the ended lists in order after the commands recorded so far, the frame commands carry on after them
+		// with the targets of the pass still bound, the pipeline and the shader parameters are set again
+		virtual void ExecuteCommandLists(IRHICommandList* const* CommandLists, uint32 Num) = 0;
 	};
 
 	extern IRHI* GRHI;
@@ -81,5 +108,29 @@ namespace ks
 		FRHIPipelineStateDesc Desc;
 	};
 
+	/*
+	* draw commands recorded apart from the frame commands, lists record on any thread and IRHI::ExecuteCommandLists
+	* submits them in order, so a pass splits its draws over one list per worker
+	* a list starts with the render target and depth stencil of the current pass bound and nothing else set
+	* the lists are recorded between BeginFrame and EndFrame, a list may record again once it is submitted
+	*/
+	class IRHICommandList
+	{
+	public:
+		virtual ~IRHICommandList() {}
+		virtual void Begin() = 0;
+		virtual void End() = 0;
+		virtual void SetPipelineState(IRHIPipelineState* PipelineState) = 0;
+		virtual void SetViewports(uint32 Num, const FViewPort* Viewports) = 0;
+		virtual void SetConstBuffer(IRHIConstBuffer1* ConstBuffer) = 0;
+		virtual void SetStructuredBuffer(IRHIConstBufferArray* ConstBufferArray) = 0;
+		virtual void SetTexture2D(IRHITexture2D* Texture2D) = 0;
+		// Data is copied to the upload memory of the frame, as IRHI::SetInstanceBuffer
+		virtual void SetInstanceBuffer(uint32 Slot, uint32 Stride, uint32 NumInstances, const void* Data) = 0;
+		// data uploaded by IRHI::UploadFrameData, shared by the lists of the frame
+		virtual void SetShaderResourceData(uint32 LocationIndex, const FRHIFrameData& FrameData) = 0;
+		virtual void DrawCommandInstanced(const IRHIDrawCommand* DrawCommand, uint32 NumInstances, uint32 FirstInstance) = 0;
+	};
+
 	
 }
\ No newline at end of file
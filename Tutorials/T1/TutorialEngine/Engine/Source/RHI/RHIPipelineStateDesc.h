@@ -11,6 +11,8 @@ namespace ks
 		EELEM_FORMAT ElemFormat{EELEM_FORMAT::UNKNOWN};
 		int32 InputSlot{-1};
 		int32 Stride{0};
+		// 0 steps per vertex, otherwise the element advances every InstanceStepRate instances
+		uint32 InstanceStepRate{0};
 	};
 
 	enum class EShaderType
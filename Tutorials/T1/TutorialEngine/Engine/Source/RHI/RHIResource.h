@@ -23,7 +23,15 @@ namespace ks
 		FViewPort ViewPort;
 		EELEM_FORMAT BackBufferFormat;
 		EELEM_FORMAT DepthBufferFormat;
+		// size of one shadow cascade, the atlas puts NumShadowCascades of them side by side
 		uint32_t ShadowMapSize{ 1024 };
+		uint32_t NumShadowCascades{ 4 };
+		// view depth the cascades cover
+		float ShadowDistance{ 200.f };
+		// no gpu, the null rhi checks the commands and drops them
+		bool bNullRHI{ false };
+		// log the visibility counts every StatsInterval frames, 0 never
+		uint32_t StatsInterval{ 0 };
 	};
 
 	struct FRenderPassDesc
@@ -39,6 +47,15 @@ namespace ks
 		int32_t Width;
 		int32_t Height;
 		EELEM_FORMAT Format{ EELEM_FORMAT::UNKNOWN };
+		uint32_t NumMips{ 1 };
+	};
+
+	/* initial data of one mip, pitches are in rows of texels or rows of 4x4 blocks */
+	struct FTextureMipData
+	{
+		const void* Data{ nullptr };
+		uint32_t RowPitch{ 0 };
+		uint32_t SlicePitch{ 0 };
 	};
 
 	struct FRenderTargetDesc
@@ -140,6 +157,34 @@ namespace ks
 		int32 LocationIndex{ -1 };
 	};
 
+	/*
+	* Count constant elements of ElemSize in one gpu resource, written in batches by IRHI::UpdateConstBufferArray
+	* the shaders read them as one structured buffer bound by IRHI::SetStructuredBuffer, the array takes a single view
+	* whatever its size
+	*/
+	class IRHIConstBufferArray
+	{
+	public:
+		IRHIConstBufferArray(uint32 InElemSize, uint32 InCount) :ElemSize(InElemSize), Count(InCount) {}
+		virtual ~IRHIConstBufferArray() = 0 {}
+		uint32 GetElemSize() const { return ElemSize; }
+		uint32 GetCount() const { return Count; }
+		void SetShaderResourceLocationIndex(int32 Index) { ShaderResourceLocationIndex = Index; }
+		int32 GetShaderResourceLocationIndex() const { return ShaderResourceLocationIndex; }
+	protected:
+		uint32 ElemSize{ 0 };
+		uint32 Count{ 0 };
+		int32 ShaderResourceLocationIndex{ -1 };
+	};
+
+	/* structured data in the upload memory of the frame, written once by IRHI::UploadFrameData and bound by any list of the frame */
+	struct FRHIFrameData
+	{
+		// gpu address of the first element, valid until the frame retires
+		uint64 Address{ 0 };
+		uint32 NumElems{ 0 };
+	};
+
 	class IRHIIndexBuffer1
 	{
 	public:
@@ -162,6 +207,13 @@ namespace ks
 		uint32 Size{ 0 };
 	};
 
+	/* the vertex and index buffers of a mesh resolved for its draws, built with the mesh and reused every frame */
+	class IRHIDrawCommand
+	{
+	public:
+		virtual ~IRHIDrawCommand() {}
+	};
+
 	class IRHIDepthStencilBuffer
 	{
 	public:
@@ -0,0 +1,194 @@
+#include "engine_pch.h"
+#include "Render/LightClusters.h"
+#include "Core/JobSystem.h"
+
+namespace ks
+{
+	namespace
+	{
+		constexpr uint32 NumSliceClusters{ FLightClusters::NumX * FLightClusters::NumY };
+
+		bool SphereIntersectsBox(const glm::vec3& Center, float Radius, const FBounds::FBox& Box)
+		{
+			const glm::vec3 Offset{ Center - glm::clamp(Center, Box.Min, Box.Max) };
+			return glm::dot(Offset, Offset) <= Radius * Radius;
+		}
+
+		// first and last tile covered by the ndc range, Num tiles across [-1, 1]
+		bool GetTileRange(float NdcMin, float NdcMax, uint32 Num, uint32& OutFirst, uint32& OutLast)
+		{
+			if (NdcMax < -1.f || NdcMin > 1.f)
+			{
+				return false;
+			}
+			const float First{ std::floor((NdcMin + 1.f) * 0.5f * Num) };
+			const float Last{ std::floor((NdcMax + 1.f) * 0.5f * Num) };
+			OutFirst = static_cast<uint32>(std::clamp(First, 0.f, float(Num - 1)));
+			OutLast = static_cast<uint32>(std::clamp(Last, 0.f, float(Num - 1)));
+			return true;
+		}
+	}
+
+	void FLightClusters::SetProjection(const glm::mat4& ProjTrans, float InZNear, float InZFar)
+	{
+		assert(InZNear > 0.f && InZFar > InZNear);
+		ProjScale = glm::vec2(ProjTrans[0][0], ProjTrans[1][1]);
+		ZNear = InZNear;
+		ZFar = InZFar;
+		const float LogDepthRatio{ std::log(ZFar / ZNear) };
+		DepthScaleBias = glm::vec2(NumSlices / LogDepthRatio, -(NumSlices * std::log(ZNear)) / LogDepthRatio);
+
+		ClusterBoxes.resize(NumClusters);
+		for (uint32 Slice = 0; Slice < NumSlices; ++Slice)
+		{
+			const float Depths[2]{ ZNear * std::pow(ZFar / ZNear, float(Slice) / NumSlices), ZNear * std::pow(ZFar / ZNear, float(Slice + 1) / NumSlices) };
+			for (uint32 Y = 0; Y < NumY; ++Y)
+			{
+				// tile rows go down the screen, ndc y goes up
+				const float NdcY[2]{ 1.f - 2.f * (Y + 1) / NumY, 1.f - 2.f * Y / NumY };
+				for (uint32 X = 0; X < NumX; ++X)
+				{
+					const float NdcX[2]{ -1.f + 2.f * X / NumX, -1.f + 2.f * (X + 1) / NumX };
+					FBounds::FBox& Box{ ClusterBoxes[Slice * NumSliceClusters + Y * NumX + X] };
+					Box.Min = glm::vec3(std::numeric_limits<float>::max());
+					Box.Max = glm::vec3(std::numeric_limits<float>::lowest());
+					for (float Depth : Depths)
+					{
+						for (uint32 Corner = 0; Corner < 4; ++Corner)
+						{
+							const glm::vec3 Point{ NdcX[Corner & 1] * Depth / ProjScale.x, NdcY[Corner >> 1] * Depth / ProjScale.y, Depth };
+							Box.Min = glm::min(Box.Min, Point);
+							Box.Max = glm::max(Box.Max, Point);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	void FLightClusters::Build(const glm::mat4& ViewTrans, const std::vector<glm::vec4>& LightSpheres, FJobSystem* JobSystem)
+	{
+		const auto StartTime{ std::chrono::steady_clock::now() };
+		// without a perspective projection every cluster is empty
+		if (ClusterBoxes.empty())
+		{
+			Ranges.assign(NumClusters, glm::uvec2(0));
+			LightIndices.clear();
+			Stats = FStats{};
+			return;
+		}
+		auto GetSlice = [this](float Depth) {
+			const float Slice{ std::floor(std::log(Depth) * DepthScaleBias.x + DepthScaleBias.y) };
+			return static_cast<uint32>(std::clamp(Slice, 0.f, float(NumSlices - 1)));
+		};
+		// the lights outside the depth range of the view touch no cluster
+		ViewLights.clear();
+		for (uint32 Light = 0; Light < LightSpheres.size(); ++Light)
+		{
+			const glm::vec4& Sphere{ LightSpheres[Light] };
+			const glm::vec4 Center{ ViewTrans * glm::vec4(glm::vec3(Sphere), 1.f) };
+			const float Depth{ -Center.z };
+			if (Depth + Sphere.w < ZNear || Depth - Sphere.w > ZFar)
+			{
+				continue;
+			}
+			ViewLights.push_back(FViewLight{ glm::vec3(Center.x, Center.y, Depth), Sphere.w, Light,
+				GetSlice(std::max(Depth - Sphere.w, ZNear)), GetSlice(std::min(Depth + Sphere.w, ZFar)) });
+		}
+
+		if (JobSystem)
+		{
+			JobSystem->ParallelFor(NumSlices, [this](uint32 Slice) { BuildSlice(Slice); });
+		}
+		else
+		{
+			for (uint32 Slice = 0; Slice < NumSlices; ++Slice)
+			{
+				BuildSlice(Slice);
+			}
+		}
+
+		// the slices back to back
+		Ranges.resize(NumClusters);
+		LightIndices.clear();
+		Stats.MaxClusterLights = 0;
+		for (uint32 Slice = 0; Slice < NumSlices; ++Slice)
+		{
+			const FSlice& SliceLights{ Slices[Slice] };
+			const uint32 SliceOffset{ static_cast<uint32>(LightIndices.size()) };
+			for (uint32 Cluster = 0; Cluster < NumSliceClusters; ++Cluster)
+			{
+				const glm::uvec2& Range{ SliceLights.Ranges[Cluster] };
+				Ranges[Slice * NumSliceClusters + Cluster] = glm::uvec2(SliceOffset + Range.x, Range.y);
+				Stats.MaxClusterLights = std::max(Stats.MaxClusterLights, Range.y);
+			}
+			LightIndices.insert(LightIndices.end(), SliceLights.LightIndices.begin(), SliceLights.LightIndices.end());
+		}
+		Stats.NumLights = static_cast<uint32>(ViewLights.size());
+		Stats.NumIndices = static_cast<uint32>(LightIndices.size());
+		Stats.BuildMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - StartTime).count();
+	}
+
+	void FLightClusters::BuildSlice(uint32 Slice)
+	{
+		FSlice& SliceLights{ Slices[Slice] };
+		SliceLights.Pairs.clear();
+		const FBounds::FBox* SliceBoxes{ &ClusterBoxes[Slice * NumSliceClusters] };
+		const float SliceNear{ SliceBoxes[0].Min.z };
+		const float SliceFar{ SliceBoxes[0].Max.z };
+		for (const FViewLight& Light : ViewLights)
+		{
+			if (Slice < Light.FirstSlice || Slice > Light.LastSlice)
+			{
+				continue;
+			}
+			const float Near{ std::max(SliceNear, Light.Center.z - Light.Radius) };
+			const float Far{ std::min(SliceFar, Light.Center.z + Light.Radius) };
+			if (Near > Far)
+			{
+				continue;
+			}
+			// x over depth is monotonic in depth, the screen rect of the sphere box is spanned by its values at the ends
+			const glm::vec2 Min{ glm::vec2(Light.Center) - Light.Radius };
+			const glm::vec2 Max{ glm::vec2(Light.Center) + Light.Radius };
+			const glm::vec2 NdcMin{ glm::min(Min / Near, Min / Far) * ProjScale };
+			const glm::vec2 NdcMax{ glm::max(Max / Near, Max / Far) * ProjScale };
+			uint32 FirstX, LastX, FirstY, LastY;
+			if (!GetTileRange(NdcMin.x, NdcMax.x, NumX, FirstX, LastX) || !GetTileRange(-NdcMax.y, -NdcMin.y, NumY, FirstY, LastY))
+			{
+				continue;
+			}
+			for (uint32 Y = FirstY; Y <= LastY; ++Y)
+			{
+				for (uint32 X = FirstX; X <= LastX; ++X)
+				{
+					const uint32 Cluster{ Y * NumX + X };
+					if (SphereIntersectsBox(Light.Center, Light.Radius, SliceBoxes[Cluster]))
+					{
+						SliceLights.Pairs.emplace_back(Cluster, Light.Light);
+					}
+				}
+			}
+		}
+
+		// counting sort by cluster, the lights of a cluster stay in light order
+		SliceLights.Ranges.assign(NumSliceClusters, glm::uvec2(0));
+		for (const auto& [Cluster, Light] : SliceLights.Pairs)
+		{
+			++SliceLights.Ranges[Cluster].y;
+		}
+		uint32 Offset{ 0 };
+		for (glm::uvec2& Range : SliceLights.Ranges)
+		{
+			Range.x = Offset;
+			Offset += Range.y;
+			Range.y = 0;
+		}
+		SliceLights.LightIndices.resize(SliceLights.Pairs.size());
+		for (const auto& [Cluster, Light] : SliceLights.Pairs)
+		{
+			glm::uvec2& Range{ SliceLights.Ranges[Cluster] };
+			SliceLights.LightIndices[Range.x + Range.y++] = Light;
+		}
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Core/CoreMinimal.h"
+#include "Core/Bounds.h"
+
+namespace ks
+{
+	class FJobSystem;
+
+	/*
+	* clustered light assignment of a view, the view frustum is cut into screen tiles and exponential depth slices
+	* the bounding spheres of the point and spot lights are binned to the clusters they touch, one job per slice,
+	* the base pass reads the light index range of the cluster of every pixel
+	*/
+	class FLightClusters
+	{
+	public:
+		static constexpr uint32 NumX{ 16 };
+		static constexpr uint32 NumY{ 9 };
+		static constexpr uint32 NumSlices{ 24 };
+		static constexpr uint32 NumClusters{ NumX * NumY * NumSlices };
+
+		struct FStats
+		{
+			// lights overlapping the view depth range
+			uint32 NumLights{ 0 };
+			uint32 NumIndices{ 0 };
+			uint32 MaxClusterLights{ 0 };
+			float BuildMs{ 0.f };
+		};
+
+		// cluster boxes of a symmetric perspective projection, depth in [ZNear, ZFar]
+		void SetProjection(const glm::mat4& ProjTrans, float ZNear, float ZFar);
+		// bin the world space bounding spheres, center in xyz and radius in w, slices run on JobSystem if not null
+		void Build(const glm::mat4& ViewTrans, const std::vector<glm::vec4>& LightSpheres, FJobSystem* JobSystem);
+		// slice of a view depth is log(depth) * x + y
+		glm::vec2 GetDepthScaleBias() const { return DepthScaleBias; }
+		// offset into the light indices and count per cluster, x fastest then y then slice
+		const std::vector<glm::uvec2>& GetRanges() const { return Ranges; }
+		const std::vector<uint32>& GetLightIndices() const { return LightIndices; }
+		const FStats& GetStats() const { return Stats; }
+	private:
+		/* a light in view space, depth grows away from the eye */
+		struct FViewLight
+		{
+			glm::vec3 Center;
+			float Radius;
+			uint32 Light;
+			uint32 FirstSlice;
+			uint32 LastSlice;
+		};
+		/* the lights of the clusters of one slice, offsets local to the slice */
+		struct FSlice
+		{
+			std::vector<glm::uvec2> Ranges;
+			std::vector<uint32> LightIndices;
+			// cluster of the slice and light, in light order
+			std::vector<std::pair<uint32, uint32>> Pairs;
+		};
+		void BuildSlice(uint32 Slice);
+
+		// projection scale of x and y, view space x times it over depth is ndc x
+		glm::vec2 ProjScale{ 1.f };
+		float ZNear{ 0.1f };
+		float ZFar{ 1000.f };
+		glm::vec2 DepthScaleBias{ 0.f };
+		// view space boxes, x right, y up and z the depth
+		std::vector<FBounds::FBox> ClusterBoxes;
+		std::vector<FViewLight> ViewLights;
+		std::array<FSlice, NumSlices> Slices;
+		std::vector<glm::uvec2> Ranges;
+		std::vector<uint32> LightIndices;
+		FStats Stats;
+	};
+}
@@ -50,6 +50,10 @@ namespace ks
 
 		CreateRHIVertBuffer(MeshData.PositionData, RHIVertBuffer1);
 		CreateRHIVertBuffer(MeshData.AttributeData, RHIAttrBuffer1);
+#endif
+#if RHIVERTBUFFER_V1 && RHIINDEXBUFFER_V1
+		const IRHIVertexBuffer1* VertexBuffers1[] = { RHIVertBuffer1.get(), RHIAttrBuffer1.get() };
+		RHIDrawCommand.reset(GRHI->CreateDrawCommand(VertexBuffers1, _countof(VertexBuffers1), RHIIndexBuffer1.get()));
 #endif
 	}
 
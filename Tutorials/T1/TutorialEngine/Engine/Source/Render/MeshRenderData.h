@@ -21,6 +21,10 @@ namespace ks
 #else
 		const IRHIVertexBuffer1* GetRHIVertexBuffer1() const { return RHIVertBuffer1.get(); }
 		const IRHIVertexBuffer1* GetRHIAttrBuffer1() const { return RHIAttrBuffer1.get(); }
+#endif
+#if RHIVERTBUFFER_V1 && RHIINDEXBUFFER_V1
+		// the buffers resolved once for the passes, every pass binds the position and attribute streams
+		const IRHIDrawCommand* GetRHIDrawCommand() const { return RHIDrawCommand.get(); }
 #endif
 	private:
 		void InitRHI();
@@ -36,6 +40,9 @@ namespace ks
 #else
 		std::unique_ptr<IRHIVertexBuffer1> RHIAttrBuffer1;
 		std::unique_ptr<IRHIVertexBuffer1> RHIVertBuffer1;
+#endif
+#if RHIVERTBUFFER_V1 && RHIINDEXBUFFER_V1
+		std::unique_ptr<IRHIDrawCommand> RHIDrawCommand;
 #endif
 	};
 }
\ No newline at end of file
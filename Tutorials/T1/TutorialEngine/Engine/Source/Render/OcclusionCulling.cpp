@@ -0,0 +1,293 @@
+#include "engine_pch.h"
+#include "Render/OcclusionCulling.h"
+#include "Core/Asset/MeshAsset.h"
+#include "Core/JobSystem.h"
+
+#include <emmintrin.h>
+
+namespace ks
+{
+	namespace
+	{
+		// vertices closer than this in clip w are treated as crossing the near plane
+		constexpr float MinClipW{ 1e-4f };
+
+		uint32 ReadIndex(const FMeshAttributeData& IndexData, uint32 i)
+		{
+			if (IndexData.DataType == EDATA_TYPE::UNSIGNED_INT)
+			{
+				return reinterpret_cast<const uint32*>(IndexData.Data.data())[i];
+			}
+			return reinterpret_cast<const uint16*>(IndexData.Data.data())[i];
+		}
+
+		float ElapsedMs(std::chrono::steady_clock::time_point StartTime)
+		{
+			return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - StartTime).count();
+		}
+	}
+
+	FOcclusionCuller::FOcclusionCuller()
+		:Depth(Width * Height, 1.f)
+		,HiZ((Width / BlockSize) * (Height / BlockSize), 1.f)
+		,TileBins(NumTilesX * NumTilesY)
+	{
+		static_assert(Width % TileWidth == 0 && Height % TileHeight == 0);
+		static_assert(TileWidth % BlockSize == 0 && TileHeight % BlockSize == 0 && BlockSize % 4 == 0);
+	}
+
+	void FOcclusionCuller::Begin(const glm::mat4& InViewProj)
+	{
+		BeginTime = std::chrono::steady_clock::now();
+		ViewProj = InViewProj;
+		Triangles.clear();
+		for (auto& TileBin : TileBins)
+		{
+			TileBin.clear();
+		}
+		Stats = FStats{};
+	}
+
+	void FOcclusionCuller::AddOccluder(const FMeshData& MeshData, const glm::mat4& WorldTrans)
+	{
+		const FMeshAttributeData& IndexData{ MeshData.IndexData };
+		const FMeshAttributeData& PositionData{ MeshData.PositionData };
+		if (PositionData.DataType != EDATA_TYPE::FLOAT || IndexData.Count < 3)
+		{
+			return;
+		}
+		const glm::mat4 Trans{ ViewProj * WorldTrans };
+		const uint32 FirstTriangle{ static_cast<uint32>(Triangles.size()) };
+		for (uint32 i = 0; i + 2 < IndexData.Count; i += 3)
+		{
+			FScreenTriangle Triangle;
+			bool bClipped{ false };
+			for (uint32 v = 0; v < 3 && !bClipped; ++v)
+			{
+				glm::vec3 Position;
+				memcpy(&Position, PositionData.Data.data() + ReadIndex(IndexData, i + v) * PositionData.Stride, sizeof(glm::vec3));
+				const glm::vec4 Clip{ Trans * glm::vec4(Position, 1.f) };
+				// dropping the triangle keeps the buffer conservative
+				bClipped = Clip.w < MinClipW || Clip.z < 0.f;
+				const float InvW{ 1.f / Clip.w };
+				Triangle.V[v] = glm::vec3((Clip.x * InvW * 0.5f + 0.5f) * Width, (0.5f - Clip.y * InvW * 0.5f) * Height, Clip.z * InvW);
+			}
+			if (bClipped)
+			{
+				continue;
+			}
+			const glm::vec3 Min{ glm::min(glm::min(Triangle.V[0], Triangle.V[1]), Triangle.V[2]) };
+			const glm::vec3 Max{ glm::max(glm::max(Triangle.V[0], Triangle.V[1]), Triangle.V[2]) };
+			if (Max.x < 0.f || Max.y < 0.f || Min.x >= Width || Min.y >= Height || Min.z > 1.f)
+			{
+				continue;
+			}
+			const uint32 TriangleIndex{ static_cast<uint32>(Triangles.size()) };
+			Triangles.push_back(Triangle);
+			const uint32 TileX0{ static_cast<uint32>(std::max(Min.x, 0.f)) / TileWidth };
+			const uint32 TileY0{ static_cast<uint32>(std::max(Min.y, 0.f)) / TileHeight };
+			const uint32 TileX1{ std::min(static_cast<uint32>(Max.x) / TileWidth, NumTilesX - 1) };
+			const uint32 TileY1{ std::min(static_cast<uint32>(Max.y) / TileHeight, NumTilesY - 1) };
+			for (uint32 TileY = TileY0; TileY <= TileY1; ++TileY)
+			{
+				for (uint32 TileX = TileX0; TileX <= TileX1; ++TileX)
+				{
+					TileBins[TileY * NumTilesX + TileX].push_back(TriangleIndex);
+				}
+			}
+		}
+		++Stats.NumOccluders;
+		Stats.NumOccluderTriangles += static_cast<uint32>(Triangles.size()) - FirstTriangle;
+	}
+
+	void FOcclusionCuller::Rasterize(FJobSystem* JobSystem)
+	{
+		const uint32 NumTiles{ NumTilesX * NumTilesY };
+		if (JobSystem)
+		{
+			JobSystem->ParallelFor(NumTiles, [this](uint32 Tile) { RasterizeTile(Tile); });
+		}
+		else
+		{
+			for (uint32 Tile = 0; Tile < NumTiles; ++Tile)
+			{
+				RasterizeTile(Tile);
+			}
+		}
+		Stats.RasterMs = ElapsedMs(BeginTime);
+	}
+
+	void FOcclusionCuller::RasterizeTile(uint32 Tile)
+	{
+		const uint32 TileX0{ (Tile % NumTilesX) * TileWidth };
+		const uint32 TileY0{ (Tile / NumTilesX) * TileHeight };
+		for (uint32 y = TileY0; y < TileY0 + TileHeight; ++y)
+		{
+			std::fill_n(Depth.data() + y * Width + TileX0, TileWidth, 1.f);
+		}
+
+		const __m128 Zero{ _mm_setzero_ps() };
+		const __m128 PixelOffsets{ _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f) };
+		for (uint32 TriangleIndex : TileBins[Tile])
+		{
+			glm::vec3 V0{ Triangles[TriangleIndex].V[0] };
+			glm::vec3 V1{ Triangles[TriangleIndex].V[1] };
+			glm::vec3 V2{ Triangles[TriangleIndex].V[2] };
+			float Area{ (V1.x - V0.x) * (V2.y - V0.y) - (V1.y - V0.y) * (V2.x - V0.x) };
+			if (std::abs(Area) < 1e-6f)
+			{
+				continue;
+			}
+			// both windings are accepted, make the area positive
+			if (Area < 0.f)
+			{
+				std::swap(V1, V2);
+				Area = -Area;
+			}
+			// edge functions E(p) = A * x + B * y + C, positive inside
+			auto EdgeSetup = [](const glm::vec3& Va, const glm::vec3& Vb, float& A, float& B, float& C) {
+				A = -(Vb.y - Va.y);
+				B = Vb.x - Va.x;
+				C = -A * Va.x - B * Va.y;
+			};
+			float A12, B12, C12, A20, B20, C20, A01, B01, C01;
+			EdgeSetup(V1, V2, A12, B12, C12);
+			EdgeSetup(V2, V0, A20, B20, C20);
+			EdgeSetup(V0, V1, A01, B01, C01);
+			// depth plane from the barycentrics, the weight of V1 is E20 / Area and of V2 is E01 / Area
+			const float InvArea{ 1.f / Area };
+			const float ZA{ ((V1.z - V0.z) * A20 + (V2.z - V0.z) * A01) * InvArea };
+			const float ZB{ ((V1.z - V0.z) * B20 + (V2.z - V0.z) * B01) * InvArea };
+			const float ZC{ V0.z + ((V1.z - V0.z) * C20 + (V2.z - V0.z) * C01) * InvArea };
+
+			const float MinX{ std::min(std::min(V0.x, V1.x), V2.x) };
+			const float MaxX{ std::max(std::max(V0.x, V1.x), V2.x) };
+			const float MinY{ std::min(std::min(V0.y, V1.y), V2.y) };
+			const float MaxY{ std::max(std::max(V0.y, V1.y), V2.y) };
+			const uint32 X0{ std::max(static_cast<uint32>(std::max(MinX, 0.f)), TileX0) & ~3u };
+			const uint32 X1{ std::min(static_cast<uint32>(std::max(MaxX + 1.f, 0.f)), TileX0 + TileWidth) };
+			const uint32 Y0{ std::max(static_cast<uint32>(std::max(MinY, 0.f)), TileY0) };
+			const uint32 Y1{ std::min(static_cast<uint32>(std::max(MaxY + 1.f, 0.f)), TileY0 + TileHeight) };
+			for (uint32 y = Y0; y < Y1; ++y)
+			{
+				const float PixelY{ y + 0.5f };
+				const __m128 RowE12{ _mm_set1_ps(B12 * PixelY + C12) };
+				const __m128 RowE20{ _mm_set1_ps(B20 * PixelY + C20) };
+				const __m128 RowE01{ _mm_set1_ps(B01 * PixelY + C01) };
+				const __m128 RowZ{ _mm_set1_ps(ZB * PixelY + ZC) };
+				float* Row{ Depth.data() + y * Width };
+				for (uint32 x = X0; x < X1; x += 4)
+				{
+					const __m128 PixelX{ _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), PixelOffsets) };
+					const __m128 E12{ _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A12), PixelX), RowE12) };
+					const __m128 E20{ _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A20), PixelX), RowE20) };
+					const __m128 E01{ _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A01), PixelX), RowE01) };
+					const __m128 Inside{ _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(E12, Zero), _mm_cmpge_ps(E20, Zero)), _mm_cmpge_ps(E01, Zero)) };
+					if (_mm_movemask_ps(Inside) == 0)
+					{
+						continue;
+					}
+					const __m128 Z{ _mm_add_ps(_mm_mul_ps(_mm_set1_ps(ZA), PixelX), RowZ) };
+					const __m128 Old{ _mm_loadu_ps(Row + x) };
+					const __m128 New{ _mm_or_ps(_mm_and_ps(Inside, _mm_min_ps(Old, Z)), _mm_andnot_ps(Inside, Old)) };
+					_mm_storeu_ps(Row + x, New);
+				}
+			}
+		}
+
+		// farthest depth of each block of the tile
+		constexpr uint32 NumBlocksX{ Width / BlockSize };
+		for (uint32 BlockY = TileY0 / BlockSize; BlockY < (TileY0 + TileHeight) / BlockSize; ++BlockY)
+		{
+			for (uint32 BlockX = TileX0 / BlockSize; BlockX < (TileX0 + TileWidth) / BlockSize; ++BlockX)
+			{
+				__m128 MaxDepth{ _mm_setzero_ps() };
+				for (uint32 y = BlockY * BlockSize; y < (BlockY + 1) * BlockSize; ++y)
+				{
+					const float* Row{ Depth.data() + y * Width + BlockX * BlockSize };
+					for (uint32 x = 0; x < BlockSize; x += 4)
+					{
+						MaxDepth = _mm_max_ps(MaxDepth, _mm_loadu_ps(Row + x));
+					}
+				}
+				MaxDepth = _mm_max_ps(MaxDepth, _mm_shuffle_ps(MaxDepth, MaxDepth, _MM_SHUFFLE(1, 0, 3, 2)));
+				MaxDepth = _mm_max_ps(MaxDepth, _mm_shuffle_ps(MaxDepth, MaxDepth, _MM_SHUFFLE(2, 3, 0, 1)));
+				HiZ[BlockY * NumBlocksX + BlockX] = _mm_cvtss_f32(MaxDepth);
+			}
+		}
+	}
+
+	bool FOcclusionCuller::IsOccluded(const FBounds::FBox& Box) const
+	{
+		glm::vec2 ScreenMin{ std::numeric_limits<float>::max() };
+		glm::vec2 ScreenMax{ std::numeric_limits<float>::lowest() };
+		float NearestDepth{ 1.f };
+		for (uint32 Corner = 0; Corner < 8; ++Corner)
+		{
+			const glm::vec3 Position{ Corner & 1 ? Box.Max.x : Box.Min.x, Corner & 2 ? Box.Max.y : Box.Min.y, Corner & 4 ? Box.Max.z : Box.Min.z };
+			const glm::vec4 Clip{ ViewProj * glm::vec4(Position, 1.f) };
+			if (Clip.w < MinClipW || Clip.z < 0.f)
+			{
+				return false;
+			}
+			const float InvW{ 1.f / Clip.w };
+			const glm::vec2 Screen{ (Clip.x * InvW * 0.5f + 0.5f) * Width, (0.5f - Clip.y * InvW * 0.5f) * Height };
+			ScreenMin = glm::min(ScreenMin, Screen);
+			ScreenMax = glm::max(ScreenMax, Screen);
+			NearestDepth = std::min(NearestDepth, Clip.z * InvW);
+		}
+		if (ScreenMax.x < 0.f || ScreenMax.y < 0.f || ScreenMin.x >= Width || ScreenMin.y >= Height)
+		{
+			return false;
+		}
+		constexpr uint32 NumBlocksX{ Width / BlockSize };
+		const uint32 BlockX0{ static_cast<uint32>(std::max(ScreenMin.x, 0.f)) / BlockSize };
+		const uint32 BlockY0{ static_cast<uint32>(std::max(ScreenMin.y, 0.f)) / BlockSize };
+		const uint32 BlockX1{ std::min(static_cast<uint32>(ScreenMax.x) / BlockSize, NumBlocksX - 1) };
+		const uint32 BlockY1{ std::min(static_cast<uint32>(ScreenMax.y) / BlockSize, Height / BlockSize - 1) };
+		for (uint32 BlockY = BlockY0; BlockY <= BlockY1; ++BlockY)
+		{
+			for (uint32 BlockX = BlockX0; BlockX <= BlockX1; ++BlockX)
+			{
+				if (NearestDepth <= HiZ[BlockY * NumBlocksX + BlockX])
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	void FOcclusionCuller::CullVisible(const std::vector<FBounds::FBox>& Boxes, std::vector<uint32>& InOutVisible, FJobSystem* JobSystem)
+	{
+		const auto StartTime{ std::chrono::steady_clock::now() };
+		const uint32 NumVisible{ static_cast<uint32>(InOutVisible.size()) };
+		Occluded.assign(NumVisible, 0);
+		auto TestOccludee = [&](uint32 i) {
+			Occluded[i] = IsOccluded(Boxes[InOutVisible[i]]) ? 1 : 0;
+		};
+		if (JobSystem)
+		{
+			JobSystem->ParallelFor(NumVisible, TestOccludee, 64);
+		}
+		else
+		{
+			for (uint32 i = 0; i < NumVisible; ++i)
+			{
+				TestOccludee(i);
+			}
+		}
+		uint32 NumKept{ 0 };
+		for (uint32 i = 0; i < NumVisible; ++i)
+		{
+			if (!Occluded[i])
+			{
+				InOutVisible[NumKept++] = InOutVisible[i];
+			}
+		}
+		InOutVisible.resize(NumKept);
+		Stats.NumTested = NumVisible;
+		Stats.NumOccluded = NumVisible - NumKept;
+		Stats.TestMs = ElapsedMs(StartTime);
+	}
+}
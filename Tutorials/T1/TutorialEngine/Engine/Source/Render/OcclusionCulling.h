@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Core/CoreMinimal.h"
+#include "Core/Bounds.h"
+
+namespace ks
+{
+	class FJobSystem;
+	struct FMeshData;
+
+	/*
+	* software occlusion culling on a small depth buffer
+	* the largest visible meshes are rasterized as occluders with SSE, one job per screen tile,
+	* each tile then reduces its depth to a hierarchical level of 8x8 blocks holding the farthest depth
+	* an occludee is hidden if the nearest depth of its box is behind every block its screen rect covers
+	*/
+	class FOcclusionCuller
+	{
+	public:
+		static constexpr uint32 Width{ 256 };
+		static constexpr uint32 Height{ 128 };
+		static constexpr uint32 TileWidth{ 64 };
+		static constexpr uint32 TileHeight{ 32 };
+		static constexpr uint32 BlockSize{ 8 };
+
+		struct FStats
+		{
+			uint32 NumOccluders{ 0 };
+			uint32 NumOccluderTriangles{ 0 };
+			uint32 NumTested{ 0 };
+			uint32 NumOccluded{ 0 };
+			float RasterMs{ 0.f };
+			float TestMs{ 0.f };
+		};
+
+		FOcclusionCuller();
+		// clear the depth buffer for a new view
+		void Begin(const glm::mat4& ViewProj);
+		// transform the triangles of the mesh and bin them to the tiles, triangles crossing the near plane are skipped
+		void AddOccluder(const FMeshData& MeshData, const glm::mat4& WorldTrans);
+		// rasterize the binned triangles and build the hierarchical depth, tiles run on JobSystem if not null
+		void Rasterize(FJobSystem* JobSystem);
+		// conservative, false if the box crosses the near plane or leaves the screen
+		bool IsOccluded(const FBounds::FBox& Box) const;
+		// remove the occluded indices from InOutVisible, Boxes is indexed by the visible indices
+		void CullVisible(const std::vector<FBounds::FBox>& Boxes, std::vector<uint32>& InOutVisible, FJobSystem* JobSystem);
+		const FStats& GetStats() const { return Stats; }
+	private:
+		static constexpr uint32 NumTilesX{ Width / TileWidth };
+		static constexpr uint32 NumTilesY{ Height / TileHeight };
+		// screen space vertices, x and y in pixels, z the depth in [0, 1]
+		struct FScreenTriangle
+		{
+			glm::vec3 V[3];
+		};
+		void RasterizeTile(uint32 Tile);
+
+		glm::mat4 ViewProj{ 1.f };
+		std::vector<float> Depth;
+		// farthest depth of each BlockSize x BlockSize block
+		std::vector<float> HiZ;
+		std::vector<FScreenTriangle> Triangles;
+		// triangle indices overlapping each tile
+		std::vector<std::vector<uint32>> TileBins;
+		std::vector<uint8> Occluded;
+		FStats Stats;
+		std::chrono::steady_clock::time_point BeginTime;
+	};
+}
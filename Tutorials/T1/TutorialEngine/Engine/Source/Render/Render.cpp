@@ -6,15 +6,80 @@
 #include "Core/Asset/MeshAsset.h"
 #include "Core/Asset/MaterialAsset.h"
 #include "Core/Component/MeshComponent.h"
+#include "Core/JobSystem.h"
 #include "RHI/RHI.h"
 
 namespace ks
 {
+	namespace
+	{
+		// occluders per frame and their total triangle budget
+		constexpr uint32 MaxOccluders{ 32 };
+		constexpr uint32 MaxOccluderTriangles{ 64 * 1024 };
+		// projected radius over view depth, smaller primitives hide too little to pay for their triangles
+		constexpr float MinOccluderSize{ 0.1f };
+		// initial number of primitive constant buffers, doubled when outgrown
+		constexpr uint32 MinPrimitiveConstBuffers{ 256 };
+		// blend of the logarithmic and the uniform cascade splits, 1 is fully logarithmic
+		constexpr float CascadeSplitLambda{ 0.75f };
+		// the light box of a cascade is widened by this fraction of its radius and moves in steps of up to twice it,
+		// the cached static casters stay valid while the camera moves within a step
+		constexpr float CascadeCacheMargin{ 0.125f };
+		// batch of a primitive not yet batched
+		constexpr uint32 InvalidBatch{ 0xFFFFFFFF };
+
+		template<typename KeyType>
+		uint32 AcquireSortId(std::map<KeyType, FSortId>& Ids, std::vector<uint32>& FreeIds, KeyType Key)
+		{
+			FSortId& SortId{ Ids[Key] };
+			if (SortId.NumBatches++ == 0)
+			{
+				// without free ids every id below the new entry is in use
+				SortId.Id = FreeIds.empty() ? static_cast<uint32>(Ids.size() - 1) : FreeIds.back();
+				if (!FreeIds.empty())
+				{
+					FreeIds.pop_back();
+				}
+			}
+			return SortId.Id;
+		}
+
+		template<typename KeyType>
+		void ReleaseSortId(std::map<KeyType, FSortId>& Ids, std::vector<uint32>& FreeIds, KeyType Key)
+		{
+			auto It{ Ids.find(Key) };
+			assert(It != Ids.end() && It->second.NumBatches > 0);
+			if (--It->second.NumBatches == 0)
+			{
+				FreeIds.push_back(It->second.Id);
+				Ids.erase(It);
+			}
+		}
+	}
+
 	FRenderPrimitive::FRenderPrimitive(FStaticMeshComponent* MeshComponent)
 		:RenderData(MeshComponent->GetStaticMesh()->GetRenderData())
+		,Material(MeshComponent->GetStaticMesh()->GetMaterialAsset())
+		,MeshData(&MeshComponent->GetStaticMesh()->GetMeshData())
+		,WorldTrans(MeshComponent->GetWorldTrans())
 		,Bounds(MeshComponent->GetBounds())
 	{
-		FPrimitiveConstBufferParameter ConstBufferParameter;
+		UpdateConstBufferParameter(MeshComponent);
+	}
+
+	void FRenderPrimitive::UpdateRenderData(FStaticMeshComponent* MeshComponent)
+	{
+		RenderData = MeshComponent->GetStaticMesh()->GetRenderData();
+		Material = MeshComponent->GetStaticMesh()->GetMaterialAsset();
+		MeshData = &MeshComponent->GetStaticMesh()->GetMeshData();
+		WorldTrans = MeshComponent->GetWorldTrans();
+		Bounds = MeshComponent->GetBounds();
+		UpdateConstBufferParameter(MeshComponent);
+	}
+
+	void FRenderPrimitive::UpdateConstBufferParameter(FStaticMeshComponent* MeshComponent)
+	{
+		ConstBufferParameter = FPrimitiveConstBufferParameter{};
 		ConstBufferParameter.WorldTrans = MeshComponent->GetWorldTrans();
 		ConstBufferParameter.InvTranspWorldTrans = glm::affineInverse(ConstBufferParameter.WorldTrans);
 		ConstBufferParameter.WorldTrans = glm::transpose(ConstBufferParameter.WorldTrans);
@@ -32,9 +97,6 @@ namespace ks
 		PrimitiveConstBuffer = std::shared_ptr<TConstBuffer<FPrimitiveConstBufferParameter>>(
 			TConstBuffer<FPrimitiveConstBufferParameter>::CreateConstBuffer(ConstBufferParameter));
 		PrimitiveConstBuffer->GetRHIConstBuffer()->SetLocationIndex(0);
-#else
-		PrimitiveConstBuffer1.reset(GRHI->CreateConstBuffer1(&ConstBufferParameter, sizeof(FPrimitiveConstBufferParameter)));
-		PrimitiveConstBuffer1->SetLocationIndex(0);
 #endif
 	}
 
@@ -43,75 +105,762 @@ namespace ks
 	FRenderScene::FRenderScene(FScene* InScene)
 		:Scene(InScene)
 	{
-		// base pass const buffer
-		FViewConstBufferParameter ViewConstBufferParm;
+		if (Scene->GetCamera().IsValid())
+		{
+			AddView(FSceneViewDesc{ Scene->GetCamera() });
+		}
+		// the cascades side by side in the shadow atlas
+		ShadowCascades.resize(std::clamp(GRHIConfig.NumShadowCascades, 1u, MaxShadowCascades));
+		for (uint32 Cascade = 0; Cascade < ShadowCascades.size(); ++Cascade)
+		{
+			ShadowCascades[Cascade].ViewPort = { Cascade * GRHIConfig.ShadowMapSize, 0, GRHIConfig.ShadowMapSize, GRHIConfig.ShadowMapSize };
+		}
+		UpdateView();
+	}
+
+	uint32 FRenderScene::AddView(const FSceneViewDesc& Desc)
+	{
+		Views.emplace_back();
+		SetViewDesc(static_cast<uint32>(Views.size() - 1), Desc);
+		return static_cast<uint32>(Views.size() - 1);
+	}
+
+	void FRenderScene::SetViewDesc(uint32 ViewIndex, const FSceneViewDesc& Desc)
+	{
+		assert(ViewIndex < Views.size() && Desc.Camera.IsValid());
+		FSceneView& View{ Views[ViewIndex] };
+		View.Desc = Desc;
+		// pixels of the rectangle in the scene color, never empty
+		const FViewPort& Target{ GRHIConfig.ViewPort };
+		View.ViewPort.TopLeftX = static_cast<uint32>(Desc.Rect.x * Target.Width);
+		View.ViewPort.TopLeftY = static_cast<uint32>(Desc.Rect.y * Target.Height);
+		View.ViewPort.Width = std::max(static_cast<uint32>(Desc.Rect.z * Target.Width), 1u);
+		View.ViewPort.Height = std::max(static_cast<uint32>(Desc.Rect.w * Target.Height), 1u);
+		if (Desc.bOcclusionCulling && !View.OcclusionCuller)
+		{
+			View.OcclusionCuller = std::make_unique<FOcclusionCuller>();
+		}
+		else if (!Desc.bOcclusionCulling)
+		{
+			View.OcclusionCuller.reset();
+		}
+		// the constants follow on the next update
+		View.LastProjTrans = glm::mat4(0.f);
+	}
 
-		// camera-view projection matrix
-		// todo : move to ticking
+	void FRenderScene::RemoveView(uint32 ViewIndex)
+	{
+		assert(ViewIndex < Views.size());
+		// the frames in flight may still bind the constants of the view
+		GRHI->FlushRenderingCommands();
+		Views.erase(Views.begin() + ViewIndex);
+	}
+
+	glm::mat4 FRenderScene::GetViewProjection(const FSceneView& View) const
+	{
+		// the projection follows the aspect of the view rectangle
+		return Scene->GetProjectionTrans(View.Desc.Camera, static_cast<float>(View.ViewPort.Width) / View.ViewPort.Height);
+	}
+
+	void FRenderScene::UpdateView()
+	{
+		const FSceneGraph& SceneGraph{ Scene->GetSceneGraph() };
+		const FSceneNodeHandle LightNode{ Scene->GetLightNode() };
+		assert(LightNode.IsValid());
+		// the cascades follow the light, the scene bounds and the main view, shared by the constants of every view
+		const FBounds& SceneBounds{ Scene->GetSceneBounds() };
+		const bool bSceneBoxChanged{ SceneBounds.Box.Min != LastSceneBox.Min || SceneBounds.Box.Max != LastSceneBox.Max };
+		bool bShadowDirty{ bViewDirty || bSceneBoxChanged || SceneGraph.HasMoved(LightNode) };
+		if (!bShadowDirty && !Views.empty())
 		{
-			glm::mat4 CameraView{ Scene->GetViewTrans() };
-			glm::mat4 PersProj{ Scene->GetProjectionTrans() };
-			ViewConstBufferParm.ViewProjTrans = glm::transpose(PersProj * CameraView);
+			bShadowDirty = SceneGraph.HasMoved(Views[0].Desc.Camera) || GetViewProjection(Views[0]) != Views[0].LastProjTrans;
 		}
-		// directional light direction and intensity
-		// todo : move to ticking
+		if (bShadowDirty)
 		{
+			bViewDirty = false;
+			LastSceneBox = SceneBounds.Box;
+
+			// directional light direction and intensity
 			glm::vec3 LightDir;
 			float LightIns;
-			auto LightNode = Scene->GetLightNode();
-			assert(LightNode && LightNode->LightComponent);
-			glm::mat4 LightToWorld = LightNode->GetWorldTrans();
+			glm::mat4 LightToWorld = SceneGraph.GetWorldTrans(LightNode);
 			glm::mat4 WorldToLight = glm::affineInverse(LightToWorld);
-			LightDir = glm::normalize(glm::vec3(LightToWorld[2]));
-			LightIns = LightNode->LightComponent->GetIntensity();
-			ViewConstBufferParm.D_LightDirectionAndInstensity = glm::vec4(LightDir, LightIns);
-
-			const auto& SceneBounds{ Scene->GetSceneBounds() };
-			const float& SceneBoundsRadius{ SceneBounds.Sphere.Radius };
-			glm::vec4 Center = WorldToLight * glm::vec4(SceneBounds.Sphere.Center, 1.f);
-			glm::mat4 OrthoProj = glm::ortho(
-				Center.x-SceneBoundsRadius, Center.x+SceneBoundsRadius,
-				Center.y-SceneBoundsRadius, Center.y+SceneBoundsRadius,
-				Center.z-SceneBoundsRadius, Center.z+SceneBoundsRadius);
-			ViewConstBufferParm.LightProj = glm::transpose(OrthoProj * WorldToLight);
-
-			glm::mat4 NDC2Tex(
-				0.5f, 0.0f, 0.0f, 0.0f,
-				0.0f, -0.5f, 0.0f, 0.0f,
-				0.0f, 0.0f, 1.0f, 0.0f,
-				0.5f, 0.5f, 0.0f, 1.0f
-			);
-			ViewConstBufferParm.LightProjTex = glm::transpose(NDC2Tex * OrthoProj * WorldToLight);
-		}
-
-		// get look direction
-		// todo : move to ticking
-		{
-			FSceneNode* Camera{ Scene->GetCamera() };
-			glm::mat4 Eye2World{ Camera->GetWorldTrans() };
-			ViewConstBufferParm.EyePos = Eye2World[3];
+			Scene->GetDirectionalLight(LightDir, LightIns);
+			LightParameters.D_LightDirectionAndInstensity = glm::vec4(LightDir, LightIns);
+			UpdateShadowCascades(WorldToLight);
 		}
 
+		for (FSceneView& View : Views)
+		{
+			const FSceneNodeHandle Camera{ View.Desc.Camera };
+			const glm::mat4 PersProj{ GetViewProjection(View) };
+			const bool bProjChanged{ PersProj != View.LastProjTrans };
+			if (!bShadowDirty && !bProjChanged && !SceneGraph.HasMoved(Camera))
+			{
+				continue;
+			}
+			View.LastProjTrans = PersProj;
+			const FCameraInfo& CameraInfo{ Scene->GetCameraComponent(Camera)->GetCameraInfo() };
+			if (bProjChanged && CameraInfo.Type == ECameraType::PERSPECTIVE)
+			{
+				View.LightClusters.SetProjection(PersProj, CameraInfo.CameraData.PersCamera.ZNear, CameraInfo.CameraData.PersCamera.ZFar);
+			}
+
+			FViewConstBufferParameter ViewConstBufferParm{ LightParameters };
+			// camera-view projection matrix
+			View.ViewTrans = Scene->GetViewTrans(Camera);
+			View.ViewProjTrans = PersProj * View.ViewTrans;
+			ViewConstBufferParm.ViewProjTrans = glm::transpose(View.ViewProjTrans);
+			// get look direction
+			glm::mat4 Eye2World{ SceneGraph.GetWorldTrans(Camera) };
+			ViewConstBufferParm.EyePos = Eye2World[3];
+			// the cluster of a pixel, the view looks down -z
+			ViewConstBufferParm.ViewDepthRow = -glm::row(View.ViewTrans, 2);
+			ViewConstBufferParm.ClusterRect = glm::vec4(View.ViewPort.TopLeftX, View.ViewPort.TopLeftY,
+				float(FLightClusters::NumX) / View.ViewPort.Width, float(FLightClusters::NumY) / View.ViewPort.Height);
+			ViewConstBufferParm.ClusterDepth = glm::vec4(View.LightClusters.GetDepthScaleBias(), 0.f, 0.f);
+			ViewConstBufferParm.ClusterGrid = glm::uvec4(FLightClusters::NumX, FLightClusters::NumY, FLightClusters::NumSlices, 0u);
 
 #if !RHICONSTBUFFER_V1
-		BasePassConstBuffer = std::shared_ptr<TConstBuffer<FViewConstBufferParameter>>(
-			TConstBuffer<FViewConstBufferParameter>::CreateConstBuffer(ViewConstBufferParm));
-		BasePassConstBuffer->GetRHIConstBuffer()->SetLocationIndex(1);
+			View.ConstBuffer = std::shared_ptr<TConstBuffer<FViewConstBufferParameter>>(
+				TConstBuffer<FViewConstBufferParameter>::CreateConstBuffer(ViewConstBufferParm));
+			View.ConstBuffer->GetRHIConstBuffer()->SetLocationIndex(1);
 #else
-		BasePassConstBuffer1.reset(GRHI->CreateConstBuffer1(&ViewConstBufferParm, sizeof(FViewConstBufferParameter)));
-		BasePassConstBuffer1->SetLocationIndex(1);
+			// the rhi buffers the constants per frame in flight, the frames still on the gpu keep their copy
+			if (View.ConstBuffer)
+			{
+				View.ConstBuffer->SetData(&ViewConstBufferParm, sizeof(FViewConstBufferParameter));
+				continue;
+			}
+			View.ConstBuffer.reset(GRHI->CreateConstBuffer1(&ViewConstBufferParm, sizeof(FViewConstBufferParameter)));
+			View.ConstBuffer->SetLocationIndex(1);
 #endif
+		}
+	}
+
+	void FRenderScene::UpdateShadowCascades(const glm::mat4& WorldToLight)
+	{
+		const uint32 NumCascades{ static_cast<uint32>(ShadowCascades.size()) };
+		// without a perspective main view nothing is shadowed
+		LightParameters.ShadowCascades = glm::uvec4(0u);
+		if (Views.empty())
+		{
+			return;
+		}
+		const FSceneView& MainView{ Views[0] };
+		const FCameraInfo& CameraInfo{ Scene->GetCameraComponent(MainView.Desc.Camera)->GetCameraInfo() };
+		if (CameraInfo.Type != ECameraType::PERSPECTIVE)
+		{
+			return;
+		}
+		const glm::mat4 Proj{ GetViewProjection(MainView) };
+		const glm::mat4 EyeToWorld{ Scene->GetSceneGraph().GetWorldTrans(MainView.Desc.Camera) };
+		const float ZNear{ CameraInfo.CameraData.PersCamera.ZNear };
+		const float ZFar{ std::max(std::min(CameraInfo.CameraData.PersCamera.ZFar, GRHIConfig.ShadowDistance), ZNear * 2.f) };
+		// half diagonal of the view slice over its depth
+		const float SliceSlope{ std::sqrt(1.f / (Proj[0][0] * Proj[0][0]) + 1.f / (Proj[1][1] * Proj[1][1])) };
+
+		// the light box reaches back to the farthest caster of the scene toward the light
+		const FBounds::FBox& SceneBox{ Scene->GetSceneBounds().Box };
+		float SceneLightMaxZ{ std::numeric_limits<float>::lowest() };
+		for (uint32 Corner = 0; Corner < 8; ++Corner)
+		{
+			const glm::vec3 Point{ Corner & 1 ? SceneBox.Max.x : SceneBox.Min.x, Corner & 2 ? SceneBox.Max.y : SceneBox.Min.y, Corner & 4 ? SceneBox.Max.z : SceneBox.Min.z };
+			SceneLightMaxZ = std::max(SceneLightMaxZ, (WorldToLight * glm::vec4(Point, 1.f)).z);
+		}
+
+		const glm::mat4 NDC2Tex(
+			0.5f, 0.0f, 0.0f, 0.0f,
+			0.0f, -0.5f, 0.0f, 0.0f,
+			0.0f, 0.0f, 1.0f, 0.0f,
+			0.5f, 0.5f, 0.0f, 1.0f
+		);
+		float SliceNear{ ZNear };
+		for (uint32 Cascade = 0; Cascade < NumCascades; ++Cascade)
+		{
+			FShadowCascade& ShadowCascade{ ShadowCascades[Cascade] };
+			const float Fraction{ float(Cascade + 1) / NumCascades };
+			const float SliceFar{ glm::mix(ZNear + (ZFar - ZNear) * Fraction, ZNear * std::pow(ZFar / ZNear, Fraction), CascadeSplitLambda) };
+
+			// the smallest sphere around the slice centered on the view axis, it does not change as the camera turns
+			const float NearHalfDiagonal{ SliceNear * SliceSlope };
+			const float FarHalfDiagonal{ SliceFar * SliceSlope };
+			const float CenterDepth{ std::clamp((SliceFar * SliceFar + FarHalfDiagonal * FarHalfDiagonal - SliceNear * SliceNear - NearHalfDiagonal * NearHalfDiagonal) /
+				(2.f * (SliceFar - SliceNear)), SliceNear, SliceFar) };
+			float Radius{ std::sqrt(std::max((CenterDepth - SliceNear) * (CenterDepth - SliceNear) + NearHalfDiagonal * NearHalfDiagonal,
+				(SliceFar - CenterDepth) * (SliceFar - CenterDepth) + FarHalfDiagonal * FarHalfDiagonal)) };
+			Radius = std::ceil(Radius * 16.f) / 16.f;
+
+			// snap the box to steps of whole texels, the shadow edges do not crawl and the box
+			// only moves, which redraws the static cache, when the slice center crosses a step
+			const float Extent{ Radius * (1.f + CascadeCacheMargin) };
+			const float TexelSize{ 2.f * Extent / GRHIConfig.ShadowMapSize };
+			const float Step{ std::max(std::floor(2.f * Radius * CascadeCacheMargin / TexelSize), 1.f) * TexelSize };
+			const glm::vec3 Center{ glm::round(glm::vec3(WorldToLight * EyeToWorld * glm::vec4(0.f, 0.f, -CenterDepth, 1.f)) / Step) * Step };
+			// the light looks down -z, near and far are distances along it
+			const float MaxZ{ std::max(Center.z + Extent, SceneLightMaxZ) };
+			const glm::mat4 OrthoProj{ glm::ortho(Center.x - Extent, Center.x + Extent, Center.y - Extent, Center.y + Extent, -MaxZ, -(Center.z - Extent)) };
+			const glm::mat4 ViewProjTrans{ OrthoProj * WorldToLight };
+			ShadowCascade.bStaticDirty |= ViewProjTrans != ShadowCascade.ViewProjTrans;
+			ShadowCascade.ViewProjTrans = ViewProjTrans;
+			ShadowCascade.SplitDepth = SliceFar;
+
+			// the tile of the cascade in the atlas
+			const glm::mat4 TexToAtlas{ glm::scale(glm::translate(glm::mat4(1.f), glm::vec3(float(Cascade) / NumCascades, 0.f, 0.f)), glm::vec3(1.f / NumCascades, 1.f, 1.f)) };
+			LightParameters.LightProjTex[Cascade] = glm::transpose(TexToAtlas * NDC2Tex * ShadowCascade.ViewProjTrans);
+			LightParameters.CascadeSplits[Cascade] = SliceFar;
+
+			// the shadow pass projects with the light
+			FViewConstBufferParameter CascadeParameters;
+			CascadeParameters.ViewProjTrans = glm::transpose(ShadowCascade.ViewProjTrans);
+			CascadeParameters.LightProj = CascadeParameters.ViewProjTrans;
+			if (ShadowCascade.ConstBuffer)
+			{
+				ShadowCascade.ConstBuffer->SetData(&CascadeParameters, sizeof(FViewConstBufferParameter));
+			}
+			else
+			{
+				ShadowCascade.ConstBuffer.reset(GRHI->CreateConstBuffer1(&CascadeParameters, sizeof(FViewConstBufferParameter)));
+				ShadowCascade.ConstBuffer->SetLocationIndex(1);
+			}
+			SliceNear = SliceFar;
+		}
+		LightParameters.ShadowCascades = glm::uvec4(NumCascades, 0u, 0u, 0u);
+	}
+
+	void FRenderScene::UpdateLocalLights()
+	{
+		const FSceneGraph& SceneGraph{ Scene->GetSceneGraph() };
+		LocalLights.clear();
+		LocalLightSpheres.clear();
+		for (const FLightComponent& Light : Scene->GetLightComponents())
+		{
+			if (Light.GetType() != ELightType::POINT && Light.GetType() != ELightType::SPOT)
+			{
+				continue;
+			}
+			const FLightInfo& LightInfo{ Light.GetLightInfo() };
+			const glm::mat4& WorldTrans{ SceneGraph.GetWorldTrans(Light.GetOwner()) };
+			const float Range{ Light.GetRange() };
+			FLocalLightData& LightData{ LocalLights.emplace_back() };
+			LightData.Position = WorldTrans[3];
+			LightData.InvRange = Range > 0.f ? 1.f / Range : 0.f;
+			LightData.Color = LightInfo.Color * LightInfo.Intensity;
+			LightData.Direction = Light.GetDirection(WorldTrans);
+			if (Light.GetType() == ELightType::POINT)
+			{
+				LocalLightSpheres.emplace_back(LightData.Position, Range);
+				continue;
+			}
+			// smooth from the outer to the inner cone
+			const float CosOuter{ std::cos(LightInfo.OuterConeAngle) };
+			const float CosInner{ std::cos(LightInfo.InnerConeAngle) };
+			LightData.SpotScale = 1.f / std::max(CosInner - CosOuter, 1e-4f);
+			LightData.SpotOffset = -CosOuter * LightData.SpotScale;
+			// the tightest sphere around the cone, the light shines against Direction
+			const glm::vec3 Axis{ -LightData.Direction };
+			if (LightInfo.OuterConeAngle > glm::quarter_pi<float>())
+			{
+				LocalLightSpheres.emplace_back(LightData.Position + Axis * (CosOuter * Range), std::sin(LightInfo.OuterConeAngle) * Range);
+			}
+			else
+			{
+				const float Radius{ Range / (2.f * CosOuter) };
+				LocalLightSpheres.emplace_back(LightData.Position + Axis * Radius, Radius);
+			}
+		}
 	}
 
 	void FRenderScene::AddPrimitive(FStaticMeshComponent* MeshComponent)
 	{
+		const uint32 PrimIndex{ static_cast<uint32>(Primitives.size()) };
 		auto Primitive = std::make_unique<FRenderPrimitive>(MeshComponent);
+		MeshComponent->SetPrimitiveIndex(static_cast<int32>(PrimIndex));
+		PrimitiveBoxes.push_back(Primitive->GetBounds().Box);
 		Primitives.push_back(std::move(Primitive));
+		PrimitiveDirtyFlags.push_back(0);
+		PrimitiveBatches.push_back(InvalidBatch);
+		MarkPrimitiveDirty(PrimIndex);
+		UpdatePrimitiveBatch(PrimIndex);
+		if (MeshComponent->IsMovable())
+		{
+			DynamicGrid.Insert(PrimIndex, PrimitiveBoxes.back());
+			return;
+		}
+		InvalidateStaticShadows(PrimitiveBoxes.back());
+		// a streamed primitive goes into the built tree, the scene load builds it once
+		if (!bBVHNeedsBuild)
+		{
+			bBVHNeedsBuild = !BVH.Insert(PrimIndex, PrimitiveBoxes);
+		}
+	}
+
+	void FRenderScene::UpdatePrimitive(FStaticMeshComponent* MeshComponent)
+	{
+		const int32 PrimitiveIndex{ MeshComponent->GetPrimitiveIndex() };
+		assert(PrimitiveIndex >= 0 && PrimitiveIndex < Primitives.size());
+		// the shadow of a static primitive is redrawn where it was and where it is
+		if (!DynamicGrid.Contains(PrimitiveIndex))
+		{
+			InvalidateStaticShadows(PrimitiveBoxes.at(PrimitiveIndex));
+		}
+		Primitives.at(PrimitiveIndex)->UpdateRenderData(MeshComponent);
+		PrimitiveBoxes.at(PrimitiveIndex) = Primitives.at(PrimitiveIndex)->GetBounds().Box;
+		MarkPrimitiveDirty(PrimitiveIndex);
+		UpdatePrimitiveBatch(PrimitiveIndex);
+		UpdatePrimitiveIndex(PrimitiveIndex, MeshComponent->IsMovable());
+		if (!MeshComponent->IsMovable())
+		{
+			InvalidateStaticShadows(PrimitiveBoxes.at(PrimitiveIndex));
+		}
+	}
+
+	void FRenderScene::RemovePrimitive(uint32 PrimIndex)
+	{
+		assert(PrimIndex < Primitives.size());
+		const uint32 LastIndex{ static_cast<uint32>(Primitives.size() - 1) };
+		if (PrimitiveDirtyFlags[LastIndex])
+		{
+			std::erase(DirtyPrimitives, LastIndex);
+		}
+		ReleasePrimitiveBatch(PrimitiveBatches[PrimIndex]);
+		if (DynamicGrid.Contains(PrimIndex))
+		{
+			DynamicGrid.Remove(PrimIndex);
+		}
+		else
+		{
+			InvalidateStaticShadows(PrimitiveBoxes[PrimIndex]);
+			if (!bBVHNeedsBuild)
+			{
+				BVH.Remove(PrimIndex);
+			}
+		}
+		if (PrimIndex != LastIndex)
+		{
+			Primitives[PrimIndex] = std::move(Primitives[LastIndex]);
+			PrimitiveBoxes[PrimIndex] = PrimitiveBoxes[LastIndex];
+			PrimitiveBatches[PrimIndex] = PrimitiveBatches[LastIndex];
+			if (DynamicGrid.Contains(LastIndex))
+			{
+				DynamicGrid.Remove(LastIndex);
+				DynamicGrid.Insert(PrimIndex, PrimitiveBoxes[PrimIndex]);
+			}
+			else if (!bBVHNeedsBuild)
+			{
+				// the leaves hold primitive indices, the views are culled again before the next draw
+				BVH.Reindex(LastIndex, PrimIndex);
+			}
+			// the moved constants go to their new slot
+			MarkPrimitiveDirty(PrimIndex);
+		}
+		Primitives.pop_back();
+		PrimitiveBoxes.pop_back();
+		PrimitiveDirtyFlags.pop_back();
+		PrimitiveBatches.pop_back();
+	}
+
+	void FRenderScene::UpdatePrimitiveBatch(uint32 PrimIndex)
+	{
+		const FRenderPrimitive* Primitive{ Primitives[PrimIndex].get() };
+		auto [It, bInserted] = BatchIds.try_emplace({ Primitive->GetRenderData(), Primitive->GetMaterial() }, InvalidBatch);
+		if (bInserted)
+		{
+			It->second = FreeBatchIds.empty() ? static_cast<uint32>(Batches.size()) : FreeBatchIds.back();
+			if (FreeBatchIds.empty())
+			{
+				Batches.emplace_back();
+			}
+			else
+			{
+				FreeBatchIds.pop_back();
+			}
+			FPrimitiveBatch& Batch{ Batches[It->second] };
+			Batch.RenderData = Primitive->GetRenderData();
+			Batch.Material = Primitive->GetMaterial();
+			const uint32 MeshId{ AcquireSortId(MeshIds, FreeMeshIds, Batch.RenderData) };
+			const uint32 MaterialId{ AcquireSortId(MaterialIds, FreeMaterialIds, Batch.Material) };
+			// 20 bits of mesh and 12 of material, ids past them only split batches apart, PrimitiveBatches still groups them
+			Batch.SortBits = ((MeshId & 0xfffff) << 12) | (MaterialId & 0xfff);
+		}
+		// join the new batch before leaving the old one, an unchanged batch is never freed in between
+		++Batches[It->second].NumPrimitives;
+		const uint32 OldBatch{ PrimitiveBatches[PrimIndex] };
+		PrimitiveBatches[PrimIndex] = It->second;
+		if (OldBatch != InvalidBatch)
+		{
+			ReleasePrimitiveBatch(OldBatch);
+		}
+	}
+
+	void FRenderScene::ReleasePrimitiveBatch(uint32 BatchId)
+	{
+		FPrimitiveBatch& Batch{ Batches[BatchId] };
+		assert(Batch.NumPrimitives > 0);
+		if (--Batch.NumPrimitives > 0)
+		{
+			return;
+		}
+		ReleaseSortId(MeshIds, FreeMeshIds, Batch.RenderData);
+		ReleaseSortId(MaterialIds, FreeMaterialIds, Batch.Material);
+		BatchIds.erase({ Batch.RenderData, Batch.Material });
+		Batch = {};
+		FreeBatchIds.push_back(BatchId);
+	}
+
+	void FRenderScene::UpdatePrimitiveIndex(uint32 PrimIndex, bool bMovable)
+	{
+		if (bMovable == DynamicGrid.Contains(PrimIndex))
+		{
+			if (bMovable)
+			{
+				DynamicGrid.Update(PrimIndex, PrimitiveBoxes[PrimIndex]);
+			}
+			else if (!bBVHNeedsBuild)
+			{
+				BVH.MarkDirty(PrimIndex);
+			}
+			return;
+		}
+		// the mobility changed, the BVH gains or loses the primitive
+		if (bMovable)
+		{
+			DynamicGrid.Insert(PrimIndex, PrimitiveBoxes[PrimIndex]);
+			if (!bBVHNeedsBuild)
+			{
+				BVH.Remove(PrimIndex);
+			}
+		}
+		else
+		{
+			DynamicGrid.Remove(PrimIndex);
+			if (!bBVHNeedsBuild)
+			{
+				bBVHNeedsBuild = !BVH.Insert(PrimIndex, PrimitiveBoxes);
+			}
+		}
+	}
+
+	void FRenderScene::InvalidateStaticShadows(const FBounds::FBox& Box)
+	{
+		// tested against the light boxes of the frame, they may still move in this one
+		StaticShadowChanges.push_back(Box);
+	}
+
+	void FRenderScene::MarkPrimitiveDirty(uint32 PrimIndex)
+	{
+		if (!PrimitiveDirtyFlags[PrimIndex])
+		{
+			PrimitiveDirtyFlags[PrimIndex] = 1;
+			DirtyPrimitives.push_back(PrimIndex);
+		}
+	}
+
+	void FRenderScene::UploadPrimitives()
+	{
+		PrimitiveUploadStats.NumUploaded = 0;
+		PrimitiveUploadStats.BytesUploaded = 0;
+#if RHICONSTBUFFER_V1
+		const uint32 NumPrimitives{ static_cast<uint32>(Primitives.size()) };
+		if (!PrimitiveConstBuffers || PrimitiveConstBuffers->GetCount() < NumPrimitives)
+		{
+			// the frames in flight may still bind the old buffers, every primitive goes to the new ones
+			if (PrimitiveConstBuffers)
+			{
+				GRHI->FlushRenderingCommands();
+			}
+			uint32 Capacity{ PrimitiveConstBuffers ? PrimitiveConstBuffers->GetCount() : MinPrimitiveConstBuffers };
+			while (Capacity < NumPrimitives)
+			{
+				Capacity *= 2;
+			}
+			// released first, the old view goes back to the heap before the new one is taken
+			PrimitiveConstBuffers.reset();
+			PrimitiveConstBuffers.reset(GRHI->CreateConstBufferArray(sizeof(FPrimitiveConstBufferParameter), Capacity));
+			PrimitiveConstBuffers->SetShaderResourceLocationIndex(4);
+			for (uint32 PrimIndex = 0; PrimIndex < NumPrimitives; ++PrimIndex)
+			{
+				MarkPrimitiveDirty(PrimIndex);
+			}
+		}
+		if (DirtyPrimitives.empty())
+		{
+			return;
+		}
+		// sorted so neighbouring primitives merge into one copy
+		std::sort(DirtyPrimitives.begin(), DirtyPrimitives.end());
+		UploadParameters.resize(DirtyPrimitives.size());
+		for (size_t i = 0; i < DirtyPrimitives.size(); ++i)
+		{
+			UploadParameters[i] = Primitives[DirtyPrimitives[i]]->GetConstBufferParameter();
+		}
+		GRHI->UpdateConstBufferArray(PrimitiveConstBuffers.get(), static_cast<uint32>(DirtyPrimitives.size()), DirtyPrimitives.data(), UploadParameters.data());
+		PrimitiveUploadStats.NumUploaded = static_cast<uint32>(DirtyPrimitives.size());
+		PrimitiveUploadStats.BytesUploaded = UploadParameters.size() * sizeof(FPrimitiveConstBufferParameter);
+		PrimitiveUploadStats.TotalBytesUploaded += PrimitiveUploadStats.BytesUploaded;
+#endif
+		for (uint32 PrimIndex : DirtyPrimitives)
+		{
+			PrimitiveDirtyFlags[PrimIndex] = 0;
+		}
+		DirtyPrimitives.clear();
 	}
 
 	void FRenderScene::Update()
 	{
+		UpdateView();
+		UpdateLocalLights();
+		// a refit that degraded the tree too much falls back to a rebuild
+		if (!bBVHNeedsBuild && BVH.NeedsRefit())
+		{
+			bBVHNeedsBuild = !BVH.Refit(PrimitiveBoxes);
+		}
+		if (bBVHNeedsBuild)
+		{
+			StaticPrimitives.clear();
+			for (uint32 PrimIndex = 0; PrimIndex < Primitives.size(); ++PrimIndex)
+			{
+				if (!DynamicGrid.Contains(PrimIndex))
+				{
+					StaticPrimitives.push_back(PrimIndex);
+				}
+			}
+			BVH.Build(PrimitiveBoxes, StaticPrimitives);
+			bBVHNeedsBuild = false;
+		}
+	}
+
+	void FRenderScene::ComputeVisibility()
+	{
+		// the cascades come first, then the camera views
+		const uint32 NumCascades{ static_cast<uint32>(ShadowCascades.size()) };
+		const uint32 NumJobs{ NumCascades + static_cast<uint32>(Views.size()) };
+		auto GetView = [&](uint32 Job) { return Job < NumCascades ? nullptr : &Views[Job - NumCascades]; };
+		auto GetVisibility = [&](uint32 Job) -> FViewVisibility& { return Job < NumCascades ? ShadowCascades[Job].Visibility : Views[Job - NumCascades].Visibility; };
+		// the cached cascades a static change falls in, a cascade without constants waits for them
+		for (FShadowCascade& ShadowCascade : ShadowCascades)
+		{
+			const FFrustum Frustum(ShadowCascade.ViewProjTrans);
+			for (size_t i = 0; i < StaticShadowChanges.size() && !ShadowCascade.bStaticDirty; ++i)
+			{
+				ShadowCascade.bStaticDirty = Frustum.Intersects(StaticShadowChanges[i]);
+			}
+			ShadowCascade.bDrawStatic = ShadowCascade.bStaticDirty && ShadowCascade.ConstBuffer;
+			ShadowCascade.bStaticDirty &= !ShadowCascade.bDrawStatic;
+			ShadowCascade.NumStaticRedraws += ShadowCascade.bDrawStatic;
+		}
+		StaticShadowChanges.clear();
+		for (uint32 Job = 0; Job < NumJobs; ++Job)
+		{
+			const glm::mat4& ViewProjTrans{ Job < NumCascades ? ShadowCascades[Job].ViewProjTrans : GetView(Job)->ViewProjTrans };
+			GetVisibility(Job).Frustum = FFrustum(ViewProjTrans);
+			// clip z of the orthographic cascades, clip w of the perspective views
+			GetVisibility(Job).DepthRow = glm::row(ViewProjTrans, Job < NumCascades ? 2 : 3);
+		}
 
+		// every cascade and camera view on its own job, a job only writes its view
+		auto ComputeViewVisibility = [&](uint32 Job) {
+			if (Job < NumCascades)
+			{
+				FShadowCascade& ShadowCascade{ ShadowCascades[Job] };
+				if (ShadowCascade.bDrawStatic)
+				{
+					ShadowCascade.StaticVisibility.Frustum = ShadowCascade.Visibility.Frustum;
+					ShadowCascade.StaticVisibility.DepthRow = ShadowCascade.Visibility.DepthRow;
+					CullView(ShadowCascade.StaticVisibility, ShadowCascade.Scratch, ECullPrimitives::STATIC);
+					BuildDrawBatches(ShadowCascade.StaticVisibility, ShadowCascade.Scratch);
+				}
+				CullView(ShadowCascade.Visibility, ShadowCascade.Scratch, ECullPrimitives::MOVABLE);
+				BuildDrawBatches(ShadowCascade.Visibility, ShadowCascade.Scratch);
+				return;
+			}
+			FSceneView& View{ *GetView(Job) };
+			CullView(View.Visibility, View.Scratch, ECullPrimitives::ALL);
+			if (View.OcclusionCuller)
+			{
+				CullOcclusion(View);
+			}
+			BuildDrawBatches(View.Visibility, View.Scratch);
+			// nested in the view job like the occlusion tiles
+			View.LightClusters.Build(View.ViewTrans, LocalLightSpheres, GJobSystem);
+		};
+		if (GJobSystem)
+		{
+			GJobSystem->ParallelFor(NumJobs, ComputeViewVisibility);
+		}
+		else
+		{
+			for (uint32 Job = 0; Job < NumJobs; ++Job)
+			{
+				ComputeViewVisibility(Job);
+			}
+		}
+
+		bMovableShadowCasters = false;
+		for (const FShadowCascade& ShadowCascade : ShadowCascades)
+		{
+			bMovableShadowCasters |= ShadowCascade.ConstBuffer && !ShadowCascade.Visibility.DrawBatches.empty();
+		}
+
+		// the counts change with every camera move, so they are sampled every GRHIConfig.StatsInterval frames
+		if (GRHIConfig.StatsInterval == 0 || ++NumStatsFrames < GRHIConfig.StatsInterval)
+		{
+			return;
+		}
+		NumStatsFrames = 0;
+		for (uint32 Cascade = 0; Cascade < NumCascades; ++Cascade)
+		{
+			FShadowCascade& ShadowCascade{ ShadowCascades[Cascade] };
+			const FViewVisibility& StaticVisibility{ ShadowCascade.StaticVisibility };
+			KS_INFOA(std::format("Shadow cache : cascade {}, {} static casters, {} draws, redrawn in {} of {} frames", Cascade, StaticVisibility.VisiblePrimitives.size(),
+				StaticVisibility.DrawBatches.size(), ShadowCascade.NumStaticRedraws, GRHIConfig.StatsInterval).c_str());
+			ShadowCascade.NumStaticRedraws = 0;
+		}
+		for (uint32 Job = 0; Job < NumJobs; ++Job)
+		{
+			const FSceneView* View{ GetView(Job) };
+			const FViewVisibility& Visibility{ GetVisibility(Job) };
+			const uint32 ViewIndex{ Job - NumCascades };
+			KS_INFOA(std::format("Visibility : {} {}, {} visible, {} culled, {} draws", View ? "view" : "cascade",
+				View ? ViewIndex : Job, Visibility.VisiblePrimitives.size(), Visibility.NumCulled, Visibility.DrawBatches.size()).c_str());
+			if (!View)
+			{
+				continue;
+			}
+			if (View->OcclusionCuller)
+			{
+				const FOcclusionCuller::FStats& Stats{ View->OcclusionCuller->GetStats() };
+				KS_INFOA(std::format("Occlusion : view {}, {} occluders, {} triangles, {} of {} occluded, raster {:.3f} ms, test {:.3f} ms",
+					ViewIndex, Stats.NumOccluders, Stats.NumOccluderTriangles, Stats.NumOccluded, Stats.NumTested, Stats.RasterMs, Stats.TestMs).c_str());
+			}
+			const FLightClusters::FStats& Stats{ View->LightClusters.GetStats() };
+			KS_INFOA(std::format("Light clusters : view {}, {} of {} lights, {} indices, {} at most per cluster, {:.3f} ms",
+				ViewIndex, Stats.NumLights, LocalLights.size(), Stats.NumIndices, Stats.MaxClusterLights, Stats.BuildMs).c_str());
+		}
+	}
+
+	void FRenderScene::CullView(FViewVisibility& View, FViewCullScratch& Scratch, ECullPrimitives CullPrimitives) const
+	{
+		// coarse pass on the BVH nodes and the grid cells, then the candidate boxes in SIMD batches
+		std::vector<uint32>& CandidatePrimitives{ Scratch.CandidatePrimitives };
+		CandidatePrimitives.clear();
+		auto NodeTest = [&View](const FBounds::FBox& NodeBox) {
+			return View.Frustum.Intersects(NodeBox);
+		};
+		auto AddCandidate = [&CandidatePrimitives](uint32 PrimIndex) {
+			CandidatePrimitives.push_back(PrimIndex);
+		};
+		if (CullPrimitives != ECullPrimitives::MOVABLE)
+		{
+			BVH.Traverse(NodeTest, AddCandidate);
+		}
+		if (CullPrimitives != ECullPrimitives::STATIC)
+		{
+			DynamicGrid.Traverse(NodeTest, AddCandidate);
+		}
+		const uint32 NumCandidates{ static_cast<uint32>(CandidatePrimitives.size()) };
+		Scratch.CandidateBoxes.resize(NumCandidates);
+		Scratch.CandidateVisible.resize(NumCandidates);
+		for (uint32 i = 0; i < NumCandidates; ++i)
+		{
+			Scratch.CandidateBoxes[i] = PrimitiveBoxes[CandidatePrimitives[i]];
+		}
+		util::CullBoxes(View.Frustum, NumCandidates, Scratch.CandidateBoxes.data(), Scratch.CandidateVisible.data());
+
+		View.VisiblePrimitives.clear();
+		for (uint32 i = 0; i < NumCandidates; ++i)
+		{
+			if (Scratch.CandidateVisible[i])
+			{
+				View.VisiblePrimitives.push_back(CandidatePrimitives[i]);
+			}
+		}
+		// draw in primitive order, the leaves and cells are visited in index order
+		std::sort(View.VisiblePrimitives.begin(), View.VisiblePrimitives.end());
+		// against the primitives the pass traverses, a cascade pass over one population does not cull the other
+		uint32 NumTraversed{ 0 };
+		if (CullPrimitives != ECullPrimitives::MOVABLE)
+		{
+			NumTraversed += BVH.GetNumPrimitives();
+		}
+		if (CullPrimitives != ECullPrimitives::STATIC)
+		{
+			NumTraversed += DynamicGrid.GetNumItems();
+		}
+		View.NumCulled = NumTraversed - static_cast<uint32>(View.VisiblePrimitives.size());
+	}
+
+	void FRenderScene::BuildDrawBatches(FViewVisibility& View, FViewCullScratch& Scratch) const
+	{
+		// sorted by mesh and material, then front to back so the instances of a batch fail the depth test early
+		std::vector<uint64>& BatchSortKeys{ Scratch.BatchSortKeys };
+		BatchSortKeys.resize(View.VisiblePrimitives.size());
+		View.InstancePrimitives = View.VisiblePrimitives;
+		for (size_t i = 0; i < View.VisiblePrimitives.size(); ++i)
+		{
+			const uint32 PrimIndex{ View.VisiblePrimitives[i] };
+			const float Depth{ glm::dot(glm::vec4(Primitives[PrimIndex]->GetBounds().Sphere.Center, 1.f), View.DepthRow) };
+			// the float bits ordered as unsigned, negative depths flip every bit and positive ones the sign
+			const uint32 DepthBits{ std::bit_cast<uint32>(Depth) };
+			const uint32 DepthKey{ DepthBits ^ ((DepthBits & 0x80000000u) ? 0xffffffffu : 0x80000000u) };
+			BatchSortKeys[i] = (uint64(Batches[PrimitiveBatches[PrimIndex]].SortBits) << 32) | DepthKey;
+		}
+		util::RadixSort(BatchSortKeys, View.InstancePrimitives, Scratch.SortScratch, GJobSystem);
+		View.DrawBatches.clear();
+		for (uint32 i = 0; i < View.InstancePrimitives.size(); ++i)
+		{
+			const uint32 PrimIndex{ View.InstancePrimitives[i] };
+			if (i == 0 || PrimitiveBatches[PrimIndex] != PrimitiveBatches[View.InstancePrimitives[i - 1]])
+			{
+				View.DrawBatches.push_back(FDrawBatch{ Primitives[PrimIndex]->GetRenderData()->GetRHIDrawCommand(), i, 0 });
+			}
+			++View.DrawBatches.back().NumInstances;
+		}
+	}
+
+	void FRenderScene::CullOcclusion(FSceneView& View) const
+	{
+		// the largest primitives on screen are the occluders
+		std::vector<std::pair<float, uint32>>& OccluderCandidates{ View.Scratch.OccluderCandidates };
+		OccluderCandidates.clear();
+		for (uint32 PrimIndex : View.Visibility.VisiblePrimitives)
+		{
+			const FBounds& PrimBounds{ Primitives[PrimIndex]->GetBounds() };
+			const float ViewDepth{ (View.ViewProjTrans * glm::vec4(PrimBounds.Sphere.Center, 1.f)).w };
+			const float ProjectedSize{ PrimBounds.Sphere.Radius / std::max(ViewDepth, PrimBounds.Sphere.Radius) };
+			if (ProjectedSize >= MinOccluderSize && Primitives[PrimIndex]->GetMeshData())
+			{
+				OccluderCandidates.emplace_back(ProjectedSize, PrimIndex);
+			}
+		}
+		std::sort(OccluderCandidates.begin(), OccluderCandidates.end(), std::greater<>{});
+
+		FOcclusionCuller& OcclusionCuller{ *View.OcclusionCuller };
+		OcclusionCuller.Begin(View.ViewProjTrans);
+		uint32 NumOccluders{ 0 };
+		uint32 NumTriangles{ 0 };
+		for (const auto& [ProjectedSize, PrimIndex] : OccluderCandidates)
+		{
+			if (NumOccluders == MaxOccluders)
+			{
+				break;
+			}
+			const FRenderPrimitive& Primitive{ *Primitives[PrimIndex] };
+			const uint32 NumPrimTriangles{ Primitive.GetMeshData()->IndexData.Count / 3 };
+			if (NumTriangles + NumPrimTriangles > MaxOccluderTriangles)
+			{
+				continue;
+			}
+			OcclusionCuller.AddOccluder(*Primitive.GetMeshData(), Primitive.GetWorldTrans());
+			++NumOccluders;
+			NumTriangles += NumPrimTriangles;
+		}
+		// nested in the view job, the waits run the queued tiles themselves
+		OcclusionCuller.Rasterize(GJobSystem);
+
+		// an occluder never hides itself, its box is in front of its own triangles
+		OcclusionCuller.CullVisible(PrimitiveBoxes, View.Visibility.VisiblePrimitives, GJobSystem);
+		View.Visibility.NumCulled += OcclusionCuller.GetStats().NumOccluded;
 	}
 
 	/**********************************************************************/
@@ -132,15 +881,47 @@ namespace ks
 		Init();
 	}
 
+	// the passes are complete types here
+	FRenderer::~FRenderer() = default;
+
 	void FRenderer::Render()
 	{
+		// visibility stage, the passes draw the visible lists
+		if (RenderScene)
+		{
+			RenderScene->Update();
+			RenderScene->ComputeVisibility();
+		}
+
 		GRHI->BeginFrame();
 
-		RenderShadowPass();
+		if (RenderScene)
+		{
+			RenderScene->UploadPrimitives();
+		}
 
-		RenderBasePass();
+		// the passes declare their textures, the graph orders them and backs the transients from the pool
+		FRenderGraph Graph(GraphPool);
+		const FRGTextureRef BackBuffer{ Graph.ImportRenderTarget("BackBuffer", GRHI->GetCurrentBackBuffer()) };
+		const FRGTextureRef SceneDepth{ Graph.ImportDepthStencilBuffer("SceneDepth", GRHI->GetDefaultDepthStencilBuffer()) };
+		FRGTextureRef SceneColor;
+		if (RenderScene)
+		{
+			const FRGTextureRef ShadowMap{ ShadowPass->AddPasses(Graph, RenderScene) };
+			SceneColor = BasePass->AddPass(Graph, RenderScene, ShadowMap, SceneDepth);
+		}
+		PostProcessPass->AddPass(Graph, SceneColor, BackBuffer, SceneDepth);
+		Graph.Execute();
 
-		RenderPostProcessPass();
+		const FRenderGraph::FStats& GraphStats{ Graph.GetStats() };
+		const FRenderGraphPool::FStats& PoolStats{ GraphPool.GetStats() };
+		if (GraphStats.NumPasses != LastGraphStats.NumPasses || GraphStats.NumCulled != LastGraphStats.NumCulled || PoolStats.NumTextures != LastNumPooledTextures)
+		{
+			KS_INFOA(std::format("Render graph : {} passes, {} culled, {} transients on {} of {} pooled textures",
+				GraphStats.NumPasses, GraphStats.NumCulled, PoolStats.NumTransients, PoolStats.NumAcquired, PoolStats.NumTextures).c_str());
+			LastGraphStats = GraphStats;
+			LastNumPooledTextures = PoolStats.NumTextures;
+		}
 
 		GRHI->EndFrame();
 	}
@@ -148,13 +929,19 @@ namespace ks
 	void FRenderer::Shutdown()
 	{
 		KS_INFO(TEXT("FRenderer::Shutdown"));
+		// wait for the frames in flight before their buffers are released
+		GRHI->FlushRenderingCommands();
 		if(RenderScene)
 		{
 			KS_INFO(TEXT("\tFree RenderScene"));
 			size_t NumErase = FRenderer::RenderScenes.erase(RenderScene);
 			RenderScene = nullptr;
 		}
-		FRenderPass::ReleaseAllPasses();
+		KS_INFOA("RenderPass : Release All Passes.");
+		ShadowPass.reset();
+		BasePass.reset();
+		PostProcessPass.reset();
+		GraphPool = FRenderGraphPool{};
 	}
 
 	void FRenderer::Init()
@@ -168,27 +955,29 @@ namespace ks
 			Desc.PipelineStateDesc.InputLayout = {
 				/*SemanticName, SemanticIndex, Format, InputSlot, Stride*/
 				{"POSITION", 0, EELEM_FORMAT::R32G32B32_FLOAT, 0, 0},
-				{"NORMAL", 0, EELEM_FORMAT::R32G32B32_FLOAT, 1, 0}
+				{"NORMAL", 0, EELEM_FORMAT::R32G32B32_FLOAT, 1, 0},
+				{"PRIMITIVEINDEX", 0, EELEM_FORMAT::R32_UINT, FRenderPass::InstanceSlot, 0, 1}
 			};
 			Desc.PipelineStateDesc.VertexShaderDesc = { "BasePassVS", util::GetShaderPath("BasePass.hlsl"), "VS" };
 			Desc.PipelineStateDesc.PixelShaderDesc = { "BasePassPS", util::GetShaderPath("BasePass.hlsl"), "PS" };
 			Desc.PipelineStateDesc.NumRenderTargets = 1;
 			Desc.PipelineStateDesc.RenderTargetFormats[0] = EELEM_FORMAT::R16G16B16A16_FLOAT;
 			Desc.PipelineStateDesc.DepthBufferFormat = GRHIConfig.DepthBufferFormat;
-			FRenderPass* Pass = FRenderPass::CreatePass<FBasePass>(Desc);
-			assert(Pass);
+			BasePass = std::make_unique<FBasePass>(Desc);
 		}
 
 		// setup shadow pass
 		{
 			FRenderPassDesc Desc{};
 			Desc.Name = "ShadowPass";
-			Desc.ViewPort = { 0, 0, GRHIConfig.ShadowMapSize, GRHIConfig.ShadowMapSize };
+			// the atlas of the cascades, one ShadowMapSize tile each
+			Desc.ViewPort = { 0, 0, GRHIConfig.ShadowMapSize * std::clamp(GRHIConfig.NumShadowCascades, 1u, MaxShadowCascades), GRHIConfig.ShadowMapSize };
 			Desc.Renderer = this;
 			Desc.PipelineStateDesc.InputLayout = {
 				/*SemanticName, SemanticIndex, Format, InputSlot, Stride*/
 				{"POSITION", 0, EELEM_FORMAT::R32G32B32_FLOAT, 0, 0},
-				{"NORMAL", 0, EELEM_FORMAT::R32G32B32_FLOAT, 1, 0}
+				{"NORMAL", 0, EELEM_FORMAT::R32G32B32_FLOAT, 1, 0},
+				{"PRIMITIVEINDEX", 0, EELEM_FORMAT::R32_UINT, FRenderPass::InstanceSlot, 0, 1}
 			};
 			Desc.PipelineStateDesc.VertexShaderDesc = { "ShadowPassVS", util::GetShaderPath("ShadowPass.hlsl"), "VS" };
 			Desc.PipelineStateDesc.PixelShaderDesc = { "ShadowPassPS", util::GetShaderPath("ShadowPass.hlsl"), "PS" };
@@ -199,8 +988,7 @@ namespace ks
 			Desc.PipelineStateDesc.RasterizerState.DepthBias = 100000;
 			Desc.PipelineStateDesc.RasterizerState.SlopeScaledDepthBias = 1.0f;
 
-			FRenderPass* Pass = FRenderPass::CreatePass<FShadowPass>(Desc);
-			assert(Pass);
+			ShadowPass = std::make_unique<FShadowPass>(Desc);
 		}
 
 		// setup post process pass
@@ -220,33 +1008,8 @@ namespace ks
 			Desc.PipelineStateDesc.RenderTargetFormats[0] = GRHIConfig.BackBufferFormat;
 			Desc.PipelineStateDesc.DepthBufferFormat = GRHIConfig.DepthBufferFormat;
 			Desc.PipelineStateDesc.DepthStencilState.DepthEnable = 0;
-			FRenderPass* Pass = FRenderPass::CreatePass<FPostProcessPass>(Desc);
-			assert(Pass);
+			PostProcessPass = std::make_unique<FPostProcessPass>(Desc);
 		}
 	}
 
-	void FRenderer::RenderBasePass()
-	{
-		static FRenderPass* Pass = FRenderPass::GetPass("BasePass");
-		Pass->Begin();
-		Pass->Render();
-		Pass->End();
-	}
-
-	void FRenderer::RenderShadowPass()
-	{
-		static FRenderPass* Pass = FRenderPass::GetPass("ShadowPass");
-		Pass->Begin();
-		Pass->Render();
-		Pass->End();
-	}
-
-	void FRenderer::RenderPostProcessPass()
-	{
-		static FRenderPass* Pass = FRenderPass::GetPass("PostProcessPass");
-		Pass->Begin();
-		Pass->Render();
-		Pass->End();
-	}
-
 }
\ No newline at end of file
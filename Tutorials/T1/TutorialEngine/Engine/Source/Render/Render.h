@@ -3,6 +3,14 @@
 #include "Core/Math.h"
 #include "RHI/RHI.h"
 #include "Core/Bounds.h"
+#include "Core/Frustum.h"
+#include "Core/SceneGraph.h"
+#include "Core/PrimitiveBVH.h"
+#include "Core/LooseGrid.h"
+#include "Core/RadixSort.h"
+#include "Render/OcclusionCulling.h"
+#include "Render/LightClusters.h"
+#include "Render/RenderGraph.h"
 
 namespace ks
 {
@@ -10,14 +18,47 @@ namespace ks
 	class FScene;
 	class FMeshRenderData;
 	class FStaticMeshComponent;
+	class FMaterialAsset;
+	struct FMeshData;
+
+	// tiles of the shadow atlas, see FShadowCascade
+	inline constexpr uint32 MaxShadowCascades{ 4 };
 
 	struct FViewConstBufferParameter
 	{
 		glm::mat4 ViewProjTrans{1.f};
+		// the cascade drawn by the shadow pass
 		glm::mat4 LightProj{1.f};
-		glm::mat4 LightProjTex{1.f};
+		// world to the shadow atlas uv and depth of each cascade
+		glm::mat4 LightProjTex[MaxShadowCascades]{ glm::mat4{1.f}, glm::mat4{1.f}, glm::mat4{1.f}, glm::mat4{1.f} };
 		glm::vec4 D_LightDirectionAndInstensity{0.f};
 		glm::vec3 EyePos{0.f};
+		float Pad{0.f};
+		// view depth of a world position is its dot with the row
+		glm::vec4 ViewDepthRow{0.f};
+		// top left of the view in pixels and the clusters per pixel
+		glm::vec4 ClusterRect{0.f};
+		// scale and bias of the log depth to the cluster slice
+		glm::vec4 ClusterDepth{0.f};
+		glm::uvec4 ClusterGrid{0u};
+		// far view depth of each cascade, the pixels beyond the last are not shadowed
+		glm::vec4 CascadeSplits{0.f};
+		// number of cascades in x
+		glm::uvec4 ShadowCascades{0u};
+	};
+
+	/* a point or spot light as the base pass reads it */
+	struct FLocalLightData
+	{
+		glm::vec3 Position{0.f};
+		float InvRange{0.f};
+		// color times intensity
+		glm::vec3 Color{0.f};
+		// the spot factor is saturate(dot(ToLight, Direction) * SpotScale + SpotOffset), 0 and 1 for a point light
+		float SpotScale{0.f};
+		// away from the spot cone, the z axis of the light node
+		glm::vec3 Direction{0.f, 0.f, 1.f};
+		float SpotOffset{1.f};
 	};
 
 	struct FPrimitiveConstBufferParameter
@@ -35,20 +76,166 @@ namespace ks
 		using ConstBufferPtrType = ConstBufferType::PtrType;
 		FRenderPrimitive(FStaticMeshComponent* MeshComponent);
 		~FRenderPrimitive() {}
+		// refresh render data, bounds and constants from the component
+		void UpdateRenderData(FStaticMeshComponent* MeshComponent);
 		ConstBufferPtrType GetPrimitiveConstBuffer() { return PrimitiveConstBuffer.get(); }
-		IRHIConstBuffer1* GetConstBuffer() { return PrimitiveConstBuffer1.get(); }
+		// uploaded by FRenderScene::UploadPrimitives when the primitive is dirty
+		const FPrimitiveConstBufferParameter& GetConstBufferParameter() const { return ConstBufferParameter; }
 		const FMeshRenderData* GetRenderData() const { return RenderData; }
+		const FMaterialAsset* GetMaterial() const { return Material; }
+		const FBounds& GetBounds() const { return Bounds; }
+		// cpu side mesh and transform, rasterized when the primitive is picked as an occluder
+		const FMeshData* GetMeshData() const { return MeshData; }
+		const glm::mat4& GetWorldTrans() const { return WorldTrans; }
 	private:
+		void UpdateConstBufferParameter(FStaticMeshComponent* MeshComponent);
 		// reference FStaticMeshAsset::RenderData
 		FMeshRenderData* RenderData{nullptr};
-		// primitive constant buffer
+		// reference FStaticMeshAsset::MaterialAsset
+		const FMaterialAsset* Material{nullptr};
+		// reference FStaticMeshAsset::MeshData
+		const FMeshData* MeshData{nullptr};
+		glm::mat4 WorldTrans{1.f};
+		// primitive constants, the gpu copy is an element of FRenderScene::PrimitiveConstBuffers
+		FPrimitiveConstBufferParameter ConstBufferParameter;
 		std::shared_ptr<ConstBufferType> PrimitiveConstBuffer;
-		std::shared_ptr<IRHIConstBuffer1> PrimitiveConstBuffer1;
 		// bounds
 		FBounds Bounds{};
 	};
 	/**********************************************************************/
 
+	/* visible primitives sharing mesh and material, drawn with one instanced draw */
+	struct FDrawBatch
+	{
+		// the cached command of the mesh
+		const IRHIDrawCommand* DrawCommand{ nullptr };
+		// range of FViewVisibility::InstancePrimitives
+		uint32 FirstInstance{ 0 };
+		uint32 NumInstances{ 0 };
+	};
+
+	/* visible primitives of a view, computed at the start of the frame */
+	struct FViewVisibility
+	{
+		FFrustum Frustum;
+		// the dot with a world position is its depth in the view, the instances of a batch are drawn nearest first
+		glm::vec4 DepthRow{ 0.f };
+		// indices into FRenderScene::Primitives
+		std::vector<uint32> VisiblePrimitives;
+		uint32 NumCulled{ 0 };
+		// the visible primitives grouped by batch, the per instance stream of the draws
+		std::vector<uint32> InstancePrimitives;
+		std::vector<FDrawBatch> DrawBatches;
+	};
+
+	/* scratch of the culling and batching of one view, each view has its own so the views cull in parallel */
+	struct FViewCullScratch
+	{
+		// the primitives of the BVH leaves and grid cells that intersect the frustum
+		std::vector<uint32> CandidatePrimitives;
+		std::vector<FBounds::FBox> CandidateBoxes;
+		std::vector<uint8> CandidateVisible;
+		// batch sort bits in the high bits and instance depth in the low bits
+		std::vector<uint64> BatchSortKeys;
+		FRadixSortScratch SortScratch;
+		// occluder selection, projected size and primitive index
+		std::vector<std::pair<float, uint32>> OccluderCandidates;
+	};
+
+	/* the primitives a view culls, the static ones are in the BVH and the movable ones in the grid */
+	enum class ECullPrimitives : uint8
+	{
+		ALL,
+		STATIC,
+		MOVABLE,
+	};
+
+	/*
+	* a depth slice of the main view, its casters drawn into one tile of the shadow atlas
+	* the static casters are cached in a tile of their own atlas, redrawn only when the light box moves or a static
+	* primitive in it changes, the movable casters are drawn over a copy of the cache every frame
+	* the light box moves with the camera in steps of about a quarter of its radius, not every frame
+	*/
+	struct FShadowCascade
+	{
+		FViewPort ViewPort;
+		// orthographic light box around the slice, snapped to coarse steps and stretched toward the light to the scene bounds
+		glm::mat4 ViewProjTrans{ 1.f };
+		// far view depth of the slice
+		float SplitDepth{ 0.f };
+		// the movable casters in the light box
+		FViewVisibility Visibility;
+		// the static casters, culled only in the frames they are redrawn
+		FViewVisibility StaticVisibility;
+		FViewCullScratch Scratch;
+		// the cached tile is out of date
+		bool bStaticDirty{ true };
+		// the static casters are redrawn this frame
+		bool bDrawStatic{ false };
+		// frames the static casters were redrawn in since the last stats sample
+		uint32 NumStaticRedraws{ 0 };
+		// constants of the cascade, bound by the shadow pass
+		std::unique_ptr<IRHIConstBuffer1> ConstBuffer;
+	};
+
+	/* a camera drawn into a rectangle of the scene color, the rectangles may split or overlap the screen */
+	struct FSceneViewDesc
+	{
+		FSceneNodeHandle Camera;
+		// left, top, width and height in fractions of the scene color
+		glm::vec4 Rect{ 0.f, 0.f, 1.f, 1.f };
+		// rasterize the largest primitives of the view and drop the ones they hide
+		bool bOcclusionCulling{ true };
+	};
+
+	/* a camera view of the render scene, everything written while the view is culled lives here */
+	struct FSceneView
+	{
+		FSceneViewDesc Desc;
+		FViewPort ViewPort;
+		glm::mat4 ViewTrans{ 1.f };
+		glm::mat4 ViewProjTrans{ 1.f };
+		FViewVisibility Visibility;
+		FViewCullScratch Scratch;
+		std::unique_ptr<FOcclusionCuller> OcclusionCuller;
+		// the point and spot lights of each cluster of the view
+		FLightClusters LightClusters;
+		// view constants, bound by the base pass for the draws of the view
+#if !RHICONSTBUFFER_V1
+		std::shared_ptr<TConstBuffer<FViewConstBufferParameter>> ConstBuffer;
+#else
+		std::unique_ptr<IRHIConstBuffer1> ConstBuffer;
+#endif
+		// projection of the last constants update, zero until the first one
+		glm::mat4 LastProjTrans{ 0.f };
+	};
+
+	/* primitive constants uploaded by the last frame */
+	struct FPrimitiveUploadStats
+	{
+		uint32 NumUploaded{ 0 };
+		uint64 BytesUploaded{ 0 };
+		uint64 TotalBytesUploaded{ 0 };
+	};
+
+	/* the primitives of a mesh and material, drawn instanced */
+	struct FPrimitiveBatch
+	{
+		const FMeshRenderData* RenderData{ nullptr };
+		const FMaterialAsset* Material{ nullptr };
+		// the high half of the draw sort key
+		uint32 SortBits{ 0 };
+		// the batch id is free again once its last primitive is removed
+		uint32 NumPrimitives{ 0 };
+	};
+
+	/* a mesh or material id of the draw sort key, free again once no batch uses it */
+	struct FSortId
+	{
+		uint32 Id{ 0 };
+		uint32 NumBatches{ 0 };
+	};
+
 	class FRenderScene
 	{
 		friend class FRenderer;
@@ -58,18 +245,118 @@ namespace ks
 		FRenderScene(FScene* InScene);
 		~FRenderScene() {}
 		void AddPrimitive(FStaticMeshComponent* MeshComponent);
+		void UpdatePrimitive(FStaticMeshComponent* MeshComponent);
+		// the last primitive moves into PrimIndex, the caller moves its component the same way
+		void RemovePrimitive(uint32 PrimIndex);
+		// refresh the view constants and build or refit the BVH, once per frame before the passes
 		void Update();
-		IRHIConstBuffer1* GetBasePassConstBuffer() { return BasePassConstBuffer1.get(); }
+		// copy the constants of the dirty primitives to the gpu in one batch, recorded in the frame after BeginFrame
+		void UploadPrimitives();
+		/*
+		* views, the camera of the scene is view 0 and the rest are added by the game, split screen or picture in picture
+		* every view is culled and batched on its own job, a view index is stable until a view before it is removed
+		*/
+		uint32 AddView(const FSceneViewDesc& Desc);
+		void SetViewDesc(uint32 ViewIndex, const FSceneViewDesc& Desc);
+		void RemoveView(uint32 ViewIndex);
+		uint32 GetNumViews() const { return static_cast<uint32>(Views.size()); }
+		const FSceneView& GetView(uint32 ViewIndex) const { return Views[ViewIndex]; }
+		// point and spot lights of the scene, indexed by the light clusters of the views
+		const std::vector<FLocalLightData>& GetLocalLights() const { return LocalLights; }
+		// GRHIConfig.NumShadowCascades tiles of the shadow atlas, fit to the main view
+		uint32 GetNumShadowCascades() const { return static_cast<uint32>(ShadowCascades.size()); }
+		const FShadowCascade& GetShadowCascade(uint32 Cascade) const { return ShadowCascades[Cascade]; }
+		// a cascade has movable casters this frame, otherwise the cached static atlas is the shadow map
+		bool HasMovableShadowCasters() const { return bMovableShadowCasters; }
+		IRHIConstBufferArray* GetPrimitiveConstBuffers() { return PrimitiveConstBuffers.get(); }
+		const FPrimitiveUploadStats& GetPrimitiveUploadStats() const { return PrimitiveUploadStats; }
 		const std::vector<PrimPtr>& GetPrimitives() { return Primitives; }
+		// spatial index over the bounds of the static primitives, the leaves hold indices into Primitives
+		const FPrimitiveBVH& GetBVH() const { return BVH; }
+		// spatial index over the bounds of the movable primitives
+		const FLooseGrid& GetDynamicGrid() const { return DynamicGrid; }
+		// frustum cull the primitives of every shadow cascade and camera view in parallel, after Update
+		void ComputeVisibility();
 	private:
+		// camera and light matrices, a view is skipped while its camera, the light, the main view and the scene bounds are unchanged
+		void UpdateView();
+		// split the main view depth and fit a texel snapped light box to every slice
+		void UpdateShadowCascades(const glm::mat4& WorldToLight);
+		glm::mat4 GetViewProjection(const FSceneView& View) const;
+		// gather the point and spot lights and their bounding spheres
+		void UpdateLocalLights();
+		void CullView(FViewVisibility& View, FViewCullScratch& Scratch, ECullPrimitives CullPrimitives) const;
+		// the cached static shadows the box falls in are redrawn
+		void InvalidateStaticShadows(const FBounds::FBox& Box);
+		void MarkPrimitiveDirty(uint32 PrimIndex);
+		// batch of the mesh and material of the primitive, primitives sharing it draw instanced
+		void UpdatePrimitiveBatch(uint32 PrimIndex);
+		// the primitive leaves the batch, the last one frees the batch and its sort ids
+		void ReleasePrimitiveBatch(uint32 BatchId);
+		// group the visible primitives of the view into instanced draws
+		void BuildDrawBatches(FViewVisibility& View, FViewCullScratch& Scratch) const;
+		// move the primitive to the index of its mobility
+		void UpdatePrimitiveIndex(uint32 PrimIndex, bool bMovable);
+		// rasterize the largest frustum visible primitives and drop the ones they hide from the view
+		void CullOcclusion(FSceneView& View) const;
 		FScene* Scene{nullptr};
 		std::vector<PrimPtr> Primitives;
-		// base pass const buffer
-		std::shared_ptr<TConstBuffer<FViewConstBufferParameter>> BasePassConstBuffer;
-		std::shared_ptr<IRHIConstBuffer1> BasePassConstBuffer1;
+		// world boxes of the primitives, the BVH input
+		std::vector<FBounds::FBox> PrimitiveBoxes;
+		FPrimitiveBVH BVH;
+		bool bBVHNeedsBuild{ true };
+		// movable primitives, kept out of the BVH so their moves never refit or rebuild it
+		FLooseGrid DynamicGrid;
+		std::vector<uint32> StaticPrimitives;
+		// the camera views and the cascades of the directional light
+		std::vector<FSceneView> Views;
+		std::vector<FShadowCascade> ShadowCascades;
+		// world boxes of the static primitives added, moved or removed since the last visibility
+		std::vector<FBounds::FBox> StaticShadowChanges;
+		bool bMovableShadowCasters{ false };
+		// frames since the visibility stats were last logged
+		uint32 NumStatsFrames{ 0 };
+		// light and scene constants shared by the views
+		FViewConstBufferParameter LightParameters;
+		// inputs of the last light update
+		FBounds::FBox LastSceneBox{};
+		bool bViewDirty{ true };
+		std::vector<FLocalLightData> LocalLights;
+		// world bounding spheres of LocalLights, the cluster input
+		std::vector<glm::vec4> LocalLightSpheres;
+		/*
+		* batch ids by mesh and material, and the batch of every primitive
+		* the entries live only while a primitive uses them, so the maps stay the size of the scene and an asset
+		* reallocated at the address of a removed one never inherits its ids
+		*/
+		std::map<std::pair<const FMeshRenderData*, const FMaterialAsset*>, uint32> BatchIds;
+		std::vector<FPrimitiveBatch> Batches;
+		std::vector<uint32> FreeBatchIds;
+		std::vector<uint32> PrimitiveBatches;
+		/*
+		* ids of the sort keys of the batches, mesh id above material id so the batches of a mesh are
+		* drawn one after another and share the vertex and index buffer binds
+		* the pipeline is the same for every draw of a pass, so it takes no bits
+		* freed ids are reused first, the ids stay dense and fit the bits of the key
+		*/
+		std::map<const FMeshRenderData*, FSortId> MeshIds;
+		std::map<const FMaterialAsset*, FSortId> MaterialIds;
+		std::vector<uint32> FreeMeshIds;
+		std::vector<uint32> FreeMaterialIds;
+		// primitive constants, written from DirtyPrimitives once per frame
+		std::unique_ptr<IRHIConstBufferArray> PrimitiveConstBuffers;
+		std::vector<uint32> DirtyPrimitives;
+		std::vector<uint8> PrimitiveDirtyFlags;
+		std::vector<FPrimitiveConstBufferParameter> UploadParameters;
+		FPrimitiveUploadStats PrimitiveUploadStats;
 	};
 	/**********************************************************************/
 
+	class FBasePass;
+	class FShadowPass;
+	class FPostProcessPass;
+
+	/* builds the render graph of the scene every frame, the passes keep their pipelines and the graph pool its textures */
 	class FRenderer
 	{
 		friend class FRenderPass;
@@ -77,6 +364,7 @@ namespace ks
 		static FRenderScene* CreateRenderScene(FScene* Scene);
 		static FRenderer* Create() { return new FRenderer; }
 		FRenderer();
+		~FRenderer();
 		void Render();
 		void Shutdown();
 		void SetScene(FRenderScene* _RenderScene) { RenderScene = _RenderScene; }
@@ -84,11 +372,16 @@ namespace ks
 
 	private:
 		void Init();
-		void RenderBasePass();
-		void RenderShadowPass();
-		void RenderPostProcessPass();
 		// referenced render scene by this instance
 		FRenderScene* RenderScene{nullptr};
+		std::unique_ptr<FShadowPass> ShadowPass;
+		std::unique_ptr<FBasePass> BasePass;
+		std::unique_ptr<FPostProcessPass> PostProcessPass;
+		// the transient textures of the graphs
+		FRenderGraphPool GraphPool;
+		// counts of the last graph, logged when they change
+		FRenderGraph::FStats LastGraphStats;
+		uint32 LastNumPooledTextures{ 0 };
 		// global allocated render scenes management
 		static std::unordered_map<const FRenderScene*, std::unique_ptr<FRenderScene>> RenderScenes;
 	};
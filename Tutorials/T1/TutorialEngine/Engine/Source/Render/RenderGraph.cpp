@@ -0,0 +1,364 @@
+#include "engine_pch.h"
+#include "Render/RenderGraph.h"
+#include "RHI/RHI.h"
+
+namespace ks
+{
+	namespace
+	{
+		// well past the frames in flight, a released texture is no longer on the gpu
+		constexpr uint32 MaxUnusedFrames{ 60 };
+	}
+
+	void FRGPassBuilder::Read(FRGTextureRef Texture)
+	{
+		assert(Texture.IsValid());
+		Reads.push_back(Texture.Index);
+	}
+
+	void FRGPassBuilder::Write(FRGTextureRef Texture)
+	{
+		assert(Texture.IsValid());
+		Writes.push_back(Texture.Index);
+	}
+
+	void FRGPassBuilder::SetRenderTarget(FRGTextureRef Texture, ERGLoadAction LoadAction, const FColor& InClearColor)
+	{
+		assert(!RenderTarget.IsValid());
+		RenderTarget = Texture;
+		RenderTargetLoad = LoadAction;
+		ClearColor = &InClearColor;
+		Write(Texture);
+		if (LoadAction == ERGLoadAction::LOAD)
+		{
+			Read(Texture);
+		}
+	}
+
+	void FRGPassBuilder::SetDepthStencil(FRGTextureRef Texture, ERGLoadAction LoadAction)
+	{
+		assert(!DepthStencil.IsValid());
+		DepthStencil = Texture;
+		DepthStencilLoad = LoadAction;
+		Write(Texture);
+		if (LoadAction == ERGLoadAction::LOAD)
+		{
+			Read(Texture);
+		}
+	}
+
+	/**********************************************************************/
+
+	IRHITexture2D* FRGPassContext::GetTexture2D(FRGTextureRef Texture) const
+	{
+		const auto& GraphTexture{ Graph.Textures[Texture.Index] };
+		return GraphTexture.DepthStencilBuffer ? GraphTexture.DepthStencilBuffer->GetTexture2D() : GraphTexture.RenderTarget->GetTexture2D();
+	}
+
+	IRHIRenderTarget* FRGPassContext::GetRenderTarget(FRGTextureRef Texture) const
+	{
+		return Graph.Textures[Texture.Index].RenderTarget;
+	}
+
+	IRHIDepthStencilBuffer* FRGPassContext::GetDepthStencilBuffer(FRGTextureRef Texture) const
+	{
+		return Graph.Textures[Texture.Index].DepthStencilBuffer;
+	}
+
+	/**********************************************************************/
+
+	uint32 FRenderGraphPool::Acquire(const FRGTextureDesc& Desc)
+	{
+		++Stats.NumTransients;
+		for (uint32 PoolIndex = 0; PoolIndex < Textures.size(); ++PoolIndex)
+		{
+			FPooledTexture& Texture{ Textures[PoolIndex] };
+			if (!Texture.bInUse && Texture.Desc == Desc)
+			{
+				Texture.bInUse = true;
+				AcquiredThisFrame.push_back(PoolIndex);
+				return PoolIndex;
+			}
+		}
+		FPooledTexture& Texture{ Textures.emplace_back() };
+		Texture.Desc = Desc;
+		FTexture2DDesc TextureDesc;
+		TextureDesc.Width = Desc.Width;
+		TextureDesc.Height = Desc.Height;
+		TextureDesc.Format = Desc.Format;
+		if (Desc.bDepthStencil)
+		{
+			Texture.DepthStencilBuffer.reset(GRHI->CreateDepthStencilBuffer(TextureDesc));
+		}
+		else
+		{
+			Texture.RenderTarget.reset(GRHI->CreateRenderTarget(TextureDesc));
+		}
+		Texture.bInUse = true;
+		AcquiredThisFrame.push_back(static_cast<uint32>(Textures.size() - 1));
+		return static_cast<uint32>(Textures.size() - 1);
+	}
+
+	void FRenderGraphPool::Release(uint32 PoolIndex)
+	{
+		assert(Textures[PoolIndex].bInUse);
+		Textures[PoolIndex].bInUse = false;
+	}
+
+	void FRenderGraphPool::EndFrame()
+	{
+		std::sort(AcquiredThisFrame.begin(), AcquiredThisFrame.end());
+		AcquiredThisFrame.erase(std::unique(AcquiredThisFrame.begin(), AcquiredThisFrame.end()), AcquiredThisFrame.end());
+		Stats.NumAcquired = static_cast<uint32>(AcquiredThisFrame.size());
+		for (FPooledTexture& Texture : Textures)
+		{
+			++Texture.NumUnusedFrames;
+		}
+		for (uint32 PoolIndex : AcquiredThisFrame)
+		{
+			Textures[PoolIndex].NumUnusedFrames = 0;
+		}
+		AcquiredThisFrame.clear();
+		std::erase_if(Textures, [](const FPooledTexture& Texture) { return Texture.NumUnusedFrames > MaxUnusedFrames; });
+		Stats.NumTextures = static_cast<uint32>(Textures.size());
+	}
+
+	/**********************************************************************/
+
+	FRGTextureRef FRenderGraph::AddTexture(FTexture&& Texture)
+	{
+		assert(!bCompiled);
+		Textures.push_back(std::move(Texture));
+		return FRGTextureRef{ static_cast<uint32>(Textures.size() - 1) };
+	}
+
+	FRGTextureRef FRenderGraph::CreateTexture(const std::string& Name, const FRGTextureDesc& Desc)
+	{
+		FTexture Texture;
+		Texture.Name = Name;
+		Texture.Desc = Desc;
+		return AddTexture(std::move(Texture));
+	}
+
+	FRGTextureRef FRenderGraph::ImportRenderTarget(const std::string& Name, IRHIRenderTarget* RenderTarget)
+	{
+		FTexture Texture;
+		Texture.Name = Name;
+		Texture.RenderTarget = RenderTarget;
+		Texture.bImported = true;
+		return AddTexture(std::move(Texture));
+	}
+
+	FRGTextureRef FRenderGraph::ImportDepthStencilBuffer(const std::string& Name, IRHIDepthStencilBuffer* DepthStencilBuffer)
+	{
+		FTexture Texture;
+		Texture.Name = Name;
+		Texture.DepthStencilBuffer = DepthStencilBuffer;
+		Texture.Desc.bDepthStencil = true;
+		Texture.bImported = true;
+		return AddTexture(std::move(Texture));
+	}
+
+	void FRenderGraph::AddPass(const std::string& Name, const FSetupFunc& Setup, FExecuteFunc&& Execute)
+	{
+		assert(!bCompiled);
+		const uint32 PassIndex{ static_cast<uint32>(Passes.size()) };
+		FPass& Pass{ Passes.emplace_back() };
+		Pass.Name = Name;
+		Pass.Execute = std::move(Execute);
+		Setup(Pass.Builder);
+		// a raster pass always binds a depth stencil, the rhi transitions it in BeginPass
+		assert(!Pass.Builder.RenderTarget.IsValid() || Pass.Builder.DepthStencil.IsValid());
+		for (uint32 Texture : Pass.Builder.Reads)
+		{
+			Textures[Texture].Readers.push_back(PassIndex);
+		}
+		for (uint32 Texture : Pass.Builder.Writes)
+		{
+			Textures[Texture].Writers.push_back(PassIndex);
+		}
+	}
+
+	void FRenderGraph::GetDependencies(uint32 Pass, std::vector<uint32>& OutPasses, std::vector<uint32>& OutOrderedAfter) const
+	{
+		// a reader waits for the last writer declared before it, a writer for the writers and readers declared before it,
+		// every edge points to an earlier pass so declaration order is a valid order for every hazard
+		const FRGPassBuilder& Builder{ Passes[Pass].Builder };
+		for (uint32 Texture : Builder.Reads)
+		{
+			const std::vector<uint32>& Writers{ Textures[Texture].Writers };
+			const auto LastWriter{ std::lower_bound(Writers.begin(), Writers.end(), Pass) };
+			if (LastWriter != Writers.begin())
+			{
+				OutPasses.push_back(*std::prev(LastWriter));
+			}
+		}
+		for (uint32 Texture : Builder.Writes)
+		{
+			for (uint32 Writer : Textures[Texture].Writers)
+			{
+				if (Writer >= Pass)
+				{
+					break;
+				}
+				OutPasses.push_back(Writer);
+			}
+			// write after read, the earlier readers see the content before this write
+			for (uint32 Reader : Textures[Texture].Readers)
+			{
+				if (Reader >= Pass)
+				{
+					break;
+				}
+				OutOrderedAfter.push_back(Reader);
+			}
+		}
+	}
+
+	void FRenderGraph::Compile()
+	{
+		assert(!bCompiled);
+		const uint32 NumPasses{ static_cast<uint32>(Passes.size()) };
+		std::vector<std::vector<uint32>> Dependencies(NumPasses);
+		std::vector<std::vector<uint32>> OrderedAfter(NumPasses);
+		for (uint32 Pass = 0; Pass < NumPasses; ++Pass)
+		{
+			GetDependencies(Pass, Dependencies[Pass], OrderedAfter[Pass]);
+		}
+
+		// the passes writing imported textures and everything they depend on survive
+		std::vector<uint8> Needed(NumPasses, 0);
+		std::vector<uint32> Stack;
+		for (uint32 Pass = 0; Pass < NumPasses; ++Pass)
+		{
+			for (uint32 Texture : Passes[Pass].Builder.Writes)
+			{
+				if (Textures[Texture].bImported && !Needed[Pass])
+				{
+					Needed[Pass] = 1;
+					Stack.push_back(Pass);
+				}
+			}
+		}
+		while (!Stack.empty())
+		{
+			const uint32 Pass{ Stack.back() };
+			Stack.pop_back();
+			for (uint32 Dependency : Dependencies[Pass])
+			{
+				if (!Needed[Dependency])
+				{
+					Needed[Dependency] = 1;
+					Stack.push_back(Dependency);
+				}
+			}
+		}
+
+		// the earliest declared pass whose dependencies ran goes next, so a graph declared in order keeps it
+		Order.clear();
+		std::vector<uint8> Scheduled(NumPasses, 0);
+		uint32 NumNeeded{ 0 };
+		for (uint32 Pass = 0; Pass < NumPasses; ++Pass)
+		{
+			Passes[Pass].bCulled = !Needed[Pass];
+			NumNeeded += Needed[Pass];
+		}
+		while (Order.size() < NumNeeded)
+		{
+			uint32 Next{ NumPasses };
+			for (uint32 Pass = 0; Pass < NumPasses && Next == NumPasses; ++Pass)
+			{
+				if (Needed[Pass] && !Scheduled[Pass] && std::all_of(Dependencies[Pass].begin(), Dependencies[Pass].end(),
+					[&Scheduled](uint32 Dependency) { return Scheduled[Dependency] != 0; }) &&
+					std::all_of(OrderedAfter[Pass].begin(), OrderedAfter[Pass].end(),
+					[&Scheduled, &Needed](uint32 Reader) { return Scheduled[Reader] != 0 || !Needed[Reader]; }))
+				{
+					Next = Pass;
+				}
+			}
+			// the edges point to earlier passes, the earliest unscheduled pass is always ready
+			assert(Next != NumPasses);
+			if (Next == NumPasses)
+			{
+				break;
+			}
+			Scheduled[Next] = 1;
+			Order.push_back(Next);
+		}
+
+		// the lifetime of every transient spans its passes in the order
+		for (uint32 Position = 0; Position < Order.size(); ++Position)
+		{
+			const FRGPassBuilder& Builder{ Passes[Order[Position]].Builder };
+			for (const std::vector<uint32>* Accesses : { &Builder.Reads, &Builder.Writes })
+			{
+				for (uint32 Texture : *Accesses)
+				{
+					FTexture& GraphTexture{ Textures[Texture] };
+					GraphTexture.FirstPass = std::min(GraphTexture.FirstPass, Position);
+					GraphTexture.LastPass = std::max(GraphTexture.LastPass, Position);
+				}
+			}
+		}
+		Stats.NumPasses = NumPasses;
+		Stats.NumCulled = NumPasses - NumNeeded;
+		bCompiled = true;
+	}
+
+	void FRenderGraph::Execute()
+	{
+		if (!bCompiled)
+		{
+			Compile();
+		}
+		Pool.Stats.NumTransients = 0;
+		for (uint32 Position = 0; Position < Order.size(); ++Position)
+		{
+			FPass& Pass{ Passes[Order[Position]] };
+			const FRGPassBuilder& Builder{ Pass.Builder };
+			// the transients starting here take a free pooled texture, possibly one a finished transient gave back
+			for (FTexture& Texture : Textures)
+			{
+				if (!Texture.bImported && Texture.FirstPass == Position)
+				{
+					Texture.PoolIndex = Pool.Acquire(Texture.Desc);
+					FRenderGraphPool::FPooledTexture& PooledTexture{ Pool.Textures[Texture.PoolIndex] };
+					Texture.RenderTarget = PooledTexture.RenderTarget.get();
+					Texture.DepthStencilBuffer = PooledTexture.DepthStencilBuffer.get();
+				}
+			}
+
+			const FRGPassContext Context(*this);
+			if (Builder.DepthStencil.IsValid())
+			{
+				GRHI->SetRenderTarget(Builder.RenderTarget.IsValid() ? Textures[Builder.RenderTarget.Index].RenderTarget : nullptr,
+					Textures[Builder.DepthStencil.Index].DepthStencilBuffer);
+				GRHI->BeginPass();
+				if (Builder.RenderTarget.IsValid() && Builder.RenderTargetLoad == ERGLoadAction::CLEAR)
+				{
+					GRHI->ClearRenderTarget(*Builder.ClearColor);
+				}
+				if (Builder.DepthStencilLoad == ERGLoadAction::CLEAR)
+				{
+					GRHI->ClearDepthStencilBuffer();
+				}
+				Pass.Execute(Context);
+				GRHI->EndPass();
+			}
+			else
+			{
+				Pass.Execute(Context);
+			}
+
+			// the transients ending here give their texture back for the passes after
+			for (FTexture& Texture : Textures)
+			{
+				if (!Texture.bImported && Texture.LastPass == Position && Texture.PoolIndex != ~0u)
+				{
+					Pool.Release(Texture.PoolIndex);
+				}
+			}
+		}
+		Pool.EndFrame();
+	}
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include "Core/CoreMinimal.h"
+#include "RHI/RHIResource.h"
+
+namespace ks
+{
+	class FRenderGraph;
+
+	/* a texture of a render graph, valid for the frame of the graph */
+	struct FRGTextureRef
+	{
+		static constexpr uint32 InvalidIndex{ ~0u };
+		uint32 Index{ InvalidIndex };
+		bool IsValid() const { return Index != InvalidIndex; }
+	};
+
+	struct FRGTextureDesc
+	{
+		uint32 Width{ 0 };
+		uint32 Height{ 0 };
+		// the depth stencil buffers take GRHIConfig.DepthBufferFormat
+		EELEM_FORMAT Format{ EELEM_FORMAT::UNKNOWN };
+		bool bDepthStencil{ false };
+		bool operator==(const FRGTextureDesc& Other) const = default;
+	};
+
+	enum class ERGLoadAction : uint8
+	{
+		// the pass draws over what the earlier writers left, it depends on them
+		LOAD,
+		CLEAR,
+	};
+
+	/* the reads and writes a pass declares while it is added */
+	class FRGPassBuilder
+	{
+		friend class FRenderGraph;
+	public:
+		// sampled by the pass
+		void Read(FRGTextureRef Texture);
+		// written outside a render target binding, by a copy
+		void Write(FRGTextureRef Texture);
+		// bound for the draws of the pass, a raster pass has a depth stencil and at most one color target
+		void SetRenderTarget(FRGTextureRef Texture, ERGLoadAction LoadAction, const FColor& ClearColor = color::Black);
+		void SetDepthStencil(FRGTextureRef Texture, ERGLoadAction LoadAction);
+	private:
+		std::vector<uint32> Reads;
+		std::vector<uint32> Writes;
+		FRGTextureRef RenderTarget;
+		FRGTextureRef DepthStencil;
+		ERGLoadAction RenderTargetLoad{ ERGLoadAction::LOAD };
+		ERGLoadAction DepthStencilLoad{ ERGLoadAction::LOAD };
+		// one of the color constants, they outlive every graph
+		const FColor* ClearColor{ &color::Black };
+	};
+
+	/* the physical textures of a pass while it executes */
+	class FRGPassContext
+	{
+		friend class FRenderGraph;
+	public:
+		IRHITexture2D* GetTexture2D(FRGTextureRef Texture) const;
+		IRHIRenderTarget* GetRenderTarget(FRGTextureRef Texture) const;
+		IRHIDepthStencilBuffer* GetDepthStencilBuffer(FRGTextureRef Texture) const;
+	private:
+		explicit FRGPassContext(const FRenderGraph& InGraph) :Graph(InGraph) {}
+		const FRenderGraph& Graph;
+	};
+
+	/*
+	* the physical textures behind the transient textures of the graphs, kept across frames
+	* a texture is free again once the last pass of the transient it backs has run, so a later transient of the same
+	* description aliases it and the pool holds the peak of textures alive at once rather than one per pass
+	*/
+	class FRenderGraphPool
+	{
+		friend class FRenderGraph;
+	public:
+		struct FStats
+		{
+			uint32 NumTextures{ 0 };
+			// transients of the last graph and the textures they took
+			uint32 NumTransients{ 0 };
+			uint32 NumAcquired{ 0 };
+		};
+		const FStats& GetStats() const { return Stats; }
+	private:
+		struct FPooledTexture
+		{
+			FRGTextureDesc Desc;
+			std::unique_ptr<IRHIRenderTarget> RenderTarget;
+			std::unique_ptr<IRHIDepthStencilBuffer> DepthStencilBuffer;
+			bool bInUse{ false };
+			// graphs since the texture was last used
+			uint32 NumUnusedFrames{ 0 };
+		};
+		uint32 Acquire(const FRGTextureDesc& Desc);
+		void Release(uint32 PoolIndex);
+		// release the textures no graph took for a while, a window resize leaves the old sizes behind
+		void EndFrame();
+
+		std::vector<FPooledTexture> Textures;
+		// the pool indices acquired by the current graph
+		std::vector<uint32> AcquiredThisFrame;
+		FStats Stats;
+	};
+
+	/*
+	* the passes of a frame and the textures they read and write, rebuilt every frame
+	* Compile culls the passes none of the imported textures depend on, orders the rest so every access sees the
+	* writes declared before it and none after, and gives every transient texture the lifetime from its first to its last pass
+	* Execute binds the targets of each pass, the RHI places the barriers around BeginPass and EndPass,
+	* and hands the transients pooled textures for their lifetime only
+	*/
+	class FRenderGraph
+	{
+	public:
+		using FSetupFunc = std::function<void(FRGPassBuilder&)>;
+		using FExecuteFunc = std::function<void(const FRGPassContext&)>;
+
+		struct FStats
+		{
+			uint32 NumPasses{ 0 };
+			uint32 NumCulled{ 0 };
+		};
+
+		explicit FRenderGraph(FRenderGraphPool& InPool) :Pool(InPool) {}
+		// a texture of this frame, backed by a pooled texture from its first pass to its last
+		FRGTextureRef CreateTexture(const std::string& Name, const FRGTextureDesc& Desc);
+		// textures that outlive the graph, the passes writing them are never culled
+		FRGTextureRef ImportRenderTarget(const std::string& Name, IRHIRenderTarget* RenderTarget);
+		FRGTextureRef ImportDepthStencilBuffer(const std::string& Name, IRHIDepthStencilBuffer* DepthStencilBuffer);
+		// Setup runs now and declares the accesses, Execute runs in Execute if the pass survives the compile
+		void AddPass(const std::string& Name, const FSetupFunc& Setup, FExecuteFunc&& Execute);
+		void Compile();
+		// record the passes in their order, compiles first if needed
+		void Execute();
+		const FStats& GetStats() const { return Stats; }
+	private:
+		friend class FRGPassContext;
+		struct FTexture
+		{
+			std::string Name;
+			FRGTextureDesc Desc;
+			// null for the transients until their first pass
+			IRHIRenderTarget* RenderTarget{ nullptr };
+			IRHIDepthStencilBuffer* DepthStencilBuffer{ nullptr };
+			bool bImported{ false };
+			// the passes writing and reading it, in declaration order
+			std::vector<uint32> Writers;
+			std::vector<uint32> Readers;
+			// positions in the execution order, the lifetime of a transient
+			uint32 FirstPass{ ~0u };
+			uint32 LastPass{ 0 };
+			uint32 PoolIndex{ ~0u };
+		};
+		struct FPass
+		{
+			std::string Name;
+			FRGPassBuilder Builder;
+			FExecuteFunc Execute;
+			bool bCulled{ false };
+		};
+		FRGTextureRef AddTexture(FTexture&& Texture);
+		// the passes whose writes Pass uses, they survive with it, and the earlier readers of what Pass overwrites,
+		// which only have to run first if they survive
+		void GetDependencies(uint32 Pass, std::vector<uint32>& OutPasses, std::vector<uint32>& OutOrderedAfter) const;
+
+		FRenderGraphPool& Pool;
+		std::vector<FTexture> Textures;
+		std::vector<FPass> Passes;
+		// indices into Passes of the surviving passes in execution order
+		std::vector<uint32> Order;
+		bool bCompiled{ false };
+		FStats Stats;
+	};
+}
@@ -3,11 +3,10 @@
 #include "RHI/RHI.h"
 #include "Render/Render.h"
 #include "Render/MeshRenderData.h"
+#include "Core/JobSystem.h"
 
 namespace ks
 {
-	std::unordered_map<std::string, std::unique_ptr<FRenderPass>> FRenderPass::RenderPasses;
-
 	FRenderPass::FRenderPass(const FRenderPassDesc& _Desc)
 		:Desc(_Desc)
 	{
@@ -15,94 +14,149 @@ namespace ks
 		RHIPipelineState.reset(pPipelineState);
 	}
 
-	/*****************************************************************************/
-	FBasePass::FBasePass(const FRenderPassDesc& _Desc)
-		:FRenderPass(_Desc)
+	FRenderPass::~FRenderPass()
 	{
-		FTexture2DDesc SceneColorDesc;
-		SceneColorDesc.Width = Desc.ViewPort.Width;
-		SceneColorDesc.Height = Desc.ViewPort.Height;
-		SceneColorDesc.Format = _Desc.PipelineStateDesc.RenderTargetFormats[0];
-		SceneColorMap.reset(GRHI->CreateRenderTarget(SceneColorDesc));
-		SceneColorMap->GetTexture2D()->SetLocationIndex(3);
 	}
 
-	FBasePass::~FBasePass()
+	void FRenderPass::RecordDrawBatches(FRenderScene* RenderScene, const std::vector<const FViewVisibility*>& Views, const FSetViewStateFunc& SetViewState)
 	{
+		uint32 NumBatches{ 0 };
+		for (const FViewVisibility* View : Views)
+		{
+			NumBatches += static_cast<uint32>(View->DrawBatches.size());
+		}
+		if (NumBatches == 0)
+		{
+			return;
+		}
+		// about a chunk per thread, a view takes at least one list of its own
+		const uint32 NumThreads{ GJobSystem ? GJobSystem->GetNumWorkers() + 1 : 1 };
+		const uint32 BatchesPerChunk{ std::max(MinBatchesPerCommandList, (NumBatches + NumThreads - 1) / NumThreads) };
+		DrawChunks.clear();
+		for (uint32 ViewIndex = 0; ViewIndex < Views.size(); ++ViewIndex)
+		{
+			const uint32 ViewBatches{ static_cast<uint32>(Views[ViewIndex]->DrawBatches.size()) };
+			for (uint32 FirstBatch = 0; FirstBatch < ViewBatches; FirstBatch += BatchesPerChunk)
+			{
+				DrawChunks.push_back(FDrawChunk{ ViewIndex, FirstBatch, std::min(BatchesPerChunk, ViewBatches - FirstBatch) });
+			}
+		}
+		const uint32 NumChunks{ static_cast<uint32>(DrawChunks.size()) };
+		while (CommandLists.size() < NumChunks)
+		{
+			CommandLists.emplace_back(GRHI->CreateCommandList());
+		}
 
+		IRHIConstBufferArray* PrimitiveConstBuffers{ RenderScene->GetPrimitiveConstBuffers() };
+		auto RecordChunk = [&](uint32 ChunkIndex) {
+			const FDrawChunk& Chunk{ DrawChunks[ChunkIndex] };
+			const FViewVisibility& View{ *Views[Chunk.View] };
+			IRHICommandList& CommandList{ *CommandLists[ChunkIndex] };
+			CommandList.Begin();
+			CommandList.SetPipelineState(RHIPipelineState.get());
+			SetViewState(CommandList, Chunk.View);
+			// the vertex shaders read the primitive constants by the per instance primitive index
+			CommandList.SetStructuredBuffer(PrimitiveConstBuffers);
+			// the instances of the chunk only, its draws count them from its first batch
+			const FDrawBatch* Batches{ View.DrawBatches.data() + Chunk.FirstBatch };
+			const FDrawBatch& LastBatch{ Batches[Chunk.NumBatches - 1] };
+			const uint32 FirstInstance{ Batches[0].FirstInstance };
+			const uint32 NumInstances{ LastBatch.FirstInstance + LastBatch.NumInstances - FirstInstance };
+			CommandList.SetInstanceBuffer(InstanceSlot, sizeof(uint32), NumInstances, View.InstancePrimitives.data() + FirstInstance);
+			// the batches of a mesh are adjacent and share its command, the rhi binds its buffers once
+			for (uint32 i = 0; i < Chunk.NumBatches; ++i)
+			{
+				CommandList.DrawCommandInstanced(Batches[i].DrawCommand, Batches[i].NumInstances, Batches[i].FirstInstance - FirstInstance);
+			}
+			CommandList.End();
+		};
+		if (GJobSystem && NumChunks > 1)
+		{
+			GJobSystem->ParallelFor(NumChunks, RecordChunk);
+		}
+		else
+		{
+			for (uint32 ChunkIndex = 0; ChunkIndex < NumChunks; ++ChunkIndex)
+			{
+				RecordChunk(ChunkIndex);
+			}
+		}
+
+		SubmitLists.resize(NumChunks);
+		for (uint32 ChunkIndex = 0; ChunkIndex < NumChunks; ++ChunkIndex)
+		{
+			SubmitLists[ChunkIndex] = CommandLists[ChunkIndex].get();
+		}
+		GRHI->ExecuteCommandLists(SubmitLists.data(), NumChunks);
 	}
 
-	void FBasePass::Begin()
+	IRHITexture2D* FRenderPass::GetTexture(const FRGPassContext& Context, FRGTextureRef Texture, int32 LocationIndex)
 	{
-		// Set the viewport and scissor rect.  This needs to be reset whenever the command list is reset.
-		GRHI->SetViewports(1, &Desc.ViewPort);
-
-		// set render target and depth stencil buffer
-		//GRHI->SetRenderTarget(GRHI->GetCurrentBackBuffer(), GRHI->GetDefaultDepthStencilBuffer());
-		GRHI->SetRenderTarget(SceneColorMap.get(), GRHI->GetDefaultDepthStencilBuffer());
-
-		GRHI->BeginPass();
-
-		// Clear the back buffer
-		GRHI->ClearRenderTarget(color::Black);
+		// a pooled texture serves different passes, the table is picked at the bind
+		IRHITexture2D* Texture2D{ Context.GetTexture2D(Texture) };
+		Texture2D->SetLocationIndex(LocationIndex);
+		return Texture2D;
+	}
 
-		// clear the depth buffer
-		GRHI->ClearDepthStencilBuffer();
+	void FRenderPass::SetTexture(const FRGPassContext& Context, FRGTextureRef Texture, int32 LocationIndex)
+	{
+		GRHI->SetTexture2D(GetTexture(Context, Texture, LocationIndex));
 	}
 
-	void FBasePass::Render()
+	/*****************************************************************************/
+	FBasePass::FBasePass(const FRenderPassDesc& _Desc)
+		:FRenderPass(_Desc)
 	{
-		auto Renderer{Desc.Renderer};
-		auto RenderScene = Renderer->GetScene();
-
-		// set pipeline state and root signature and primitive type
-		GRHI->SetPipelineState(RHIPipelineState.get());
-
-		// bind shadow map parameter
-		auto ShadowPass = dynamic_cast<FShadowPass*>(FRenderPass::GetPass("ShadowPass"));
-		GRHI->SetTexture2D(ShadowPass->GetShadowTexture2D());
-		
-		// bind pass shader parameter
-#if !RHICONSTBUFFER_V1
-		GRHI->SetShaderConstBuffer(Renderer->RenderScene->BasePassConstBuffer->GetRHIConstBuffer());
-#else
-		GRHI->SetConstBuffer(RenderScene->GetBasePassConstBuffer());
-#endif
-		
-		auto& Primitives{RenderScene->GetPrimitives()};
-		// bind primitive shader parameter
-		for (int32 i{0}; i < Primitives.size(); ++i)
-		{
-			FRenderPrimitive* Prim{Primitives.at(i).get()};
-#if !RHICONSTBUFFER_V1
-			GRHI->SetShaderConstBuffer(Prim->GetPrimitiveConstBuffer()->GetRHIConstBuffer());
-#else
-			GRHI->SetConstBuffer(Prim->GetConstBuffer());
-#endif
-			// set vertex input
-			const FMeshRenderData* MeshRenderData{ Prim->GetRenderData() };
-#if !RHIVERTBUFFER_V1
-			const IRHIVertexBuffer* VertexBuffers[] = {MeshRenderData->GetRHIVertexBuffer(), MeshRenderData->GetRHIAttrBuffer()};
-			GRHI->SetVertexBuffers(VertexBuffers, _countof(VertexBuffers));
-#else
-			const IRHIVertexBuffer1* VertexBuffers1[] = {MeshRenderData->GetRHIVertexBuffer1(), MeshRenderData->GetRHIAttrBuffer1()};
-			GRHI->SetVertexBuffers1(VertexBuffers1, _countof(VertexBuffers1));
-#endif
-			// set index buffer and draw primitives
-#if RHIINDEXBUFFER_V1
-			const IRHIIndexBuffer1* IndexBuffer{ MeshRenderData->GetRHIIndexBuffer1() };
-			GRHI->DrawIndexedPrimitive1(IndexBuffer);
-#else
-			const IRHIIndexBuffer* IndexBuffer{ MeshRenderData->GetRHIIndexBuffer() };
-			GRHI->DrawIndexedPrimitive(IndexBuffer);
-#endif
-		}
-		// end
 	}
 
-	void FBasePass::End()
+	FRGTextureRef FBasePass::AddPass(FRenderGraph& Graph, FRenderScene* RenderScene, FRGTextureRef ShadowMap, FRGTextureRef SceneDepth)
 	{
-		GRHI->EndPass();
+		FRGTextureDesc SceneColorDesc;
+		SceneColorDesc.Width = Desc.ViewPort.Width;
+		SceneColorDesc.Height = Desc.ViewPort.Height;
+		SceneColorDesc.Format = Desc.PipelineStateDesc.RenderTargetFormats[0];
+		const FRGTextureRef SceneColor{ Graph.CreateTexture("SceneColor", SceneColorDesc) };
+		Graph.AddPass(Desc.Name,
+			[&](FRGPassBuilder& Builder) {
+				Builder.Read(ShadowMap);
+				Builder.SetRenderTarget(SceneColor, ERGLoadAction::CLEAR, color::Black);
+				Builder.SetDepthStencil(SceneDepth, ERGLoadAction::CLEAR);
+			},
+			[this, RenderScene, ShadowMap](const FRGPassContext& Context) {
+				IRHITexture2D* ShadowMapTexture{ GetTexture(Context, ShadowMap, ShadowMapLocation) };
+				// point and spot lights, each view picks them per cluster
+				// uploaded once here, the lists of a view only bind the addresses
+				const std::vector<FLocalLightData>& LocalLights{ RenderScene->GetLocalLights() };
+				const FRHIFrameData LocalLightsData{ GRHI->UploadFrameData(sizeof(FLocalLightData), static_cast<uint32>(LocalLights.size()), LocalLights.data()) };
+				std::vector<const FViewVisibility*> Views;
+				std::vector<FRHIFrameData> ClusterRanges;
+				std::vector<FRHIFrameData> ClusterLightIndices;
+				for (uint32 ViewIndex = 0; ViewIndex < RenderScene->GetNumViews(); ++ViewIndex)
+				{
+					const FSceneView& View{ RenderScene->GetView(ViewIndex) };
+					Views.push_back(&View.Visibility);
+					const std::vector<glm::uvec2>& Ranges{ View.LightClusters.GetRanges() };
+					const std::vector<uint32>& LightIndices{ View.LightClusters.GetLightIndices() };
+					ClusterRanges.push_back(GRHI->UploadFrameData(sizeof(glm::uvec2), static_cast<uint32>(Ranges.size()), Ranges.data()));
+					ClusterLightIndices.push_back(GRHI->UploadFrameData(sizeof(uint32), static_cast<uint32>(LightIndices.size()), LightIndices.data()));
+				}
+				// every view into its rectangle, the views share the shadow map and the primitive constants
+				RecordDrawBatches(RenderScene, Views, [&](IRHICommandList& CommandList, uint32 ViewIndex) {
+					const FSceneView& View{ RenderScene->GetView(ViewIndex) };
+					CommandList.SetViewports(1, &View.ViewPort);
+
+					// bind shadow map parameter
+					CommandList.SetTexture2D(ShadowMapTexture);
+
+					CommandList.SetShaderResourceData(LocalLightsLocation, LocalLightsData);
+					CommandList.SetShaderResourceData(ClusterRangesLocation, ClusterRanges[ViewIndex]);
+					CommandList.SetShaderResourceData(ClusterLightIndicesLocation, ClusterLightIndices[ViewIndex]);
+
+					// bind pass shader parameter
+					CommandList.SetConstBuffer(View.ConstBuffer.get());
+				});
+			});
+		return SceneColor;
 	}
 
 	/*****************************************************************************/
@@ -112,55 +166,92 @@ namespace ks
 		FTexture2DDesc DepthDesc;
 		DepthDesc.Width = Desc.ViewPort.Width;
 		DepthDesc.Height = Desc.ViewPort.Height;
-		ShadowMap.reset(GRHI->CreateDepthStencilBuffer(DepthDesc));
-		ShadowMap->GetTexture2D()->SetLocationIndex(2);
-	}
-
-	void FShadowPass::Begin()
-	{
-		// Set the viewport and scissor rect.  This needs to be reset whenever the command list is reset.
-		GRHI->SetViewports(1, &Desc.ViewPort);
-
-		// set render target and depth stencil buffer
-		GRHI->SetRenderTarget(nullptr, ShadowMap.get());
-
-		GRHI->BeginPass();
-
-		// clear the depth buffer
-		GRHI->ClearDepthStencilBuffer();
+		StaticShadowMap.reset(GRHI->CreateDepthStencilBuffer(DepthDesc));
 	}
 
-	void FShadowPass::Render()
+	FRGTextureRef FShadowPass::AddPasses(FRenderGraph& Graph, FRenderScene* RenderScene)
 	{
-		auto Renderer{ Desc.Renderer };
-		auto RenderScene{ Renderer->GetScene() };
-
-		// set pipeline state and root signature and primitive type
-		GRHI->SetPipelineState(RHIPipelineState.get());
-
-		// bind pass shader parameter
-		GRHI->SetConstBuffer(RenderScene->GetBasePassConstBuffer());
-
-		auto& Primitives{ RenderScene->GetPrimitives() };
-		// bind primitive shader parameter
-		for (int32 i{ 0 }; i < Primitives.size(); ++i)
+		// the cascades drawn by a pass and their casters, static or movable
+		auto DrawCascades = [this, RenderScene](const std::vector<const FShadowCascade*>& Cascades, bool bStatic) {
+			std::vector<const FViewVisibility*> Views;
+			for (const FShadowCascade* ShadowCascade : Cascades)
+			{
+				Views.push_back(bStatic ? &ShadowCascade->StaticVisibility : &ShadowCascade->Visibility);
+			}
+			RecordDrawBatches(RenderScene, Views, [&Cascades](IRHICommandList& CommandList, uint32 ViewIndex) {
+				CommandList.SetViewports(1, &Cascades[ViewIndex]->ViewPort);
+
+				// bind pass shader parameter
+				CommandList.SetConstBuffer(Cascades[ViewIndex]->ConstBuffer.get());
+			});
+		};
+		const uint32 NumCascades{ RenderScene->GetNumShadowCascades() };
+		const FRGTextureRef StaticShadowMapRef{ Graph.ImportDepthStencilBuffer("StaticShadowMap", StaticShadowMap.get()) };
+
+		// redraw the static casters of the cascades whose cache went stale, the other tiles are kept
+		bool bDrawStatic{ false };
+		for (uint32 Cascade = 0; Cascade < NumCascades; ++Cascade)
 		{
-			FRenderPrimitive* Prim{ Primitives.at(i).get() };
-
-			GRHI->SetConstBuffer(Prim->GetConstBuffer());
-			// set vertex input
-			const FMeshRenderData* MeshRenderData{ Prim->GetRenderData() };
-			const IRHIVertexBuffer1* VertexBuffers1[] = { MeshRenderData->GetRHIVertexBuffer1(), MeshRenderData->GetRHIAttrBuffer1() };
-			GRHI->SetVertexBuffers1(VertexBuffers1, _countof(VertexBuffers1));
-			// set index buffer and draw primitives
-			const IRHIIndexBuffer1* IndexBuffer{ MeshRenderData->GetRHIIndexBuffer1() };
-			GRHI->DrawIndexedPrimitive1(IndexBuffer);
+			bDrawStatic |= RenderScene->GetShadowCascade(Cascade).bDrawStatic;
+		}
+		if (bDrawStatic)
+		{
+			Graph.AddPass(Desc.Name + "Static",
+				[&](FRGPassBuilder& Builder) {
+					Builder.SetDepthStencil(StaticShadowMapRef, ERGLoadAction::LOAD);
+				},
+				[RenderScene, NumCascades, DrawCascades](const FRGPassContext& Context) {
+					// the tiles are cleared on the frame commands, the lists of the draws run after them
+					std::vector<const FShadowCascade*> Cascades;
+					for (uint32 Cascade = 0; Cascade < NumCascades; ++Cascade)
+					{
+						const FShadowCascade& ShadowCascade{ RenderScene->GetShadowCascade(Cascade) };
+						if (ShadowCascade.bDrawStatic)
+						{
+							GRHI->ClearDepthStencilBuffer(ShadowCascade.ViewPort);
+							Cascades.push_back(&ShadowCascade);
+						}
+					}
+					DrawCascades(Cascades, true);
+				});
 		}
-	}
 
-	void FShadowPass::End()
-	{
-		GRHI->EndPass();
+		// without movable casters the cache is sampled as is, nothing is drawn on a static frame
+		if (!RenderScene->HasMovableShadowCasters())
+		{
+			return StaticShadowMapRef;
+		}
+		// the movable casters over a copy of the cache
+		FRGTextureDesc ShadowMapDesc;
+		ShadowMapDesc.Width = Desc.ViewPort.Width;
+		ShadowMapDesc.Height = Desc.ViewPort.Height;
+		ShadowMapDesc.bDepthStencil = true;
+		const FRGTextureRef ShadowMap{ Graph.CreateTexture("ShadowMap", ShadowMapDesc) };
+		Graph.AddPass(Desc.Name + "Copy",
+			[&](FRGPassBuilder& Builder) {
+				Builder.Read(StaticShadowMapRef);
+				Builder.Write(ShadowMap);
+			},
+			[StaticShadowMapRef, ShadowMap](const FRGPassContext& Context) {
+				GRHI->CopyDepthStencilBuffer(Context.GetDepthStencilBuffer(ShadowMap), Context.GetDepthStencilBuffer(StaticShadowMapRef));
+			});
+		Graph.AddPass(Desc.Name + "Movable",
+			[&](FRGPassBuilder& Builder) {
+				Builder.SetDepthStencil(ShadowMap, ERGLoadAction::LOAD);
+			},
+			[RenderScene, NumCascades, DrawCascades](const FRGPassContext& Context) {
+				std::vector<const FShadowCascade*> Cascades;
+				for (uint32 Cascade = 0; Cascade < NumCascades; ++Cascade)
+				{
+					const FShadowCascade& ShadowCascade{ RenderScene->GetShadowCascade(Cascade) };
+					if (ShadowCascade.ConstBuffer)
+					{
+						Cascades.push_back(&ShadowCascade);
+					}
+				}
+				DrawCascades(Cascades, false);
+			});
+		return ShadowMap;
 	}
 
 	const FPostProcessPass::FTriangleMesh FPostProcessPass::TriangleMesh = {
@@ -178,32 +269,30 @@ namespace ks
 		TriangleMeshVertexBuffer.reset(RHIVertexBuffer);
 	}
 
-	void FPostProcessPass::Begin()
-	{
-		GRHI->SetViewports(1, &Desc.ViewPort);
-		GRHI->SetRenderTarget(GRHI->GetCurrentBackBuffer(), GRHI->GetDefaultDepthStencilBuffer());
-		GRHI->BeginPass();
-		GRHI->ClearRenderTarget(color::Red);
-		GRHI->ClearDepthStencilBuffer();
-	}
-
-	void FPostProcessPass::Render()
+	void FPostProcessPass::AddPass(FRenderGraph& Graph, FRGTextureRef SceneColor, FRGTextureRef BackBuffer, FRGTextureRef SceneDepth)
 	{
-		GRHI->SetPipelineState(RHIPipelineState.get());
-
-		// bind scene color texture
-		FBasePass* BasePass = dynamic_cast<FBasePass*>(FRenderPass::GetPass("BasePass"));
-		IRHITexture2D* SceneColorTexture2D = BasePass->GetSceneColorTexture2D();
-		GRHI->SetTexture2D(SceneColorTexture2D);
-
-		GRHI->SetVertexBuffer1(TriangleMeshVertexBuffer.get());
-		GRHI->DrawIndexedPrimitive1(TriangleMeshIndexBuffer.get());
+		Graph.AddPass(Desc.Name,
+			[&](FRGPassBuilder& Builder) {
+				if (SceneColor.IsValid())
+				{
+					Builder.Read(SceneColor);
+				}
+				Builder.SetRenderTarget(BackBuffer, ERGLoadAction::CLEAR, color::Red);
+				Builder.SetDepthStencil(SceneDepth, ERGLoadAction::CLEAR);
+			},
+			[this, SceneColor](const FRGPassContext& Context) {
+				if (!SceneColor.IsValid())
+				{
+					return;
+				}
+				GRHI->SetViewports(1, &Desc.ViewPort);
+				GRHI->SetPipelineState(RHIPipelineState.get());
+
+				// bind scene color texture
+				SetTexture(Context, SceneColor, SceneColorLocation);
+
+				GRHI->SetVertexBuffer1(TriangleMeshVertexBuffer.get());
+				GRHI->DrawIndexedPrimitive1(TriangleMeshIndexBuffer.get());
+			});
 	}
-
-	void FPostProcessPass::End()
-	{
-		GRHI->EndPass();
-	}
-	
-
 }
@@ -1,73 +1,86 @@
 #pragma once
 
 #include "RHI/RHICommon.h"
+#include "Render/RenderGraph.h"
 
 namespace ks
 {
 	class IRHIPipelineState;
+	class IRHICommandList;
+	class FRenderScene;
+	struct FViewVisibility;
 
+	/* the pipeline of a pass, the pass adds its steps to the render graph of every frame */
 	class FRenderPass
 	{
 	public:
-		template<typename _PassType>
-		static FRenderPass* CreatePass(const FRenderPassDesc& Desc) {
-			const auto& KeyName{ Desc.Name };
-			assert(RenderPasses.find(KeyName) == RenderPasses.end());
-			RenderPasses.insert({ KeyName, std::make_unique<_PassType>(Desc) }) ;
-			return RenderPasses.at(KeyName).get();
-		}
-		static FRenderPass* GetPass(const std::string& KeyName) {
-			return RenderPasses.at(KeyName).get();
-		}
-		static void ReleaseAllPasses() {
-			KS_INFOA("RenderPass : Release All Passes.");
-			RenderPasses.clear();
-		}
+		// vertex buffer slot of the per instance primitive indices
+		static constexpr uint32 InstanceSlot{ 2 };
+		// root parameters of the clustered light buffers, see FRenderScene::GetLocalLights
+		static constexpr uint32 LocalLightsLocation{ 5 };
+		static constexpr uint32 ClusterRangesLocation{ 6 };
+		static constexpr uint32 ClusterLightIndicesLocation{ 7 };
+		// descriptor tables of the sampled textures
+		static constexpr int32 ShadowMapLocation{ 2 };
+		static constexpr int32 SceneColorLocation{ 3 };
+		// fewer batches than this per command list cost more in list setup than they save
+		static constexpr uint32 MinBatchesPerCommandList{ 64 };
 		FRenderPass() = default;
 		FRenderPass(const FRenderPassDesc& _Desc);
-		virtual ~FRenderPass() = 0 {}
-		virtual void Begin() = 0;
-		virtual void Render() = 0;
-		virtual void End() = 0;
+		virtual ~FRenderPass() = 0;
 	protected:
+		// the state a view draws with, set on each list that records a part of the view
+		using FSetViewStateFunc = std::function<void(IRHICommandList& CommandList, uint32 ViewIndex)>;
+		/*
+		* the draw batches of the views, one instanced draw each, inside the current pass
+		* the batches are cut into chunks recorded in parallel on command lists of the pass and submitted in view order,
+		* each list sets the pipeline of the pass, SetViewState and the instances of its chunk only
+		*/
+		void RecordDrawBatches(FRenderScene* RenderScene, const std::vector<const FViewVisibility*>& Views, const FSetViewStateFunc& SetViewState);
+		// the texture of the graph for the descriptor table at LocationIndex, and bound to it
+		static IRHITexture2D* GetTexture(const FRGPassContext& Context, FRGTextureRef Texture, int32 LocationIndex);
+		static void SetTexture(const FRGPassContext& Context, FRGTextureRef Texture, int32 LocationIndex);
 		FRenderPassDesc Desc;
 		std::unique_ptr<IRHIPipelineState> RHIPipelineState;
-		static std::unordered_map<std::string, std::unique_ptr<FRenderPass>> RenderPasses;
+	private:
+		struct FDrawChunk
+		{
+			uint32 View{ 0 };
+			// range of FViewVisibility::DrawBatches
+			uint32 FirstBatch{ 0 };
+			uint32 NumBatches{ 0 };
+		};
+		std::vector<FDrawChunk> DrawChunks;
+		// grown to the most chunks a pass recorded, a list records again once submitted
+		std::vector<std::unique_ptr<IRHICommandList>> CommandLists;
+		std::vector<IRHICommandList*> SubmitLists;
 	};
 
 	class FBasePass : public FRenderPass
 	{
 	public:
 		FBasePass(const FRenderPassDesc& Desc);
-		virtual ~FBasePass();
-		virtual void Begin() override;
-		virtual void Render() override;
-		virtual void End() override;
-		IRHITexture2D* GetSceneColorTexture2D() { return SceneColorMap->GetTexture2D(); }
-	protected:
-		std::shared_ptr<IRHIRenderTarget> SceneColorMap;
+		// the views into a transient scene color, returned for the post process
+		FRGTextureRef AddPass(FRenderGraph& Graph, FRenderScene* RenderScene, FRGTextureRef ShadowMap, FRGTextureRef SceneDepth);
 	};
 
+	/* the static casters are cached in an atlas kept across frames, see FShadowCascade */
 	class FShadowPass : public FRenderPass
 	{
 	public:
 		FShadowPass(const FRenderPassDesc& Desc);
-		virtual void Begin() override;
-		virtual void Render() override;
-		virtual void End() override;
-		IRHITexture2D* GetShadowTexture2D() { return ShadowMap->GetTexture2D(); }
+		// redraw the stale cascades of the cache and the movable casters over a copy of it, returns the atlas to sample
+		FRGTextureRef AddPasses(FRenderGraph& Graph, FRenderScene* RenderScene);
 	protected:
-		std::unique_ptr<IRHIDepthStencilBuffer> ShadowMap;
-
+		std::unique_ptr<IRHIDepthStencilBuffer> StaticShadowMap;
 	};
 
 	class FPostProcessPass : public FRenderPass
 	{
 	public:
 		FPostProcessPass(const FRenderPassDesc& Desc);
-		virtual void Begin() override;
-		virtual void Render() override;
-		virtual void End() override;
+		// the scene color to the back buffer, an invalid scene color only clears it
+		void AddPass(FRenderGraph& Graph, FRGTextureRef SceneColor, FRGTextureRef BackBuffer, FRGTextureRef SceneDepth);
 	protected:
 		struct FTriangleMesh
 		{
@@ -79,5 +92,3 @@ namespace ks
 		std::shared_ptr<IRHIVertexBuffer1> TriangleMeshVertexBuffer;
 	};
 }
-
-